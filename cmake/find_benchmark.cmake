@@ -0,0 +1,20 @@
+###############################################################################
+# Find Google Benchmark
+###############################################################################
+
+find_package(benchmark QUIET)
+
+if (NOT benchmark_FOUND)
+  include(FetchContent)
+
+  set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+  set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+
+  FetchContent_Declare(
+      benchmark
+      URL
+      https://github.com/google/benchmark/archive/refs/tags/v1.8.3.tar.gz
+  )
+
+  FetchContent_MakeAvailable(benchmark)
+endif()
@@ -0,0 +1,34 @@
+//===-- CallPathStream.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_CALLPATHSTREAM_H
+#define KLEE_CALLPATHSTREAM_H
+
+#include <stdint.h>
+
+namespace klee {
+namespace callpathstream {
+
+// A call path stream is a single file (or FIFO) holding every call path
+// explored by KLEE, written as the states terminate. It starts with the magic
+// number below, followed by one record per call path. Each record is a
+// RecordHeader (host byte order) followed by Size bytes holding the call path,
+// in the same format as the individual .call_path files. A record with Size 0
+// marks the end of the stream.
+const uint32_t Magic = 0x31535043; // "CPS1"
+
+struct RecordHeader {
+  uint32_t Id;
+  uint32_t Size;
+};
+
+} // namespace callpathstream
+} // namespace klee
+
+#endif /* KLEE_CALLPATHSTREAM_H */
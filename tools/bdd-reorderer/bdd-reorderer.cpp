@@ -2,6 +2,8 @@
 #include "bdd-visualizer.h"
 
 #include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace bdd {
 
@@ -92,57 +94,249 @@ static const Node *get_vector_next(const vector_t &vector) {
   return next;
 }
 
-static bool fn_has_side_effects(const std::string &fn) {
-  auto found = fn_has_side_effects_lookup.find(fn);
-  assert(found != fn_has_side_effects_lookup.end() && "Function not found");
-  return found->second;
-}
-
 static bool fn_can_be_reordered(const std::string &fn) {
   auto found_it = std::find(fn_cannot_reorder_lookup.begin(),
                             fn_cannot_reorder_lookup.end(), fn);
   return found_it == fn_cannot_reorder_lookup.end();
 }
 
-static bool read_in_chunk(klee::ref<klee::ReadExpr> read,
-                          klee::ref<klee::Expr> chunk) {
-  klee::ref<klee::Expr> index_expr = read->index;
-  unsigned byte_read = kutil::solver_toolbox.value_from_expr(index_expr);
+struct known_symbols_t {
+  std::unordered_set<std::string> names;
+  std::unordered_set<unsigned> packet_bytes;
+};
+
+struct expr_deps_t {
+  std::unordered_set<std::string> names;
+  std::vector<unsigned> packet_bytes;
+};
 
-  std::vector<kutil::byte_read_t> known_chunk_bytes =
-      kutil::get_bytes_read(chunk);
+// Arguments naming the objects stateful calls access, each with the argument
+// telling apart the entries of the object, if it has one.
+static const std::vector<std::pair<std::string, std::string>> obj_args{
+    {"map", "key"}, {"vector", "index"}, {"dchain", ""},
+    {"sketch", ""}, {"cht", ""},
+};
 
-  auto is_byte_read = [byte_read](const kutil::byte_read_t &read) {
-    return read.symbol == "packet_chunks" && read.offset == byte_read;
-  };
+struct obj_access_t {
+  std::string obj_arg;
 
-  auto found_it = std::find_if(known_chunk_bytes.begin(),
-                               known_chunk_bytes.end(), is_byte_read);
-  return found_it != known_chunk_bytes.end();
-}
+  // Objects are almost always concrete addresses, and any object might be the
+  // one behind a symbolic one.
+  std::optional<addr_t> addr;
 
-static bool are_all_symbols_known(klee::ref<klee::Expr> expr,
-                                  const symbols_t &known_symbols) {
-  kutil::SymbolRetriever symbol_retriever;
-  symbol_retriever.visit(expr);
+  // Null when the call accesses the object as a whole.
+  klee::ref<klee::Expr> key;
+};
 
-  const std::unordered_set<std::string> &dependencies =
-      symbol_retriever.get_retrieved_strings();
+struct rw_set_t {
+  std::vector<obj_access_t> reads;
+  std::vector<obj_access_t> writes;
+};
 
-  if (dependencies.size() == 0) {
-    return true;
+// Facts about the nodes of a BDD, computed lazily and kept on the BDD, so that
+// every reordering query on it shares them: the symbols each node depends on,
+// the symbols known at each anchor, the objects each node reads and writes,
+// and the branches dominating each node. IO and RW checks become set lookups,
+// leaving the solver for genuine relations between expressions.
+class DependencyIndex {
+private:
+  const BDD *bdd;
+  std::unordered_map<const Node *, expr_deps_t> node_deps;
+  std::unordered_map<const Node *, known_symbols_t> known_symbols;
+  std::unordered_map<const Node *, rw_set_t> rw_sets;
+  std::unordered_map<const Node *, int> dominating_branches;
+
+public:
+  DependencyIndex(const BDD *_bdd) : bdd(_bdd) {}
+
+  // Only the reorderer keeps an analysis on BDDs, and the BDD drops it as
+  // soon as its structure changes.
+  static DependencyIndex &get(const BDD *bdd) {
+    std::shared_ptr<void> analysis = bdd->get_analysis();
+
+    if (!analysis) {
+      analysis = std::make_shared<DependencyIndex>(bdd);
+      bdd->set_analysis(analysis);
+    }
+
+    return *static_cast<DependencyIndex *>(analysis.get());
   }
 
-  bool has_packet_dependencies = false;
-  for (const std::string &dependency : dependencies) {
-    auto is_dependency = [dependency](const symbol_t &s) {
-      return s.array->name == dependency;
-    };
+  const BDD *get_bdd() const { return bdd; }
+
+  static void add_deps(klee::ref<klee::Expr> expr, expr_deps_t &deps) {
+    kutil::SymbolRetriever symbol_retriever;
+    symbol_retriever.visit(expr);
+
+    const std::unordered_set<std::string> &names =
+        symbol_retriever.get_retrieved_strings();
+    deps.names.insert(names.begin(), names.end());
+
+    for (klee::ref<klee::ReadExpr> read :
+         symbol_retriever.get_retrieved_packet_chunks()) {
+      unsigned byte = kutil::solver_toolbox.value_from_expr(read->index);
+      deps.packet_bytes.push_back(byte);
+    }
+  }
+
+  static expr_deps_t get_deps(klee::ref<klee::Expr> expr) {
+    expr_deps_t deps;
+    add_deps(expr, deps);
+    return deps;
+  }
+
+  const expr_deps_t &get_deps(const Node *node) {
+    auto found_it = node_deps.find(node);
+    if (found_it != node_deps.end()) {
+      return found_it->second;
+    }
+
+    expr_deps_t &deps = node_deps[node];
+
+    switch (node->get_type()) {
+    case NodeType::BRANCH: {
+      const Branch *branch_node = static_cast<const Branch *>(node);
+      add_deps(branch_node->get_condition(), deps);
+    } break;
+    case NodeType::CALL: {
+      const Call *call_node = static_cast<const Call *>(node);
+      const call_t &call = call_node->get_call();
+
+      for (const auto &[name, arg] : call.args) {
+        if (!arg.expr.isNull()) {
+          add_deps(arg.expr, deps);
+        }
+
+        if (!arg.in.isNull()) {
+          add_deps(arg.in, deps);
+        }
+      }
+    } break;
+    case NodeType::ROUTE:
+      // Nothing to do here.
+      break;
+    }
+
+    return deps;
+  }
+
+  const known_symbols_t &get_known_symbols(const Node *anchor) {
+    auto found_it = known_symbols.find(anchor);
+    if (found_it != known_symbols.end()) {
+      return found_it->second;
+    }
+
+    known_symbols_t &known = known_symbols[anchor];
+
+    for (const symbol_t &symbol : bdd->get_generated_symbols(anchor)) {
+      known.names.insert(symbol.array->name);
+
+      if (symbol.array->name != "packet_chunks") {
+        continue;
+      }
+
+      for (const kutil::byte_read_t &byte : kutil::get_bytes_read(symbol.expr)) {
+        if (byte.symbol == "packet_chunks") {
+          known.packet_bytes.insert(byte.offset);
+        }
+      }
+    }
+
+    return known;
+  }
+
+  const rw_set_t &get_rw_set(const Node *node) {
+    auto found_it = rw_sets.find(node);
+    if (found_it != rw_sets.end()) {
+      return found_it->second;
+    }
+
+    rw_set_t &rw_set = rw_sets[node];
+
+    if (node->get_type() != NodeType::CALL) {
+      return rw_set;
+    }
+
+    const Call *call_node = static_cast<const Call *>(node);
+    const call_t &call = call_node->get_call();
 
-    auto found_it =
-        std::find_if(known_symbols.begin(), known_symbols.end(), is_dependency);
+    // Unknown functions are assumed to write every object they are given.
+    auto side_effects_it = fn_has_side_effects_lookup.find(call.function_name);
+    bool writes = side_effects_it == fn_has_side_effects_lookup.end() ||
+                  side_effects_it->second;
 
-    if (found_it == known_symbols.end()) {
+    for (const auto &[obj_arg, key_arg] : obj_args) {
+      auto obj_it = call.args.find(obj_arg);
+      if (obj_it == call.args.end() || obj_it->second.expr.isNull()) {
+        continue;
+      }
+
+      klee::ref<klee::Expr> obj = obj_it->second.expr;
+
+      obj_access_t access;
+      access.obj_arg = obj_arg;
+
+      if (kutil::is_constant(obj)) {
+        access.addr = kutil::expr_addr_to_obj_addr(obj);
+      }
+
+      auto key_it = key_arg.empty() ? call.args.end() : call.args.find(key_arg);
+      if (key_it != call.args.end()) {
+        const arg_t &key = key_it->second;
+        access.key = key.in.isNull() ? key.expr : key.in;
+      }
+
+      if (writes) {
+        rw_set.writes.push_back(access);
+      } else {
+        rw_set.reads.push_back(access);
+      }
+    }
+
+    return rw_set;
+  }
+
+  // Branches on the path from the root to the node, not counting the node.
+  int get_dominating_branches(const Node *node) {
+    std::vector<const Node *> pending;
+
+    while (node && !dominating_branches.count(node)) {
+      pending.push_back(node);
+      node = node->get_prev();
+    }
+
+    int branches = node ? dominating_branches.at(node) : 0;
+    bool is_branch = node && node->get_type() == NodeType::BRANCH;
+
+    for (auto it = pending.rbegin(); it != pending.rend(); it++) {
+      branches += is_branch ? 1 : 0;
+      dominating_branches[*it] = branches;
+      node = *it;
+      is_branch = node->get_type() == NodeType::BRANCH;
+    }
+
+    return branches;
+  }
+
+  // Branches strictly between the anchor and a node it dominates.
+  int get_branches_between(const Node *anchor, const Node *node) {
+    int branches =
+        get_dominating_branches(node) - get_dominating_branches(anchor);
+
+    if (anchor->get_type() == NodeType::BRANCH) {
+      branches--;
+    }
+
+    return branches;
+  }
+};
+
+static bool are_all_symbols_known(const expr_deps_t &dependencies,
+                                  const known_symbols_t &known_symbols) {
+  bool has_packet_dependencies = false;
+
+  for (const std::string &dependency : dependencies.names) {
+    if (known_symbols.names.find(dependency) == known_symbols.names.end()) {
       return false;
     }
 
@@ -155,20 +349,9 @@ static bool are_all_symbols_known(klee::ref<klee::Expr> expr,
     return true;
   }
 
-  const std::vector<klee::ref<klee::ReadExpr>> &packet_dependencies =
-      symbol_retriever.get_retrieved_packet_chunks();
-
-  for (klee::ref<klee::ReadExpr> dependency : packet_dependencies) {
-    bool filled = false;
-    for (const symbol_t &known : known_symbols) {
-      if (known.array->name == "packet_chunks" &&
-          read_in_chunk(dependency, known.expr)) {
-        filled = true;
-        break;
-      }
-    }
-
-    if (!filled) {
+  for (unsigned byte : dependencies.packet_bytes) {
+    if (known_symbols.packet_bytes.find(byte) ==
+        known_symbols.packet_bytes.end()) {
       return false;
     }
   }
@@ -202,8 +385,14 @@ static bool get_siblings(const vector_t &anchor, const Node *target,
       if (target_type == NodeType::BRANCH) {
         const Branch *target_branch = static_cast<const Branch *>(target);
 
-        bool matching_conditions = kutil::solver_toolbox.are_exprs_always_equal(
-            branch_node->get_condition(), target_branch->get_condition());
+        klee::ref<klee::Expr> condition = branch_node->get_condition();
+        klee::ref<klee::Expr> target_condition = target_branch->get_condition();
+
+        // Structurally equal conditions need no solver query.
+        bool matching_conditions =
+            condition == target_condition ||
+            kutil::solver_toolbox.are_exprs_always_equal(condition,
+                                                         target_condition);
 
         if (matching_conditions) {
           siblings.insert(node->get_id());
@@ -273,107 +462,47 @@ static bool get_siblings(const vector_t &anchor, const Node *target,
   return true;
 }
 
-static bool io_check(const Node *node, const symbols_t &anchor_symbols) {
-  bool met = true;
-
-  switch (node->get_type()) {
-  case NodeType::BRANCH: {
-    const Branch *branch_node = static_cast<const Branch *>(node);
-    klee::ref<klee::Expr> condition = branch_node->get_condition();
-    met &= are_all_symbols_known(condition, anchor_symbols);
-  } break;
-  case NodeType::CALL: {
-    const Call *call_node = static_cast<const Call *>(node);
-    const call_t &call = call_node->get_call();
-
-    for (const std::pair<std::string, arg_t> &arg_pair : call.args) {
-      const arg_t &arg = arg_pair.second;
-
-      klee::ref<klee::Expr> expr = arg.expr;
-      klee::ref<klee::Expr> in = arg.in;
-
-      if (!expr.isNull()) {
-        met &= are_all_symbols_known(expr, anchor_symbols);
-      }
-
-      if (!in.isNull()) {
-        met &= are_all_symbols_known(in, anchor_symbols);
-      }
-    }
-  } break;
-  case NodeType::ROUTE:
-    // Nothing to do here.
-    break;
-  }
-
-  return met;
+static bool io_check(DependencyIndex &index, const Node *node,
+                     const known_symbols_t &anchor_symbols) {
+  return are_all_symbols_known(index.get_deps(node), anchor_symbols);
 }
 
 static bool io_check(klee::ref<klee::Expr> expr,
-                     const symbols_t &anchor_symbols) {
-  return are_all_symbols_known(expr, anchor_symbols);
-}
-
-static bool check_no_side_effects(const Node *node) {
-  NodeType type = node->get_type();
-
-  if (type != NodeType::CALL) {
-    return true;
-  }
-
-  const Call *call_node = static_cast<const Call *>(node);
-  const call_t &call = call_node->get_call();
-
-  return !fn_has_side_effects(call.function_name);
+                     const known_symbols_t &anchor_symbols) {
+  return are_all_symbols_known(DependencyIndex::get_deps(expr),
+                               anchor_symbols);
 }
 
-static bool check_obj(const Node *n0, const Node *n1,
-                      const std::string &obj_name) {
-  NodeType n0_type = n0->get_type();
-  NodeType n1_type = n1->get_type();
-
-  if ((n0_type != n1_type) || (n0_type != NodeType::CALL)) {
-    return true;
-  }
-
-  const Call *n0_call_node = static_cast<const Call *>(n0);
-  const Call *n1_call_node = static_cast<const Call *>(n1);
-
-  const call_t &n0_call = n0_call_node->get_call();
-  const call_t &n1_call = n1_call_node->get_call();
-
-  auto n0_obj_it = n0_call.args.find(obj_name);
-  auto n1_obj_it = n1_call.args.find(obj_name);
-
-  if (n0_obj_it == n0_call.args.end() || n1_obj_it == n1_call.args.end()) {
+static bool may_be_same_obj(const obj_access_t &a0, const obj_access_t &a1) {
+  if (a0.obj_arg != a1.obj_arg) {
     return false;
   }
 
-  klee::ref<klee::Expr> n0_obj = n0_obj_it->second.expr;
-  klee::ref<klee::Expr> n1_obj = n1_obj_it->second.expr;
+  if (a0.addr.has_value() && a1.addr.has_value()) {
+    return *a0.addr == *a1.addr;
+  }
 
-  bool same_obj = kutil::solver_toolbox.are_exprs_always_equal(n0_obj, n1_obj);
-  return same_obj;
+  return true;
 }
 
-static bool map_can_reorder(const BDD *bdd, const Node *anchor,
-                            const Node *between, const Node *candidate,
-                            klee::ref<klee::Expr> &condition) {
-  if (check_no_side_effects(candidate)) {
-    return true;
-  }
-
-  // Has side effects, but we encountered a branch condition in between.
-  if (between->get_type() == NodeType::BRANCH) {
+// Whether the candidate access can be pulled above the one between it and the
+// anchor. If that only holds for some packets, the condition under which it
+// does is left in condition.
+static bool can_reorder_accesses(const Node *between,
+                                 const obj_access_t &between_access,
+                                 const Node *candidate,
+                                 const obj_access_t &candidate_access,
+                                 klee::ref<klee::Expr> &condition) {
+  klee::ref<klee::Expr> between_key = between_access.key;
+  klee::ref<klee::Expr> candidate_key = candidate_access.key;
+
+  if (between_key.isNull() || candidate_key.isNull()) {
     return false;
   }
 
-  if (between->get_type() != NodeType::CALL) {
-    return true;
-  }
-
-  if (!check_obj(between, candidate, "map")) {
-    return true;
+  if (kutil::is_constant(between_key) && kutil::is_constant(candidate_key) &&
+      between_key->getWidth() == candidate_key->getWidth()) {
+    return between_key != candidate_key;
   }
 
   const klee::ConstraintManager &between_constraints =
@@ -381,177 +510,24 @@ static bool map_can_reorder(const BDD *bdd, const Node *anchor,
   const klee::ConstraintManager &candidate_constraints =
       candidate->get_constraints();
 
-  const Call *between_call_node = static_cast<const Call *>(between);
-  const Call *candidate_call_node = static_cast<const Call *>(candidate);
-
-  const call_t &between_call = between_call_node->get_call();
-  const call_t &candidate_call = candidate_call_node->get_call();
-
-  auto between_key_it = between_call.args.find("key");
-  auto candidate_key_it = candidate_call.args.find("key");
-
-  if (between_key_it == between_call.args.end()) {
-    return false;
-  }
-
-  klee::ref<klee::Expr> between_key = between_key_it->second.in;
-  klee::ref<klee::Expr> candidate_key = candidate_key_it->second.in;
-
   bool always_eq = kutil::solver_toolbox.are_exprs_always_equal(
       between_key, candidate_key, between_constraints, candidate_constraints);
 
-  bool always_diff = kutil::solver_toolbox.are_exprs_always_not_equal(
-      between_key, candidate_key, between_constraints, candidate_constraints);
-
   if (always_eq) {
     return false;
   }
 
-  if (always_diff) {
-    return true;
-  }
-
-  condition = kutil::solver_toolbox.exprBuilder->Not(
-      kutil::solver_toolbox.exprBuilder->Eq(between_key, candidate_key));
-
-  symbols_t anchor_symbols = bdd->get_generated_symbols(anchor);
-  return io_check(condition, anchor_symbols);
-}
-
-static bool dchain_can_reorder(const BDD *bdd, const Node *anchor,
-                               const Node *between, const Node *candidate,
-                               klee::ref<klee::Expr> &condition) {
-  if (check_no_side_effects(candidate)) {
-    return true;
-  }
-
-  // Has side effects, but we encountered a branch condition in between.
-  if (between->get_type() == NodeType::BRANCH) {
-    return false;
-  }
-
-  if (between->get_type() != NodeType::CALL) {
-    return true;
-  }
-
-  return !check_obj(between, candidate, "dchain");
-}
-
-static bool vector_can_reorder(const BDD *bdd, const Node *anchor,
-                               const Node *between, const Node *candidate,
-                               klee::ref<klee::Expr> &condition) {
-  if (check_no_side_effects(candidate)) {
-    return true;
-  }
-
-  // Has side effects, but we encountered a branch condition in between.
-  if (between->get_type() == NodeType::BRANCH) {
-    return false;
-  }
-
-  if (between->get_type() != NodeType::CALL) {
-    return true;
-  }
-
-  if (!check_obj(between, candidate, "vector")) {
-    return true;
-  }
-
-  const klee::ConstraintManager &between_constraints =
-      between->get_constraints();
-  const klee::ConstraintManager &candidate_constraints =
-      candidate->get_constraints();
-
-  const Call *between_call_node = static_cast<const Call *>(between);
-  const Call *candidate_call_node = static_cast<const Call *>(candidate);
-
-  const call_t &between_call = between_call_node->get_call();
-  const call_t &candidate_call = candidate_call_node->get_call();
-
-  auto between_index_it = between_call.args.find("index");
-  if (between_index_it == between_call.args.end()) {
-    return true;
-  }
-
-  klee::ref<klee::Expr> between_index = between_call.args.at("index").expr;
-  klee::ref<klee::Expr> candidate_index = candidate_call.args.at("index").expr;
-
-  bool always_eq = kutil::solver_toolbox.are_exprs_always_equal(
-      between_index, candidate_index, between_constraints,
-      candidate_constraints);
-
   bool always_diff = kutil::solver_toolbox.are_exprs_always_not_equal(
-      between_index, candidate_index, between_constraints,
-      candidate_constraints);
-
-  if (always_eq) {
-    return false;
-  }
+      between_key, candidate_key, between_constraints, candidate_constraints);
 
   if (always_diff) {
     return true;
   }
 
   condition = kutil::solver_toolbox.exprBuilder->Not(
-      kutil::solver_toolbox.exprBuilder->Eq(between_index, candidate_index));
-
-  symbols_t anchor_symbols = bdd->get_generated_symbols(anchor);
-  return io_check(condition, anchor_symbols);
-}
-
-static bool cht_can_reorder(const BDD *bdd, const Node *anchor,
-                            const Node *between, const Node *candidate,
-                            klee::ref<klee::Expr> &condition) {
-  return check_no_side_effects(candidate);
-}
-
-static bool sketch_can_reorder(const BDD *bdd, const Node *anchor,
-                               const Node *between, const Node *candidate,
-                               klee::ref<klee::Expr> &condition) {
-  bool can_reorder = true;
-  can_reorder &= check_no_side_effects(candidate);
-  can_reorder &= !check_obj(between, candidate, "sketch");
-  return can_reorder;
-}
-
-using can_reorder_stateful_op_fn = bool (*)(const BDD *bdd, const Node *anchor,
-                                            const Node *between,
-                                            const Node *candidate,
-                                            klee::ref<klee::Expr> &condition);
-
-const std::unordered_map<std::string, can_reorder_stateful_op_fn>
-    can_reorder_handlers{
-        {"vector_borrow", vector_can_reorder},
-        {"vector_return", vector_can_reorder},
-        {"map_get", map_can_reorder},
-        {"map_put", map_can_reorder},
-        {"map_erase", map_can_reorder},
-        {"dchain_allocate_new_index", dchain_can_reorder},
-        {"dchain_is_index_allocated", dchain_can_reorder},
-        {"dchain_free_index", dchain_can_reorder},
-        {"dchain_rejuvenate_index", dchain_can_reorder},
-        {"cht_find_preferred_available_backend", cht_can_reorder},
-        {"sketch_expire", sketch_can_reorder},
-        {"sketch_compute_hashes", sketch_can_reorder},
-        {"sketch_refresh", sketch_can_reorder},
-        {"sketch_fetch", sketch_can_reorder},
-        {"sketch_touch_buckets", sketch_can_reorder},
-    };
-
-static bool can_reorder_stateful_op(const BDD *bdd, const Node *anchor,
-                                    const Node *between, const Node *candidate,
-                                    klee::ref<klee::Expr> &condition) {
-  assert(candidate->get_type() == NodeType::CALL);
-
-  const Call *call_node = static_cast<const Call *>(candidate);
-  const call_t &call = call_node->get_call();
-
-  auto found_it = can_reorder_handlers.find(call.function_name);
-  if (found_it == can_reorder_handlers.end()) {
-    return true;
-  }
+      kutil::solver_toolbox.exprBuilder->Eq(between_key, candidate_key));
 
-  return found_it->second(bdd, anchor, between, candidate, condition);
+  return true;
 }
 
 static klee::ref<klee::Expr>
@@ -583,20 +559,70 @@ add_unique_condition(klee::ref<klee::Expr> new_condition,
   conditions.push_back(new_condition);
 }
 
-static bool rw_check(const BDD *bdd, const Node *anchor, const Node *candidate,
-                     klee::ref<klee::Expr> &condition) {
-  const Node *between = candidate->get_prev();
+// Pulling the candidate above the nodes between it and the anchor must not
+// reorder a write with any other access to the same entry of an object.
+static bool rw_check(DependencyIndex &index, const Node *anchor,
+                     const Node *candidate, klee::ref<klee::Expr> &condition) {
+  const rw_set_t &candidate_rw = index.get_rw_set(candidate);
+
+  if (candidate_rw.reads.empty() && candidate_rw.writes.empty()) {
+    return true;
+  }
+
+  // Writes would then also happen on the paths the branches steered away.
+  if (!candidate_rw.writes.empty() &&
+      index.get_branches_between(anchor, candidate) > 0) {
+    return false;
+  }
 
+  const known_symbols_t &anchor_symbols = index.get_known_symbols(anchor);
   std::vector<klee::ref<klee::Expr>> all_conditions;
 
-  while (between != anchor) {
+  auto check = [&](const Node *between, const obj_access_t &between_access,
+                   const obj_access_t &candidate_access) {
+    if (!may_be_same_obj(between_access, candidate_access)) {
+      return true;
+    }
+
     klee::ref<klee::Expr> cond;
-    if (!can_reorder_stateful_op(bdd, anchor, between, candidate, cond)) {
+    if (!can_reorder_accesses(between, between_access, candidate,
+                              candidate_access, cond)) {
+      return false;
+    }
+
+    if (!cond.isNull() && !io_check(cond, anchor_symbols)) {
       return false;
     }
 
     add_unique_condition(cond, all_conditions);
-    between = between->get_prev();
+    return true;
+  };
+
+  for (const Node *between = candidate->get_prev(); between != anchor;
+       between = between->get_prev()) {
+    const rw_set_t &between_rw = index.get_rw_set(between);
+
+    for (const obj_access_t &candidate_write : candidate_rw.writes) {
+      for (const obj_access_t &between_read : between_rw.reads) {
+        if (!check(between, between_read, candidate_write)) {
+          return false;
+        }
+      }
+
+      for (const obj_access_t &between_write : between_rw.writes) {
+        if (!check(between, between_write, candidate_write)) {
+          return false;
+        }
+      }
+    }
+
+    for (const obj_access_t &candidate_read : candidate_rw.reads) {
+      for (const obj_access_t &between_write : between_rw.writes) {
+        if (!check(between, between_write, candidate_read)) {
+          return false;
+        }
+      }
+    }
   }
 
   condition = build_condition(all_conditions);
@@ -657,11 +683,12 @@ static bool anchor_reaches_candidate(const vector_t &anchor,
   return candidate->is_reachable(anchor_next_id);
 }
 
-candidate_info_t
-concretize_reordering_candidate(const BDD *bdd, const vector_t &anchor,
+static candidate_info_t
+concretize_reordering_candidate(DependencyIndex &index, const vector_t &anchor,
                                 node_id_t proposed_candidate_id) {
   candidate_info_t candidate_info;
 
+  const BDD *bdd = index.get_bdd();
   const Node *proposed_candidate = bdd->get_node_by_id(proposed_candidate_id);
 
   candidate_info.is_branch =
@@ -679,8 +706,6 @@ concretize_reordering_candidate(const BDD *bdd, const vector_t &anchor,
     return candidate_info;
   }
 
-  symbols_t anchor_symbols = bdd->get_generated_symbols(anchor.node);
-
   assert(anchor.node && "Anchor node not found");
   assert(proposed_candidate && "Proposed candidate node not found");
 
@@ -690,7 +715,9 @@ concretize_reordering_candidate(const BDD *bdd, const vector_t &anchor,
     return candidate_info;
   }
 
-  if (!io_check(proposed_candidate, anchor_symbols)) {
+  const known_symbols_t &anchor_symbols = index.get_known_symbols(anchor.node);
+
+  if (!io_check(index, proposed_candidate, anchor_symbols)) {
     candidate_info.status = ReorderingCandidateStatus::IO_CHECK_FAILED;
     return candidate_info;
   }
@@ -709,7 +736,7 @@ concretize_reordering_candidate(const BDD *bdd, const vector_t &anchor,
       return candidate_info;
     }
 
-    if (!rw_check(bdd, anchor.node, call_node, candidate_info.condition)) {
+    if (!rw_check(index, anchor.node, call_node, candidate_info.condition)) {
       candidate_info.status = ReorderingCandidateStatus::RW_CHECK_FAILED;
       return candidate_info;
     }
@@ -754,11 +781,12 @@ static node_id_t get_next_branch(const Node *node) {
   return next_branch_id;
 }
 
-std::vector<reorder_op_t> get_reorder_ops(const BDD *bdd,
-                                          const anchor_info_t &anchor_info,
-                                          bool allow_shape_altering_ops) {
+static std::vector<reorder_op_t>
+get_reorder_ops(DependencyIndex &index, const anchor_info_t &anchor_info,
+                bool allow_shape_altering_ops) {
   std::vector<reorder_op_t> ops;
 
+  const BDD *bdd = index.get_bdd();
   const Node *anchor_node = bdd->get_node_by_id(anchor_info.id);
   const vector_t anchor = {anchor_node, anchor_info.direction};
   const Node *next = get_vector_next(anchor);
@@ -784,10 +812,10 @@ std::vector<reorder_op_t> get_reorder_ops(const BDD *bdd,
     return true;
   };
 
-  next->visit_nodes([&ops, &bdd, anchor, next, anchor_info,
+  next->visit_nodes([&ops, &index, anchor, next, anchor_info,
                      allow_candidate](const Node *node) -> NodeVisitAction {
     candidate_info_t proposed_candidate =
-        concretize_reordering_candidate(bdd, anchor, node->get_id());
+        concretize_reordering_candidate(index, anchor, node->get_id());
 
     if (proposed_candidate.status == ReorderingCandidateStatus::VALID &&
         allow_candidate(proposed_candidate)) {
@@ -805,6 +833,13 @@ std::vector<reorder_op_t> get_reorder_ops(const BDD *bdd,
   return ops;
 }
 
+std::vector<reorder_op_t> get_reorder_ops(const BDD *bdd,
+                                          const anchor_info_t &anchor_info,
+                                          bool allow_shape_altering_ops) {
+  DependencyIndex &index = DependencyIndex::get(bdd);
+  return get_reorder_ops(index, anchor_info, allow_shape_altering_ops);
+}
+
 // Returns the old next node.
 static Node *link(const mutable_vector_t &anchor, Node *next) {
   Node *old_next = nullptr;
@@ -1254,13 +1289,18 @@ BDD *reorder(const BDD *original_bdd, const reorder_op_t &op) {
   assert(candidate && "Candidate not found in BDD");
   assert(anchor.node && "Anchor not found in BDD");
 
+  // Everything after the anchor may move, so it is indexed again once done.
+  mutable_vector_t original_anchor = anchor;
+  bdd->remove_from_index(get_vector_next(anchor));
+
   // Reordering can only be done if a given extra condition is met.
   // Therefore, we must introduce a new branch condition evaluating this extra
   // condition.
   // Reordering will happen on the true side of this branch node, while the
   // false side will contain the original remaining nodes.
   if (!candidate_info.condition.isNull()) {
-    klee::ConstraintManager anchor_constraints = anchor.node->get_constraints();
+    const SharedConstraints &anchor_constraints =
+        anchor.node->get_shared_constraints();
 
     Node *after_anchor = get_vector_next(anchor);
     assert(after_anchor && "Anchor has no next node");
@@ -1284,7 +1324,7 @@ BDD *reorder(const BDD *original_bdd, const reorder_op_t &op) {
     // Same logic for all the siblings.
     siblings.clear();
     for (node_id_t sibling_id : candidate_info.siblings) {
-      Node *sibling = bdd->get_mutable_node_by_id(sibling_id);
+      Node *sibling = after_anchor_clone->get_mutable_node_by_id(sibling_id);
       assert(sibling && "Sibling not found in BDD");
       siblings.insert(sibling);
     }
@@ -1307,6 +1347,8 @@ BDD *reorder(const BDD *original_bdd, const reorder_op_t &op) {
 
   pull_candidate(bdd, anchor, candidate, siblings);
 
+  bdd->update_index(get_vector_next(original_anchor));
+
   return bdd;
 }
 
@@ -1317,8 +1359,9 @@ std::vector<reordered_bdd_t> reorder(const BDD *bdd, node_id_t anchor_id,
   const Node *anchor = bdd->get_node_by_id(anchor_id);
   assert(anchor && "Anchor not found in BDD");
 
+  DependencyIndex &index = DependencyIndex::get(bdd);
   std::vector<reorder_op_t> ops =
-      get_reorder_ops(bdd, {anchor_id, true}, allow_shape_altering_ops);
+      get_reorder_ops(index, {anchor_id, true}, allow_shape_altering_ops);
 
   for (const reorder_op_t &op : ops) {
     BDD *new_bdd = reorder(bdd, op);
@@ -1331,7 +1374,7 @@ std::vector<reordered_bdd_t> reorder(const BDD *bdd, node_id_t anchor_id,
 
   const std::vector<reorder_op_t> &lhs_ops = ops;
   std::vector<reorder_op_t> rhs_ops =
-      get_reorder_ops(bdd, {anchor_id, false}, allow_shape_altering_ops);
+      get_reorder_ops(index, {anchor_id, false}, allow_shape_altering_ops);
 
   // Now let's combine all the possible reordering operations!
   for (size_t rhs_idx = 0; rhs_idx < rhs_ops.size(); rhs_idx++) {
@@ -1377,8 +1420,9 @@ reordered_bdd_t try_reorder(const BDD *bdd, const anchor_info_t &anchor_info,
   vector_t anchor_vector = {anchor, anchor_info.direction};
   const Node *next = get_vector_next(anchor_vector);
 
+  DependencyIndex &index = DependencyIndex::get(bdd);
   candidate_info_t proposed_candidate =
-      concretize_reordering_candidate(bdd, anchor_vector, candidate_id);
+      concretize_reordering_candidate(index, anchor_vector, candidate_id);
   reorder_op_t op = {anchor_info, next->get_id(), proposed_candidate};
 
   reordered_bdd_t result = {
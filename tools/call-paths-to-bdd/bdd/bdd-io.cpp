@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <unordered_map>
 
 #include "bdd-io.h"
 #include "bdd.h"
@@ -772,7 +774,7 @@ static symbols_t parse_call_symbols(std::string serialized_symbols,
 }
 
 static Node *parse_node_call(node_id_t id,
-                             const klee::ConstraintManager &constraints,
+                             const SharedConstraints &constraints,
                              std::string serialized,
                              std::vector<klee::ref<klee::Expr>> &exprs,
                              NodeManager &manager) {
@@ -791,7 +793,7 @@ static Node *parse_node_call(node_id_t id,
 }
 
 static Node *parse_node_branch(node_id_t id,
-                               const klee::ConstraintManager &constraints,
+                               const SharedConstraints &constraints,
                                std::string serialized,
                                std::vector<klee::ref<klee::Expr>> &exprs,
                                NodeManager &manager) {
@@ -802,7 +804,7 @@ static Node *parse_node_branch(node_id_t id,
 }
 
 static Node *parse_node_route(node_id_t id,
-                              const klee::ConstraintManager &constraints,
+                              const SharedConstraints &constraints,
                               std::string serialized,
                               std::vector<klee::ref<klee::Expr>> &exprs,
                               NodeManager &manager) {
@@ -830,9 +832,37 @@ static Node *parse_node_route(node_id_t id,
   return route_node;
 }
 
+// Constraints loaded so far, by hash. Nodes loaded under the same constraints
+// share them, as they did in the BDD that was saved.
+typedef std::unordered_map<size_t, std::vector<SharedConstraints>>
+    constraints_cache_t;
+
+static SharedConstraints
+get_shared_constraints(const klee::ConstraintManager &constraints,
+                       constraints_cache_t &cache) {
+  size_t hash = constraints.size();
+  for (klee::ref<klee::Expr> constraint : constraints) {
+    hash = hash * 31 + constraint->hash();
+  }
+
+  std::vector<SharedConstraints> &candidates = cache[hash];
+
+  for (const SharedConstraints &candidate : candidates) {
+    const klee::ConstraintManager &other = candidate.get();
+    if (other.size() == constraints.size() &&
+        std::equal(constraints.begin(), constraints.end(), other.begin())) {
+      return candidate;
+    }
+  }
+
+  candidates.emplace_back(constraints);
+  return candidates.back();
+}
+
 static Node *parse_node(std::string serialized_node,
                         std::vector<klee::ref<klee::Expr>> &exprs,
-                        NodeManager &manager) {
+                        NodeManager &manager,
+                        constraints_cache_t &constraints_cache) {
   Node *node;
 
   size_t delim = serialized_node.find(":");
@@ -869,15 +899,15 @@ static Node *parse_node(std::string serialized_node,
   serialized_node = serialized_node.substr(delim + 1);
   serialized_node = serialized_node.substr(0, serialized_node.size() - 1);
 
+  SharedConstraints constraints =
+      get_shared_constraints(constraint_manager, constraints_cache);
+
   if (node_type_str == "CALL") {
-    node = parse_node_call(id, constraint_manager, serialized_node, exprs,
-                           manager);
+    node = parse_node_call(id, constraints, serialized_node, exprs, manager);
   } else if (node_type_str == "BRANCH") {
-    node = parse_node_branch(id, constraint_manager, serialized_node, exprs,
-                             manager);
+    node = parse_node_branch(id, constraints, serialized_node, exprs, manager);
   } else if (node_type_str == "ROUTE") {
-    node = parse_node_route(id, constraint_manager, serialized_node, exprs,
-                            manager);
+    node = parse_node_route(id, constraints, serialized_node, exprs, manager);
   } else {
     assert(false);
   }
@@ -1027,6 +1057,7 @@ void BDD::deserialize(const std::string &file_path) {
 
   std::vector<klee::ref<klee::Expr>> exprs;
   std::map<node_id_t, Node *> nodes;
+  constraints_cache_t constraints_cache;
   std::vector<const klee::Array *> arrays;
 
   int parenthesis_level = 0;
@@ -1091,7 +1122,8 @@ void BDD::deserialize(const std::string &file_path) {
       }
 
       if (parenthesis_level == 0) {
-        Node *node = parse_node(current_node, exprs, manager);
+        Node *node =
+            parse_node(current_node, exprs, manager, constraints_cache);
 
         assert(node);
         assert(nodes.find(node->get_id()) == nodes.end());
@@ -1129,6 +1161,8 @@ void BDD::deserialize(const std::string &file_path) {
   }
 
   assert(magic_check && "Not a BDD file (missing magic signature)");
+
+  build_index();
 }
 
 } // namespace bdd
\ No newline at end of file
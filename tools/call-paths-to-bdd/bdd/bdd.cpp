@@ -2,6 +2,7 @@
 #include <set>
 #include <iostream>
 #include <optional>
+#include <functional>
 
 #include "bdd-io.h"
 #include "bdd.h"
@@ -143,48 +144,105 @@ static std::unordered_map<std::string, SymbolsExtractor>
 
 void BDD::visit(BDDVisitor &visitor) const { visitor.visit(this); }
 
-const Node *BDD::get_node_by_id(node_id_t _id) const {
-  return root ? root->get_node_by_id(_id) : nullptr;
+// Visits the nodes under root breadth-first, along with their depth (starting
+// at the given one).
+static void
+visit_nodes_by_depth(const Node *root, int root_depth,
+                     std::function<void(const Node *, int)> visitor) {
+  if (!root) {
+    return;
+  }
+
+  std::vector<std::pair<const Node *, int>> nodes{{root, root_depth}};
+
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const Node *node = nodes[i].first;
+    int depth = nodes[i].second;
+
+    visitor(node, depth);
+
+    switch (node->get_type()) {
+    case NodeType::BRANCH: {
+      const Branch *branch_node = static_cast<const Branch *>(node);
+      const Node *on_true = branch_node->get_on_true();
+      const Node *on_false = branch_node->get_on_false();
+      if (on_true)
+        nodes.push_back({on_true, depth + 1});
+      if (on_false)
+        nodes.push_back({on_false, depth + 1});
+    } break;
+    case NodeType::CALL:
+    case NodeType::ROUTE: {
+      const Node *next = node->get_next();
+      if (next)
+        nodes.push_back({next, depth + 1});
+    } break;
+    }
+  }
 }
 
-Node *BDD::get_mutable_node_by_id(node_id_t _id) {
-  return root ? root->get_mutable_node_by_id(_id) : nullptr;
+void BDD::index_nodes(const Node *node, int depth) {
+  analysis.reset();
+
+  visit_nodes_by_depth(node, depth, [this](const Node *node, int depth) {
+    node_id_t node_id = node->get_id();
+
+    if (node_id >= nodes_by_id.size()) {
+      nodes_by_id.resize(node_id + 1, nullptr);
+      depth_by_id.resize(node_id + 1, -1);
+    }
+
+    // Every node of the BDD is owned by its manager.
+    nodes_by_id[node_id] = const_cast<Node *>(node);
+    depth_by_id[node_id] = depth;
+  });
 }
 
-int BDD::get_node_depth(node_id_t _id) const {
-  int depth = -1;
+void BDD::build_index() {
+  nodes_by_id.assign(id, nullptr);
+  depth_by_id.assign(id, -1);
+  index_nodes(root, 0);
+}
 
-  if (!root) {
-    return depth;
+void BDD::update_index(const Node *node) {
+  if (!node) {
+    return;
   }
 
-  struct depth_tracker_t : cookie_t {
-    int depth;
+  int depth = 0;
 
-    depth_tracker_t() : depth(0) {}
+  if (node != root) {
+    const Node *prev = node->get_prev();
+    assert(prev && "Node not linked to the BDD");
+    depth = get_node_depth(prev->get_id()) + 1;
+  }
 
-    cookie_t *clone() const override {
-      depth_tracker_t *new_cookie = new depth_tracker_t();
-      new_cookie->depth = depth;
-      return new_cookie;
-    }
-  };
+  index_nodes(node, depth);
+}
 
-  root->visit_nodes(
-      [_id, &depth](const Node *node, cookie_t *cookie) {
-        depth_tracker_t *depth_tracker = static_cast<depth_tracker_t *>(cookie);
+void BDD::remove_from_index(const Node *node) {
+  analysis.reset();
 
-        if (node->get_id() == _id) {
-          depth = depth_tracker->depth;
-          return NodeVisitAction::STOP;
-        }
+  visit_nodes_by_depth(node, 0, [this](const Node *node, int depth) {
+    node_id_t node_id = node->get_id();
+
+    if (node_id < nodes_by_id.size() && nodes_by_id[node_id] == node) {
+      nodes_by_id[node_id] = nullptr;
+      depth_by_id[node_id] = -1;
+    }
+  });
+}
+
+const Node *BDD::get_node_by_id(node_id_t _id) const {
+  return _id < nodes_by_id.size() ? nodes_by_id[_id] : nullptr;
+}
 
-        depth_tracker->depth++;
-        return NodeVisitAction::VISIT_CHILDREN;
-      },
-      std::make_unique<depth_tracker_t>());
+Node *BDD::get_mutable_node_by_id(node_id_t _id) {
+  return _id < nodes_by_id.size() ? nodes_by_id[_id] : nullptr;
+}
 
-  return depth;
+int BDD::get_node_depth(node_id_t _id) const {
+  return _id < depth_by_id.size() ? depth_by_id[_id] : -1;
 }
 
 static bool is_bdd_symbol(const std::string &symbol) {
@@ -230,7 +288,7 @@ static bool is_skip_condition(klee::ref<klee::Expr> condition) {
 }
 
 static Route *route_node_from_call(const call_t &call,
-                                   const klee::ConstraintManager &constraints,
+                                   const SharedConstraints &constraints,
                                    node_id_t id) {
   assert(is_routing_function(call));
 
@@ -426,6 +484,10 @@ static Node *bdd_from_call_paths(
 
   symbols_t symbols = call_paths.get_symbols();
 
+  // Every node built in this call (i.e. until the next branch) has the same
+  // constraints.
+  SharedConstraints node_constraints(constraints);
+
   while (call_paths.cps.size()) {
     CallPathsGroup group(call_paths);
 
@@ -466,9 +528,9 @@ static Node *bdd_from_call_paths(
         Node *node;
 
         if (is_routing_function(call)) {
-          node = route_node_from_call(call, constraints, id);
+          node = route_node_from_call(call, node_constraints, id);
         } else {
-          node = new Call(id, constraints, call, generated_symbols);
+          node = new Call(id, node_constraints, call, generated_symbols);
         }
 
         manager.add_node(node);
@@ -523,7 +585,7 @@ static Node *bdd_from_call_paths(
         continue;
       }
 
-      Branch *node = new Branch(id, constraints, condition);
+      Branch *node = new Branch(id, node_constraints, condition);
       id++;
       manager.add_node(node);
 
@@ -592,6 +654,8 @@ BDD::BDD(const call_paths_t &call_paths) : id(0) {
   if (device.expr.isNull()) {
     device.expr = kutil::solver_toolbox.create_new_symbol("DEVICE", 32);
   }
+
+  build_index();
 }
 
 BDD::BDD(const std::string &file_path) : id(0) { deserialize(file_path); }
@@ -20,6 +20,17 @@ private:
 
   NodeManager manager;
 
+  // Dense id -> node and id -> depth tables, built along with the BDD and
+  // kept up to date by whoever changes its structure (see update_index and
+  // remove_from_index), so that lookups never walk the BDD.
+  std::vector<Node *> nodes_by_id;
+  std::vector<int> depth_by_id;
+
+  // Facts other tools derive from the BDD (e.g. the reorderer's dependency
+  // index). They refer to its nodes, so they are dropped whenever the index
+  // changes and never copied along with the BDD.
+  mutable std::shared_ptr<void> analysis;
+
 public:
   BDD() : id(0), root(nullptr) {}
 
@@ -30,7 +41,10 @@ public:
       : id(other.id), device(std::move(other.device)),
         packet_len(std::move(other.packet_len)), time(std::move(other.time)),
         init(std::move(other.init)), root(other.root),
-        manager(std::move(other.manager)) {
+        manager(std::move(other.manager)),
+        nodes_by_id(std::move(other.nodes_by_id)),
+        depth_by_id(std::move(other.depth_by_id)),
+        analysis(std::move(other.analysis)) {
     other.root = nullptr;
   }
 
@@ -38,6 +52,7 @@ public:
       : id(other.id), device(other.device), packet_len(other.packet_len),
         time(other.time), init(other.init) {
     root = other.root->clone(manager, true);
+    build_index();
   }
 
   BDD &operator=(const BDD &other) {
@@ -49,10 +64,13 @@ public:
     time = other.time;
     init = other.init;
     root = other.root->clone(manager, true);
+    build_index();
     return *this;
   }
 
   node_id_t get_id() const { return id; }
+
+  // Only hands out the id counter, nodes keep their ids.
   node_id_t &get_mutable_id() { return id; }
 
   symbol_t get_device() const { return device; }
@@ -75,6 +93,24 @@ public:
   int get_node_depth(node_id_t _id) const;
 
   NodeManager &get_mutable_manager() { return manager; }
+
+  const std::shared_ptr<void> &get_analysis() const { return analysis; }
+  void set_analysis(std::shared_ptr<void> _analysis) const {
+    analysis = _analysis;
+  }
+
+  // Indexes the node and every node under it, which must be linked to the
+  // BDD. To be called on the highest node whose links changed, once done
+  // changing them.
+  void update_index(const Node *node);
+
+  // Drops the node and every node under it from the index. To be called
+  // before taking them out of the BDD.
+  void remove_from_index(const Node *node);
+
+private:
+  void build_index();
+  void index_nodes(const Node *node, int depth);
 };
 
 } // namespace bdd
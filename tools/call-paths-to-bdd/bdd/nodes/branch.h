@@ -12,13 +12,13 @@ private:
   klee::ref<klee::Expr> condition;
 
 public:
-  Branch(node_id_t _id, const klee::ConstraintManager &_constraints,
+  Branch(node_id_t _id, const SharedConstraints &_constraints,
          klee::ref<klee::Expr> _condition)
       : Node(_id, NodeType::BRANCH, _constraints), on_false(nullptr),
         condition(_condition) {}
 
   Branch(node_id_t _id, Node *_prev,
-         const klee::ConstraintManager &_constraints, Node *_on_true,
+         const SharedConstraints &_constraints, Node *_on_true,
          Node *_on_false, klee::ref<klee::Expr> _condition)
       : Node(_id, NodeType::BRANCH, _on_true, _prev, _constraints),
         on_false(_on_false), condition(_condition) {}
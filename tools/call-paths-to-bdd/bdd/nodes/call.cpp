@@ -7,15 +7,16 @@
 namespace bdd {
 
 Node *Call::clone(NodeManager &manager, bool recursive) const {
-  Call *clone;
+  // The copy shares the constraints, call and generated symbols with this
+  // node.
+  Call *clone = new Call(*this);
+  clone->set_next(nullptr);
+  clone->set_prev(nullptr);
 
   if (recursive && next) {
     Node *next_clone = next->clone(manager, true);
-    clone =
-        new Call(id, next_clone, nullptr, constraints, call, generated_symbols);
+    clone->set_next(next_clone);
     next_clone->set_prev(clone);
-  } else {
-    clone = new Call(id, constraints, call, generated_symbols);
   }
 
   manager.add_node(clone);
@@ -27,7 +28,7 @@ void Call::visit(BDDVisitor &visitor) const { visitor.visit(this); }
 std::string Call::dump(bool one_liner, bool id_name_only) const {
   std::stringstream ss;
   ss << id << ":";
-  ss << call.function_name;
+  ss << call->function_name;
 
   if (id_name_only) {
     return ss.str();
@@ -36,7 +37,7 @@ std::string Call::dump(bool one_liner, bool id_name_only) const {
   ss << "(";
 
   bool first = true;
-  for (auto &arg : call.args) {
+  for (auto &arg : call->args) {
     if (!first)
       ss << ", ";
     ss << arg.first << ":";
@@ -63,11 +64,11 @@ std::string Call::dump(bool one_liner, bool id_name_only) const {
 symbols_t Call::get_locally_generated_symbols(
     std::vector<std::string> base_filters) const {
   if (base_filters.empty()) {
-    return generated_symbols;
+    return *generated_symbols;
   }
 
   symbols_t result;
-  for (const symbol_t &symbol : generated_symbols) {
+  for (const symbol_t &symbol : *generated_symbols) {
     auto found_it =
         std::find(base_filters.begin(), base_filters.end(), symbol.base);
     if (found_it != base_filters.end()) {
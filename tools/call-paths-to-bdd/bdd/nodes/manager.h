@@ -3,37 +3,36 @@
 #include "node.h"
 
 #include <memory>
-#include <vector>
+#include <unordered_map>
 
 namespace bdd {
 
 class NodeManager {
 private:
-  std::vector<std::unique_ptr<Node>> nodes;
+  // Keyed by address, so nodes can be freed in constant time.
+  std::unordered_map<const Node *, std::unique_ptr<Node>> nodes;
 
 public:
   NodeManager() {}
   NodeManager(NodeManager &&other) = default;
 
-  void add_node(Node *node) { nodes.emplace_back(node); }
+  void add_node(Node *node) { nodes.emplace(node, node); }
 
   void free_node(Node *node) {
-    auto it = std::find_if(
-        nodes.begin(), nodes.end(),
-        [node](const std::unique_ptr<Node> &n) { return n.get() == node; });
+    auto it = nodes.find(node);
 
     if (it != nodes.end()) {
-      assert((*it)->get_id() == node->get_id());
+      assert(it->second->get_id() == node->get_id());
       nodes.erase(it);
     }
   }
 
   NodeManager operator+(const NodeManager &other) const {
     NodeManager manager;
-    for (const std::unique_ptr<Node> &node : nodes)
-      node->clone(manager);
-    for (const std::unique_ptr<Node> &node : other.nodes)
-      node->clone(manager);
+    for (const auto &node : nodes)
+      node.second->clone(manager);
+    for (const auto &node : other.nodes)
+      node.second->clone(manager);
     return manager;
   }
 
@@ -42,4 +41,4 @@ public:
   }
 };
 
-} // namespace bdd
\ No newline at end of file
+} // namespace bdd
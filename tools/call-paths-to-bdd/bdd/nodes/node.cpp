@@ -8,6 +8,7 @@
 #include "llvm/Support/MD5.h"
 
 #include <iomanip>
+#include <unordered_map>
 
 namespace bdd {
 
@@ -227,8 +228,25 @@ void Node::recursive_translate_symbol(const symbol_t &old_symbol,
 }
 
 void Node::recursive_add_constraint(klee::ref<klee::Expr> constraint) {
-  visit_mutable_nodes([constraint](Node *node) -> NodeVisitAction {
-    node->constraints.addConstraint(constraint);
+  // Nodes that shared their constraints keep sharing the extended ones. The
+  // old sets are kept alive until we are done, so their addresses stay unique.
+  std::unordered_map<const klee::ConstraintManager *,
+                     std::pair<SharedConstraints, SharedConstraints>>
+      extended;
+
+  visit_mutable_nodes([constraint, &extended](Node *node) -> NodeVisitAction {
+    const klee::ConstraintManager *old_constraints = &node->get_constraints();
+    auto found_it = extended.find(old_constraints);
+
+    if (found_it == extended.end()) {
+      SharedConstraints new_constraints = node->constraints.with(constraint);
+      found_it = extended
+                     .insert({old_constraints,
+                              {node->constraints, new_constraints}})
+                     .first;
+    }
+
+    node->constraints = found_it->second.second;
     return NodeVisitAction::VISIT_CHILDREN;
   });
 }
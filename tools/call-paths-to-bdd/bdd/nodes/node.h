@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
@@ -23,6 +24,32 @@ struct cookie_t {
   virtual cookie_t *clone() const = 0;
 };
 
+// Constraints never change once attached to a node, so nodes with the same
+// constraints (clones, and the non-branch nodes between two branches) share a
+// single copy. Adding a constraint creates a new set instead of mutating the
+// shared one.
+class SharedConstraints {
+private:
+  std::shared_ptr<const klee::ConstraintManager> constraints;
+
+public:
+  explicit SharedConstraints(const klee::ConstraintManager &_constraints)
+      : constraints(
+            std::make_shared<const klee::ConstraintManager>(_constraints)) {}
+
+  const klee::ConstraintManager &get() const { return *constraints; }
+
+  SharedConstraints with(klee::ref<klee::Expr> constraint) const {
+    klee::ConstraintManager extended = *constraints;
+    extended.addConstraint(constraint);
+    return SharedConstraints(extended);
+  }
+
+  bool operator==(const SharedConstraints &other) const {
+    return constraints == other.constraints;
+  }
+};
+
 class Node {
 protected:
   node_id_t id;
@@ -31,15 +58,15 @@ protected:
   Node *next;
   Node *prev;
 
-  klee::ConstraintManager constraints;
+  SharedConstraints constraints;
 
 public:
-  Node(node_id_t _id, NodeType _type, klee::ConstraintManager _constraints)
+  Node(node_id_t _id, NodeType _type, const SharedConstraints &_constraints)
       : id(_id), type(_type), next(nullptr), prev(nullptr),
         constraints(_constraints) {}
 
   Node(node_id_t _id, NodeType _type, Node *_next, Node *_prev,
-       klee::ConstraintManager _constraints)
+       const SharedConstraints &_constraints)
       : id(_id), type(_type), next(_next), prev(_prev),
         constraints(_constraints) {}
 
@@ -52,7 +79,14 @@ public:
   NodeType get_type() const { return type; }
   node_id_t get_id() const { return id; }
 
-  const klee::ConstraintManager &get_constraints() const { return constraints; }
+  const klee::ConstraintManager &get_constraints() const {
+    return constraints.get();
+  }
+
+  // For new nodes under the same constraints, which then share them.
+  const SharedConstraints &get_shared_constraints() const {
+    return constraints;
+  }
 
   std::vector<klee::ref<klee::Expr>> get_ordered_branch_constraints() const;
 
@@ -12,12 +12,12 @@ private:
   int dst_device;
 
 public:
-  Route(node_id_t _id, const klee::ConstraintManager &_constraints,
+  Route(node_id_t _id, const SharedConstraints &_constraints,
         RouteOperation _operation, int _dst_device)
       : Node(_id, NodeType::ROUTE, _constraints), operation(_operation),
         dst_device(_dst_device) {}
 
-  Route(node_id_t _id, const klee::ConstraintManager &_constraints,
+  Route(node_id_t _id, const SharedConstraints &_constraints,
         RouteOperation _operation)
       : Node(_id, NodeType::ROUTE, _constraints), operation(_operation) {
     assert(operation == RouteOperation::DROP ||
@@ -25,7 +25,7 @@ public:
   }
 
   Route(node_id_t _id, Node *_next, Node *_prev,
-        const klee::ConstraintManager &_constraints, RouteOperation _operation,
+        const SharedConstraints &_constraints, RouteOperation _operation,
         int _dst_device)
       : Node(_id, NodeType::ROUTE, _next, _prev, _constraints),
         operation(_operation), dst_device(_dst_device) {}
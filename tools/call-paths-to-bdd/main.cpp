@@ -15,6 +15,12 @@ llvm::cl::opt<std::string>
     InputBDDFile("in", llvm::cl::desc("Input file for BDD deserialization."),
                  llvm::cl::cat(BDDGeneratorCat));
 
+llvm::cl::opt<std::string> InputCallPathStream(
+    "stream",
+    llvm::cl::desc("Input call path stream (file or FIFO) written by KLEE "
+                   "with -call-path-stream."),
+    llvm::cl::cat(BDDGeneratorCat));
+
 llvm::cl::opt<std::string>
     OutputBDDFile("out", llvm::cl::desc("Output file for BDD serialization."),
                   llvm::cl::cat(BDDGeneratorCat));
@@ -72,16 +78,28 @@ void assert_bdd(const BDD &bdd) {
   std::cerr << "OK!\n";
 }
 
+BDD build_bdd() {
+  if (InputBDDFile.size()) {
+    return BDD(InputBDDFile);
+  }
+
+  if (InputCallPathStream.size()) {
+    return BDD(call_paths_t(load_call_paths_stream(InputCallPathStream)));
+  }
+
+  return BDD(call_paths_t(InputCallPathFiles));
+}
+
 int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
-  if (InputBDDFile.size() == 0 && InputCallPathFiles.size() == 0) {
+  if (InputBDDFile.size() == 0 && InputCallPathFiles.size() == 0 &&
+      InputCallPathStream.size() == 0) {
     std::cerr << "No input files provided.\n";
     return 1;
   }
 
-  BDD bdd = InputBDDFile.size() ? BDD(InputBDDFile)
-                                : BDD(call_paths_t(InputCallPathFiles));
+  BDD bdd = build_bdd();
   assert_bdd(bdd);
 
   PrinterDebug printer;
@@ -373,19 +373,20 @@ uint64_t solver_toolbox_t::value_from_expr(
   return value_expr->getZExtValue();
 }
 
-bool solver_toolbox_t::are_calls_equal(call_t c1, call_t c2) const {
+bool solver_toolbox_t::are_calls_equal(const call_t &c1,
+                                       const call_t &c2) const {
   if (c1.function_name != c2.function_name) {
     return false;
   }
 
-  for (auto arg : c1.args) {
+  for (const auto &arg : c1.args) {
     auto found = c2.args.find(arg.first);
     if (found == c2.args.end()) {
       return false;
     }
 
-    auto arg1 = arg.second;
-    auto arg2 = found->second;
+    const auto &arg1 = arg.second;
+    const auto &arg2 = found->second;
 
     auto expr1 = arg1.expr;
     auto expr2 = arg2.expr;
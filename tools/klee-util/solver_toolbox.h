@@ -102,7 +102,7 @@ struct solver_toolbox_t {
   signed_value_from_expr(klee::ref<klee::Expr> expr,
                          const klee::ConstraintManager &constraints) const;
 
-  bool are_calls_equal(call_t c1, call_t c2) const;
+  bool are_calls_equal(const call_t &c1, const call_t &c2) const;
 };
 
 extern solver_toolbox_t solver_toolbox;
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "klee/CallPathStream.h"
 #include "klee/Config/Version.h"
 #include "klee/ExecutionState.h"
 #include "klee/Expr.h"
@@ -166,6 +167,14 @@ DumpCallTraces("dump-call-traces",
                         "klee_trace_ret* intrinsic labels."),
                cl::init(false));
 
+cl::opt<std::string>
+CallPathStream("call-path-stream",
+               cl::desc("Stream call traces into the given file (or FIFO) "
+                        "as states terminate, all in a single stream, so "
+                        "that a consumer can process them while KLEE "
+                        "runs (see klee/CallPathStream.h)."),
+               cl::init(""));
+
 cl::opt<bool> CondoneUndeclaredHavocs(
     "condone-undeclared-havocs",
     cl::desc("Do not throw an error if a memory location changes "
@@ -264,6 +273,7 @@ private:
   unsigned m_pathsExplored;     // number of paths explored so far
   unsigned m_callPathIndex;     // number of call path strings dumped so far
   unsigned m_callPathPrefixIndex; // number of call path strings dumped so far
+  llvm::raw_fd_ostream *m_callPathStream;
 
   // used for writing .ktest files
   int m_argc;
@@ -303,13 +313,14 @@ public:
 
   void dumpCallPathPrefixes();
   void dumpCallPath(const ExecutionState &state, llvm::raw_ostream *file);
+  void streamCallPath(const ExecutionState &state, unsigned id);
 };
 
 KleeHandler::KleeHandler(int argc, char **argv)
     : m_interpreter(0), m_pathWriter(0), m_symPathWriter(0), m_infoFile(0),
       m_outputDirectory(), m_numTotalTests(0), m_numGeneratedTests(0),
       m_pathsExplored(0), m_callPathIndex(1), m_callPathPrefixIndex(0),
-      m_argc(argc), m_argv(argv) {
+      m_callPathStream(0), m_argc(argc), m_argv(argv) {
 
   // create output directory (OutputDir or "klee-out-<i>")
   bool dir_given = OutputDir != "";
@@ -387,6 +398,12 @@ KleeHandler::KleeHandler(int argc, char **argv)
 }
 
 KleeHandler::~KleeHandler() {
+  if (m_callPathStream) {
+    callpathstream::RecordHeader end = {0, 0};
+    m_callPathStream->write((const char *)&end, sizeof(end));
+    delete m_callPathStream;
+  }
+
   delete m_pathWriter;
   delete m_symPathWriter;
   fclose(klee_warning_file);
@@ -397,6 +414,18 @@ KleeHandler::~KleeHandler() {
 void KleeHandler::setInterpreter(Interpreter *i) {
   m_interpreter = i;
 
+  if (!CallPathStream.empty()) {
+    std::string path = CallPathStream;
+    std::string Error;
+    // Opening a FIFO blocks until the consumer opens it for reading.
+    m_callPathStream = klee_open_output_file(path, Error);
+    if (!Error.empty())
+      klee_error("unable to open call path stream \"%s\": %s", path.c_str(),
+                 Error.c_str());
+    uint32_t magic = callpathstream::Magic;
+    m_callPathStream->write((const char *)&magic, sizeof(magic));
+  }
+
   if (WritePaths) {
     m_pathWriter = new TreeStreamWriter(getOutputFilename("paths.ts"));
     assert(m_pathWriter->good());
@@ -535,6 +564,10 @@ void KleeHandler::processTestCase(const ExecutionState &state,
         delete trace_file;
       }
 
+      if (m_callPathStream && !errorMessage) {
+        streamCallPath(state, id);
+      }
+
       for (unsigned i = 0; i < b.numObjects; i++)
         delete[] b.objects[i].bytes;
       delete[] b.objects;
@@ -1021,6 +1054,20 @@ void KleeHandler::dumpCallPath(const ExecutionState &state,
   }
 }
 
+void KleeHandler::streamCallPath(const ExecutionState &state, unsigned id) {
+  std::string callPath;
+  llvm::raw_string_ostream callPathROS(callPath);
+  dumpCallPath(state, &callPathROS);
+  callPathROS.flush();
+
+  callpathstream::RecordHeader header = {id, (uint32_t)callPath.size()};
+  m_callPathStream->write((const char *)&header, sizeof(header));
+  m_callPathStream->write(callPath.data(), callPath.size());
+
+  // Hand the record over to the consumer right away.
+  m_callPathStream->flush();
+}
+
 // load a .path file
 void KleeHandler::loadPathFile(std::string name, std::vector<bool> &buffer) {
   std::ifstream f(name.c_str(), std::ios::in | std::ios::binary);
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "klee/CallPathStream.h"
 #include "klee/ExprBuilder.h"
 #include "klee/perf-contracts.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -19,6 +20,7 @@
 #include <expr/Parser.h>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
@@ -86,10 +88,8 @@ static symbol_t build_symbol(const klee::Array *array) {
   return symbol_t({base, array, expr});
 }
 
-call_path_t *load_call_path(const std::string &file_name) {
-  std::ifstream call_path_file(file_name);
-  assert(call_path_file.is_open() && "Unable to open call path file.");
-
+static call_path_t *parse_call_path(std::istream &call_path_file,
+                                    const std::string &file_name) {
   call_path_t *call_path = new call_path_t;
   call_path->file_name = file_name;
 
@@ -631,6 +631,55 @@ struct symbols_merger_t {
   }
 };
 
+call_path_t *load_call_path(const std::string &file_name) {
+  std::ifstream call_path_file(file_name);
+  assert(call_path_file.is_open() && "Unable to open call path file.");
+  return parse_call_path(call_path_file, file_name);
+}
+
+std::vector<call_path_t *>
+load_call_paths_stream(const std::string &stream_file_name) {
+  // Opening a FIFO blocks until KLEE opens it for writing.
+  std::ifstream stream(stream_file_name, std::ios::binary);
+  assert(stream.is_open() && "Unable to open call path stream.");
+
+  uint32_t magic;
+  stream.read((char *)&magic, sizeof(magic));
+  assert(stream && magic == klee::callpathstream::Magic &&
+         "Not a call path stream (missing magic signature)");
+
+  std::vector<call_path_t *> call_paths;
+  std::string record;
+
+  while (true) {
+    klee::callpathstream::RecordHeader header;
+    stream.read((char *)&header, sizeof(header));
+
+    // KLEE died without closing the stream. Keep what we have.
+    if (!stream) {
+      std::cerr << "Call path stream \"" << stream_file_name
+                << "\" ended without its end marker.\n";
+      break;
+    }
+
+    if (header.Size == 0) {
+      break;
+    }
+
+    record.resize(header.Size);
+    stream.read(&record[0], header.Size);
+    assert(stream && "Truncated call path stream record");
+
+    // Each call path is parsed as soon as it arrives, while KLEE is still
+    // exploring the remaining paths.
+    std::stringstream call_path_file(record);
+    std::string name = stream_file_name + "#" + std::to_string(header.Id);
+    call_paths.push_back(parse_call_path(call_path_file, name));
+  }
+
+  return call_paths;
+}
+
 void call_paths_t::merge_symbols() {
   symbols_merger_t merger;
 
@@ -61,6 +61,11 @@ struct call_path_t {
 
 call_path_t *load_call_path(const std::string &file_name);
 
+// Loads every call path from a call path stream written by KLEE with
+// -call-path-stream (a regular file or a FIFO).
+std::vector<call_path_t *>
+load_call_paths_stream(const std::string &stream_file_name);
+
 struct call_paths_t {
   std::vector<call_path_t *> cps;
 
@@ -72,6 +77,10 @@ struct call_paths_t {
     merge_symbols();
   }
 
+  call_paths_t(const std::vector<call_path_t *> &_cps) : cps(_cps) {
+    merge_symbols();
+  }
+
   symbols_t get_symbols() const {
     symbols_t symbols;
     for (const call_path_t *cp : cps)
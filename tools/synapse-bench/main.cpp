@@ -0,0 +1,472 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+
+#include "runtime.h"
+
+// Microbenchmarks for the data structures behind synapse's x86 modules.
+//
+// Every benchmark that measures the cost of a synapse module is labeled with
+// the module's name and reports the key size and the working set size (in the
+// same terms synapse uses when estimating the cost of a placed module), e.g.:
+//
+//   synapse-bench --benchmark_out=bench.json --benchmark_out_format=json
+//   synapse -cpu-perf bench.json ...
+//
+// synapse fits its x86 cost model to the results in bench.json.
+
+using namespace synapse::bench;
+
+#define BATCH 1024
+#define DEFAULT_SKETCH_DEPTH 4
+#define SKETCH_THRESHOLD 16
+#define SKETCH_KEY_BYTES 13
+
+static std::vector<uint8_t> random_keys(uint64_t n, uint32_t key_size) {
+  std::mt19937_64 gen(0);
+  std::vector<uint8_t> keys(n * key_size);
+
+  for (uint64_t i = 0; i < n; i++) {
+    uint8_t *key = &keys[i * key_size];
+
+    for (uint32_t b = 0; b < key_size; b++) {
+      key[b] = gen();
+    }
+
+    // Make sure every key is unique.
+    uint32_t unique_bytes = std::min<uint32_t>(key_size, sizeof(uint32_t));
+    memcpy(key, &i, unique_bytes);
+  }
+
+  return keys;
+}
+
+static std::vector<uint32_t> random_indexes(uint64_t n, uint32_t range) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<uint32_t> dist(0, range - 1);
+  std::vector<uint32_t> indexes(n);
+
+  for (uint32_t &index : indexes) {
+    index = dist(gen);
+  }
+
+  return indexes;
+}
+
+static void report(benchmark::State &state, const char *module,
+                   uint32_t key_bytes, uint64_t working_set_bytes) {
+  if (module) {
+    state.SetLabel(module);
+  }
+
+  state.counters["key_bytes"] = key_bytes;
+  state.counters["working_set_bytes"] = working_set_bytes;
+}
+
+static uint64_t map_working_set(uint64_t entries, uint32_t key_bytes) {
+  return entries * (key_bytes + sizeof(uint64_t));
+}
+
+static uint64_t dchain_working_set(uint64_t index_range) {
+  return index_range * 2 * sizeof(uint64_t);
+}
+
+static uint64_t sketch_working_set(uint64_t capacity) {
+  return capacity * sizeof(uint32_t);
+}
+
+// Args: key bytes, capacity, occupancy (%).
+static void MapArgs(benchmark::internal::Benchmark *b) {
+  for (int key_bytes : {4, 13, 32}) {
+    for (int capacity : {1 << 12, 1 << 16, 1 << 20, 1 << 21}) {
+      for (int occupancy : {50, 90}) {
+        b->Args({key_bytes, capacity, occupancy});
+      }
+    }
+  }
+}
+
+static void BM_MapGet(benchmark::State &state) {
+  uint32_t key_bytes = state.range(0);
+  uint32_t capacity = state.range(1);
+  uint32_t entries = capacity * state.range(2) / 100;
+
+  Map map(capacity, key_bytes);
+  std::vector<uint8_t> keys = random_keys(entries, key_bytes);
+
+  for (uint32_t i = 0; i < entries; i++) {
+    map.put(&keys[i * key_bytes], i);
+  }
+
+  std::vector<uint32_t> lookups = random_indexes(BATCH * 64, entries);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    int value = 0;
+    bool found = map.get(&keys[lookups[i] * key_bytes], value);
+    benchmark::DoNotOptimize(found);
+    benchmark::DoNotOptimize(value);
+    i = (i + 1) % lookups.size();
+  }
+
+  report(state, "MapGet", key_bytes, map_working_set(entries, key_bytes));
+}
+
+static void BM_MapPut(benchmark::State &state) {
+  uint32_t key_bytes = state.range(0);
+  uint32_t capacity = state.range(1);
+  uint32_t entries = capacity * state.range(2) / 100;
+  uint32_t batch = std::min<uint32_t>(BATCH, capacity - entries);
+
+  Map map(capacity, key_bytes);
+  std::vector<uint8_t> keys = random_keys(entries + batch, key_bytes);
+
+  for (uint32_t i = 0; i < entries; i++) {
+    map.put(&keys[i * key_bytes], i);
+  }
+
+  uint32_t i = 0;
+
+  for (auto _ : state) {
+    map.put(&keys[(entries + i) * key_bytes], i);
+
+    if (++i == batch) {
+      state.PauseTiming();
+      for (uint32_t j = 0; j < batch; j++) {
+        map.erase(&keys[(entries + j) * key_bytes]);
+      }
+      i = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  report(state, "MapPut", key_bytes, map_working_set(entries, key_bytes));
+}
+
+static void BM_MapErase(benchmark::State &state) {
+  uint32_t key_bytes = state.range(0);
+  uint32_t capacity = state.range(1);
+  uint32_t entries = capacity * state.range(2) / 100;
+  uint32_t batch = std::min<uint32_t>(BATCH, capacity - entries);
+
+  Map map(capacity, key_bytes);
+  std::vector<uint8_t> keys = random_keys(entries + batch, key_bytes);
+
+  for (uint32_t i = 0; i < entries + batch; i++) {
+    map.put(&keys[i * key_bytes], i);
+  }
+
+  uint32_t i = 0;
+
+  for (auto _ : state) {
+    map.erase(&keys[(entries + i) * key_bytes]);
+
+    if (++i == batch) {
+      state.PauseTiming();
+      for (uint32_t j = 0; j < batch; j++) {
+        map.put(&keys[(entries + j) * key_bytes], j);
+      }
+      i = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  report(state, "MapErase", key_bytes, map_working_set(entries, key_bytes));
+}
+
+// Args: index range.
+static void DchainArgs(benchmark::internal::Benchmark *b) {
+  for (int index_range : {1 << 12, 1 << 16, 1 << 20, 1 << 23}) {
+    b->Args({index_range});
+  }
+}
+
+static void BM_DchainAllocateNewIndex(benchmark::State &state) {
+  uint32_t index_range = state.range(0);
+  uint32_t batch = std::min<uint32_t>(BATCH, index_range);
+
+  Dchain dchain(index_range);
+  std::vector<uint32_t> allocated(batch);
+  time_ns_t time = 0;
+  uint32_t i = 0;
+
+  for (auto _ : state) {
+    bool success = dchain.allocate_new_index(allocated[i], time++);
+    benchmark::DoNotOptimize(success);
+
+    if (++i == batch) {
+      state.PauseTiming();
+      for (uint32_t index : allocated) {
+        dchain.free_index(index);
+      }
+      i = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  report(state, "DchainAllocateNewIndex", 0, dchain_working_set(index_range));
+}
+
+static void BM_DchainRejuvenateIndex(benchmark::State &state) {
+  uint32_t index_range = state.range(0);
+
+  Dchain dchain(index_range);
+  time_ns_t time = 0;
+
+  for (uint32_t i = 0; i < index_range; i++) {
+    uint32_t index;
+    dchain.allocate_new_index(index, time++);
+  }
+
+  std::vector<uint32_t> indexes = random_indexes(BATCH * 64, index_range);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    bool success = dchain.rejuvenate_index(indexes[i], time++);
+    benchmark::DoNotOptimize(success);
+    i = (i + 1) % indexes.size();
+  }
+
+  report(state, "DchainRejuvenateIndex", 0, dchain_working_set(index_range));
+}
+
+static void BM_DchainIsIndexAllocated(benchmark::State &state) {
+  uint32_t index_range = state.range(0);
+
+  Dchain dchain(index_range);
+
+  for (uint32_t i = 0; i < index_range / 2; i++) {
+    uint32_t index;
+    dchain.allocate_new_index(index, i);
+  }
+
+  std::vector<uint32_t> indexes = random_indexes(BATCH * 64, index_range);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    bool allocated = dchain.is_index_allocated(indexes[i]);
+    benchmark::DoNotOptimize(allocated);
+    i = (i + 1) % indexes.size();
+  }
+
+  report(state, "DchainIsIndexAllocated", 0, dchain_working_set(index_range));
+}
+
+static void BM_DchainFreeIndex(benchmark::State &state) {
+  uint32_t index_range = state.range(0);
+  uint32_t batch = std::min<uint32_t>(BATCH, index_range);
+
+  Dchain dchain(index_range);
+  std::vector<uint32_t> allocated(batch);
+  time_ns_t time = 0;
+
+  for (uint32_t &index : allocated) {
+    dchain.allocate_new_index(index, time++);
+  }
+
+  uint32_t i = 0;
+
+  for (auto _ : state) {
+    bool success = dchain.free_index(allocated[i]);
+    benchmark::DoNotOptimize(success);
+
+    if (++i == batch) {
+      state.PauseTiming();
+      for (uint32_t &index : allocated) {
+        dchain.allocate_new_index(index, time++);
+      }
+      i = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  report(state, "DchainFreeIndex", 0, dchain_working_set(index_range));
+}
+
+// Steady state of an NF that keeps a flow table: every packet expires the
+// flows that timed out, allocates an index for a new flow and rejuvenates an
+// existing one.
+static void BM_DchainChurn(benchmark::State &state) {
+  uint32_t index_range = state.range(0);
+  time_ns_t timeout = index_range / 2;
+
+  Dchain dchain(index_range);
+  std::vector<uint32_t> indexes = random_indexes(BATCH * 64, index_range);
+  time_ns_t time = timeout;
+  size_t i = 0;
+
+  for (auto _ : state) {
+    uint32_t index;
+
+    while (dchain.expire_one_index(index, time - timeout)) {
+    }
+
+    dchain.allocate_new_index(index, time);
+    dchain.rejuvenate_index(indexes[i], time);
+
+    i = (i + 1) % indexes.size();
+    time++;
+  }
+
+  report(state, nullptr, 0, dchain_working_set(index_range));
+}
+
+// Args: capacity (width of each row), depth.
+static void SketchArgs(benchmark::internal::Benchmark *b) {
+  for (int capacity : {1 << 10, 1 << 14, 1 << 18}) {
+    for (int depth : {2, DEFAULT_SKETCH_DEPTH, 8}) {
+      b->Args({capacity, depth});
+    }
+  }
+}
+
+// Sketch benchmarks only stand for the synapse modules when using the default
+// depth, as synapse does not model the number of rows.
+static const char *sketch_module(benchmark::State &state, const char *module) {
+  return state.range(1) == DEFAULT_SKETCH_DEPTH ? module : nullptr;
+}
+
+static void BM_SketchComputeHashes(benchmark::State &state) {
+  uint32_t key_bytes = state.range(0);
+  uint32_t depth = state.range(1);
+
+  Sketch sketch(1 << 10, depth, key_bytes, SKETCH_THRESHOLD);
+  std::vector<uint8_t> keys = random_keys(BATCH, key_bytes);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    sketch.compute_hashes(&keys[i * key_bytes]);
+    i = (i + 1) % BATCH;
+  }
+
+  report(state, sketch_module(state, "SketchComputeHashes"), key_bytes, 0);
+}
+
+static void BM_SketchTouchBuckets(benchmark::State &state) {
+  uint32_t capacity = state.range(0);
+  uint32_t depth = state.range(1);
+
+  Sketch sketch(capacity, depth, SKETCH_KEY_BYTES, SKETCH_THRESHOLD);
+  std::vector<uint8_t> keys = random_keys(capacity / 2, SKETCH_KEY_BYTES);
+  time_ns_t time = 0;
+  size_t i = 0;
+
+  for (auto _ : state) {
+    sketch.compute_hashes(&keys[i * SKETCH_KEY_BYTES]);
+    bool success = sketch.touch_buckets(time++);
+    benchmark::DoNotOptimize(success);
+    i = (i + 1) % (capacity / 2);
+  }
+
+  report(state, sketch_module(state, "SketchTouchBuckets"), SKETCH_KEY_BYTES,
+         sketch_working_set(capacity));
+}
+
+static void BM_SketchFetch(benchmark::State &state) {
+  uint32_t capacity = state.range(0);
+  uint32_t depth = state.range(1);
+
+  Sketch sketch(capacity, depth, SKETCH_KEY_BYTES, SKETCH_THRESHOLD);
+  std::vector<uint8_t> keys = random_keys(capacity / 2, SKETCH_KEY_BYTES);
+
+  for (uint32_t i = 0; i < capacity / 2; i++) {
+    sketch.compute_hashes(&keys[i * SKETCH_KEY_BYTES]);
+    sketch.touch_buckets(0);
+  }
+
+  size_t i = 0;
+
+  for (auto _ : state) {
+    sketch.compute_hashes(&keys[i * SKETCH_KEY_BYTES]);
+    bool overflow = sketch.fetch();
+    benchmark::DoNotOptimize(overflow);
+    i = (i + 1) % (capacity / 2);
+  }
+
+  report(state, sketch_module(state, "SketchFetch"), SKETCH_KEY_BYTES,
+         sketch_working_set(capacity));
+}
+
+static void BM_SketchRefresh(benchmark::State &state) {
+  uint32_t capacity = state.range(0);
+  uint32_t depth = state.range(1);
+
+  Sketch sketch(capacity, depth, SKETCH_KEY_BYTES, SKETCH_THRESHOLD);
+  std::vector<uint8_t> keys = random_keys(capacity / 2, SKETCH_KEY_BYTES);
+  time_ns_t time = 0;
+
+  for (uint32_t i = 0; i < capacity / 2; i++) {
+    sketch.compute_hashes(&keys[i * SKETCH_KEY_BYTES]);
+    sketch.touch_buckets(time++);
+  }
+
+  size_t i = 0;
+
+  for (auto _ : state) {
+    sketch.compute_hashes(&keys[i * SKETCH_KEY_BYTES]);
+    sketch.refresh(time++);
+    i = (i + 1) % (capacity / 2);
+  }
+
+  report(state, sketch_module(state, "SketchRefresh"), SKETCH_KEY_BYTES,
+         sketch_working_set(capacity));
+}
+
+static void BM_SketchExpire(benchmark::State &state) {
+  uint32_t capacity = state.range(0);
+  uint32_t depth = state.range(1);
+  uint32_t batch = std::min<uint32_t>(BATCH, capacity / 2);
+
+  Sketch sketch(capacity, depth, SKETCH_KEY_BYTES, SKETCH_THRESHOLD);
+  std::vector<uint8_t> keys = random_keys(capacity, SKETCH_KEY_BYTES);
+  time_ns_t time = 0;
+  uint32_t next_key = 0;
+
+  auto touch_batch = [&]() {
+    for (uint32_t j = 0; j < batch; j++) {
+      sketch.compute_hashes(&keys[next_key * SKETCH_KEY_BYTES]);
+      sketch.touch_buckets(time++);
+      next_key = (next_key + 1) % capacity;
+    }
+  };
+
+  touch_batch();
+
+  time_ns_t expired = 0;
+  uint32_t i = 0;
+
+  for (auto _ : state) {
+    int freed = sketch.expire(++expired);
+    benchmark::DoNotOptimize(freed);
+
+    if (++i == batch) {
+      state.PauseTiming();
+      touch_batch();
+      i = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  report(state, sketch_module(state, "SketchExpire"), SKETCH_KEY_BYTES,
+         sketch_working_set(capacity));
+}
+
+BENCHMARK(BM_MapGet)->Apply(MapArgs);
+BENCHMARK(BM_MapPut)->Apply(MapArgs);
+BENCHMARK(BM_MapErase)->Apply(MapArgs);
+
+BENCHMARK(BM_DchainAllocateNewIndex)->Apply(DchainArgs);
+BENCHMARK(BM_DchainRejuvenateIndex)->Apply(DchainArgs);
+BENCHMARK(BM_DchainIsIndexAllocated)->Apply(DchainArgs);
+BENCHMARK(BM_DchainFreeIndex)->Apply(DchainArgs);
+BENCHMARK(BM_DchainChurn)->Apply(DchainArgs);
+
+BENCHMARK(BM_SketchComputeHashes)
+    ->ArgsProduct({{4, 13, 32}, {2, DEFAULT_SKETCH_DEPTH, 8}});
+BENCHMARK(BM_SketchTouchBuckets)->Apply(SketchArgs);
+BENCHMARK(BM_SketchFetch)->Apply(SketchArgs);
+BENCHMARK(BM_SketchRefresh)->Apply(SketchArgs);
+BENCHMARK(BM_SketchExpire)->Apply(SketchArgs);
+
+BENCHMARK_MAIN();
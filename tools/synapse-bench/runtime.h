@@ -0,0 +1,381 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+// Ports of the data structures used by the NFs synapse generates for x86
+// (the Vigor libvig map, double chain and count-min sketch). They keep the
+// same memory layout and probing logic, so that their costs can be measured
+// without linking against DPDK.
+
+namespace synapse {
+namespace bench {
+
+typedef uint64_t time_ns_t;
+
+inline uint32_t hash_key(const uint8_t *key, uint32_t key_size,
+                         uint32_t salt = 0) {
+  uint64_t hash = 0xcbf29ce484222325ull ^ salt;
+
+  for (uint32_t i = 0; i < key_size; i++) {
+    hash ^= key[i];
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash ^ (hash >> 32);
+}
+
+// Open addressing hash table with linear probing. Each bucket keeps a chain
+// counter with the number of keys whose probing went past it, which bounds
+// unsuccessful lookups.
+class Map {
+private:
+  uint32_t capacity;
+  uint32_t key_size;
+
+  std::vector<uint8_t> busybits;
+  std::vector<uint8_t> keys;
+  std::vector<uint32_t> hashes;
+  std::vector<uint32_t> chains;
+  std::vector<int> values;
+  uint32_t size;
+
+public:
+  // The capacity must be a power of 2.
+  Map(uint32_t _capacity, uint32_t _key_size)
+      : capacity(_capacity), key_size(_key_size), busybits(_capacity, 0),
+        keys(_capacity * _key_size), hashes(_capacity, 0),
+        chains(_capacity, 0), values(_capacity, 0), size(0) {
+    assert((capacity & (capacity - 1)) == 0);
+  }
+
+  uint32_t get_size() const { return size; }
+
+  bool get(const uint8_t *key, int &value_out) const {
+    uint32_t hash = hash_key(key, key_size);
+    int index = find_key(key, hash);
+
+    if (index < 0) {
+      return false;
+    }
+
+    value_out = values[index];
+    return true;
+  }
+
+  void put(const uint8_t *key, int value) {
+    assert(size < capacity);
+
+    uint32_t hash = hash_key(key, key_size);
+    uint32_t start = loop(hash);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+      uint32_t index = loop(start + i);
+
+      if (!busybits[index]) {
+        busybits[index] = 1;
+        memcpy(&keys[index * key_size], key, key_size);
+        hashes[index] = hash;
+        values[index] = value;
+        size++;
+        return;
+      }
+
+      chains[index]++;
+    }
+
+    assert(false && "Map is full");
+  }
+
+  void erase(const uint8_t *key) {
+    uint32_t hash = hash_key(key, key_size);
+    uint32_t start = loop(hash);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+      uint32_t index = loop(start + i);
+
+      if (busybits[index] && hashes[index] == hash &&
+          memcmp(&keys[index * key_size], key, key_size) == 0) {
+        busybits[index] = 0;
+        size--;
+        return;
+      }
+
+      assert(chains[index] > 0);
+      chains[index]--;
+    }
+
+    assert(false && "Key not found");
+  }
+
+private:
+  uint32_t loop(uint32_t k) const { return k & (capacity - 1); }
+
+  int find_key(const uint8_t *key, uint32_t hash) const {
+    uint32_t start = loop(hash);
+
+    for (uint32_t i = 0; i < capacity; i++) {
+      uint32_t index = loop(start + i);
+
+      if (busybits[index] && hashes[index] == hash &&
+          memcmp(&keys[index * key_size], key, key_size) == 0) {
+        return index;
+      }
+
+      if (chains[index] == 0) {
+        return -1;
+      }
+    }
+
+    return -1;
+  }
+};
+
+// Index allocator keeping the allocated indexes sorted by the time they were
+// last rejuvenated, so that the oldest ones can be expired in constant time.
+class Dchain {
+private:
+  enum { ALLOC_LIST_HEAD = 0, FREE_LIST_HEAD = 1, INDEX_SHIFT = 2 };
+
+  struct cell_t {
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  std::vector<cell_t> cells;
+  std::vector<time_ns_t> timestamps;
+
+public:
+  Dchain(uint32_t index_range)
+      : cells(index_range + INDEX_SHIFT), timestamps(index_range, 0) {
+    cell_t &al_head = cells[ALLOC_LIST_HEAD];
+    al_head.prev = 0;
+    al_head.next = 0;
+
+    uint32_t i = INDEX_SHIFT;
+
+    cell_t &fl_head = cells[FREE_LIST_HEAD];
+    fl_head.next = i;
+    fl_head.prev = fl_head.next;
+
+    while (i < (index_range + INDEX_SHIFT - 1)) {
+      cells[i].next = i + 1;
+      cells[i].prev = cells[i].next;
+      i++;
+    }
+
+    cells[i].next = FREE_LIST_HEAD;
+    cells[i].prev = cells[i].next;
+  }
+
+  bool allocate_new_index(uint32_t &index_out, time_ns_t time) {
+    cell_t &fl_head = cells[FREE_LIST_HEAD];
+    cell_t &al_head = cells[ALLOC_LIST_HEAD];
+    uint32_t allocated = fl_head.next;
+
+    if (allocated == FREE_LIST_HEAD) {
+      return false;
+    }
+
+    cell_t &allocp = cells[allocated];
+    fl_head.next = allocp.next;
+    fl_head.prev = fl_head.next;
+
+    allocp.next = ALLOC_LIST_HEAD;
+    allocp.prev = al_head.prev;
+
+    cells[al_head.prev].next = allocated;
+    al_head.prev = allocated;
+
+    index_out = allocated - INDEX_SHIFT;
+    timestamps[index_out] = time;
+
+    return true;
+  }
+
+  bool rejuvenate_index(uint32_t index, time_ns_t time) {
+    uint32_t lifted = index + INDEX_SHIFT;
+    cell_t &liftedp = cells[lifted];
+
+    if (liftedp.next == liftedp.prev) {
+      if (liftedp.next != ALLOC_LIST_HEAD) {
+        return false;
+      }
+
+      timestamps[index] = time;
+      return true;
+    }
+
+    cells[liftedp.prev].next = liftedp.next;
+    cells[liftedp.next].prev = liftedp.prev;
+
+    cell_t &al_head = cells[ALLOC_LIST_HEAD];
+    uint32_t al_head_prev = al_head.prev;
+
+    liftedp.next = ALLOC_LIST_HEAD;
+    liftedp.prev = al_head_prev;
+
+    cells[al_head_prev].next = lifted;
+    al_head.prev = lifted;
+
+    timestamps[index] = time;
+    return true;
+  }
+
+  bool is_index_allocated(uint32_t index) const {
+    const cell_t &liftedp = cells[index + INDEX_SHIFT];
+    return liftedp.next != liftedp.prev || liftedp.next == ALLOC_LIST_HEAD;
+  }
+
+  bool free_index(uint32_t index) {
+    uint32_t freed = index + INDEX_SHIFT;
+    cell_t &freedp = cells[freed];
+
+    if (freedp.next == freedp.prev && freedp.prev != ALLOC_LIST_HEAD) {
+      return false;
+    }
+
+    cells[freedp.prev].next = freedp.next;
+    cells[freedp.next].prev = freedp.prev;
+
+    cell_t &fr_head = cells[FREE_LIST_HEAD];
+    freedp.next = fr_head.next;
+    freedp.prev = freedp.next;
+
+    fr_head.next = freed;
+    fr_head.prev = fr_head.next;
+
+    return true;
+  }
+
+  // Frees the oldest index, if it was last rejuvenated before the given time.
+  bool expire_one_index(uint32_t &index_out, time_ns_t time) {
+    cell_t &al_head = cells[ALLOC_LIST_HEAD];
+
+    if (al_head.next == ALLOC_LIST_HEAD) {
+      return false;
+    }
+
+    index_out = al_head.next - INDEX_SHIFT;
+
+    if (timestamps[index_out] >= time) {
+      return false;
+    }
+
+    return free_index(index_out);
+  }
+};
+
+// Count-min sketch. Each row keeps its buckets' counters in a map from bucket
+// to a dchain index, so that buckets can be expired individually.
+class Sketch {
+private:
+  uint32_t capacity;
+  uint32_t depth;
+  uint32_t key_size;
+  uint32_t threshold;
+
+  struct row_t {
+    Map buckets;
+    Dchain allocator;
+    std::vector<uint32_t> counters;
+    std::vector<uint32_t> bucket_of_index;
+
+    row_t(uint32_t capacity)
+        : buckets(capacity, sizeof(uint32_t)), allocator(capacity),
+          counters(capacity, 0), bucket_of_index(capacity, 0) {}
+  };
+
+  std::vector<row_t> rows;
+  std::vector<uint32_t> hashes;
+
+public:
+  // The capacity (the width of each row) must be a power of 2.
+  Sketch(uint32_t _capacity, uint32_t _depth, uint32_t _key_size,
+         uint32_t _threshold)
+      : capacity(_capacity), depth(_depth), key_size(_key_size),
+        threshold(_threshold), rows(_depth, row_t(_capacity)),
+        hashes(_depth, 0) {}
+
+  void compute_hashes(const uint8_t *key) {
+    for (uint32_t i = 0; i < depth; i++) {
+      hashes[i] = hash_key(key, key_size, i + 1) & (capacity - 1);
+    }
+  }
+
+  void refresh(time_ns_t time) {
+    for (uint32_t i = 0; i < depth; i++) {
+      row_t &row = rows[i];
+      int index;
+
+      if (row.buckets.get((const uint8_t *)&hashes[i], index)) {
+        row.allocator.rejuvenate_index(index, time);
+      }
+    }
+  }
+
+  bool fetch() const {
+    uint32_t min_value = UINT32_MAX;
+
+    for (uint32_t i = 0; i < depth; i++) {
+      const row_t &row = rows[i];
+      int index;
+      uint32_t value = 0;
+
+      if (row.buckets.get((const uint8_t *)&hashes[i], index)) {
+        value = row.counters[index];
+      }
+
+      min_value = value < min_value ? value : min_value;
+    }
+
+    return min_value > threshold;
+  }
+
+  bool touch_buckets(time_ns_t time) {
+    for (uint32_t i = 0; i < depth; i++) {
+      row_t &row = rows[i];
+      int index;
+
+      if (row.buckets.get((const uint8_t *)&hashes[i], index)) {
+        row.allocator.rejuvenate_index(index, time);
+        row.counters[index]++;
+        continue;
+      }
+
+      uint32_t new_index;
+      if (!row.allocator.allocate_new_index(new_index, time)) {
+        return false;
+      }
+
+      row.buckets.put((const uint8_t *)&hashes[i], new_index);
+      row.counters[new_index] = 1;
+      row.bucket_of_index[new_index] = hashes[i];
+    }
+
+    return true;
+  }
+
+  int expire(time_ns_t time) {
+    int freed = 0;
+
+    for (uint32_t i = 0; i < depth; i++) {
+      row_t &row = rows[i];
+      uint32_t index;
+
+      while (row.allocator.expire_one_index(index, time)) {
+        row.buckets.erase((const uint8_t *)&row.bucket_of_index[index]);
+        row.counters[index] = 0;
+        freed++;
+      }
+    }
+
+    return freed;
+  }
+};
+
+} // namespace bench
+} // namespace synapse
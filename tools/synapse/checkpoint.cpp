@@ -0,0 +1,169 @@
+#include "checkpoint.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace synapse {
+
+static const char MAGIC[] = "SYNAPSE-CHECKPOINT";
+static const uint32_t VERSION = 1;
+
+template <typename T> static void write(std::ostream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void write(std::ostream &out, const std::string &str) {
+  write<uint64_t>(out, str.size());
+  out.write(str.data(), str.size());
+}
+
+template <typename T> static T read(std::istream &in) {
+  T value;
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return value;
+}
+
+static std::string read_string(std::istream &in) {
+  std::string str(read<uint64_t>(in), '\0');
+  in.read(str.data(), str.size());
+  return str;
+}
+
+static void abort_load(const std::string &file, const std::string &reason) {
+  Log::err() << "Unable to resume from " << file << ": " << reason << "\n";
+  exit(1);
+}
+
+void checkpoint_t::save(const std::string &file) const {
+  std::string tmp_file = file + ".tmp";
+  std::ofstream out(tmp_file, std::ios::binary);
+
+  if (!out.is_open()) {
+    Log::err() << "Unable to write checkpoint to " << tmp_file << "\n";
+    exit(1);
+  }
+
+  out.write(MAGIC, sizeof(MAGIC));
+  write<uint32_t>(out, VERSION);
+
+  write(out, bdd_hash);
+  write<uint32_t>(out, seed);
+  write(out, random_state);
+
+  write<int64_t>(out, elapsed_time);
+  write<uint64_t>(out, steps);
+  write<uint64_t>(out, backtracks);
+  write<uint64_t>(out, avg_bdd_size);
+  write<uint64_t>(out, generated);
+  write<uint64_t>(out, duplicates);
+  write<uint64_t>(out, pruned);
+
+  write<uint64_t>(out, visits_per_node.size());
+  for (const auto &[node_id, visits] : visits_per_node) {
+    write<uint64_t>(out, node_id);
+    write<int32_t>(out, visits);
+  }
+
+  write<uint64_t>(out, avg_children_per_node.size());
+  for (const auto &[node_id, avg_children] : avg_children_per_node) {
+    write<uint64_t>(out, node_id);
+    write<float>(out, avg_children);
+  }
+
+  write<uint64_t>(out, seen_eps.size());
+  for (size_t ep_hash : seen_eps) {
+    write<uint64_t>(out, ep_hash);
+  }
+
+  write<uint64_t>(out, frontier.size());
+  for (const checkpoint_ep_t &ep : frontier) {
+    write<int64_t>(out, ep.random_number);
+    write<uint32_t>(out, ep.path.size());
+    for (const ep_decision_t &decision : ep.path) {
+      write<uint32_t>(out, decision.modgen);
+      write<uint32_t>(out, decision.product);
+    }
+  }
+
+  out.close();
+
+  if (out.fail() || std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+    Log::err() << "Unable to write checkpoint to " << file << "\n";
+    exit(1);
+  }
+}
+
+checkpoint_t checkpoint_t::load(const std::string &file) {
+  std::ifstream in(file, std::ios::binary);
+
+  if (!in.is_open()) {
+    abort_load(file, "file not found");
+  }
+
+  char magic[sizeof(MAGIC)];
+  in.read(magic, sizeof(MAGIC));
+  if (in.fail() || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    abort_load(file, "not a checkpoint");
+  }
+
+  if (read<uint32_t>(in) != VERSION) {
+    abort_load(file, "unsupported version");
+  }
+
+  checkpoint_t checkpoint;
+
+  checkpoint.bdd_hash = read_string(in);
+  checkpoint.seed = read<uint32_t>(in);
+  checkpoint.random_state = read_string(in);
+
+  checkpoint.elapsed_time = read<int64_t>(in);
+  checkpoint.steps = read<uint64_t>(in);
+  checkpoint.backtracks = read<uint64_t>(in);
+  checkpoint.avg_bdd_size = read<uint64_t>(in);
+  checkpoint.generated = read<uint64_t>(in);
+  checkpoint.duplicates = read<uint64_t>(in);
+  checkpoint.pruned = read<uint64_t>(in);
+
+  uint64_t total_visits = read<uint64_t>(in);
+  for (uint64_t i = 0; i < total_visits && !in.fail(); i++) {
+    bdd::node_id_t node_id = read<uint64_t>(in);
+    checkpoint.visits_per_node[node_id] = read<int32_t>(in);
+  }
+
+  uint64_t total_avg_children = read<uint64_t>(in);
+  for (uint64_t i = 0; i < total_avg_children && !in.fail(); i++) {
+    bdd::node_id_t node_id = read<uint64_t>(in);
+    checkpoint.avg_children_per_node[node_id] = read<float>(in);
+  }
+
+  uint64_t total_seen_eps = read<uint64_t>(in);
+  for (uint64_t i = 0; i < total_seen_eps && !in.fail(); i++) {
+    checkpoint.seen_eps.push_back(read<uint64_t>(in));
+  }
+
+  uint64_t total_frontier = read<uint64_t>(in);
+  for (uint64_t i = 0; i < total_frontier && !in.fail(); i++) {
+    checkpoint_ep_t ep;
+    ep.random_number = read<int64_t>(in);
+
+    uint32_t path_size = read<uint32_t>(in);
+    for (uint32_t j = 0; j < path_size && !in.fail(); j++) {
+      ep_decision_t decision;
+      decision.modgen = read<uint32_t>(in);
+      decision.product = read<uint32_t>(in);
+      ep.path.push_back(decision);
+    }
+
+    checkpoint.frontier.push_back(ep);
+  }
+
+  if (in.fail()) {
+    abort_load(file, "truncated file");
+  }
+
+  return checkpoint;
+}
+
+} // namespace synapse
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "call-paths-to-bdd.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace synapse {
+
+struct checkpoint_cfg_t {
+  // Empty if the search is not checkpointed.
+  std::string file;
+
+  // Seconds between checkpoints.
+  time_t interval;
+
+  // Start from the checkpoint found on the file, instead of from scratch.
+  bool resume;
+};
+
+// A step from an EP to one of its children: the module generator applied
+// (indexed over the generators of every target, in order) and which of its
+// products was kept.
+struct ep_decision_t {
+  uint32_t modgen;
+  uint32_t product;
+};
+
+typedef std::vector<ep_decision_t> ep_path_t;
+
+// EPs are not stored, as they hold expressions, BDDs and the state of every
+// target. Instead, we store the decisions that lead to them from the initial
+// EP, and replay them when resuming. Module generators are deterministic, so
+// this rebuilds the same EPs.
+struct checkpoint_ep_t {
+  ep_path_t path;
+  int64_t random_number;
+};
+
+struct checkpoint_t {
+  // Used to refuse resuming with a different input.
+  std::string bdd_hash;
+  unsigned seed;
+  std::string random_state;
+
+  time_t elapsed_time;
+  uint64_t steps;
+  uint64_t backtracks;
+  uint64_t avg_bdd_size;
+  uint64_t generated;
+  uint64_t duplicates;
+  uint64_t pruned;
+  std::unordered_map<bdd::node_id_t, int> visits_per_node;
+  std::unordered_map<bdd::node_id_t, float> avg_children_per_node;
+
+  // Transposition table.
+  std::vector<size_t> seen_eps;
+
+  // In the order the heuristic keeps them.
+  std::vector<checkpoint_ep_t> frontier;
+
+  // The file is replaced atomically, so that being interrupted while saving
+  // never loses the previous checkpoint.
+  void save(const std::string &file) const;
+  static checkpoint_t load(const std::string &file);
+};
+
+} // namespace synapse
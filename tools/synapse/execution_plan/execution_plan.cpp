@@ -4,11 +4,31 @@
 #include "../targets/targets.h"
 #include "../profiler.h"
 #include "../log.h"
+#include "../instrumentation.h"
+
+#include <algorithm>
 
 namespace synapse {
 
 static ep_id_t counter = 0;
 
+static const std::string CLONE_PHASE = "clone";
+
+// Called first thing on the copy constructor, so that the phase also covers
+// the copy of the members.
+static ep_id_t start_cloning() {
+  if (Instrumentation::is_enabled()) {
+    Instrumentation::push_phase(CLONE_PHASE);
+  }
+  return counter++;
+}
+
+static void finish_cloning() {
+  if (Instrumentation::is_enabled()) {
+    Instrumentation::pop_phase();
+  }
+}
+
 static std::unordered_set<TargetType>
 get_target_types(const targets_t &targets) {
   assert(targets.size());
@@ -41,6 +61,8 @@ EP::EP(std::shared_ptr<const bdd::BDD> _bdd, const targets_t &_targets,
   }
 
   leaves.emplace_back(nullptr, bdd->get_root());
+
+  Instrumentation::count_allocation(AllocationKind::EP);
 }
 
 static std::set<ep_id_t> update_ancestors(const EP &other, bool is_ancestor) {
@@ -54,14 +76,17 @@ static std::set<ep_id_t> update_ancestors(const EP &other, bool is_ancestor) {
 }
 
 EP::EP(const EP &other, bool is_ancestor)
-    : id(counter++), bdd(other.bdd),
+    : id(start_cloning()), bdd(other.bdd),
       root(other.root ? other.root->clone(true) : nullptr),
       initial_target(other.initial_target), targets(other.targets),
       ancestors(update_ancestors(other, is_ancestor)),
       targets_roots(other.targets_roots), ctx(other.ctx), meta(other.meta) {
+  Instrumentation::count_allocation(AllocationKind::EP);
+
   if (!root) {
     assert(other.leaves.size() == 1);
     leaves.emplace_back(nullptr, bdd->get_root());
+    finish_cloning();
     return;
   }
 
@@ -71,6 +96,8 @@ EP::EP(const EP &other, bool is_ancestor)
     assert(leaf_node && "Leaf node not found in the cloned tree.");
     leaves.emplace_back(leaf_node, leaf.next);
   }
+
+  finish_cloning();
 }
 
 EP::~EP() {
@@ -78,6 +105,8 @@ EP::~EP() {
     delete root;
     root = nullptr;
   }
+
+  Instrumentation::count_deallocation(AllocationKind::EP);
 }
 
 const EPMeta &EP::get_meta() const { return meta; }
@@ -149,6 +178,8 @@ const Context &EP::get_ctx() const { return ctx; }
 
 Context &EP::get_mutable_ctx() { return ctx; }
 
+EPMeta &EP::get_mutable_meta() { return meta; }
+
 const bdd::Node *EP::get_next_node() const {
   const EPLeaf *active_leaf = get_active_leaf();
 
@@ -212,6 +243,7 @@ void EP::process_leaf(EPNode *new_node, const std::vector<EPLeaf> &new_leaves,
   }
 
   ctx.update_traffic_fractions(new_node);
+  ctx.add_module_cost(new_node);
   meta.update(active_leaf, new_node, process_node);
 
   meta.depth++;
@@ -439,4 +471,60 @@ uint64_t EP::speculate_throughput_pps() const {
   return ctx.get_throughput_speculation_pps();
 }
 
+uint64_t EP::bound_throughput_pps() const {
+  return ctx.get_throughput_bound_pps();
+}
+
+size_t EP::hash() const {
+  std::vector<std::pair<bdd::node_id_t, size_t>> modules;
+  std::vector<bdd::node_id_t> processed(meta.processed_nodes.begin(),
+                                        meta.processed_nodes.end());
+  std::vector<std::pair<bdd::node_id_t, TargetType>> next;
+
+  if (root) {
+    root->visit_nodes([&modules](const EPNode *ep_node) {
+      const Module *module = ep_node->get_module();
+      const bdd::Node *node = module->get_node();
+      if (node) {
+        modules.emplace_back(node->get_id(), module->hash());
+      }
+      return EPNodeVisitAction::VISIT_CHILDREN;
+    });
+  }
+
+  for (const EPLeaf &leaf : leaves) {
+    if (!leaf.next) {
+      continue;
+    }
+
+    TargetType target = leaf.node ? leaf.node->get_module()->get_next_target()
+                                  : initial_target;
+    next.emplace_back(leaf.next->get_id(), target);
+  }
+
+  std::sort(modules.begin(), modules.end());
+  std::sort(processed.begin(), processed.end());
+  std::sort(next.begin(), next.end());
+
+  size_t seed = std::hash<std::string>{}(bdd->hash());
+
+  for (const auto &[node_id, module_hash] : modules) {
+    hash_combine(seed, node_id);
+    hash_combine(seed, module_hash);
+  }
+
+  for (bdd::node_id_t node_id : processed) {
+    hash_combine(seed, node_id);
+  }
+
+  for (const auto &[node_id, target] : next) {
+    hash_combine(seed, node_id);
+    hash_combine(seed, static_cast<size_t>(target));
+  }
+
+  hash_combine(seed, ctx.hash());
+
+  return seed;
+}
+
 } // namespace synapse
\ No newline at end of file
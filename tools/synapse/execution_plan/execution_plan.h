@@ -76,6 +76,7 @@ public:
 
   EPNode *get_mutable_root();
   Context &get_mutable_ctx();
+  EPMeta &get_mutable_meta();
   EPNode *get_mutable_node_by_id(ep_node_id_t id);
 
   std::vector<const EPNode *> get_prev_nodes() const;
@@ -110,6 +111,16 @@ public:
   uint64_t estimate_throughput_pps() const;
   uint64_t speculate_throughput_pps() const;
 
+  // No EP derived from this one can be estimated above it.
+  uint64_t bound_throughput_pps() const;
+
+  // Canonical fingerprint, independent of the order in which the modules
+  // were generated. EPs with the same BDD, the same modules (parameters
+  // included, see Module::hash) on the same BDD nodes, the same leaves and
+  // the same context hash equally. Different EPs only hash equally on a
+  // 64-bit collision.
+  size_t hash() const;
+
   void visit(EPVisitor &visitor) const;
 
   void log_debug_placements() const;
@@ -3,15 +3,20 @@
 #include "../targets/targets.h"
 #include "../targets/module.h"
 #include "../log.h"
+#include "../instrumentation.h"
 
 namespace synapse {
 
 static ep_node_id_t counter = 0;
 
 EPNode::EPNode(Module *_module)
-    : id(counter++), module(_module), prev(nullptr) {}
+    : id(counter++), module(_module), prev(nullptr) {
+  Instrumentation::count_allocation(AllocationKind::EPNode);
+}
 
 EPNode::~EPNode() {
+  Instrumentation::count_deallocation(AllocationKind::EPNode);
+
   if (module) {
     delete module;
     module = nullptr;
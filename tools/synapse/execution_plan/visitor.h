@@ -93,6 +93,7 @@ class Drop;
 class MapGet;
 class MapPut;
 class MapErase;
+class CoalescedMapGet;
 class ExpireItemsSingleMap;
 class ExpireItemsSingleMapIteratively;
 class VectorRead;
@@ -216,6 +217,7 @@ public:
   VISIT_NOP(x86::SketchRefresh)
   VISIT_NOP(x86::SketchTouchBuckets)
   VISIT_NOP(x86::MapErase)
+  VISIT_NOP(x86::CoalescedMapGet)
   VISIT_NOP(x86::DchainFreeIndex)
   VISIT_NOP(x86::ChtFindBackend)
   VISIT_NOP(x86::HashObj)
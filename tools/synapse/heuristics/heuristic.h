@@ -34,7 +34,7 @@ protected:
 public:
   Heuristic() : terminate_on_first_solution(true) {}
 
-  ~Heuristic() {
+  virtual ~Heuristic() {
     for (const EP *ep : execution_plans) {
       if (ep) {
         delete ep;
@@ -42,9 +42,12 @@ public:
     }
   }
 
-  bool finished() { return get_next_it() == execution_plans.end(); }
+  // Called once, when the search starts.
+  virtual void start() {}
 
-  const EP *get() {
+  virtual bool finished() { return get_next_it() == execution_plans.end(); }
+
+  virtual const EP *get() {
     get_best_it();
     return *best_it;
   }
@@ -65,7 +68,7 @@ public:
     return eps;
   }
 
-  const EP *pop() {
+  virtual const EP *pop() {
     auto it = get_next_it();
     assert(it != execution_plans.end());
 
@@ -77,7 +80,7 @@ public:
     return ep;
   }
 
-  void add(const std::vector<const EP *> &next_eps) {
+  virtual void add(const std::vector<const EP *> &next_eps) {
     for (const EP *ep : next_eps) {
       execution_plans.insert(ep);
     }
@@ -87,6 +90,10 @@ public:
 
   size_t size() const { return execution_plans.size(); }
 
+  void set_terminate_on_first_solution(bool value) {
+    terminate_on_first_solution = value;
+  }
+
   const HCfg *get_cfg() const { return &configuration; }
 
   Score get_score(const EP *e) const {
@@ -94,6 +101,9 @@ public:
     return conf->get_score(e);
   }
 
+protected:
+  void reset_best_it() { best_it = execution_plans.end(); }
+
 private:
   void get_best_it() {
     assert(execution_plans.size());
@@ -119,8 +129,6 @@ private:
     }
   }
 
-  void reset_best_it() { best_it = execution_plans.end(); }
-
   typename std::set<const EP *, HCfg>::iterator get_next_it() {
     if (execution_plans.size() == 0) {
       Log::err() << "No more execution plans to pick!\n";
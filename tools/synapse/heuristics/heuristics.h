@@ -8,6 +8,7 @@
 #include "most_compact.h"
 #include "gallium.h"
 #include "max_throughput.h"
+#include "mcts.h"
 
 #define EXPLICIT_HEURISTIC_TEMPLATE_CLASS_INSTANTIATION(C)                     \
   template class C<BFSComparator>;                                             \
@@ -17,4 +18,5 @@
   template class C<MaxSwitchNodesComparator>;                                  \
   template class C<MostCompactComparator>;                                     \
   template class C<MaxThroughputComparator>;                                   \
+  template class C<MCTSComparator>;                                            \
   template class C<RandomComparator>;
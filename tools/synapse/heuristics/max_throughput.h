@@ -14,6 +14,10 @@ struct MaxThroughputComparator : public HeuristicCfg {
                 {ScoreCategory::SpeculativeThroughput, ScoreObjective::MAX},
                 // {ScoreCategory::Throughput, ScoreObjective::MAX},
 
+                // Among equally fast plans, avoid the ones saturating a
+                // single recirculation port.
+                {ScoreCategory::RecircPortUtilization, ScoreObjective::MIN},
+
                 // Avoid desincentivising modules that expand the BDD.
                 {ScoreCategory::SwitchProgressionNodes, ScoreObjective::MAX},
 
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "heuristic.h"
+#include "score.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+
+namespace synapse {
+
+struct MCTSComparator : public HeuristicCfg {
+  MCTSComparator() : HeuristicCfg("MCTS") {}
+
+  Score get_score(const EP *ep) const override {
+    Score score(ep, {
+                        {ScoreCategory::SpeculativeThroughput,
+                         ScoreObjective::MAX},
+                        {ScoreCategory::Throughput, ScoreObjective::MAX},
+                    });
+    return score;
+  }
+};
+
+// Monte Carlo Tree Search. Instead of expanding the best EP of the frontier,
+// it descends the tree of generated EPs from the top, picking on each level
+// the child with the highest UCT value, and expands the EP it reaches.
+//
+// The speculation of each new EP is its rollout: a greedy completion of the
+// rest of the BDD, whose throughput is back-propagated to every ancestor.
+//
+// The search space keeps the same tree, but only for visualization, so the
+// statistics are kept here.
+class MCTS : public Heuristic<MCTSComparator> {
+private:
+  struct node_t {
+    std::optional<ep_id_t> parent;
+    std::vector<ep_id_t> children;
+    uint64_t visits;
+    double total_pps;
+    bool expanded;
+
+    // Nothing left to expand on this subtree.
+    bool exhausted;
+
+    // Only while on the frontier.
+    const EP *ep;
+  };
+
+  // Parent of the initial EP (or of every EP of a resumed frontier).
+  node_t top;
+  std::unordered_map<ep_id_t, node_t> tree;
+
+  // EP being expanded. Its children are the next ones to be added.
+  std::optional<ep_id_t> expanding;
+
+  // Stop once either is reached, as long as there is a solution. Without
+  // any, stop on the first solution. The budget counts from start().
+  const time_t time_budget;
+  const uint64_t max_rollouts;
+
+  uint64_t rollouts;
+  double max_pps;
+  const EP *best_solution;
+  uint64_t best_solution_pps;
+  std::chrono::steady_clock::time_point start_time;
+
+  static constexpr double EXPLORATION = M_SQRT2;
+
+public:
+  MCTS(time_t _time_budget, uint64_t _max_rollouts)
+      : Heuristic(), top({std::nullopt, {}, 0, 0, false, false, nullptr}),
+        time_budget(_time_budget), max_rollouts(_max_rollouts), rollouts(0),
+        max_pps(0), best_solution(nullptr), best_solution_pps(0) {}
+
+  void start() override { start_time = std::chrono::steady_clock::now(); }
+
+  bool finished() override {
+    if (top.exhausted || execution_plans.empty()) {
+      return true;
+    }
+
+    if (!best_solution) {
+      return false;
+    }
+
+    if (time_budget == 0 && max_rollouts == 0) {
+      return true;
+    }
+
+    time_t elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count();
+
+    return (time_budget > 0 && elapsed >= time_budget) ||
+           (max_rollouts > 0 && rollouts >= max_rollouts);
+  }
+
+  // Only complete EPs are solutions, so there may be none once the tree is
+  // exhausted.
+  const EP *get() override { return best_solution; }
+
+  const EP *pop() override {
+    // The last EP popped was dropped without being expanded (e.g. pruned).
+    if (expanding) {
+      node_t &node = tree.at(*expanding);
+      node.expanded = true;
+      update_exhausted(*expanding);
+      expanding.reset();
+    }
+
+    assert(!top.exhausted && "Nothing left to expand");
+
+    node_t *node = &top;
+    std::optional<ep_id_t> node_id;
+
+    while (node->expanded) {
+      node_id = select_child(*node);
+      node = &tree.at(*node_id);
+    }
+
+    assert(node_id && node->ep && "Selected EP not on the frontier");
+
+    const EP *ep = node->ep;
+    node->ep = nullptr;
+    expanding = node_id;
+
+    auto range = execution_plans.equal_range(ep);
+    for (auto it = range.first; it != range.second; it++) {
+      if (*it == ep) {
+        execution_plans.erase(it);
+        break;
+      }
+    }
+
+    reset_best_it();
+
+    return ep;
+  }
+
+  void add(const std::vector<const EP *> &next_eps) override {
+    Heuristic::add(next_eps);
+
+    node_t &parent = expanding ? tree.at(*expanding) : top;
+    parent.expanded = true;
+
+    for (const EP *ep : next_eps) {
+      ep_id_t id = ep->get_id();
+      bool complete = !ep->get_next_node();
+
+      tree[id] = {expanding, {}, 0, 0, false, complete, ep};
+      parent.children.push_back(id);
+
+      if (complete) {
+        uint64_t pps = ep->estimate_throughput_pps();
+        if (!best_solution || pps > best_solution_pps) {
+          best_solution = ep;
+          best_solution_pps = pps;
+        }
+      }
+
+      rollout(id);
+    }
+
+    if (expanding) {
+      update_exhausted(*expanding);
+      expanding.reset();
+    } else {
+      top.exhausted = std::all_of(
+          top.children.begin(), top.children.end(),
+          [this](ep_id_t child) { return tree.at(child).exhausted; });
+    }
+  }
+
+private:
+  void rollout(ep_id_t id) {
+    double pps = tree.at(id).ep->speculate_throughput_pps();
+
+    rollouts++;
+    max_pps = std::max(max_pps, pps);
+
+    std::optional<ep_id_t> current = id;
+    while (current) {
+      node_t &node = tree.at(*current);
+      node.visits++;
+      node.total_pps += pps;
+      current = node.parent;
+    }
+
+    top.visits++;
+    top.total_pps += pps;
+  }
+
+  double uct(const node_t &node, uint64_t parent_visits) const {
+    assert(node.visits > 0);
+    double exploitation = node.total_pps / node.visits;
+    if (max_pps > 0) {
+      exploitation /= max_pps;
+    }
+    double exploration = std::sqrt(std::log(parent_visits) / node.visits);
+    return exploitation + EXPLORATION * exploration;
+  }
+
+  ep_id_t select_child(const node_t &node) const {
+    std::optional<ep_id_t> best;
+    double best_uct = 0;
+
+    for (ep_id_t child_id : node.children) {
+      const node_t &child = tree.at(child_id);
+
+      if (child.exhausted) {
+        continue;
+      }
+
+      double child_uct = uct(child, node.visits);
+      if (!best || child_uct > best_uct) {
+        best = child_id;
+        best_uct = child_uct;
+      }
+    }
+
+    assert(best && "No child left to select");
+    return *best;
+  }
+
+  void update_exhausted(ep_id_t id) {
+    std::optional<ep_id_t> current = id;
+
+    while (current) {
+      node_t &node = tree.at(*current);
+
+      bool exhausted = std::all_of(
+          node.children.begin(), node.children.end(),
+          [this](ep_id_t child) { return tree.at(child).exhausted; });
+
+      if (!exhausted) {
+        return;
+      }
+
+      node.exhausted = true;
+      current = node.parent;
+    }
+
+    top.exhausted = std::all_of(
+        top.children.begin(), top.children.end(),
+        [this](ep_id_t child) { return tree.at(child).exhausted; });
+  }
+};
+
+} // namespace synapse
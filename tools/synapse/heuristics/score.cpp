@@ -84,6 +84,9 @@ std::ostream &operator<<(std::ostream &os, ScoreCategory score_category) {
   case ScoreCategory::SpeculativeThroughput:
     os << "T*(pps)";
     break;
+  case ScoreCategory::RecircPortUtilization:
+    os << "RecircUtil";
+    break;
   case ScoreCategory::Random:
     os << "Random";
   }
@@ -315,6 +318,25 @@ int64_t Score::get_throughput_speculation(const EP *ep) const {
   return ep->speculate_throughput_pps();
 }
 
+// Utilization of the busiest recirculation port, in per mille, so that plans
+// saturating a single port can be told apart from the ones spreading their
+// recirculations.
+int64_t Score::get_recirc_port_utilization(const EP *ep) const {
+  const Context &ctx = ep->get_ctx();
+  const std::unordered_map<TargetType, double> &traffic_fractions =
+      ctx.get_traffic_fractions();
+
+  if (traffic_fractions.find(TargetType::Tofino) == traffic_fractions.end()) {
+    return 0;
+  }
+
+  const tofino::TofinoContext *tofino_ctx =
+      ctx.get_target_ctx<tofino::TofinoContext>();
+  const tofino::PerfOracle &oracle = tofino_ctx->get_tna().get_perf_oracle();
+
+  return oracle.get_max_recirc_port_utilization() * 1000;
+}
+
 int64_t Score::get_random(const EP *ep) const {
   const EPMeta &meta = ep->get_meta();
   return meta.random_number;
@@ -29,6 +29,7 @@ enum class ScoreCategory {
   ProcessedBDDPercentage,
   Throughput,
   SpeculativeThroughput,
+  RecircPortUtilization,
   Random,
 };
 
@@ -121,6 +122,10 @@ public:
                 ScoreCategory::SpeculativeThroughput,
                 &Score::get_throughput_speculation,
             },
+            {
+                ScoreCategory::RecircPortUtilization,
+                &Score::get_recirc_port_utilization,
+            },
             {
                 ScoreCategory::Random,
                 &Score::get_random,
@@ -231,6 +236,7 @@ private:
   int64_t get_nr_recirculations(const EP *ep) const;
   int64_t get_throughput_prediction(const EP *ep) const;
   int64_t get_throughput_speculation(const EP *ep) const;
+  int64_t get_recirc_port_utilization(const EP *ep) const;
   int64_t get_random(const EP *ep) const;
 };
 
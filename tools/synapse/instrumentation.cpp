@@ -0,0 +1,223 @@
+#include "instrumentation.h"
+#include "log.h"
+
+#include "klee-util.h"
+#include "klee/SolverImpl.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace synapse {
+
+const std::string Instrumentation::SOLVER_PHASE = "solver";
+
+bool Instrumentation::enabled = false;
+std::chrono::steady_clock::time_point Instrumentation::start;
+std::vector<Instrumentation::frame_t> Instrumentation::frames;
+std::unordered_map<std::string, Instrumentation::phase_stats_t>
+    Instrumentation::phases;
+std::unordered_map<std::string, uint64_t> Instrumentation::stacks_self_ns;
+Instrumentation::allocation_stats_t Instrumentation::allocations[3];
+std::vector<std::pair<std::string, uint64_t>> Instrumentation::counters;
+std::string Instrumentation::stream_file;
+time_t Instrumentation::stream_interval = 0;
+std::chrono::steady_clock::time_point Instrumentation::last_stream;
+
+static const char *ALLOCATION_KIND_NAMES[] = {"EP", "EPNode", "SSNode"};
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - since)
+      .count();
+}
+
+// Every query to the solver toolbox goes through here.
+class InstrumentedSolverImpl : public klee::SolverImpl {
+private:
+  klee::Solver *solver;
+
+public:
+  InstrumentedSolverImpl(klee::Solver *_solver) : solver(_solver) {}
+
+  ~InstrumentedSolverImpl() { delete solver; }
+
+  bool computeValidity(const klee::Query &query,
+                       klee::Solver::Validity &result) override {
+    InstrumentationScope scope(Instrumentation::SOLVER_PHASE);
+    return solver->impl->computeValidity(query, result);
+  }
+
+  bool computeTruth(const klee::Query &query, bool &isValid) override {
+    InstrumentationScope scope(Instrumentation::SOLVER_PHASE);
+    return solver->impl->computeTruth(query, isValid);
+  }
+
+  bool computeValue(const klee::Query &query,
+                    klee::ref<klee::Expr> &result) override {
+    InstrumentationScope scope(Instrumentation::SOLVER_PHASE);
+    return solver->impl->computeValue(query, result);
+  }
+
+  bool computeInitialValues(
+      const klee::Query &query, const std::vector<const klee::Array *> &objects,
+      std::vector<std::vector<unsigned char>> &values,
+      bool &hasSolution) override {
+    InstrumentationScope scope(Instrumentation::SOLVER_PHASE);
+    return solver->impl->computeInitialValues(query, objects, values,
+                                              hasSolution);
+  }
+
+  SolverRunStatus getOperationStatusCode() override {
+    return solver->impl->getOperationStatusCode();
+  }
+
+  char *getConstraintLog(const klee::Query &query) override {
+    return solver->impl->getConstraintLog(query);
+  }
+
+  void setCoreSolverTimeout(double timeout) override {
+    solver->impl->setCoreSolverTimeout(timeout);
+  }
+};
+
+void Instrumentation::enable() {
+  if (enabled) {
+    return;
+  }
+
+  enabled = true;
+  start = std::chrono::steady_clock::now();
+  last_stream = start;
+
+  klee::Solver *solver = kutil::solver_toolbox.solver;
+  kutil::solver_toolbox.solver =
+      new klee::Solver(new InstrumentedSolverImpl(solver));
+}
+
+void Instrumentation::push_phase(const std::string &name) {
+  std::string stack = frames.empty() ? name : frames.back().stack + ";" + name;
+  frames.push_back({name, stack, std::chrono::steady_clock::now(), 0});
+}
+
+void Instrumentation::pop_phase() {
+  assert(!frames.empty() && "No phase to pop");
+
+  frame_t frame = std::move(frames.back());
+  frames.pop_back();
+
+  uint64_t total_ns = elapsed_ns(frame.start);
+  uint64_t self_ns = total_ns - std::min(total_ns, frame.children_ns);
+
+  phase_stats_t &stats = phases[frame.name];
+  stats.calls++;
+  stats.total_ns += total_ns;
+  stats.self_ns += self_ns;
+
+  stacks_self_ns[frame.stack] += self_ns;
+
+  if (frames.empty()) {
+    return;
+  }
+
+  frame_t &parent = frames.back();
+  parent.children_ns += total_ns;
+
+  if (frame.name == SOLVER_PHASE && parent.name != SOLVER_PHASE) {
+    phase_stats_t &parent_stats = phases[parent.name];
+    parent_stats.solver_queries++;
+    parent_stats.solver_ns += total_ns;
+  }
+}
+
+void Instrumentation::set_counter(const std::string &name, uint64_t value) {
+  for (auto &[counter_name, counter_value] : counters) {
+    if (counter_name == name) {
+      counter_value = value;
+      return;
+    }
+  }
+
+  counters.emplace_back(name, value);
+}
+
+void Instrumentation::set_stream(const std::string &file, time_t interval) {
+  stream_file = file;
+  stream_interval = interval;
+
+  // Start afresh, as every tick appends to it.
+  std::ofstream out(stream_file, std::ios::trunc);
+
+  if (!out.is_open()) {
+    Log::err() << "Unable to write stats to " << stream_file << "\n";
+    exit(1);
+  }
+}
+
+void Instrumentation::tick(bool force) {
+  if (!enabled || stream_file.empty()) {
+    return;
+  }
+
+  uint64_t since_last_ns = elapsed_ns(last_stream);
+  if (!force && since_last_ns < (uint64_t)stream_interval * 1'000'000'000) {
+    return;
+  }
+
+  last_stream = std::chrono::steady_clock::now();
+
+  std::ofstream out(stream_file, std::ios::app);
+  dump_json(out);
+  out << "\n";
+}
+
+static double ns2ms(uint64_t ns) { return ns / 1e6; }
+
+void Instrumentation::dump_json(std::ostream &os) {
+  json j;
+
+  j["elapsed_ms"] = ns2ms(elapsed_ns(start));
+
+  for (const auto &[name, value] : counters) {
+    j["counters"][name] = value;
+  }
+
+  for (int kind = 0; kind < 3; kind++) {
+    j["allocations"][ALLOCATION_KIND_NAMES[kind]] = {
+        {"total", allocations[kind].total},
+        {"live", allocations[kind].live},
+    };
+  }
+
+  for (const auto &[name, stats] : phases) {
+    j["phases"][name] = {
+        {"calls", stats.calls},
+        {"total_ms", ns2ms(stats.total_ns)},
+        {"self_ms", ns2ms(stats.self_ns)},
+        {"solver_queries", stats.solver_queries},
+        {"solver_ms", ns2ms(stats.solver_ns)},
+    };
+  }
+
+  os << j.dump();
+}
+
+void Instrumentation::dump_folded_stacks(const std::string &file) {
+  std::ofstream out(file);
+
+  if (!out.is_open()) {
+    Log::err() << "Unable to write flame graph stacks to " << file << "\n";
+    exit(1);
+  }
+
+  // Microseconds of self time, as samples.
+  for (const auto &[stack, self_ns] : stacks_self_ns) {
+    uint64_t self_us = self_ns / 1000;
+    if (self_us > 0) {
+      out << stack << " " << self_us << "\n";
+    }
+  }
+}
+
+} // namespace synapse
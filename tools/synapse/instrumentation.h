@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace synapse {
+
+enum class AllocationKind { EP, EPNode, SSNode };
+
+// Timers and call counts per phase of the search (module generators, BDD
+// reordering, speculation, placement, EP cloning, ...), with the solver
+// queries each phase makes. Phases nest, and their stacks are dumped in the
+// folded format flame graph tools take.
+//
+// Disabled by default, in which case phases cost a single branch.
+class Instrumentation {
+public:
+  static const std::string SOLVER_PHASE;
+
+  // Also wraps the solver toolbox, to time its queries.
+  static void enable();
+  static bool is_enabled() { return enabled; }
+
+  static void push_phase(const std::string &name);
+  static void pop_phase();
+
+  // Always counted, enabled or not.
+  static void count_allocation(AllocationKind kind) {
+    allocations[static_cast<int>(kind)].total++;
+    allocations[static_cast<int>(kind)].live++;
+  }
+
+  static void count_deallocation(AllocationKind kind) {
+    allocations[static_cast<int>(kind)].live--;
+  }
+
+  // Progress of the search, reported along with the phases.
+  static void set_counter(const std::string &name, uint64_t value);
+
+  // Appends a JSON line with every stat to the stream file, at most once per
+  // interval (in seconds) unless forced.
+  static void set_stream(const std::string &file, time_t interval);
+  static void tick(bool force = false);
+
+  static void dump_json(std::ostream &os);
+  static void dump_folded_stacks(const std::string &file);
+
+private:
+  struct phase_stats_t {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t self_ns;
+    uint64_t solver_queries;
+    uint64_t solver_ns;
+  };
+
+  struct frame_t {
+    std::string name;
+    std::string stack;
+    std::chrono::steady_clock::time_point start;
+    uint64_t children_ns;
+  };
+
+  struct allocation_stats_t {
+    uint64_t total;
+    uint64_t live;
+  };
+
+  static bool enabled;
+  static std::chrono::steady_clock::time_point start;
+
+  static std::vector<frame_t> frames;
+  static std::unordered_map<std::string, phase_stats_t> phases;
+  static std::unordered_map<std::string, uint64_t> stacks_self_ns;
+  static allocation_stats_t allocations[3];
+  static std::vector<std::pair<std::string, uint64_t>> counters;
+
+  static std::string stream_file;
+  static time_t stream_interval;
+  static std::chrono::steady_clock::time_point last_stream;
+};
+
+// Times the enclosing scope as a phase of the search.
+class InstrumentationScope {
+private:
+  bool active;
+
+public:
+  InstrumentationScope(const std::string &name)
+      : active(Instrumentation::is_enabled()) {
+    if (active) {
+      Instrumentation::push_phase(name);
+    }
+  }
+
+  ~InstrumentationScope() {
+    if (active) {
+      Instrumentation::pop_phase();
+    }
+  }
+
+  InstrumentationScope(const InstrumentationScope &) = delete;
+  InstrumentationScope &operator=(const InstrumentationScope &) = delete;
+};
+
+} // namespace synapse
@@ -35,10 +35,16 @@ public:
   std::ostream stream;
 
   static Level MINIMUM_LOG_LEVEL;
-  static bool is_debug_active() {
-    return Log::MINIMUM_LOG_LEVEL >= Level::DEBUG;
+
+  // Messages below the minimum level are dropped by operator<<, but only
+  // after their arguments have been built. Code producing expensive messages
+  // should check this first.
+  static bool is_active(Level level) {
+    return level >= Log::MINIMUM_LOG_LEVEL;
   }
 
+  static bool is_debug_active() { return is_active(Level::DEBUG); }
+
   static Log log();
   static Log dbg();
   static Log wrn();
@@ -80,7 +86,7 @@ private:
 };
 
 template <typename T> Log &operator<<(Log &log, T &&t) {
-  if (log.level < Log::MINIMUM_LOG_LEVEL)
+  if (!Log::is_active(log.level))
     return log;
 
   log.stream << log.color;
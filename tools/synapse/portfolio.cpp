@@ -0,0 +1,300 @@
+#include "portfolio.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace synapse {
+
+// Improvements on the solution of an engine kept for the anytime curve. Later
+// ones overwrite the last, which only loses points of very long searches.
+static constexpr size_t MAX_ANYTIME_POINTS = 1024;
+
+struct shared_point_t {
+  int64_t elapsed_ms;
+  uint64_t pps;
+};
+
+// State of an engine visible to the whole portfolio. Only the process running
+// the engine writes it.
+struct engine_slot_t {
+  std::atomic<bool> has_solution;
+  std::atomic<uint64_t> pps;
+  std::atomic<bool> deadline_reached;
+  std::atomic<size_t> total_points;
+  shared_point_t points[MAX_ANYTIME_POINTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Atomics shared across processes must be lock free");
+
+static engine_slot_t *map_slots(size_t total) {
+  void *memory =
+      mmap(nullptr, sizeof(engine_slot_t) * total, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  if (memory == MAP_FAILED) {
+    Log::err() << "Unable to map the portfolio shared memory.\n";
+    exit(1);
+  }
+
+  engine_slot_t *slots = static_cast<engine_slot_t *>(memory);
+  for (size_t i = 0; i < total; i++) {
+    new (&slots[i]) engine_slot_t{false, 0, false, 0, {}};
+  }
+
+  return slots;
+}
+
+static std::optional<size_t> get_winner(const engine_slot_t *slots,
+                                        const std::vector<bool> &alive) {
+  std::optional<size_t> winner;
+
+  for (size_t i = 0; i < alive.size(); i++) {
+    if (!alive[i] || !slots[i].has_solution) {
+      continue;
+    }
+
+    if (!winner || slots[i].pps > slots[*winner].pps) {
+      winner = i;
+    }
+  }
+
+  return winner;
+}
+
+// Every point improving on the best solution of the whole portfolio.
+static std::vector<anytime_point_t> build_anytime_curve(
+    const engine_slot_t *slots,
+    const std::vector<std::unique_ptr<SearchEngineBase>> &engines) {
+  std::vector<anytime_point_t> points;
+
+  for (size_t i = 0; i < engines.size(); i++) {
+    size_t total = std::min(slots[i].total_points.load(), MAX_ANYTIME_POINTS);
+    for (size_t j = 0; j < total; j++) {
+      points.push_back({
+          .elapsed_ms = slots[i].points[j].elapsed_ms,
+          .pps = slots[i].points[j].pps,
+          .heuristic = engines[i]->get_heuristic_name(),
+      });
+    }
+  }
+
+  std::stable_sort(points.begin(), points.end(),
+                   [](const anytime_point_t &p1, const anytime_point_t &p2) {
+                     return p1.elapsed_ms < p2.elapsed_ms;
+                   });
+
+  std::vector<anytime_point_t> curve;
+  for (const anytime_point_t &point : points) {
+    if (curve.empty() || point.pps > curve.back().pps) {
+      curve.push_back(point);
+    }
+  }
+
+  return curve;
+}
+
+// Runs a single engine, sharing its solutions through its slot and pruning
+// against the ones of the others.
+static void run_engine(SearchEngineBase *engine, size_t idx,
+                       engine_slot_t *slots, size_t total,
+                       std::chrono::steady_clock::time_point start,
+                       time_t deadline) {
+  engine_slot_t &slot = slots[idx];
+  std::optional<uint64_t> shared_pps;
+
+  engine->start();
+
+  while (true) {
+    int64_t elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    if (deadline > 0 && elapsed_ms >= deadline * 1000) {
+      slot.deadline_reached = true;
+      break;
+    }
+
+    for (size_t i = 0; i < total; i++) {
+      if (i == idx || !slots[i].has_solution.load(std::memory_order_acquire)) {
+        continue;
+      }
+
+      uint64_t pps = slots[i].pps.load(std::memory_order_relaxed);
+      if (!shared_pps || pps > *shared_pps) {
+        shared_pps = pps;
+        engine->share_incumbent_pps(pps);
+      }
+    }
+
+    bool running = engine->step();
+
+    std::optional<uint64_t> pps = engine->get_incumbent_pps();
+    if (pps && (!slot.has_solution || *pps > slot.pps)) {
+      size_t point =
+          std::min(slot.total_points.load(), MAX_ANYTIME_POINTS - 1);
+      slot.points[point] = {elapsed_ms, *pps};
+      slot.total_points = point + 1;
+
+      slot.pps.store(*pps, std::memory_order_relaxed);
+      slot.has_solution.store(true, std::memory_order_release);
+
+      if (!shared_pps || *pps > *shared_pps) {
+        Log::log() << "[" << elapsed_ms << " ms] "
+                   << engine->get_heuristic_name()
+                   << " found a solution with " << int2hr(*pps) << " pps\n";
+      }
+    }
+
+    if (!running) {
+      break;
+    }
+  }
+}
+
+Portfolio::Portfolio(time_t _deadline) : deadline(_deadline) {}
+
+void Portfolio::add(SearchEngineBase *engine) { engines.emplace_back(engine); }
+
+search_report_t Portfolio::search() {
+  assert(!engines.empty() && "Empty portfolio");
+
+  size_t total = engines.size();
+  engine_slot_t *slots = map_slots(total);
+
+  std::vector<pid_t> pids(total);
+  std::vector<int> done_fds(total);
+  std::vector<int> verdict_fds(total);
+
+  // Otherwise every child would flush the parent's pending output again.
+  std::cout.flush();
+  std::cerr.flush();
+  fflush(nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < total; i++) {
+    int done_pipe[2];
+    int verdict_pipe[2];
+
+    if (pipe(done_pipe) != 0 || pipe(verdict_pipe) != 0) {
+      Log::err() << "Unable to create the portfolio pipes.\n";
+      exit(1);
+    }
+
+    pid_t pid = fork();
+
+    if (pid < 0) {
+      Log::err() << "Unable to fork the portfolio engines.\n";
+      exit(1);
+    }
+
+    if (pid == 0) {
+      close(done_pipe[0]);
+      close(verdict_pipe[1]);
+      for (size_t j = 0; j < i; j++) {
+        close(done_fds[j]);
+        close(verdict_fds[j]);
+      }
+
+      run_engine(engines[i].get(), i, slots, total, start, deadline);
+
+      char byte = 1;
+      if (write(done_pipe[1], &byte, 1) != 1) {
+        _exit(1);
+      }
+      close(done_pipe[1]);
+
+      // Only the winner reports its solution. The rest leave without
+      // unwinding: their state is a copy of the parent's.
+      bool won = read(verdict_pipe[0], &byte, 1) == 1 && byte == 1;
+      close(verdict_pipe[0]);
+
+      if (!won) {
+        _exit(0);
+      }
+
+      search_report_t report = engines[i]->finish();
+
+      search_meta_t meta = report.meta;
+      meta.anytime_curve = build_anytime_curve(slots, engines);
+
+      munmap(slots, sizeof(engine_slot_t) * total);
+
+      return {
+          .config = report.config,
+          .solution = report.solution,
+          .meta = meta,
+      };
+    }
+
+    close(done_pipe[1]);
+    close(verdict_pipe[0]);
+
+    pids[i] = pid;
+    done_fds[i] = done_pipe[0];
+    verdict_fds[i] = verdict_pipe[1];
+  }
+
+  // Engines that crashed never signal, and their solutions are lost.
+  std::vector<bool> alive(total);
+  for (size_t i = 0; i < total; i++) {
+    char byte;
+    alive[i] = read(done_fds[i], &byte, 1) == 1;
+    close(done_fds[i]);
+  }
+
+  std::optional<size_t> winner = get_winner(slots, alive);
+
+  bool deadline_reached = false;
+  for (size_t i = 0; i < total; i++) {
+    deadline_reached |= slots[i].deadline_reached.load();
+  }
+
+  if (deadline_reached) {
+    Log::log() << "Portfolio deadline reached\n";
+  }
+
+  // Without the verdict, the winner leaves like the rest.
+  bool notified = false;
+  for (size_t i = 0; i < total; i++) {
+    if (winner && *winner == i) {
+      char byte = 1;
+      notified = write(verdict_fds[i], &byte, 1) == 1;
+    }
+    close(verdict_fds[i]);
+  }
+
+  int winner_status = 1;
+  for (size_t i = 0; i < total; i++) {
+    int status;
+    waitpid(pids[i], &status, 0);
+
+    if (winner && *winner == i) {
+      winner_status =
+          notified && WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+  }
+
+  munmap(slots, sizeof(engine_slot_t) * total);
+
+  if (!winner) {
+    Log::err() << "No heuristic in the portfolio found a solution"
+               << (deadline_reached ? " before the deadline" : "") << ".\n";
+    exit(1);
+  }
+
+  // The winner took over the rest of the run.
+  exit(winner_status);
+}
+
+} // namespace synapse
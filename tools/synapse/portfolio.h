@@ -0,0 +1,38 @@
+#pragma once
+
+#include "search.h"
+
+#include <memory>
+#include <vector>
+
+namespace synapse {
+
+// Runs several search engines over the same BDD, profiler and targets
+// concurrently. Engines must be branching and bounding: every time one of them
+// improves the best solution found, the others prune against it.
+//
+// Each engine runs on a process of its own, as the solver toolbox and the id
+// counters are global, and solutions are shared through shared memory. Once
+// every engine is done, the process of the winner returns its report and
+// carries on with the run, while the original one waits for it and exits with
+// its status.
+class Portfolio {
+private:
+  std::vector<std::unique_ptr<SearchEngineBase>> engines;
+
+  // Seconds after which the search stops, failing if no engine has found a
+  // solution by then. Zero runs the engines until all of them are done.
+  const time_t deadline;
+
+public:
+  Portfolio(time_t deadline);
+
+  // Takes ownership of the engine.
+  void add(SearchEngineBase *engine);
+
+  // The report of the engine with the best solution, along with the anytime
+  // curve of the whole portfolio. Returns only on the process of the winner.
+  search_report_t search();
+};
+
+} // namespace synapse
@@ -525,6 +525,10 @@ Profiler::get_fraction(const constraints_t &constraints) const {
 }
 
 void Profiler::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "\n============== Hit Rate Tree ==============\n";
   if (root) {
     root->log_debug();
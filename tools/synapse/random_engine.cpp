@@ -1,7 +1,23 @@
 #include "random_engine.h"
 
+#include <sstream>
+
 namespace synapse {
 
 std::unique_ptr<RandomEngine> RandomEngine::engine;
 
+std::string RandomEngine::get_state() {
+  assert(engine);
+  std::stringstream state;
+  state << engine->gen << " " << engine->random_dist;
+  return state.str();
+}
+
+void RandomEngine::set_state(const std::string &state) {
+  assert(engine);
+  std::stringstream input(state);
+  input >> engine->gen >> engine->random_dist;
+  assert(!input.fail() && "Invalid random engine state");
+}
+
 }
\ No newline at end of file
@@ -1,39 +1,30 @@
 #pragma once
 
-#include <functional>
 #include <random>
 #include <memory>
+#include <string>
 #include <assert.h>
 
 namespace synapse {
 
 class RandomEngine {
 private:
-  // What a mouth full...
-  // This is the product of the bind expression below.
-  typedef std::_Bind<std::uniform_int_distribution<int>(std::mt19937)>
-      Generator;
-
   unsigned rand_seed;
   std::mt19937 gen;
   std::uniform_int_distribution<int> random_dist;
-  Generator generator;
 
   RandomEngine(unsigned _rand_seed, int _min, int _max)
-      : rand_seed(_rand_seed), gen(rand_seed), random_dist(_min, _max),
-        generator(std::bind(random_dist, gen)) {}
+      : rand_seed(_rand_seed), gen(rand_seed), random_dist(_min, _max) {}
 
   RandomEngine(unsigned _rand_seed)
-      : rand_seed(_rand_seed), gen(rand_seed), random_dist(0, INT32_MAX),
-        generator(std::bind(random_dist, gen)) {}
+      : rand_seed(_rand_seed), gen(rand_seed), random_dist(0, INT32_MAX) {}
 
   RandomEngine(const RandomEngine &) = delete;
   RandomEngine(RandomEngine &&) = delete;
 
   RandomEngine &operator=(const RandomEngine &) = delete;
 
-  int generate_number() { return generator(); }
-  unsigned get_seed() const { return rand_seed; }
+  int generate_number() { return random_dist(gen); }
 
 private:
   static std::unique_ptr<RandomEngine> engine;
@@ -47,6 +38,16 @@ public:
     assert(engine);
     return engine->generate_number();
   }
+
+  static unsigned get_seed() {
+    assert(engine);
+    return engine->rand_seed;
+  }
+
+  // Where the engine is on its sequence, so that it can pick up from there
+  // (e.g. when resuming a search).
+  static std::string get_state();
+  static void set_state(const std::string &state);
 };
 
 } // namespace synapse
\ No newline at end of file
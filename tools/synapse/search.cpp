@@ -1,5 +1,7 @@
 #include "search.h"
 #include "log.h"
+#include "instrumentation.h"
+#include "random_engine.h"
 #include "targets/targets.h"
 #include "heuristics/heuristics.h"
 #include "visualizers/ss_visualizer.h"
@@ -7,23 +9,64 @@
 
 #include <chrono>
 #include <iomanip>
+#include <map>
+#include <numeric>
 
 namespace synapse {
 
+static std::vector<const ModuleGenerator *>
+get_module_generators(const targets_t &targets) {
+  std::vector<const ModuleGenerator *> modgens;
+  for (const Target *target : targets) {
+    modgens.insert(modgens.end(), target->module_generators.begin(),
+                   target->module_generators.end());
+  }
+  return modgens;
+}
+
+static std::vector<std::string> get_modgen_phases(const targets_t &targets) {
+  std::vector<std::string> phases;
+  for (const Target *target : targets) {
+    for (const ModuleGenerator *modgen : target->module_generators) {
+      std::stringstream phase;
+      phase << target->type << "::" << modgen->get_name();
+      phases.push_back(phase.str());
+    }
+  }
+  return phases;
+}
+
 template <class HCfg>
-SearchEngine<HCfg>::SearchEngine(const bdd::BDD *_bdd, Heuristic<HCfg> *_h,
-                                 Profiler *_profiler, const targets_t &_targets,
+SearchEngine<HCfg>::SearchEngine(std::shared_ptr<const bdd::BDD> _bdd,
+                                 Heuristic<HCfg> *_h,
+                                 std::shared_ptr<Profiler> _profiler,
+                                 const targets_t &_targets,
                                  bool _allow_bdd_reordering,
                                  const std::unordered_set<ep_id_t> &_peek,
-                                 bool _pause_and_show_on_backtrack)
-    : bdd(new bdd::BDD(*_bdd)), h(_h), profiler(new Profiler(*_profiler)),
-      targets(_targets), allow_bdd_reordering(_allow_bdd_reordering),
-      peek(_peek), pause_and_show_on_backtrack(_pause_and_show_on_backtrack) {}
+                                 bool _pause_and_show_on_backtrack,
+                                 bool _detailed_search_space,
+                                 bool _branch_and_bound,
+                                 double _max_optimality_gap,
+                                 const checkpoint_cfg_t &_checkpoint_cfg)
+    : bdd(_bdd), h(_h), profiler(_profiler), targets(_targets),
+      allow_bdd_reordering(_allow_bdd_reordering),
+      peek(_peek), pause_and_show_on_backtrack(_pause_and_show_on_backtrack),
+      detailed_search_space(_detailed_search_space || !_peek.empty() ||
+                            _pause_and_show_on_backtrack),
+      branch_and_bound(_branch_and_bound),
+      max_optimality_gap(_max_optimality_gap), checkpoint_cfg(_checkpoint_cfg),
+      checkpointing(!_checkpoint_cfg.file.empty()),
+      modgen_phases(get_modgen_phases(_targets)), search_space(nullptr),
+      generated(0), modgens(get_module_generators(_targets)),
+      resumed_elapsed_time(0), last_checkpoint(0), incumbent(nullptr),
+      incumbent_pps(0), done(false) {}
 
 template <class HCfg>
 SearchEngine<HCfg>::SearchEngine(const bdd::BDD *_bdd, Heuristic<HCfg> *_h,
                                  Profiler *_profiler, const targets_t &_targets)
-    : SearchEngine(_bdd, _h, _profiler, _targets, true, {}, false) {}
+    : SearchEngine(std::make_shared<bdd::BDD>(*_bdd), _h,
+                   std::make_shared<Profiler>(*_profiler), _targets, true, {},
+                   false, false, false, 0, {"", 0, false}) {}
 
 struct search_step_report_t {
   int available_execution_plans;
@@ -59,6 +102,10 @@ struct search_step_report_t {
 
 static void log_search_iteration(const search_step_report_t &report,
                                  const search_meta_t &search_meta) {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   TargetType platform = report.chosen->get_current_platform();
   const EPLeaf *leaf = report.chosen->get_active_leaf();
   const EPMeta &meta = report.chosen->get_meta();
@@ -142,115 +189,468 @@ static void peek_backtrack(const EP *ep, SearchSpace *search_space,
   }
 }
 
-template <class HCfg> search_report_t SearchEngine<HCfg>::search() {
-  search_meta_t meta;
-  auto start_search = std::chrono::steady_clock::now();
-  SearchSpace *search_space = new SearchSpace(h->get_cfg());
+// Upper bound on the throughput of any solution derived from this EP. The
+// estimation itself is not one, as moving traffic to a CPU can raise it, so
+// each target is bounded as if it received all of the traffic.
+static uint64_t get_throughput_upper_bound(const EP *ep) {
+  return ep->bound_throughput_pps();
+}
 
-  h->add({new EP(bdd, targets, profiler)});
+// Relative distance between the incumbent and the best throughput any EP
+// still open could achieve.
+template <class HCfg>
+static double get_optimality_gap(const Heuristic<HCfg> *h,
+                                 uint64_t incumbent_pps) {
+  uint64_t best_bound = incumbent_pps;
 
-  std::unordered_map<bdd::node_id_t, int> node_depth;
+  for (const EP *ep : h->get_all()) {
+    if (!ep->get_next_node()) {
+      continue;
+    }
 
-  bdd->get_root()->visit_nodes(
-      [this, &meta, &node_depth](const bdd::Node *node) {
-        bdd::node_id_t id = node->get_id();
-        meta.avg_children_per_node[id] = 0;
-        meta.visits_per_node[id] = 0;
-        node_depth[id] = this->bdd->get_node_depth(id);
-        return bdd::NodeVisitAction::VISIT_CHILDREN;
-      });
+    best_bound = std::max(best_bound, get_throughput_upper_bound(ep));
+  }
 
-  while (!h->finished()) {
-    meta.elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(
-                            std::chrono::steady_clock::now() - start_search)
-                            .count();
+  if (best_bound == 0) {
+    return 0;
+  }
 
-    const EP *ep = h->pop();
-    search_space->activate_leaf(ep);
+  return (double)(best_bound - incumbent_pps) / best_bound;
+}
 
-    meta.avg_bdd_size *= meta.steps;
-    meta.avg_bdd_size += ep->get_bdd()->size();
-    meta.steps++;
-    meta.avg_bdd_size /= meta.steps;
+// Rebuilds the EPs on the frontier of a checkpoint, out of the ones whose
+// paths go through the given EP (found after the first depth decisions).
+// EPs sharing a prefix are only generated once. Takes ownership of the EP.
+static void replay_frontier(const EP *ep, size_t depth,
+                            const std::vector<size_t> &frontier_idxs,
+                            const std::vector<checkpoint_ep_t> &frontier,
+                            const std::vector<const ModuleGenerator *> &modgens,
+                            bool allow_bdd_reordering,
+                            std::vector<const EP *> &eps) {
+  std::map<uint32_t, std::map<uint32_t, std::vector<size_t>>> next;
+
+  for (size_t idx : frontier_idxs) {
+    const checkpoint_ep_t &checkpoint_ep = frontier[idx];
+
+    if (checkpoint_ep.path.size() == depth) {
+      assert(frontier_idxs.size() == 1 && "Frontier EP has descendants");
+      // Random numbers are drawn as EPs are built, and the replay does not
+      // build them in the same order as the original search did.
+      const_cast<EP *>(ep)->get_mutable_meta().random_number =
+          checkpoint_ep.random_number;
+      eps[idx] = ep;
+      return;
+    }
+
+    const ep_decision_t &decision = checkpoint_ep.path[depth];
+    next[decision.modgen][decision.product].push_back(idx);
+  }
+
+  const bdd::Node *node = ep->get_next_node();
+  assert(node && "Replaying a complete EP");
+
+  for (const auto &[modgen_idx, products_idxs] : next) {
+    assert(modgen_idx < modgens.size() && "Unknown module generator");
+    const ModuleGenerator *modgen = modgens[modgen_idx];
+
+    std::vector<generator_product_t> products =
+        modgen->generate(ep, node, allow_bdd_reordering);
+
+    for (size_t i = 0; i < products.size(); i++) {
+      auto found_it = products_idxs.find(i);
+
+      if (found_it == products_idxs.end()) {
+        delete products[i].ep;
+        continue;
+      }
 
-    if (search_space->is_backtrack()) {
-      meta.backtracks++;
-      peek_backtrack(ep, search_space, pause_and_show_on_backtrack);
+      replay_frontier(products[i].ep, depth + 1, found_it->second, frontier,
+                      modgens, allow_bdd_reordering, eps);
     }
+  }
+
+  delete ep;
+}
 
-    const bdd::Node *node = ep->get_next_node();
-    search_step_report_t report(h->size(), ep, node);
+static void report_progress(const search_meta_t &meta, size_t frontier) {
+  if (!Instrumentation::is_enabled()) {
+    return;
+  }
 
-    float &avg_node_children = meta.avg_children_per_node[node->get_id()];
-    int &node_visits = meta.visits_per_node[node->get_id()];
+  Instrumentation::set_counter("steps", meta.steps);
+  Instrumentation::set_counter("backtracks", meta.backtracks);
+  Instrumentation::set_counter("ss_size", meta.ss_size);
+  Instrumentation::set_counter("frontier", frontier);
+  Instrumentation::set_counter("duplicates", meta.duplicates);
+  Instrumentation::set_counter("pruned", meta.pruned);
+  Instrumentation::tick();
+}
 
-    std::vector<const EP *> new_eps;
+template <class HCfg>
+static checkpoint_t
+build_checkpoint(const bdd::BDD *bdd, const Heuristic<HCfg> *h,
+                 const search_meta_t &meta, uint64_t generated,
+                 const std::unordered_set<size_t> &seen_eps,
+                 const std::unordered_map<ep_id_t, ep_path_t> &paths) {
+  checkpoint_t checkpoint;
+
+  checkpoint.bdd_hash = bdd->hash();
+  checkpoint.seed = RandomEngine::get_seed();
+  checkpoint.random_state = RandomEngine::get_state();
+
+  checkpoint.elapsed_time = meta.elapsed_time;
+  checkpoint.steps = meta.steps;
+  checkpoint.backtracks = meta.backtracks;
+  checkpoint.avg_bdd_size = meta.avg_bdd_size;
+  checkpoint.generated = generated;
+  checkpoint.duplicates = meta.duplicates;
+  checkpoint.pruned = meta.pruned;
+  checkpoint.visits_per_node = meta.visits_per_node;
+  checkpoint.avg_children_per_node = meta.avg_children_per_node;
+
+  checkpoint.seen_eps.assign(seen_eps.begin(), seen_eps.end());
+
+  for (const EP *ep : h->get_all()) {
+    checkpoint.frontier.push_back({
+        .path = paths.at(ep->get_id()),
+        .random_number = ep->get_meta().random_number,
+    });
+  }
 
-    uint64_t children = 0;
-    for (const Target *target : targets) {
-      for (const ModuleGenerator *modgen : target->module_generators) {
-        std::vector<generator_product_t> modgen_products =
-            modgen->generate(ep, node, allow_bdd_reordering);
-        search_space->add_to_active_leaf(ep, node, modgen, modgen_products);
-        report.save(modgen, modgen_products);
+  return checkpoint;
+}
+
+template <class HCfg> SearchEngine<HCfg>::~SearchEngine() {
+  // Only if the search was never finished.
+  if (search_space) {
+    delete search_space;
+  }
+}
+
+template <class HCfg>
+const std::string &SearchEngine<HCfg>::get_heuristic_name() const {
+  return h->get_cfg()->name;
+}
+
+template <class HCfg>
+std::optional<uint64_t> SearchEngine<HCfg>::get_incumbent_pps() const {
+  if (!incumbent) {
+    return std::nullopt;
+  }
+  return incumbent_pps;
+}
+
+template <class HCfg>
+void SearchEngine<HCfg>::share_incumbent_pps(uint64_t pps) {
+  if (!shared_incumbent_pps || pps > *shared_incumbent_pps) {
+    shared_incumbent_pps = pps;
+  }
+}
+
+template <class HCfg>
+std::optional<uint64_t> SearchEngine<HCfg>::get_best_known_pps() const {
+  std::optional<uint64_t> best = shared_incumbent_pps;
+  if (incumbent && (!best || incumbent_pps > *best)) {
+    best = incumbent_pps;
+  }
+  return best;
+}
+
+template <class HCfg> void SearchEngine<HCfg>::start() {
+  start_search = std::chrono::steady_clock::now();
+  h->start();
+
+  search_space = new SearchSpace(h->get_cfg(), detailed_search_space);
+
+  const EP *initial_ep = new EP(bdd, targets, profiler);
+
+  seen_eps.insert(initial_ep->hash());
+  generated = 1;
+
+  bdd->get_root()->visit_nodes([this](const bdd::Node *node) {
+    bdd::node_id_t id = node->get_id();
+    meta.avg_children_per_node[id] = 0;
+    meta.visits_per_node[id] = 0;
+    node_depth[id] = bdd->get_node_depth(id);
+    return bdd::NodeVisitAction::VISIT_CHILDREN;
+  });
+
+  if (checkpoint_cfg.resume) {
+    checkpoint_t checkpoint = checkpoint_t::load(checkpoint_cfg.file);
+
+    if (checkpoint.bdd_hash != bdd->hash() ||
+        checkpoint.seed != RandomEngine::get_seed()) {
+      Log::err() << "Checkpoint " << checkpoint_cfg.file
+                 << " was made for another BDD or seed.\n";
+      exit(1);
+    }
+
+    resumed_elapsed_time = checkpoint.elapsed_time;
+    meta.steps = checkpoint.steps;
+    meta.backtracks = checkpoint.backtracks;
+    meta.avg_bdd_size = checkpoint.avg_bdd_size;
+    meta.duplicates = checkpoint.duplicates;
+    meta.pruned = checkpoint.pruned;
+    meta.visits_per_node = checkpoint.visits_per_node;
+    meta.avg_children_per_node = checkpoint.avg_children_per_node;
+    generated = checkpoint.generated;
+    seen_eps.insert(checkpoint.seen_eps.begin(), checkpoint.seen_eps.end());
+
+    std::vector<size_t> frontier_idxs(checkpoint.frontier.size());
+    std::iota(frontier_idxs.begin(), frontier_idxs.end(), 0);
+    std::vector<const EP *> frontier(checkpoint.frontier.size());
+
+    search_space->activate_leaf(initial_ep);
+    replay_frontier(initial_ep, 0, frontier_idxs, checkpoint.frontier, modgens,
+                    allow_bdd_reordering, frontier);
+
+    std::vector<TargetType> frontier_targets;
+    for (size_t i = 0; i < frontier.size(); i++) {
+      const ep_path_t &path = checkpoint.frontier[i].path;
+      frontier_targets.push_back(
+          path.empty() ? frontier[i]->get_current_platform()
+                       : modgens[path.back().modgen]->get_target());
+    }
+
+    search_space->add_resumed_to_active_leaf(frontier, frontier_targets);
+
+    for (size_t i = 0; i < frontier.size(); i++) {
+      paths[frontier[i]->get_id()] = checkpoint.frontier[i].path;
+    }
 
-        for (const generator_product_t &product : modgen_products) {
-          new_eps.push_back(product.ep);
+    h->add(frontier);
+
+    // The replay draws random numbers of its own.
+    RandomEngine::set_state(checkpoint.random_state);
+
+    Log::log() << "Resumed " << frontier.size() << " EPs from "
+               << checkpoint_cfg.file << "\n";
+  } else {
+    paths[initial_ep->get_id()] = {};
+    h->add({initial_ep});
+  }
+
+  last_checkpoint = resumed_elapsed_time;
+
+  if (branch_and_bound) {
+    h->set_terminate_on_first_solution(false);
+
+    for (const EP *ep : h->get_all()) {
+      uint64_t pps = ep->estimate_throughput_pps();
+      if (!ep->get_next_node() && (!incumbent || pps > incumbent_pps)) {
+        incumbent = ep;
+        incumbent_pps = pps;
+      }
+    }
+  }
+}
+
+template <class HCfg> bool SearchEngine<HCfg>::step() {
+  // Pruning against a shared incumbent can empty the frontier.
+  if (done || h->size() == 0) {
+    return false;
+  }
+
+  InstrumentationScope scope("step");
+  report_progress(meta, h->size());
+
+  meta.elapsed_time = resumed_elapsed_time +
+                      std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now() - start_search)
+                          .count();
+
+  // Before the heuristic draws the random numbers that pick the next EP, which
+  // a resumed search draws again.
+  if (checkpointing &&
+      meta.elapsed_time - last_checkpoint >= checkpoint_cfg.interval) {
+    build_checkpoint(bdd.get(), h, meta, generated, seen_eps, paths)
+        .save(checkpoint_cfg.file);
+    last_checkpoint = meta.elapsed_time;
+  }
+
+  if (h->finished()) {
+    return false;
+  }
+
+  const EP *ep = h->pop();
+
+  // The EP leaves the frontier, but its children extend its path.
+  ep_path_t path;
+  if (checkpointing) {
+    path = std::move(paths.at(ep->get_id()));
+    paths.erase(ep->get_id());
+  }
+
+  std::optional<uint64_t> best_known_pps = get_best_known_pps();
+  if (best_known_pps && get_throughput_upper_bound(ep) < *best_known_pps) {
+    meta.pruned++;
+    search_space->drop_leaf(ep);
+    delete ep;
+    return true;
+  }
+
+  search_space->activate_leaf(ep);
+
+  meta.avg_bdd_size *= meta.steps;
+  meta.avg_bdd_size += ep->get_bdd()->size();
+  meta.steps++;
+  meta.avg_bdd_size /= meta.steps;
+
+  if (search_space->is_backtrack()) {
+    meta.backtracks++;
+    peek_backtrack(ep, search_space, pause_and_show_on_backtrack);
+  }
+
+  const bdd::Node *node = ep->get_next_node();
+  search_step_report_t report(h->size(), ep, node);
+
+  float &avg_node_children = meta.avg_children_per_node[node->get_id()];
+  int &node_visits = meta.visits_per_node[node->get_id()];
+
+  std::vector<const EP *> new_eps;
+
+  uint64_t children = 0;
+  uint32_t modgen_idx = 0;
+  for (const Target *target : targets) {
+    for (const ModuleGenerator *modgen : target->module_generators) {
+      InstrumentationScope modgen_scope(modgen_phases[modgen_idx]);
+      std::vector<generator_product_t> modgen_products;
+      uint32_t product_idx = 0;
+
+      for (const generator_product_t &product :
+           modgen->generate(ep, node, allow_bdd_reordering)) {
+        ep_decision_t decision = {modgen_idx, product_idx++};
+        generated++;
+
+        if (!seen_eps.insert(product.ep->hash()).second) {
+          meta.duplicates++;
+          delete product.ep;
+          continue;
         }
 
-        if (target->type == TargetType::Tofino) {
-          children += modgen_products.size();
+        if (checkpointing) {
+          ep_path_t &product_path = paths[product.ep->get_id()];
+          product_path = path;
+          product_path.push_back(decision);
         }
+
+        modgen_products.push_back(product);
       }
-    }
 
-    if (children > 1) {
-      avg_node_children *= node_visits;
-      avg_node_children += children;
-      node_visits++;
-      avg_node_children /= node_visits;
+      modgen_idx++;
 
-      meta.branching_factor = 0;
-      for (const auto &kv : meta.avg_children_per_node)
-        meta.branching_factor += std::max(1.0f, kv.second);
-      meta.branching_factor /= meta.avg_children_per_node.size();
+      search_space->add_to_active_leaf(ep, node, modgen, modgen_products);
+      report.save(modgen, modgen_products);
+
+      for (const generator_product_t &product : modgen_products) {
+        new_eps.push_back(product.ep);
+      }
 
-      meta.total_ss_size_estimation = 0;
-      for (const auto &[id, depth] : node_depth) {
-        meta.total_ss_size_estimation += pow(meta.branching_factor, depth + 1);
+      if (target->type == TargetType::Tofino) {
+        children += modgen_products.size();
       }
     }
+  }
 
-    meta.ss_size = search_space->get_size();
-    meta.solutions = h->size();
+  if (children > 1) {
+    avg_node_children *= node_visits;
+    avg_node_children += children;
+    node_visits++;
+    avg_node_children /= node_visits;
 
-    h->add(new_eps);
+    meta.branching_factor = 0;
+    for (const auto &kv : meta.avg_children_per_node)
+      meta.branching_factor += std::max(1.0f, kv.second);
+    meta.branching_factor /= meta.avg_children_per_node.size();
 
-    log_search_iteration(report, meta);
-    peek_search_space(new_eps, peek, search_space);
+    meta.total_ss_size_estimation = 0;
+    for (const auto &[id, depth] : node_depth) {
+      meta.total_ss_size_estimation += pow(meta.branching_factor, depth + 1);
+    }
+  }
 
-    delete ep;
+  meta.ss_size = search_space->get_size();
+  meta.solutions = h->size();
+  meta.dedupe_rate = (float)meta.duplicates / generated;
+
+  h->add(new_eps);
+
+  log_search_iteration(report, meta);
+  peek_search_space(new_eps, peek, search_space);
+
+  delete ep;
+
+  if (!branch_and_bound) {
+    return true;
+  }
+
+  // Complete EPs are never popped, so the heuristic keeps owning them.
+  for (const EP *new_ep : new_eps) {
+    if (new_ep->get_next_node()) {
+      continue;
+    }
+
+    uint64_t pps = new_ep->estimate_throughput_pps();
+    if (!incumbent || pps > incumbent_pps) {
+      incumbent = new_ep;
+      incumbent_pps = pps;
+    }
+  }
+
+  if (incumbent && max_optimality_gap > 0) {
+    meta.optimality_gap = get_optimality_gap(h, incumbent_pps);
+    if (meta.optimality_gap <= max_optimality_gap) {
+      done = true;
+    }
   }
 
+  return !done;
+}
+
+template <class HCfg> search_report_t SearchEngine<HCfg>::finish() {
   meta.ss_size = search_space->get_size();
   meta.solutions = h->size();
 
-  EP *winner = new EP(*h->get());
+  if (incumbent) {
+    meta.optimality_gap = get_optimality_gap(h, incumbent_pps);
+  }
+
+  const EP *best = incumbent;
+  if (!best && h->size() > 0) {
+    best = h->get();
+  }
+
+  // The frontier ran dry (or the search was stopped) before completing an EP.
+  if (best && best->get_next_node()) {
+    best = nullptr;
+  }
 
   const search_config_t config = {
       .heuristic = h->get_cfg()->name,
+      .branch_and_bound = branch_and_bound,
   };
 
-  const search_solution_t solution = {
-      .ep = winner,
+  search_solution_t solution = {
+      .ep = nullptr,
       .search_space = search_space,
-      .score = h->get_score(winner),
-      .throughput_estimation =
-          SearchSpace::build_meta_throughput_estimate(winner),
-      .throughput_speculation =
-          SearchSpace::build_meta_throughput_speculation(winner),
+      .score = std::nullopt,
+      .throughput_estimation = "",
+      .throughput_speculation = "",
   };
 
+  if (best) {
+    EP *winner = new EP(*best);
+    solution.ep = winner;
+    solution.score = h->get_score(winner);
+    solution.throughput_estimation =
+        SearchSpace::build_meta_throughput_estimate(winner);
+    solution.throughput_speculation =
+        SearchSpace::build_meta_throughput_speculation(winner);
+  }
+
+  // The report owns it now.
+  search_space = nullptr;
+
   search_report_t report = {
       .config = config,
       .solution = solution,
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <unordered_set>
 
@@ -8,11 +10,20 @@
 #include "heuristics/heuristic.h"
 #include "search_space.h"
 #include "profiler.h"
+#include "checkpoint.h"
 
 namespace synapse {
 
 struct search_config_t {
   std::string heuristic;
+  bool branch_and_bound;
+};
+
+struct anytime_point_t {
+  // Milliseconds since the search started.
+  int64_t elapsed_ms;
+  uint64_t pps;
+  std::string heuristic;
 };
 
 struct search_meta_t {
@@ -27,18 +38,34 @@ struct search_meta_t {
   float total_ss_size_estimation;
   int solutions;
 
+  // Generated EPs dropped for being equal to one generated before, and their
+  // fraction of all generated EPs.
+  uint64_t duplicates;
+  float dedupe_rate;
+
+  // Branch and bound only. The gap is relative to the best throughput any
+  // EP could still achieve, so 0 means the winner is proven optimal.
+  uint64_t pruned;
+  double optimality_gap;
+
+  // Portfolio only. Every improvement on the best solution found by any of
+  // the heuristics, in the order they were found.
+  std::vector<anytime_point_t> anytime_curve;
+
   search_meta_t()
       : ss_size(0), elapsed_time(0), steps(0), backtracks(0), avg_bdd_size(0),
-        branching_factor(0), total_ss_size_estimation(0), solutions(0) {}
+        branching_factor(0), total_ss_size_estimation(0), solutions(0),
+        duplicates(0), dedupe_rate(0), pruned(0), optimality_gap(1) {}
 
   search_meta_t(const search_meta_t &other) = default;
   search_meta_t(search_meta_t &&other) = default;
 };
 
+// Without a solution (every EP was a dead end), only the search space is set.
 struct search_solution_t {
   const EP *ep;
   const SearchSpace *search_space;
-  Score score;
+  std::optional<Score> score;
   std::string throughput_estimation;
   std::string throughput_speculation;
 };
@@ -49,9 +76,38 @@ struct search_report_t {
   const search_meta_t meta;
 };
 
-template <class HCfg> class SearchEngine {
+// Searches in steps, so that a portfolio can share solutions between them.
+class SearchEngineBase {
+public:
+  virtual ~SearchEngineBase() {}
+
+  virtual void start() = 0;
+
+  // Returns false once the search is over.
+  virtual bool step() = 0;
+
+  virtual search_report_t finish() = 0;
+
+  virtual const std::string &get_heuristic_name() const = 0;
+
+  // Throughput of the best complete EP found so far, if any. Only tracked
+  // when branching and bounding.
+  virtual std::optional<uint64_t> get_incumbent_pps() const = 0;
+
+  // Prune against a solution found elsewhere, as if it were found here.
+  virtual void share_incumbent_pps(uint64_t pps) = 0;
+
+  search_report_t search() {
+    start();
+    while (step()) {
+    }
+    return finish();
+  }
+};
+
+template <class HCfg> class SearchEngine : public SearchEngineBase {
 private:
-  std::shared_ptr<bdd::BDD> bdd;
+  std::shared_ptr<const bdd::BDD> bdd;
   Heuristic<HCfg> *h;
   std::shared_ptr<Profiler> profiler;
   const targets_t targets;
@@ -60,11 +116,61 @@ private:
   const std::unordered_set<ep_id_t> peek;
   const bool pause_and_show_on_backtrack;
 
+  // Build the descriptions needed to visualize the search space. Implied by
+  // peeking and by pausing on backtracks.
+  const bool detailed_search_space;
+
+  // Keeps searching after the first solution, pruning the EPs that cannot
+  // beat the best one found so far. Stops once the optimality gap is at most
+  // max_optimality_gap.
+  const bool branch_and_bound;
+  const double max_optimality_gap;
+
+  const checkpoint_cfg_t checkpoint_cfg;
+  const bool checkpointing;
+
+  // Instrumentation phase of each module generator, e.g. "Tofino::Table".
+  const std::vector<std::string> modgen_phases;
+
+  // Search state, from start() to finish().
+  search_meta_t meta;
+  std::chrono::steady_clock::time_point start_search;
+  SearchSpace *search_space;
+
+  // Transposition table: different orderings of the same decisions often
+  // yield the same EP, which only needs to be expanded once. Only hashes are
+  // kept, so that checkpoints stay small and expanded EPs can be freed. A
+  // collision between different EPs wrongly drops the later one, which is
+  // accepted: with 64-bit hashes, even a billion EPs collide with a
+  // probability of about 3%.
+  std::unordered_set<size_t> seen_eps;
+  uint64_t generated;
+
+  std::unordered_map<bdd::node_id_t, int> node_depth;
+
+  // Decisions leading to each EP on the frontier, when checkpointing.
+  std::vector<const ModuleGenerator *> modgens;
+  std::unordered_map<ep_id_t, ep_path_t> paths;
+  time_t resumed_elapsed_time;
+  time_t last_checkpoint;
+
+  // Best complete solution found so far, when branching and bounding.
+  const EP *incumbent;
+  uint64_t incumbent_pps;
+  std::optional<uint64_t> shared_incumbent_pps;
+
+  bool done;
+
 public:
-  SearchEngine(const bdd::BDD *bdd, Heuristic<HCfg> *h, Profiler *profiler,
-               const targets_t &targets, bool allow_bdd_reordering,
+  // Engines can share the BDD and the profiler: EPs never change the BDD, and
+  // copy the profiler before changing it.
+  SearchEngine(std::shared_ptr<const bdd::BDD> bdd, Heuristic<HCfg> *h,
+               std::shared_ptr<Profiler> profiler, const targets_t &targets,
+               bool allow_bdd_reordering,
                const std::unordered_set<ep_id_t> &peek,
-               bool _pause_and_show_on_backtrack);
+               bool _pause_and_show_on_backtrack, bool detailed_search_space,
+               bool branch_and_bound, double max_optimality_gap,
+               const checkpoint_cfg_t &checkpoint_cfg);
 
   SearchEngine(const bdd::BDD *bdd, Heuristic<HCfg> *h, Profiler *profiler,
                const targets_t &_targets);
@@ -74,7 +180,18 @@ public:
 
   SearchEngine &operator=(const SearchEngine &) = delete;
 
-  search_report_t search();
+  ~SearchEngine();
+
+  void start() override;
+  bool step() override;
+  search_report_t finish() override;
+
+  const std::string &get_heuristic_name() const override;
+  std::optional<uint64_t> get_incumbent_pps() const override;
+  void share_incumbent_pps(uint64_t pps) override;
+
+private:
+  std::optional<uint64_t> get_best_known_pps() const;
 };
 
 } // namespace synapse
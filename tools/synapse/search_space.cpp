@@ -11,23 +11,30 @@ void SearchSpace::activate_leaf(const EP *ep) {
 
   if (!root) {
     ss_node_id_t id = node_id_counter++;
-    Score score = hcfg->get_score(ep);
+    std::optional<Score> score;
+    if (detailed) {
+      score = hcfg->get_score(ep);
+    }
     TargetType target = ep->get_current_platform();
+    avg_pkt_bytes = ep->get_ctx().get_profiler()->get_avg_pkt_bytes();
     root = new SSNode(id, ep_id, score, target);
     active_leaf = root;
     return;
   }
 
-  auto ss_node_matcher = [ep_id](const SSNode *node) {
-    return node->ep_id == ep_id;
-  };
-
-  auto found_it = std::find_if(leaves.begin(), leaves.end(), ss_node_matcher);
+  auto found_it = leaves.find(ep_id);
   assert(found_it != leaves.end() && "Leaf not found");
 
-  active_leaf = *found_it;
+  SSNode *previous_leaf = active_leaf;
+
+  active_leaf = found_it->second;
   leaves.erase(found_it);
 
+  // The previous leaf was a dead end.
+  if (previous_leaf->children.empty()) {
+    drop_dead_branch(previous_leaf);
+  }
+
   backtrack = (last_eps.find(ep_id) == last_eps.end());
   last_eps.clear();
 }
@@ -83,40 +90,32 @@ static std::string get_bdd_node_description(const bdd::Node *node) {
   return node_str;
 }
 
-std::string SearchSpace::build_meta_throughput_estimate(const EP *ep) {
-  const Context &ctx = ep->get_ctx();
-  const Profiler *profiler = ctx.get_profiler();
-  int avg_pkt_size = profiler->get_avg_pkt_bytes();
-
-  uint64_t estimate_pps = ep->estimate_throughput_pps();
-  uint64_t estimate_bps = estimate_pps * avg_pkt_size * 8;
+std::string SearchSpace::build_meta_throughput(uint64_t pps,
+                                               int avg_pkt_bytes) {
+  uint64_t bps = pps * avg_pkt_bytes * 8;
 
   std::stringstream ss;
-  ss << throughput2str(estimate_bps, "bps", true);
+  ss << throughput2str(bps, "bps", true);
 
   ss << " (";
-  ss << throughput2str(estimate_pps, "pps", true);
+  ss << throughput2str(pps, "pps", true);
   ss << ")";
 
   return ss.str();
 }
 
-std::string SearchSpace::build_meta_throughput_speculation(const EP *ep) {
+std::string SearchSpace::build_meta_throughput_estimate(const EP *ep) {
   const Context &ctx = ep->get_ctx();
   const Profiler *profiler = ctx.get_profiler();
-  int avg_pkt_size = profiler->get_avg_pkt_bytes();
-
-  uint64_t speculation_pps = ep->speculate_throughput_pps();
-  uint64_t speculation_bps = speculation_pps * avg_pkt_size * 8;
-
-  std::stringstream ss;
-  ss << throughput2str(speculation_bps, "bps", true);
-
-  ss << " (";
-  ss << throughput2str(speculation_pps, "pps", true);
-  ss << ")";
+  return build_meta_throughput(ep->estimate_throughput_pps(),
+                               profiler->get_avg_pkt_bytes());
+}
 
-  return ss.str();
+std::string SearchSpace::build_meta_throughput_speculation(const EP *ep) {
+  const Context &ctx = ep->get_ctx();
+  const Profiler *profiler = ctx.get_profiler();
+  return build_meta_throughput(ep->speculate_throughput_pps(),
+                               profiler->get_avg_pkt_bytes());
 }
 
 void SearchSpace::add_to_active_leaf(
@@ -124,53 +123,134 @@ void SearchSpace::add_to_active_leaf(
     const std::vector<generator_product_t> &products) {
   assert(active_leaf && "Active leaf not set");
 
+  if (products.empty()) {
+    return;
+  }
+
+  // The same for every product, as they all come from the same leaf.
+  std::optional<double> hit_rate;
+  std::string node_description;
+  if (detailed) {
+    hit_rate = ep->get_active_leaf_hit_rate();
+    node_description = get_bdd_node_description(node);
+  }
+
   for (const generator_product_t &product : products) {
     ss_node_id_t id = node_id_counter++;
     ep_id_t ep_id = product.ep->get_id();
-    Score score = hcfg->get_score(product.ep);
     TargetType target = modgen->get_target();
     const bdd::Node *next = product.ep->get_next_node();
 
+    std::optional<Score> score;
+    if (detailed) {
+      score = hcfg->get_score(product.ep);
+    }
+
     module_data_t module_data = {
         .type = modgen->get_type(),
         .name = modgen->get_name(),
         .description = product.description,
         .bdd_reordered = product.bdd_reordered,
-        .hit_rate = ep->get_active_leaf_hit_rate(),
+        .hit_rate = hit_rate,
     };
 
     bdd_node_data_t bdd_node_data = {
         .id = node->get_id(),
-        .description = get_bdd_node_description(node),
+        .description = node_description,
     };
 
     std::optional<bdd_node_data_t> next_bdd_node_data;
     if (next) {
       next_bdd_node_data = {
           .id = next->get_id(),
-          .description = get_bdd_node_description(next),
+          .description = detailed ? get_bdd_node_description(next) : "",
       };
     }
 
-    std::map<std::string, std::string> metadata = {
-        {"Throughput", build_meta_throughput_estimate(product.ep)},
-        {"Speculation", build_meta_throughput_speculation(product.ep)},
-    };
+    SSNode *new_node = new SSNode(
+        id, ep_id, score, target, module_data, bdd_node_data,
+        next_bdd_node_data, product.ep->estimate_throughput_pps(),
+        product.ep->speculate_throughput_pps());
+
+    new_node->parent = active_leaf;
+    active_leaf->children.push_back(new_node);
+    leaves[ep_id] = new_node;
+
+    size++;
+    last_eps.insert(ep_id);
+  }
+}
+
+void SearchSpace::add_resumed_to_active_leaf(
+    const std::vector<const EP *> &eps,
+    const std::vector<TargetType> &targets) {
+  assert(active_leaf && "Active leaf not set");
+  assert(eps.size() == targets.size());
 
-    SSNode *new_node = new SSNode(id, ep_id, score, target, module_data,
-                                  bdd_node_data, next_bdd_node_data, metadata);
+  for (size_t i = 0; i < eps.size(); i++) {
+    const EP *ep = eps[i];
+    ss_node_id_t id = node_id_counter++;
+    ep_id_t ep_id = ep->get_id();
+    TargetType target = targets[i];
+    const bdd::Node *next = ep->get_next_node();
+
+    std::optional<Score> score;
+    if (detailed) {
+      score = hcfg->get_score(ep);
+    }
+
+    SSNode *new_node = new SSNode(id, ep_id, score, target);
 
+    if (next) {
+      new_node->next_bdd_node_data = {
+          .id = next->get_id(),
+          .description = detailed ? get_bdd_node_description(next) : "",
+      };
+    }
+
+    new_node->parent = active_leaf;
     active_leaf->children.push_back(new_node);
-    leaves.push_back(new_node);
+    leaves[ep_id] = new_node;
 
     size++;
     last_eps.insert(ep_id);
   }
 }
 
+void SearchSpace::drop_leaf(const EP *ep) {
+  auto found_it = leaves.find(ep->get_id());
+  assert(found_it != leaves.end() && "Leaf not found");
+
+  SSNode *node = found_it->second;
+  leaves.erase(found_it);
+
+  drop_dead_branch(node);
+}
+
+void SearchSpace::drop_dead_branch(SSNode *node) {
+  if (detailed) {
+    return;
+  }
+
+  while (node != root && node != active_leaf && node->children.empty() &&
+         leaves.find(node->ep_id) == leaves.end()) {
+    SSNode *parent = node->parent;
+
+    auto found_it =
+        std::find(parent->children.begin(), parent->children.end(), node);
+    assert(found_it != parent->children.end() && "Child not found");
+    parent->children.erase(found_it);
+
+    delete node;
+    node = parent;
+  }
+}
+
 SSNode *SearchSpace::get_root() const { return root; }
 size_t SearchSpace::get_size() const { return size; }
 const HeuristicCfg *SearchSpace::get_hcfg() const { return hcfg; }
+bool SearchSpace::is_detailed() const { return detailed; }
 bool SearchSpace::is_backtrack() const { return backtrack; }
+int SearchSpace::get_avg_pkt_bytes() const { return avg_pkt_bytes; }
 
 } // namespace synapse
\ No newline at end of file
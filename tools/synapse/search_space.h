@@ -4,11 +4,13 @@
 #include <assert.h>
 #include <vector>
 #include <optional>
+#include <unordered_map>
 
 #include "heuristics/heuristic.h"
 #include "heuristics/score.h"
 
 #include "execution_plan/execution_plan.h"
+#include "instrumentation.h"
 
 namespace synapse {
 
@@ -19,41 +21,57 @@ struct module_data_t {
   std::string name;
   std::string description;
   bool bdd_reordered;
-  double hit_rate;
+  std::optional<double> hit_rate;
 };
 
 struct bdd_node_data_t {
   bdd::node_id_t id;
+
+  // Empty unless the search space is detailed.
   std::string description;
 };
 
 struct SSNode {
   ss_node_id_t node_id;
   ep_id_t ep_id;
-  Score score;
+  std::optional<Score> score;
   TargetType target;
   std::optional<module_data_t> module_data;
   std::optional<bdd_node_data_t> bdd_node_data;
   std::optional<bdd_node_data_t> next_bdd_node_data;
-  std::map<std::string, std::string> metadata;
+  uint64_t throughput_estimate_pps;
+  uint64_t throughput_speculation_pps;
+  SSNode *parent;
   std::vector<SSNode *> children;
 
-  SSNode(ss_node_id_t _node_id, ep_id_t _ep_id, const Score &_score,
-         TargetType _target, const module_data_t &_module_data,
+  SSNode(ss_node_id_t _node_id, ep_id_t _ep_id,
+         const std::optional<Score> &_score, TargetType _target,
+         const module_data_t &_module_data,
          const bdd_node_data_t &_bdd_node_data,
          const std::optional<bdd_node_data_t> &_next_bdd_node_data,
-         const std::map<std::string, std::string> &_metadata)
+         uint64_t _throughput_estimate_pps,
+         uint64_t _throughput_speculation_pps)
       : node_id(_node_id), ep_id(_ep_id), score(_score), target(_target),
         module_data(_module_data), bdd_node_data(_bdd_node_data),
-        next_bdd_node_data(_next_bdd_node_data), metadata(_metadata) {}
+        next_bdd_node_data(_next_bdd_node_data),
+        throughput_estimate_pps(_throughput_estimate_pps),
+        throughput_speculation_pps(_throughput_speculation_pps),
+        parent(nullptr) {
+    Instrumentation::count_allocation(AllocationKind::SSNode);
+  }
 
-  SSNode(ss_node_id_t _node_id, ep_id_t _ep_id, const Score &_score,
-         TargetType _target)
+  SSNode(ss_node_id_t _node_id, ep_id_t _ep_id,
+         const std::optional<Score> &_score, TargetType _target)
       : node_id(_node_id), ep_id(_ep_id), score(_score), target(_target),
         module_data(std::nullopt), bdd_node_data(std::nullopt),
-        next_bdd_node_data(std::nullopt) {}
+        next_bdd_node_data(std::nullopt), throughput_estimate_pps(0),
+        throughput_speculation_pps(0), parent(nullptr) {
+    Instrumentation::count_allocation(AllocationKind::SSNode);
+  }
 
   ~SSNode() {
+    Instrumentation::count_deallocation(AllocationKind::SSNode);
+
     for (SSNode *child : children) {
       if (child) {
         delete child;
@@ -67,17 +85,27 @@ class SearchSpace {
 private:
   SSNode *root;
   SSNode *active_leaf;
-  std::vector<SSNode *> leaves;
+  std::unordered_map<ep_id_t, SSNode *> leaves;
   size_t size;
   const HeuristicCfg *hcfg;
 
+  // Scores, hit rates and BDD node descriptions are only needed to visualize
+  // the search space, and are too expensive to build on every step otherwise
+  // (the hit rate goes through the solver).
+  //
+  // Without them, nobody visualizes the search space, so the subtrees with no
+  // EP left on the frontier are dropped as soon as they die. This keeps the
+  // frontier and the ancestry of every solution.
+  const bool detailed;
+  int avg_pkt_bytes;
+
   std::unordered_set<ss_node_id_t> last_eps;
   bool backtrack;
 
 public:
-  SearchSpace(const HeuristicCfg *_hcfg)
+  SearchSpace(const HeuristicCfg *_hcfg, bool _detailed)
       : root(nullptr), active_leaf(nullptr), size(0), hcfg(_hcfg),
-        backtrack(false) {}
+        detailed(_detailed), avg_pkt_bytes(0), backtrack(false) {}
 
   SearchSpace(const SearchSpace &) = delete;
   SearchSpace(SearchSpace &&) = delete;
@@ -91,13 +119,28 @@ public:
                           const ModuleGenerator *mogden,
                           const std::vector<generator_product_t> &products);
 
+  // A resumed search does not know how the EPs on its frontier were built, so
+  // they are attached directly to the active leaf. Each comes with the target
+  // of the module that extended it last, as complete EPs have no platform.
+  void add_resumed_to_active_leaf(const std::vector<const EP *> &eps,
+                                  const std::vector<TargetType> &targets);
+
+  // For EPs leaving the frontier without being expanded (e.g. pruned).
+  void drop_leaf(const EP *ep);
+
   SSNode *get_root() const;
   size_t get_size() const;
   const HeuristicCfg *get_hcfg() const;
+  bool is_detailed() const;
   bool is_backtrack() const;
+  int get_avg_pkt_bytes() const;
 
+  static std::string build_meta_throughput(uint64_t pps, int avg_pkt_bytes);
   static std::string build_meta_throughput_estimate(const EP *ep);
   static std::string build_meta_throughput_speculation(const EP *ep);
+
+private:
+  void drop_dead_branch(SSNode *node);
 };
 
 } // namespace synapse
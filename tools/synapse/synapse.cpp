@@ -31,6 +31,8 @@
 #include "visualizers/profiler_visualizer.h"
 #include "heuristics/heuristics.h"
 #include "search.h"
+#include "portfolio.h"
+#include "instrumentation.h"
 #include "synthesizers/synthesizers.h"
 
 using namespace synapse;
@@ -74,6 +76,18 @@ llvm::cl::opt<bool> ShowBacktrack("backtrack",
                                   llvm::cl::init(false),
                                   llvm::cl::cat(SyNAPSE));
 
+llvm::cl::opt<bool> BranchAndBound(
+    "bnb",
+    llvm::cl::desc("Keep searching after the first solution, pruning the "
+                   "execution plans that cannot beat the best one found."),
+    llvm::cl::ValueDisallowed, llvm::cl::init(false), llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<double>
+    BnBGap("bnb-gap",
+           llvm::cl::desc("Stop the branch and bound search once the winner "
+                          "is within this relative gap of the optimum."),
+           llvm::cl::init(0), llvm::cl::cat(SyNAPSE));
+
 llvm::cl::list<int>
     Peek("peek", llvm::cl::desc("Peek search space at these Execution Plans."),
          llvm::cl::Positional, llvm::cl::ZeroOrMore, llvm::cl::cat(SyNAPSE));
@@ -84,12 +98,31 @@ llvm::cl::opt<std::string> BDDProfile("prof",
                                       llvm::cl::Optional,
                                       llvm::cl::cat(SyNAPSE));
 
+llvm::cl::opt<std::string>
+    CPUPerfParams("cpu-perf",
+                  llvm::cl::desc("x86 and Tofino CPU performance model JSON."),
+                  llvm::cl::ValueRequired, llvm::cl::Optional,
+                  llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<tofino::PipeStatePolicy> PipeState(
+    "pipe-state",
+    llvm::cl::desc("Layout of the Tofino data plane state across pipes."),
+    llvm::cl::values(clEnumValN(tofino::PipeStatePolicy::REPLICATE,
+                                "replicate", "Replicate it on every pipe"),
+                     clEnumValN(tofino::PipeStatePolicy::STEER, "steer",
+                                "Keep it on a single pipe and steer traffic "
+                                "to it"),
+                     clEnumValEnd),
+    llvm::cl::init(tofino::PipeStatePolicy::REPLICATE),
+    llvm::cl::cat(SyNAPSE));
+
 enum class HeuristicOption {
   BFS,
   DFS,
   RANDOM,
   GALLIUM,
   MAX_THROUGHPUT,
+  MCTS,
 };
 
 llvm::cl::opt<HeuristicOption> ChosenHeuristic(
@@ -100,51 +133,226 @@ llvm::cl::opt<HeuristicOption> ChosenHeuristic(
                      clEnumValN(HeuristicOption::GALLIUM, "gallium", "Gallium"),
                      clEnumValN(HeuristicOption::MAX_THROUGHPUT,
                                 "max-throughput", "Maximize throughput"),
+                     clEnumValN(HeuristicOption::MCTS, "mcts",
+                                "Monte Carlo Tree Search"),
+                     clEnumValEnd),
+    llvm::cl::cat(SyNAPSE));
+
+llvm::cl::list<HeuristicOption> PortfolioHeuristics(
+    "portfolio",
+    llvm::cl::desc("Run these heuristics concurrently, sharing the best "
+                   "solution found (instead of a single -heuristic)."),
+    llvm::cl::values(clEnumValN(HeuristicOption::BFS, "bfs", "BFS"),
+                     clEnumValN(HeuristicOption::DFS, "dfs", "DFS"),
+                     clEnumValN(HeuristicOption::RANDOM, "random", "Random"),
+                     clEnumValN(HeuristicOption::GALLIUM, "gallium", "Gallium"),
+                     clEnumValN(HeuristicOption::MAX_THROUGHPUT,
+                                "max-throughput", "Maximize throughput"),
+                     clEnumValN(HeuristicOption::MCTS, "mcts",
+                                "Monte Carlo Tree Search"),
                      clEnumValEnd),
-    llvm::cl::Required, llvm::cl::cat(SyNAPSE));
+    llvm::cl::CommaSeparated, llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<int> PortfolioDeadline(
+    "deadline",
+    llvm::cl::desc("Seconds after which the portfolio returns its best "
+                   "solution, failing if there is none yet (default 0, run "
+                   "until every heuristic is done)."),
+    llvm::cl::ValueRequired, llvm::cl::init(0), llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<int> MCTSBudget(
+    "mcts-budget",
+    llvm::cl::desc("Seconds MCTS keeps improving its solution (default 60)."),
+    llvm::cl::ValueRequired, llvm::cl::init(60), llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<uint64_t> MCTSRollouts(
+    "mcts-rollouts",
+    llvm::cl::desc("Rollouts after which MCTS stops (default unlimited)."),
+    llvm::cl::ValueRequired, llvm::cl::init(0), llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<std::string> Checkpoint(
+    "checkpoint",
+    llvm::cl::desc("File where the search is periodically checkpointed."),
+    llvm::cl::ValueRequired, llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<int> CheckpointInterval(
+    "checkpoint-interval",
+    llvm::cl::desc("Seconds between checkpoints (default 600)."),
+    llvm::cl::ValueRequired, llvm::cl::init(600), llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<bool>
+    Resume("resume",
+           llvm::cl::desc("Resume the search from the checkpoint file. "
+                          "Requires the same BDD, profile and seed."),
+           llvm::cl::ValueDisallowed, llvm::cl::init(false),
+           llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<std::string> Stats(
+    "stats",
+    llvm::cl::desc("File where search stats are streamed, as JSON lines."),
+    llvm::cl::ValueRequired, llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<int>
+    StatsInterval("stats-interval",
+                  llvm::cl::desc("Seconds between stats (default 1)."),
+                  llvm::cl::ValueRequired, llvm::cl::init(1),
+                  llvm::cl::cat(SyNAPSE));
+
+llvm::cl::opt<std::string> FlameGraph(
+    "flamegraph",
+    llvm::cl::desc("File where the time spent on each phase of the search is "
+                   "dumped, as folded stacks for flame graphs."),
+    llvm::cl::ValueRequired, llvm::cl::cat(SyNAPSE));
 
 llvm::cl::opt<bool> Verbose("v", llvm::cl::desc("Verbose mode."),
                             llvm::cl::ValueDisallowed, llvm::cl::init(false),
                             llvm::cl::cat(SyNAPSE));
 } // namespace
 
-search_report_t search(const bdd::BDD *bdd, Profiler *profiler,
+search_report_t portfolio_search(std::shared_ptr<const bdd::BDD> bdd,
+                                 std::shared_ptr<Profiler> profiler,
+                                 const targets_t &targets,
+                                 const std::unordered_set<ep_id_t> &peek) {
+  if (ChosenHeuristic.getNumOccurrences() > 0) {
+    Log::err() << "Choose either a heuristic or a portfolio, not both.\n";
+    exit(1);
+  }
+
+  if (!Checkpoint.empty() || Resume) {
+    Log::err() << "Portfolio searches cannot be checkpointed or resumed.\n";
+    exit(1);
+  }
+
+  BFS bfs;
+  DFS dfs;
+  Random random;
+  Gallium gallium;
+  MaxThroughput max_throughput;
+  MCTS mcts(MCTSBudget, MCTSRollouts);
+
+  Portfolio portfolio(PortfolioDeadline);
+  std::unordered_set<HeuristicOption> chosen;
+
+  // Engines must branch and bound to prune against each other's solutions.
+  for (HeuristicOption option : PortfolioHeuristics) {
+    if (!chosen.insert(option).second) {
+      continue;
+    }
+
+    switch (option) {
+    case HeuristicOption::BFS: {
+      portfolio.add(new SearchEngine(bdd, &bfs, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    case HeuristicOption::DFS: {
+      portfolio.add(new SearchEngine(bdd, &dfs, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    case HeuristicOption::RANDOM: {
+      portfolio.add(new SearchEngine(bdd, &random, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    case HeuristicOption::GALLIUM: {
+      portfolio.add(new SearchEngine(bdd, &gallium, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    case HeuristicOption::MAX_THROUGHPUT: {
+      portfolio.add(new SearchEngine(bdd, &max_throughput, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    case HeuristicOption::MCTS: {
+      portfolio.add(new SearchEngine(bdd, &mcts, profiler, targets,
+                                     !BDDNoReorder, peek, ShowBacktrack,
+                                     ShowSS, true, BnBGap, {"", 0, false}));
+    } break;
+    }
+  }
+
+  return portfolio.search();
+}
+
+search_report_t search(std::shared_ptr<const bdd::BDD> bdd,
+                       std::shared_ptr<Profiler> profiler,
                        const targets_t &targets) {
   std::unordered_set<ep_id_t> peek;
   for (ep_id_t ep_id : Peek) {
     peek.insert(ep_id);
   }
 
+  if (!PortfolioHeuristics.empty()) {
+    return portfolio_search(bdd, profiler, targets, peek);
+  }
+
+  if (ChosenHeuristic.getNumOccurrences() == 0) {
+    Log::err() << "Choose a heuristic, or a portfolio of them.\n";
+    exit(1);
+  }
+
+  if (Resume && Checkpoint.empty()) {
+    Log::err() << "Resuming requires a checkpoint file.\n";
+    exit(1);
+  }
+
+  // Checkpoints hold the frontier, but not the tree statistics MCTS chooses
+  // by, so it could not resume where it left off.
+  if (!Checkpoint.empty() && ChosenHeuristic == HeuristicOption::MCTS) {
+    Log::err() << "MCTS searches cannot be checkpointed.\n";
+    exit(1);
+  }
+
+  checkpoint_cfg_t checkpoint_cfg = {
+      .file = Checkpoint,
+      .interval = CheckpointInterval,
+      .resume = Resume,
+  };
+
   // A bit disgusting, but oh well...
   switch (ChosenHeuristic) {
   case HeuristicOption::BFS: {
     BFS heuristic;
     SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
-                        ShowBacktrack);
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
     return engine.search();
   } break;
   case HeuristicOption::DFS: {
     DFS heuristic;
     SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
-                        ShowBacktrack);
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
     return engine.search();
   } break;
   case HeuristicOption::RANDOM: {
     Random heuristic;
     SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
-                        ShowBacktrack);
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
     return engine.search();
   } break;
   case HeuristicOption::GALLIUM: {
     Gallium heuristic;
     SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
-                        ShowBacktrack);
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
     return engine.search();
   } break;
   case HeuristicOption::MAX_THROUGHPUT: {
     MaxThroughput heuristic;
     SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
-                        ShowBacktrack);
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
+    return engine.search();
+  } break;
+  case HeuristicOption::MCTS: {
+    MCTS heuristic(MCTSBudget, MCTSRollouts);
+    SearchEngine engine(bdd, &heuristic, profiler, targets, !BDDNoReorder, peek,
+                        ShowBacktrack, ShowSS, BranchAndBound, BnBGap,
+                        checkpoint_cfg);
     return engine.search();
   } break;
   }
@@ -168,26 +376,48 @@ int main(int argc, char **argv) {
     Log::MINIMUM_LOG_LEVEL = Log::Level::LOG;
   }
 
-  bdd::BDD *bdd = new bdd::BDD(InputBDDFile);
+  if (!Stats.empty() || !FlameGraph.empty()) {
+    Instrumentation::enable();
+  }
+
+  if (!Stats.empty()) {
+    Instrumentation::set_stream(Stats, StatsInterval);
+  }
+
+  std::shared_ptr<bdd::BDD> bdd = std::make_shared<bdd::BDD>(InputBDDFile);
 
   unsigned seed = (Seed >= 0) ? Seed : std::random_device()();
   RandomEngine::seed(seed);
 
-  Profiler *profiler = nullptr;
+  std::shared_ptr<Profiler> profiler;
   if (!BDDProfile.empty()) {
-    profiler = new Profiler(bdd, BDDProfile);
+    profiler = std::make_shared<Profiler>(bdd.get(), BDDProfile);
   } else {
-    profiler = new Profiler(bdd);
+    profiler = std::make_shared<Profiler>(bdd.get());
   }
 
   profiler->log_debug();
   // ProfilerVisualizer::visualize(bdd, profiler, true);
 
-  targets_t targets = build_targets(profiler);
+  cpu_perf_params_t x86_params = default_x86_perf_params();
+  cpu_perf_params_t tofino_cpu_params = default_tofino_cpu_perf_params();
+
+  if (!CPUPerfParams.empty()) {
+    parse_cpu_perf_params(CPUPerfParams, x86_params, tofino_cpu_params);
+  }
+
+  targets_t targets =
+      build_targets(profiler.get(), PipeState, x86_params, tofino_cpu_params);
 
   // std::string nf_name = nf_name_from_bdd(InputBDDFile);
   search_report_t report = search(bdd, profiler, targets);
 
+  Instrumentation::tick(true);
+
+  if (!FlameGraph.empty()) {
+    Instrumentation::dump_folded_stacks(FlameGraph);
+  }
+
   Log::log() << "\n";
   Log::log() << "Params:\n";
   Log::log() << "  Heuristic:        " << report.config.heuristic << "\n";
@@ -202,8 +432,35 @@ int main(int argc, char **argv) {
   Log::log() << "  Avg BDD size:     " << int2hr(report.meta.avg_bdd_size)
              << "\n";
   Log::log() << "  Solutions:        " << int2hr(report.meta.solutions) << "\n";
+  Log::log() << "  Duplicates:       " << int2hr(report.meta.duplicates) << " ("
+             << 100 * report.meta.dedupe_rate << "%)\n";
+  if (report.config.branch_and_bound) {
+    Log::log() << "  Pruned:           " << int2hr(report.meta.pruned) << "\n";
+    Log::log() << "  Optimality gap:   " << 100 * report.meta.optimality_gap
+               << "%\n";
+  }
+  if (!report.meta.anytime_curve.empty()) {
+    Log::log() << "Anytime curve:\n";
+    for (const anytime_point_t &point : report.meta.anytime_curve) {
+      Log::log() << "  " << std::setw(8) << point.elapsed_ms << " ms  "
+                 << std::setw(8) << int2hr(point.pps) << " pps  "
+                 << point.heuristic << "\n";
+    }
+  }
+
+  if (!report.solution.ep) {
+    Log::err() << "No solution found.\n";
+
+    if (report.solution.search_space) {
+      delete report.solution.search_space;
+    }
+
+    delete_targets(targets);
+    return 1;
+  }
+
   Log::log() << "Winner EP:\n";
-  Log::log() << "  Winner:           " << report.solution.score << "\n";
+  Log::log() << "  Winner:           " << *report.solution.score << "\n";
   Log::log() << "  Throughput:       " << report.solution.throughput_estimation
              << "\n";
   Log::log() << "  Speculation:      " << report.solution.throughput_speculation
@@ -223,18 +480,14 @@ int main(int argc, char **argv) {
     bdd::BDDVisualizer::visualize(report.solution.ep->get_bdd(), false);
   }
 
-  // synthesize(report.solution.ep, std::string(Out));
+  synthesize(report.solution.ep, std::string(Out));
 
-  if (report.solution.ep) {
-    delete report.solution.ep;
-  }
+  delete report.solution.ep;
 
   if (report.solution.search_space) {
     delete report.solution.search_space;
   }
 
-  delete bdd;
-
   delete_targets(targets);
 
   return 0;
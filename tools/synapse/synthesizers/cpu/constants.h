@@ -0,0 +1,11 @@
+#pragma once
+
+namespace synapse {
+namespace cpu {
+
+const char *const MARKER_STATE = "STATE";
+const char *const MARKER_NF_INIT = "NF_INIT";
+const char *const MARKER_NF_PROCESS = "NF_PROCESS";
+
+} // namespace cpu
+} // namespace synapse
@@ -0,0 +1,800 @@
+#include "synthesizer.h"
+
+namespace synapse {
+namespace cpu {
+
+CPUSynthesizer::CPUSynthesizer(
+    const char *template_fname, const std::filesystem::path &out_file,
+    const bdd::BDD *bdd,
+    const std::unordered_set<ModuleType> &_branching_modules)
+    : Synthesizer(template_fname,
+                  {
+                      {MARKER_STATE, 0},
+                      {MARKER_NF_INIT, 1},
+                      {MARKER_NF_PROCESS, 1},
+                  },
+                  out_file),
+      branching_modules(_branching_modules), var_stacks(1), transpiler(this) {
+  symbol_t device = bdd->get_device();
+  symbol_t time = bdd->get_time();
+  symbol_t packet_len = bdd->get_packet_len();
+
+  add_var("device", device.expr);
+  add_var("now", time.expr);
+  add_var("packet_length", packet_len.expr);
+}
+
+void CPUSynthesizer::visit(const EP *ep, const EPNode *node) {
+  EPVisitor::visit(ep, node);
+
+  const Module *module = node->get_module();
+  ModuleType type = module->get_type();
+
+  if (branching_modules.find(type) != branching_modules.end()) {
+    return;
+  }
+
+  const std::vector<EPNode *> &children = node->get_children();
+  for (const EPNode *child : children) {
+    visit(ep, child);
+  }
+}
+
+void CPUSynthesizer::transpile_state(const bdd::BDD *bdd) {
+  code_builder_t &state_decls = get(MARKER_STATE);
+  code_builder_t &nf_init = get(MARKER_NF_INIT);
+
+  auto declare = [&](addr_t obj, const code_t &prefix, const code_t &type,
+                     StateType state_type) {
+    code_t name = get_unique_var_name(prefix);
+    state[obj] = {name, state_type};
+
+    state_decls.indent();
+    state_decls << "struct " << type << " *" << name << ";\n";
+
+    return name;
+  };
+
+  auto allocate = [&](const code_t &call) {
+    nf_init.indent();
+    nf_init << "if (!" << call << ") {\n";
+    nf_init.inc();
+    nf_init.indent();
+    nf_init << "return false;\n";
+    nf_init.dec();
+    nf_init.indent();
+    nf_init << "}\n";
+  };
+
+  for (const call_t &call : bdd->get_init()) {
+    if (call.function_name == "map_allocate") {
+      klee::ref<klee::Expr> map_out = call.args.at("map_out").out;
+      addr_t obj = kutil::expr_addr_to_obj_addr(map_out);
+      bdd::map_config_t config = bdd::get_map_config(*bdd, obj);
+      code_t name = declare(obj, "map", "Map", StateType::Map);
+
+      allocate("map_allocate(" + std::to_string(config.capacity) + ", " +
+               std::to_string(config.key_size / 8) + ", &" + name + ")");
+    } else if (call.function_name == "vector_allocate") {
+      klee::ref<klee::Expr> vector_out = call.args.at("vector_out").out;
+      addr_t obj = kutil::expr_addr_to_obj_addr(vector_out);
+      bdd::vector_config_t config = bdd::get_vector_config(*bdd, obj);
+      code_t name = declare(obj, "vector", "Vector", StateType::Vector);
+
+      allocate("vector_allocate(" + std::to_string(config.elem_size / 8) +
+               ", " + std::to_string(config.capacity) + ", &" + name + ")");
+    } else if (call.function_name == "dchain_allocate") {
+      klee::ref<klee::Expr> chain_out = call.args.at("chain_out").out;
+      addr_t obj = kutil::expr_addr_to_obj_addr(chain_out);
+      bdd::dchain_config_t config = bdd::get_dchain_config(*bdd, obj);
+      code_t name = declare(obj, "dchain", "DoubleChain", StateType::Dchain);
+
+      allocate("dchain_allocate(" + std::to_string(config.index_range) +
+               ", &" + name + ")");
+    } else if (call.function_name == "sketch_allocate") {
+      klee::ref<klee::Expr> sketch_out = call.args.at("sketch_out").out;
+      addr_t obj = kutil::expr_addr_to_obj_addr(sketch_out);
+      bdd::sketch_config_t config = bdd::get_sketch_config(*bdd, obj);
+      code_t name = declare(obj, "sketch", "Sketch", StateType::Sketch);
+
+      allocate("sketch_allocate(" + std::to_string(config.capacity) + ", " +
+               std::to_string(config.threshold) + ", " +
+               std::to_string(config.key_size / 8) + ", &" + name + ")");
+    } else if (call.function_name == "cht_fill_cht") {
+      klee::ref<klee::Expr> cht = call.args.at("cht").expr;
+      addr_t obj = kutil::expr_addr_to_obj_addr(cht);
+      bdd::cht_config_t config = bdd::get_cht_config(*bdd, obj);
+      const state_t &vector = get_state(obj);
+
+      allocate("cht_fill_cht(" + vector.name + ", " +
+               std::to_string(config.height) + ", " +
+               std::to_string(config.capacity) + ")");
+    } else {
+      assert(false && "Unknown init call");
+    }
+  }
+
+  nf_init.indent();
+  nf_init << "return true;\n";
+}
+
+code_t CPUSynthesizer::transpile(klee::ref<klee::Expr> expr) {
+  return transpiler.transpile(expr);
+}
+
+// Vigor expects keys as pointers to their bytes. If the key is not already in
+// memory, it is built byte by byte into a new array.
+code_t CPUSynthesizer::build_buffer(klee::ref<klee::Expr> expr) {
+  code_t ptr;
+  if (get_buffer_var(expr, ptr)) {
+    return ptr;
+  }
+
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  klee::Expr::Width width = expr->getWidth();
+  assert(width % 8 == 0);
+
+  bytes_t size = width / 8;
+  code_t name = get_unique_var_name("key");
+
+  builder.indent();
+  builder << "uint8_t " << name << "[" << size << "];\n";
+
+  for (bytes_t byte = 0; byte < size; byte++) {
+    klee::ref<klee::Expr> byte_expr =
+        kutil::solver_toolbox.exprBuilder->Extract(expr, byte * 8, 8);
+
+    builder.indent();
+    builder << name << "[" << byte << "] = " << transpile(byte_expr) << ";\n";
+  }
+
+  add_var(name, expr, true);
+  return name;
+}
+
+code_t CPUSynthesizer::get_unique_var_name(const code_t &prefix) {
+  if (var_prefix_usage.find(prefix) == var_prefix_usage.end()) {
+    var_prefix_usage[prefix] = 0;
+  }
+
+  int &counter = var_prefix_usage[prefix];
+
+  code_builder_t builder;
+  builder << prefix << "_" << counter;
+
+  counter++;
+
+  return builder.dump();
+}
+
+code_t CPUSynthesizer::slice_var(const var_t &var, unsigned offset,
+                                 bits_t size) const {
+  assert(offset + size <= var.expr->getWidth());
+
+  code_builder_t builder;
+
+  if (!var.is_buffer) {
+    if (offset == 0 && size == var.expr->getWidth()) {
+      return var.name;
+    }
+
+    builder << "(" << var.name << " >> " << offset << ")";
+    return truncate(size, builder.dump());
+  }
+
+  code_t ptr = var.name;
+  if (offset > 0) {
+    ptr = "(" + var.name + " + " + std::to_string(offset / 8) + ")";
+  }
+
+  if (size > 64) {
+    return ptr;
+  }
+
+  builder << "load<" << type_from_width(size) << ">(" << ptr << ", "
+          << (size + 7) / 8 << ")";
+
+  if (size % 8 != 0) {
+    return truncate(size, builder.dump());
+  }
+
+  return builder.dump();
+}
+
+bool CPUSynthesizer::get_var(klee::ref<klee::Expr> expr,
+                             var_t &out_var) const {
+  klee::Expr::Width expr_bits = expr->getWidth();
+
+  for (auto it = var_stacks.rbegin(); it != var_stacks.rend(); ++it) {
+    const vars_t &vars = *it;
+    for (const var_t &var : vars) {
+      klee::Expr::Width var_bits = var.expr->getWidth();
+
+      if (expr_bits > var_bits) {
+        continue;
+      }
+
+      for (bits_t offset = 0; offset <= var_bits - expr_bits; offset += 8) {
+        klee::ref<klee::Expr> var_slice = var.expr;
+
+        if (expr_bits != var_bits) {
+          var_slice = kutil::solver_toolbox.exprBuilder->Extract(
+              var.expr, offset, expr_bits);
+        }
+
+        if (!kutil::solver_toolbox.are_exprs_always_equal(var_slice, expr)) {
+          continue;
+        }
+
+        out_var = var;
+        out_var.name = slice_var(var, offset, expr_bits);
+        out_var.expr = expr;
+        out_var.is_buffer = var.is_buffer && expr_bits > 64;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool CPUSynthesizer::get_buffer_var(klee::ref<klee::Expr> expr,
+                                    code_t &out_ptr) const {
+  klee::Expr::Width expr_bits = expr->getWidth();
+
+  for (auto it = var_stacks.rbegin(); it != var_stacks.rend(); ++it) {
+    const vars_t &vars = *it;
+    for (const var_t &var : vars) {
+      klee::Expr::Width var_bits = var.expr->getWidth();
+
+      if (!var.is_buffer || expr_bits > var_bits) {
+        continue;
+      }
+
+      for (bits_t offset = 0; offset <= var_bits - expr_bits; offset += 8) {
+        klee::ref<klee::Expr> var_slice = var.expr;
+
+        if (expr_bits != var_bits) {
+          var_slice = kutil::solver_toolbox.exprBuilder->Extract(
+              var.expr, offset, expr_bits);
+        }
+
+        if (!kutil::solver_toolbox.are_exprs_always_equal(var_slice, expr)) {
+          continue;
+        }
+
+        out_ptr = var.name;
+        if (offset > 0) {
+          out_ptr = "(" + var.name + " + " + std::to_string(offset / 8) + ")";
+        }
+
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void CPUSynthesizer::add_var(const code_t &name, klee::ref<klee::Expr> expr,
+                             bool is_buffer) {
+  var_stacks.back().emplace_back(name, expr, is_buffer);
+}
+
+void CPUSynthesizer::push_vars() { var_stacks.emplace_back(); }
+
+void CPUSynthesizer::pop_vars() { var_stacks.pop_back(); }
+
+const CPUSynthesizer::state_t &CPUSynthesizer::get_state(addr_t obj) const {
+  auto found_it = state.find(obj);
+  assert(found_it != state.end() && "State not found");
+  return found_it->second;
+}
+
+code_t CPUSynthesizer::get_buffer(addr_t addr) const {
+  auto found_it = buffers.find(addr);
+  assert(found_it != buffers.end() && "Buffer not found");
+  return found_it->second;
+}
+
+code_t CPUSynthesizer::type_from_expr(klee::ref<klee::Expr> expr) {
+  klee::Expr::Width width = expr->getWidth();
+  assert(width != klee::Expr::InvalidWidth);
+  return type_from_width(width);
+}
+
+code_t CPUSynthesizer::type_from_width(bits_t width) {
+  if (width <= 8) {
+    return "uint8_t";
+  }
+
+  if (width <= 16) {
+    return "uint16_t";
+  }
+
+  if (width <= 32) {
+    return "uint32_t";
+  }
+
+  assert(width <= 64 && "Values wider than 64 bits must live in buffers");
+  return "uint64_t";
+}
+
+code_t CPUSynthesizer::truncate(bits_t width, const code_t &code) {
+  code_t type = type_from_width(width);
+
+  if (width == 8 || width == 16 || width == 32 || width == 64) {
+    return "(" + type + ")(" + code + ")";
+  }
+
+  uint64_t mask = (1ull << width) - 1;
+
+  std::stringstream mask_stream;
+  mask_stream << "0x" << std::hex << mask << "ull";
+
+  return "((" + type + ")(" + code + ") & " + mask_stream.str() + ")";
+}
+
+void CPUSynthesizer::branch(const EP *ep, const EPNode *ep_node,
+                            klee::ref<klee::Expr> condition) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const std::vector<EPNode *> &children = ep_node->get_children();
+  assert(children.size() == 2);
+
+  const EPNode *then_node = children[0];
+  const EPNode *else_node = children[1];
+
+  builder.indent();
+  builder << "if (" << transpile(condition) << ") {\n";
+
+  builder.inc();
+  push_vars();
+  visit(ep, then_node);
+  pop_vars();
+  builder.dec();
+
+  builder.indent();
+  builder << "} else {\n";
+
+  builder.inc();
+  push_vars();
+  visit(ep, else_node);
+  pop_vars();
+  builder.dec();
+
+  builder.indent();
+  builder << "}\n";
+}
+
+void CPUSynthesizer::forward(int dst_device) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  builder.indent();
+  builder << "return " << dst_device << ";\n";
+}
+
+void CPUSynthesizer::drop() {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  builder.indent();
+  builder << "return DROP;\n";
+}
+
+void CPUSynthesizer::broadcast() {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  builder.indent();
+  builder << "return FLOOD;\n";
+}
+
+void CPUSynthesizer::parse_header(addr_t chunk_addr,
+                                  klee::ref<klee::Expr> chunk,
+                                  klee::ref<klee::Expr> length) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  code_t name = get_unique_var_name("hdr");
+
+  builder.indent();
+  builder << "uint8_t *" << name << " = cursor;\n";
+
+  builder.indent();
+  builder << "cursor += " << transpile(length) << ";\n";
+
+  add_var(name, chunk, true);
+  buffers[chunk_addr] = name;
+}
+
+void CPUSynthesizer::modify_header(addr_t chunk_addr,
+                                   const std::vector<modification_t> &changes) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  code_t hdr = get_buffer(chunk_addr);
+
+  for (const modification_t &mod : changes) {
+    builder.indent();
+    builder << hdr << "[" << mod.byte << "] = " << transpile(mod.expr)
+            << ";\n";
+  }
+}
+
+void CPUSynthesizer::checksum_update(addr_t ip_hdr_addr, addr_t l4_hdr_addr,
+                                     const symbol_t &checksum) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  code_t name = get_unique_var_name("checksum");
+
+  builder.indent();
+  builder << "uint16_t " << name << " = rte_ipv4_udptcp_cksum(";
+  builder << "(struct rte_ipv4_hdr *)" << get_buffer(ip_hdr_addr) << ", ";
+  builder << get_buffer(l4_hdr_addr) << ");\n";
+
+  add_var(name, checksum.expr);
+}
+
+void CPUSynthesizer::map_get(addr_t map_addr, klee::ref<klee::Expr> key,
+                             klee::ref<klee::Expr> value_out,
+                             klee::ref<klee::Expr> map_has_this_key) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &map = get_state(map_addr);
+  code_t key_ptr = build_buffer(key);
+  code_t value = get_unique_var_name("value");
+  code_t has_key = get_unique_var_name("map_has_this_key");
+
+  builder.indent();
+  builder << "int " << value << ";\n";
+
+  builder.indent();
+  builder << "int " << has_key << " = map_get(" << map.name << ", " << key_ptr
+          << ", &" << value << ");\n";
+
+  add_var(value, value_out);
+
+  if (!map_has_this_key.isNull()) {
+    add_var(has_key, map_has_this_key);
+  }
+}
+
+// Vigor maps keep pointers to the keys, so these must outlive the call. NFs
+// always keep them in a vector cell.
+void CPUSynthesizer::map_put(addr_t map_addr, addr_t key_addr,
+                             klee::ref<klee::Expr> value) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &map = get_state(map_addr);
+  code_t key_ptr = get_buffer(key_addr);
+
+  builder.indent();
+  builder << "map_put(" << map.name << ", " << key_ptr << ", "
+          << transpile(value) << ");\n";
+}
+
+void CPUSynthesizer::map_erase(addr_t map_addr, klee::ref<klee::Expr> key) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &map = get_state(map_addr);
+  code_t key_ptr = build_buffer(key);
+  code_t trash = get_unique_var_name("trash");
+
+  builder.indent();
+  builder << "void *" << trash << ";\n";
+
+  builder.indent();
+  builder << "map_erase(" << map.name << ", " << key_ptr << ", &" << trash
+          << ");\n";
+}
+
+// The index found by the map is only valid if it has the key, so everything
+// that uses it goes under the same check. As with vector_read, the borrowed
+// cells are never written, so they are not returned.
+void CPUSynthesizer::coalesced_map_get(
+    addr_t map_addr, klee::ref<klee::Expr> key, klee::ref<klee::Expr> value_out,
+    klee::ref<klee::Expr> map_has_this_key, std::optional<addr_t> dchain_addr,
+    klee::ref<klee::Expr> time,
+    const std::vector<coalesced_vector_read_t> &reads) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &map = get_state(map_addr);
+  code_t key_ptr = build_buffer(key);
+  code_t value = get_unique_var_name("value");
+  code_t has_key = get_unique_var_name("map_has_this_key");
+
+  builder.indent();
+  builder << "int " << value << ";\n";
+
+  builder.indent();
+  builder << "int " << has_key << " = map_get(" << map.name << ", " << key_ptr
+          << ", &" << value << ");\n";
+
+  std::vector<code_t> cells;
+  for (size_t i = 0; i < reads.size(); i++) {
+    code_t cell = get_unique_var_name("vector_value");
+    cells.push_back(cell);
+
+    builder.indent();
+    builder << "uint8_t *" << cell << " = NULL;\n";
+  }
+
+  builder.indent();
+  builder << "if (" << has_key << ") {\n";
+  builder.inc();
+
+  if (dchain_addr.has_value()) {
+    const state_t &dchain = get_state(*dchain_addr);
+
+    builder.indent();
+    builder << "dchain_rejuvenate_index(" << dchain.name << ", " << value
+            << ", " << transpile(time) << ");\n";
+  }
+
+  for (size_t i = 0; i < reads.size(); i++) {
+    const state_t &vector = get_state(reads[i].vector_addr);
+
+    builder.indent();
+    builder << "vector_borrow(" << vector.name << ", " << value
+            << ", (void **)&" << cells[i] << ");\n";
+  }
+
+  builder.dec();
+  builder.indent();
+  builder << "}\n";
+
+  add_var(value, value_out);
+
+  if (!map_has_this_key.isNull()) {
+    add_var(has_key, map_has_this_key);
+  }
+
+  for (size_t i = 0; i < reads.size(); i++) {
+    add_var(cells[i], reads[i].value, true);
+    buffers[reads[i].value_addr] = cells[i];
+  }
+}
+
+code_t CPUSynthesizer::vector_borrow(addr_t vector_addr,
+                                     klee::ref<klee::Expr> index,
+                                     klee::ref<klee::Expr> value) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &vector = get_state(vector_addr);
+  code_t cell = get_unique_var_name("vector_value");
+
+  builder.indent();
+  builder << "uint8_t *" << cell << ";\n";
+
+  builder.indent();
+  builder << "vector_borrow(" << vector.name << ", " << transpile(index)
+          << ", (void **)&" << cell << ");\n";
+
+  add_var(cell, value, true);
+  return cell;
+}
+
+void CPUSynthesizer::vector_read(addr_t vector_addr,
+                                 klee::ref<klee::Expr> index,
+                                 addr_t value_addr,
+                                 klee::ref<klee::Expr> value) {
+  buffers[value_addr] = vector_borrow(vector_addr, index, value);
+}
+
+void CPUSynthesizer::vector_write(
+    addr_t vector_addr, klee::ref<klee::Expr> index, addr_t value_addr,
+    const std::vector<modification_t> &modifications) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &vector = get_state(vector_addr);
+  code_t cell = get_buffer(value_addr);
+
+  for (const modification_t &mod : modifications) {
+    builder.indent();
+    builder << cell << "[" << mod.byte << "] = " << transpile(mod.expr)
+            << ";\n";
+  }
+
+  builder.indent();
+  builder << "vector_return(" << vector.name << ", " << transpile(index)
+          << ", " << cell << ");\n";
+}
+
+void CPUSynthesizer::dchain_allocate_new_index(
+    addr_t dchain_addr, klee::ref<klee::Expr> time,
+    klee::ref<klee::Expr> index_out,
+    const std::optional<symbol_t> &out_of_space) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &dchain = get_state(dchain_addr);
+  code_t index = get_unique_var_name("index");
+
+  builder.indent();
+  builder << "int " << index << ";\n";
+
+  builder.indent();
+
+  if (out_of_space.has_value()) {
+    code_t ret = get_unique_var_name("out_of_space");
+    builder << "int " << ret << " = ";
+    add_var(ret, out_of_space->expr);
+  }
+
+  builder << "dchain_allocate_new_index(" << dchain.name << ", &" << index
+          << ", " << transpile(time) << ");\n";
+
+  add_var(index, index_out);
+}
+
+void CPUSynthesizer::dchain_rejuvenate_index(addr_t dchain_addr,
+                                             klee::ref<klee::Expr> index,
+                                             klee::ref<klee::Expr> time) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  const state_t &dchain = get_state(dchain_addr);
+
+  builder.indent();
+  builder << "dchain_rejuvenate_index(" << dchain.name << ", "
+          << transpile(index) << ", " << transpile(time) << ");\n";
+}
+
+void CPUSynthesizer::dchain_is_index_allocated(
+    addr_t dchain_addr, klee::ref<klee::Expr> index,
+    klee::ref<klee::Expr> is_allocated) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &dchain = get_state(dchain_addr);
+  code_t name = get_unique_var_name("is_allocated");
+
+  builder.indent();
+  builder << "int " << name << " = dchain_is_index_allocated(" << dchain.name
+          << ", " << transpile(index) << ");\n";
+
+  if (!is_allocated.isNull()) {
+    add_var(name, is_allocated);
+  }
+}
+
+void CPUSynthesizer::dchain_free_index(addr_t dchain_addr,
+                                       klee::ref<klee::Expr> index) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  const state_t &dchain = get_state(dchain_addr);
+
+  builder.indent();
+  builder << "dchain_free_index(" << dchain.name << ", " << transpile(index)
+          << ");\n";
+}
+
+void CPUSynthesizer::sketch_compute_hashes(addr_t sketch_addr,
+                                           klee::ref<klee::Expr> key) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &sketch = get_state(sketch_addr);
+  code_t key_ptr = build_buffer(key);
+
+  builder.indent();
+  builder << "sketch_compute_hashes(" << sketch.name << ", " << key_ptr
+          << ");\n";
+}
+
+void CPUSynthesizer::sketch_refresh(addr_t sketch_addr,
+                                    klee::ref<klee::Expr> time) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  const state_t &sketch = get_state(sketch_addr);
+
+  builder.indent();
+  builder << "sketch_refresh(" << sketch.name << ", " << transpile(time)
+          << ");\n";
+}
+
+void CPUSynthesizer::sketch_fetch(addr_t sketch_addr,
+                                  const symbol_t &overflow) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &sketch = get_state(sketch_addr);
+  code_t name = get_unique_var_name("overflow");
+
+  builder.indent();
+  builder << "int " << name << " = sketch_fetch(" << sketch.name << ");\n";
+
+  add_var(name, overflow.expr);
+}
+
+void CPUSynthesizer::sketch_touch_buckets(addr_t sketch_addr,
+                                          klee::ref<klee::Expr> time,
+                                          const symbol_t &success) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &sketch = get_state(sketch_addr);
+  code_t name = get_unique_var_name("success");
+
+  builder.indent();
+  builder << "int " << name << " = sketch_touch_buckets(" << sketch.name
+          << ", " << transpile(time) << ");\n";
+
+  add_var(name, success.expr);
+}
+
+void CPUSynthesizer::sketch_expire(addr_t sketch_addr,
+                                   klee::ref<klee::Expr> time) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  const state_t &sketch = get_state(sketch_addr);
+
+  builder.indent();
+  builder << "sketch_expire(" << sketch.name << ", " << transpile(time)
+          << ");\n";
+}
+
+void CPUSynthesizer::cht_find_backend(
+    addr_t cht_addr, addr_t backends_addr, klee::ref<klee::Expr> hash,
+    klee::ref<klee::Expr> height, klee::ref<klee::Expr> capacity,
+    klee::ref<klee::Expr> backend, const symbol_t &found) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  const state_t &cht = get_state(cht_addr);
+  const state_t &backends = get_state(backends_addr);
+  code_t chosen = get_unique_var_name("backend");
+  code_t name = get_unique_var_name("found");
+
+  builder.indent();
+  builder << "int " << chosen << ";\n";
+
+  builder.indent();
+  builder << "int " << name << " = cht_find_preferred_available_backend(";
+  builder << transpile(hash) << ", ";
+  builder << cht.name << ", ";
+  builder << backends.name << ", ";
+  builder << transpile(height) << ", ";
+  builder << transpile(capacity) << ", ";
+  builder << "&" << chosen << ");\n";
+
+  add_var(chosen, backend);
+  add_var(name, found.expr);
+}
+
+void CPUSynthesizer::hash_obj(addr_t obj_addr, klee::ref<klee::Expr> size,
+                              klee::ref<klee::Expr> hash) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  code_t name = get_unique_var_name("hash");
+
+  builder.indent();
+  builder << "uint32_t " << name << " = hash_obj(" << get_buffer(obj_addr)
+          << ", " << transpile(size) << ");\n";
+
+  add_var(name, hash);
+}
+
+void CPUSynthesizer::expire_items_single_map(
+    addr_t dchain_addr, addr_t vector_addr, addr_t map_addr,
+    klee::ref<klee::Expr> time, klee::ref<klee::Expr> total_freed) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+  code_t name = get_unique_var_name("freed");
+
+  builder.indent();
+  builder << "int " << name << " = expire_items_single_map(";
+  builder << get_state(dchain_addr).name << ", ";
+  builder << get_state(vector_addr).name << ", ";
+  builder << get_state(map_addr).name << ", ";
+  builder << transpile(time) << ");\n";
+
+  add_var(name, total_freed);
+}
+
+void CPUSynthesizer::expire_items_single_map_iteratively(
+    addr_t vector_addr, addr_t map_addr, klee::ref<klee::Expr> start,
+    klee::ref<klee::Expr> n_elems) {
+  code_builder_t &builder = get(MARKER_NF_PROCESS);
+
+  builder.indent();
+  builder << "expire_items_single_map_iteratively(";
+  builder << get_state(vector_addr).name << ", ";
+  builder << get_state(map_addr).name << ", ";
+  builder << transpile(start) << ", ";
+  builder << transpile(n_elems) << ");\n";
+}
+
+void CPUSynthesizer::dbg_vars() const {
+  Log::dbg() << "================= Vars ================= \n";
+  for (const vars_t &vars : var_stacks) {
+    Log::dbg() << "------------------------------------------\n";
+    for (const var_t &var : vars) {
+      Log::dbg() << var.name << ": ";
+      Log::dbg() << kutil::expr_to_string(var.expr, false) << "\n";
+    }
+  }
+  Log::dbg() << "======================================== \n";
+}
+
+} // namespace cpu
+} // namespace synapse
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "klee-util.h"
+#include "call-paths-to-bdd.h"
+
+#include "../synthesizer.h"
+#include "../../targets/module.h"
+#include "../../util.h"
+#include "constants.h"
+#include "transpiler.h"
+
+#include <stack>
+#include <unordered_set>
+#include <filesystem>
+
+namespace synapse {
+namespace cpu {
+
+// Shared by the targets that run on general purpose CPUs (the x86 server and
+// the switch controller). Both are synthesized into C++ on top of DPDK, using
+// the same data structures as the NF the BDD was extracted from, just like
+// bdd-to-c does.
+class CPUSynthesizer : public Synthesizer {
+protected:
+  struct var_t {
+    code_t name;
+    klee::ref<klee::Expr> expr;
+
+    // The variable points to the bytes holding the value, instead of holding
+    // the value itself.
+    bool is_buffer;
+
+    var_t() {}
+
+    var_t(const code_t &_name, klee::ref<klee::Expr> _expr,
+          bool _is_buffer = false)
+        : name(_name), expr(_expr), is_buffer(_is_buffer) {}
+  };
+
+  typedef std::vector<var_t> vars_t;
+
+  enum class StateType { Map, Vector, Dchain, Sketch };
+
+  struct state_t {
+    code_t name;
+    StateType type;
+  };
+
+private:
+  const std::unordered_set<ModuleType> branching_modules;
+
+  std::unordered_map<code_t, int> var_prefix_usage;
+  std::vector<vars_t> var_stacks;
+
+  // Global variable holding each data structure, indexed by object address.
+  std::unordered_map<addr_t, state_t> state;
+
+  // Memory the NF points into (packet headers and vector cells), indexed by
+  // the address it has on the BDD.
+  std::unordered_map<addr_t, code_t> buffers;
+
+  Transpiler transpiler;
+
+public:
+  CPUSynthesizer(const char *template_fname,
+                 const std::filesystem::path &out_file, const bdd::BDD *bdd,
+                 const std::unordered_set<ModuleType> &branching_modules);
+
+  void visit(const EP *ep, const EPNode *ep_node) override;
+
+protected:
+  void transpile_state(const bdd::BDD *bdd);
+
+  code_t transpile(klee::ref<klee::Expr> expr);
+  code_t build_buffer(klee::ref<klee::Expr> expr);
+
+  code_t get_unique_var_name(const code_t &prefix);
+  code_t slice_var(const var_t &var, unsigned offset, bits_t size) const;
+  bool get_var(klee::ref<klee::Expr> expr, var_t &out_var) const;
+  bool get_buffer_var(klee::ref<klee::Expr> expr, code_t &out_ptr) const;
+  void add_var(const code_t &name, klee::ref<klee::Expr> expr,
+               bool is_buffer = false);
+  void push_vars();
+  void pop_vars();
+
+  const state_t &get_state(addr_t obj) const;
+  code_t get_buffer(addr_t addr) const;
+
+  static code_t type_from_expr(klee::ref<klee::Expr> expr);
+  static code_t type_from_width(bits_t width);
+
+  // Keeps only the lower bits of an expression, as C promotes the operands
+  // of arithmetic operations.
+  static code_t truncate(bits_t width, const code_t &code);
+
+  void branch(const EP *ep, const EPNode *ep_node,
+              klee::ref<klee::Expr> condition);
+  void forward(int dst_device);
+  void drop();
+  void broadcast();
+
+  void parse_header(addr_t chunk_addr, klee::ref<klee::Expr> chunk,
+                    klee::ref<klee::Expr> length);
+  void modify_header(addr_t chunk_addr,
+                     const std::vector<modification_t> &changes);
+  void checksum_update(addr_t ip_hdr_addr, addr_t l4_hdr_addr,
+                       const symbol_t &checksum);
+
+  void map_get(addr_t map_addr, klee::ref<klee::Expr> key,
+               klee::ref<klee::Expr> value_out,
+               klee::ref<klee::Expr> map_has_this_key);
+  void map_put(addr_t map_addr, addr_t key_addr, klee::ref<klee::Expr> value);
+  void map_erase(addr_t map_addr, klee::ref<klee::Expr> key);
+  void coalesced_map_get(addr_t map_addr, klee::ref<klee::Expr> key,
+                         klee::ref<klee::Expr> value_out,
+                         klee::ref<klee::Expr> map_has_this_key,
+                         std::optional<addr_t> dchain_addr,
+                         klee::ref<klee::Expr> time,
+                         const std::vector<coalesced_vector_read_t> &reads);
+
+  code_t vector_borrow(addr_t vector_addr, klee::ref<klee::Expr> index,
+                       klee::ref<klee::Expr> value);
+  void vector_read(addr_t vector_addr, klee::ref<klee::Expr> index,
+                   addr_t value_addr, klee::ref<klee::Expr> value);
+  void vector_write(addr_t vector_addr, klee::ref<klee::Expr> index,
+                    addr_t value_addr,
+                    const std::vector<modification_t> &modifications);
+
+  void dchain_allocate_new_index(addr_t dchain_addr, klee::ref<klee::Expr> time,
+                                 klee::ref<klee::Expr> index_out,
+                                 const std::optional<symbol_t> &out_of_space);
+  void dchain_rejuvenate_index(addr_t dchain_addr, klee::ref<klee::Expr> index,
+                               klee::ref<klee::Expr> time);
+  void dchain_is_index_allocated(addr_t dchain_addr,
+                                 klee::ref<klee::Expr> index,
+                                 klee::ref<klee::Expr> is_allocated);
+  void dchain_free_index(addr_t dchain_addr, klee::ref<klee::Expr> index);
+
+  void sketch_compute_hashes(addr_t sketch_addr, klee::ref<klee::Expr> key);
+  void sketch_refresh(addr_t sketch_addr, klee::ref<klee::Expr> time);
+  void sketch_fetch(addr_t sketch_addr, const symbol_t &overflow);
+  void sketch_touch_buckets(addr_t sketch_addr, klee::ref<klee::Expr> time,
+                            const symbol_t &success);
+  void sketch_expire(addr_t sketch_addr, klee::ref<klee::Expr> time);
+
+  void cht_find_backend(addr_t cht_addr, addr_t backends_addr,
+                        klee::ref<klee::Expr> hash,
+                        klee::ref<klee::Expr> height,
+                        klee::ref<klee::Expr> capacity,
+                        klee::ref<klee::Expr> backend, const symbol_t &found);
+  void hash_obj(addr_t obj_addr, klee::ref<klee::Expr> size,
+                klee::ref<klee::Expr> hash);
+
+  void expire_items_single_map(addr_t dchain_addr, addr_t vector_addr,
+                               addr_t map_addr, klee::ref<klee::Expr> time,
+                               klee::ref<klee::Expr> total_freed);
+  void expire_items_single_map_iteratively(addr_t vector_addr,
+                                           addr_t map_addr,
+                                           klee::ref<klee::Expr> start,
+                                           klee::ref<klee::Expr> n_elems);
+
+  void dbg_vars() const;
+
+  friend class Transpiler;
+};
+
+} // namespace cpu
+} // namespace synapse
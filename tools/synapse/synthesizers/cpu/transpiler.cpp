@@ -0,0 +1,307 @@
+#include "transpiler.h"
+#include "synthesizer.h"
+
+namespace synapse {
+namespace cpu {
+
+Transpiler::Transpiler(const CPUSynthesizer *_synthesizer)
+    : synthesizer(_synthesizer) {}
+
+code_t Transpiler::transpile(klee::ref<klee::Expr> expr) {
+  Log::dbg() << "Transpile: " << kutil::expr_to_string(expr, false) << "\n";
+
+  builders.emplace();
+  code_builder_t &builder = builders.top();
+
+  bool is_constant = kutil::is_constant(expr);
+
+  if (is_constant) {
+    assert(expr->getWidth() <= 64 && "Constants must fit in 64 bits");
+    uint64_t value = kutil::solver_toolbox.value_from_expr(expr);
+
+    builder << std::to_string(value);
+    if (value > 0x7fffffff) {
+      builder << "ull";
+    }
+  } else {
+    visit(expr);
+
+    // HACK: clear the visited map so we force the transpiler to revisit all
+    // expressions.
+    visited.clear();
+  }
+
+  code_t code = builder.dump();
+  builders.pop();
+
+  assert(code.size() > 0);
+  return code;
+}
+
+code_t Transpiler::transpile_signed(klee::ref<klee::Expr> expr) {
+  klee::Expr::Width width = expr->getWidth();
+  assert(width <= 64);
+
+  code_builder_t builder;
+  builder << "((int64_t)((uint64_t)(" << transpile(expr) << ") << "
+          << 64 - width << ") >> " << 64 - width << ")";
+
+  return builder.dump();
+}
+
+klee::ExprVisitor::Action Transpiler::visitRead(const klee::ReadExpr &e) {
+  klee::ref<klee::Expr> expr = const_cast<klee::ReadExpr *>(&e);
+
+  code_builder_t &builder = builders.top();
+
+  CPUSynthesizer::var_t var;
+  if (synthesizer->get_var(expr, var)) {
+    assert(!var.is_buffer && "Values wider than 64 bits must live in buffers");
+    builder << var.name;
+    return klee::ExprVisitor::Action::skipChildren();
+  }
+
+  Log::dbg() << kutil::expr_to_string(expr) << "\n";
+  synthesizer->dbg_vars();
+
+  assert(false && "Variable not found");
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action
+Transpiler::visitNotOptimized(const klee::NotOptimizedExpr &e) {
+  code_builder_t &builder = builders.top();
+  builder << transpile(e.getKid(0));
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitSelect(const klee::SelectExpr &e) {
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> cond = e.getKid(0);
+  klee::ref<klee::Expr> on_true = e.getKid(1);
+  klee::ref<klee::Expr> on_false = e.getKid(2);
+
+  builder << "(" << transpile(cond) << " ? " << transpile(on_true) << " : "
+          << transpile(on_false) << ")";
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitConcat(const klee::ConcatExpr &e) {
+  klee::ref<klee::Expr> expr = const_cast<klee::ConcatExpr *>(&e);
+
+  code_builder_t &builder = builders.top();
+
+  CPUSynthesizer::var_t var;
+  if (synthesizer->get_var(expr, var)) {
+    assert(!var.is_buffer && "Values wider than 64 bits must live in buffers");
+    builder << var.name;
+    return klee::ExprVisitor::Action::skipChildren();
+  }
+
+  klee::ref<klee::Expr> msb = e.getKid(0);
+  klee::ref<klee::Expr> lsb = e.getKid(1);
+
+  code_t type = CPUSynthesizer::type_from_expr(expr);
+
+  builder << "(((" << type << ")" << transpile(msb) << " << "
+          << lsb->getWidth() << ") | " << transpile(lsb) << ")";
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitExtract(const klee::ExtractExpr &e) {
+  klee::ref<klee::Expr> expr = const_cast<klee::ExtractExpr *>(&e);
+
+  code_builder_t &builder = builders.top();
+
+  CPUSynthesizer::var_t var;
+  if (synthesizer->get_var(expr, var)) {
+    assert(!var.is_buffer && "Values wider than 64 bits must live in buffers");
+    builder << var.name;
+    return klee::ExprVisitor::Action::skipChildren();
+  }
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  code_builder_t shifted;
+  shifted << "(" << transpile(kid) << " >> " << e.offset << ")";
+
+  builder << CPUSynthesizer::truncate(e.width, shifted.dump());
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitZExt(const klee::ZExtExpr &e) {
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+  code_t type = CPUSynthesizer::type_from_width(e.getWidth());
+
+  builder << "(" << type << ")(" << transpile(kid) << ")";
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitSExt(const klee::SExtExpr &e) {
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  builder << CPUSynthesizer::truncate(e.getWidth(), transpile_signed(kid));
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+// Arithmetic and bitwise operations are computed on the promoted operands and
+// truncated back to the width of the expression.
+#define TRANSPILE_BINARY_OP(OP)                                                \
+  code_builder_t &builder = builders.top();                                    \
+  code_builder_t op;                                                           \
+  op << transpile(e.getKid(0)) << " " OP " " << transpile(e.getKid(1));        \
+  builder << CPUSynthesizer::truncate(e.getWidth(), op.dump());                \
+  return klee::ExprVisitor::Action::skipChildren();
+
+#define TRANSPILE_SIGNED_BINARY_OP(OP)                                         \
+  code_builder_t &builder = builders.top();                                    \
+  code_builder_t op;                                                           \
+  op << transpile_signed(e.getKid(0)) << " " OP " "                            \
+     << transpile_signed(e.getKid(1));                                         \
+  builder << CPUSynthesizer::truncate(e.getWidth(), op.dump());                \
+  return klee::ExprVisitor::Action::skipChildren();
+
+#define TRANSPILE_COMPARISON(OP)                                               \
+  code_builder_t &builder = builders.top();                                    \
+  builder << "(" << transpile(e.getKid(0)) << " " OP " "                       \
+          << transpile(e.getKid(1)) << ")";                                    \
+  return klee::ExprVisitor::Action::skipChildren();
+
+#define TRANSPILE_SIGNED_COMPARISON(OP)                                        \
+  code_builder_t &builder = builders.top();                                    \
+  builder << "(" << transpile_signed(e.getKid(0)) << " " OP " "                \
+          << transpile_signed(e.getKid(1)) << ")";                             \
+  return klee::ExprVisitor::Action::skipChildren();
+
+// Boolean operations are kept as boolean, as their results end up on
+// conditions.
+#define TRANSPILE_LOGICAL_OP(LOGICAL_OP, BITWISE_OP)                           \
+  if (e.getWidth() != klee::Expr::Bool) {                                      \
+    TRANSPILE_BINARY_OP(BITWISE_OP)                                            \
+  }                                                                            \
+  TRANSPILE_COMPARISON(LOGICAL_OP)
+
+klee::ExprVisitor::Action Transpiler::visitAdd(const klee::AddExpr &e) {
+  TRANSPILE_BINARY_OP("+")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSub(const klee::SubExpr &e) {
+  TRANSPILE_BINARY_OP("-")
+}
+
+klee::ExprVisitor::Action Transpiler::visitMul(const klee::MulExpr &e) {
+  TRANSPILE_BINARY_OP("*")
+}
+
+klee::ExprVisitor::Action Transpiler::visitUDiv(const klee::UDivExpr &e) {
+  TRANSPILE_BINARY_OP("/")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSDiv(const klee::SDivExpr &e) {
+  TRANSPILE_SIGNED_BINARY_OP("/")
+}
+
+klee::ExprVisitor::Action Transpiler::visitURem(const klee::URemExpr &e) {
+  TRANSPILE_BINARY_OP("%")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSRem(const klee::SRemExpr &e) {
+  TRANSPILE_SIGNED_BINARY_OP("%")
+}
+
+klee::ExprVisitor::Action Transpiler::visitNot(const klee::NotExpr &e) {
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  if (e.getWidth() == klee::Expr::Bool) {
+    builder << "!" << transpile(kid);
+  } else {
+    builder << CPUSynthesizer::truncate(e.getWidth(), "~" + transpile(kid));
+  }
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitAnd(const klee::AndExpr &e) {
+  TRANSPILE_LOGICAL_OP("&&", "&")
+}
+
+klee::ExprVisitor::Action Transpiler::visitOr(const klee::OrExpr &e) {
+  TRANSPILE_LOGICAL_OP("||", "|")
+}
+
+klee::ExprVisitor::Action Transpiler::visitXor(const klee::XorExpr &e) {
+  TRANSPILE_LOGICAL_OP("!=", "^")
+}
+
+klee::ExprVisitor::Action Transpiler::visitShl(const klee::ShlExpr &e) {
+  TRANSPILE_BINARY_OP("<<")
+}
+
+klee::ExprVisitor::Action Transpiler::visitLShr(const klee::LShrExpr &e) {
+  TRANSPILE_BINARY_OP(">>")
+}
+
+klee::ExprVisitor::Action Transpiler::visitAShr(const klee::AShrExpr &e) {
+  code_builder_t &builder = builders.top();
+
+  code_builder_t op;
+  op << transpile_signed(e.getKid(0)) << " >> " << transpile(e.getKid(1));
+  builder << CPUSynthesizer::truncate(e.getWidth(), op.dump());
+
+  return klee::ExprVisitor::Action::skipChildren();
+}
+
+klee::ExprVisitor::Action Transpiler::visitEq(const klee::EqExpr &e) {
+  TRANSPILE_COMPARISON("==")
+}
+
+klee::ExprVisitor::Action Transpiler::visitNe(const klee::NeExpr &e) {
+  TRANSPILE_COMPARISON("!=")
+}
+
+klee::ExprVisitor::Action Transpiler::visitUlt(const klee::UltExpr &e) {
+  TRANSPILE_COMPARISON("<")
+}
+
+klee::ExprVisitor::Action Transpiler::visitUle(const klee::UleExpr &e) {
+  TRANSPILE_COMPARISON("<=")
+}
+
+klee::ExprVisitor::Action Transpiler::visitUgt(const klee::UgtExpr &e) {
+  TRANSPILE_COMPARISON(">")
+}
+
+klee::ExprVisitor::Action Transpiler::visitUge(const klee::UgeExpr &e) {
+  TRANSPILE_COMPARISON(">=")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSlt(const klee::SltExpr &e) {
+  TRANSPILE_SIGNED_COMPARISON("<")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSle(const klee::SleExpr &e) {
+  TRANSPILE_SIGNED_COMPARISON("<=")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSgt(const klee::SgtExpr &e) {
+  TRANSPILE_SIGNED_COMPARISON(">")
+}
+
+klee::ExprVisitor::Action Transpiler::visitSge(const klee::SgeExpr &e) {
+  TRANSPILE_SIGNED_COMPARISON(">=")
+}
+
+} // namespace cpu
+} // namespace synapse
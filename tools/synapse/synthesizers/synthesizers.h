@@ -1,28 +1,60 @@
 #pragma once
 
 #include "tofino/synthesizer.h"
+#include "tofino_cpu/synthesizer.h"
+#include "x86/synthesizer.h"
 #include <filesystem>
 
 namespace synapse {
 
+static bool target_has_nodes(const EP *ep, TargetType type) {
+  const EPNode *root = ep->get_root();
+  bool found = false;
+
+  if (!root) {
+    return false;
+  }
+
+  root->visit_nodes([type, &found](const EPNode *node) {
+    const Module *module = node->get_module();
+
+    if (module->get_target() == type) {
+      found = true;
+      return EPNodeVisitAction::STOP;
+    }
+
+    return EPNodeVisitAction::VISIT_CHILDREN;
+  });
+
+  return found;
+}
+
 void synthesize(const EP *ep, const std::filesystem::path &out_dir) {
   const targets_t &targets = ep->get_targets();
 
   for (const Target *target : targets) {
+    // Nothing to synthesize for targets the solution does not use. The switch
+    // always needs its controller though, which sets it up.
+    bool used = target_has_nodes(ep, target->type) ||
+                (target->type == TargetType::TofinoCPU &&
+                 target_has_nodes(ep, TargetType::Tofino));
+
+    if (!used) {
+      continue;
+    }
+
     switch (target->type) {
     case TargetType::Tofino: {
       tofino::TofinoSynthesizer synthesizer(out_dir, ep->get_bdd());
       synthesizer.visit(ep);
     } break;
     case TargetType::TofinoCPU: {
-      //   assert(false && "TODO");
-      // TofinoCPUSynthesizer synthesizer(out_dir);
-      // synthesizer.visit(ep);
+      tofino_cpu::TofinoCPUSynthesizer synthesizer(out_dir, ep->get_bdd());
+      synthesizer.visit(ep);
     } break;
     case TargetType::x86: {
-      //   assert(false && "TODO");
-      // x86Synthesizer synthesizer(out_dir);
-      // synthesizer.visit(ep);
+      x86::x86Synthesizer synthesizer(out_dir, ep->get_bdd());
+      synthesizer.visit(ep);
     } break;
     }
   }
@@ -0,0 +1,449 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <lib/verified/cht.h>
+#include <lib/verified/double-chain.h>
+#include <lib/verified/map.h>
+#include <lib/verified/vector.h>
+#include <lib/unverified/sketch.h>
+#include <lib/unverified/hash.h>
+#include <lib/unverified/expirator.h>
+
+#include <lib/verified/expirator.h>
+#include <lib/verified/packet-io.h>
+#include <lib/verified/tcpudp_hdr.h>
+#include <lib/verified/vigor-time.h>
+
+#include <bf_switchd/bf_switchd.h>
+#ifdef __cplusplus
+}
+#endif
+
+#include <bf_rt/bf_rt_info.hpp>
+#include <bf_rt/bf_rt_init.hpp>
+#include <bf_rt/bf_rt_session.hpp>
+#include <bf_rt/bf_rt_table.hpp>
+#include <bf_rt/bf_rt_table_data.hpp>
+#include <bf_rt/bf_rt_table_key.hpp>
+
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_udp.h>
+
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+
+#include <memory>
+#include <stdbool.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define NF_INFO(text, ...)                                                     \
+    printf(text "\n", ##__VA_ARGS__);                                          \
+    fflush(stdout);
+
+#define BATCH_SIZE 32
+
+#define DROP ((uint16_t)-1)
+
+// The switch broadcasts packets coming back from the controller with the MSB
+// of their out port set.
+#define FLOOD ((uint16_t)0x8000)
+
+// Same as in the P4 program.
+#define BROADCAST_MCAST_GROUP 1
+#define BROADCAST_MCAST_NODE 1
+
+// The DPDK device connected to the switch CPU port.
+#define CPU_DEVICE 0
+
+#define SWITCH_DEVICE 0
+#define SWITCH_PROGRAM "synapse"
+
+static const uint16_t RX_QUEUE_SIZE = 1024;
+static const uint16_t TX_QUEUE_SIZE = 1024;
+
+static const unsigned MEMPOOL_BUFFER_COUNT = 2048;
+
+// Values are read straight from memory, with the same byte order KLEE used
+// when building the expressions.
+template <typename T> static inline T load(const uint8_t *ptr, size_t bytes) {
+    T value = 0;
+    memcpy(&value, ptr, bytes);
+    return value;
+}
+
+static inline uint16_t load_be16(const uint8_t *ptr) {
+    return (ptr[0] << 8) | ptr[1];
+}
+
+static inline void store_be16(uint8_t *ptr, uint16_t value) {
+    ptr[0] = value >> 8;
+    ptr[1] = value & 0xff;
+}
+
+// The switch sends fields in network order.
+static inline void cpu_field(uint8_t *dst, const uint8_t *src, size_t bytes) {
+    for (size_t byte = 0; byte < bytes; byte++) {
+        dst[byte] = src[bytes - byte - 1];
+    }
+}
+
+struct bytes_t {
+    const uint8_t *data;
+    size_t size;
+};
+
+static const bfrt::BfRtInfo *bfrt_info;
+static std::shared_ptr<bfrt::BfRtSession> session;
+static bf_rt_target_t dev_tgt;
+
+static void switch_init() {
+    bf_switchd_context_t *switchd_ctx =
+        (bf_switchd_context_t *)calloc(1, sizeof(bf_switchd_context_t));
+
+    switchd_ctx->install_dir = getenv("SDE_INSTALL");
+    switchd_ctx->conf_file = (char *)SWITCH_PROGRAM ".conf";
+    switchd_ctx->running_in_background = true;
+    switchd_ctx->skip_port_add = false;
+
+    if (bf_switchd_lib_init(switchd_ctx) != BF_SUCCESS) {
+        rte_exit(EXIT_FAILURE, "Error initializing bf_switchd");
+    }
+
+    bfrt::BfRtDevMgr &dev_mgr = bfrt::BfRtDevMgr::getInstance();
+    if (dev_mgr.bfRtInfoGet(SWITCH_DEVICE, SWITCH_PROGRAM, &bfrt_info) !=
+        BF_SUCCESS) {
+        rte_exit(EXIT_FAILURE, "Error getting the BfRt info");
+    }
+
+    session = bfrt::BfRtSession::sessionCreate();
+
+    dev_tgt.dev_id = SWITCH_DEVICE;
+    dev_tgt.pipe_id = BF_DEV_PIPE_ALL;
+}
+
+// BfRt expects values in network order, KLEE keeps them in host order. The
+// switch may pack consecutive fields together, so these are concatenated and
+// then split according to the sizes of the fields on the switch.
+static std::vector<uint8_t> to_network(const std::vector<bytes_t> &fields) {
+    std::vector<uint8_t> value;
+
+    for (bytes_t field : fields) {
+        size_t offset = value.size();
+        value.resize(offset + field.size);
+        cpu_field(value.data() + offset, field.data, field.size);
+    }
+
+    return value;
+}
+
+static void set_key(const bfrt::BfRtTable *table, bfrt::BfRtTableKey *key,
+                    const std::vector<bytes_t> &keys) {
+    std::vector<uint8_t> value = to_network(keys);
+    size_t offset = 0;
+
+    std::vector<bf_rt_id_t> ids;
+    table->keyFieldIdListGet(&ids);
+
+    for (bf_rt_id_t id : ids) {
+        size_t bits;
+        table->keyFieldSizeGet(id, &bits);
+
+        size_t bytes = (bits + 7) / 8;
+        key->setValue(id, value.data() + offset, bytes);
+        offset += bytes;
+    }
+
+    assert(offset == value.size());
+}
+
+// Installs the entry, replacing the one already there for the same key.
+static void switch_table_write(const char *table_name, const char *action_name,
+                               const std::vector<bytes_t> &keys,
+                               const std::vector<bytes_t> &values) {
+    const bfrt::BfRtTable *table;
+    bfrt_info->bfrtTableFromNameGet(table_name, &table);
+
+    bf_rt_id_t action_id;
+    table->actionIdGet(action_name, &action_id);
+
+    std::unique_ptr<bfrt::BfRtTableKey> key;
+    std::unique_ptr<bfrt::BfRtTableData> data;
+    table->keyAllocate(&key);
+    table->dataAllocate(action_id, &data);
+
+    set_key(table, key.get(), keys);
+
+    std::vector<uint8_t> value = to_network(values);
+    size_t offset = 0;
+
+    std::vector<bf_rt_id_t> ids;
+    table->dataFieldIdListGet(action_id, &ids);
+
+    for (bf_rt_id_t id : ids) {
+        size_t bits;
+        table->dataFieldSizeGet(id, action_id, &bits);
+
+        size_t bytes = (bits + 7) / 8;
+        data->setValue(id, value.data() + offset, bytes);
+        offset += bytes;
+    }
+
+    assert(offset == value.size());
+
+    if (table->tableEntryMod(*session, dev_tgt, *key, *data) != BF_SUCCESS) {
+        table->tableEntryAdd(*session, dev_tgt, *key, *data);
+    }
+
+    session->sessionCompleteOperations();
+}
+
+static void switch_table_erase(const char *table_name,
+                               const std::vector<bytes_t> &keys) {
+    const bfrt::BfRtTable *table;
+    bfrt_info->bfrtTableFromNameGet(table_name, &table);
+
+    std::unique_ptr<bfrt::BfRtTableKey> key;
+    table->keyAllocate(&key);
+
+    set_key(table, key.get(), keys);
+
+    table->tableEntryDel(*session, dev_tgt, *key);
+    session->sessionCompleteOperations();
+}
+
+static void register_key(const bfrt::BfRtTable *table,
+                         bfrt::BfRtTableKey *key, uint32_t index) {
+    bf_rt_id_t index_id;
+    table->keyFieldIdGet("$REGISTER_INDEX", &index_id);
+    key->setValue(index_id, index);
+}
+
+static void switch_register_read(const char *register_name, uint32_t index,
+                                 uint8_t *value, size_t size) {
+    const bfrt::BfRtTable *table;
+    bfrt_info->bfrtTableFromNameGet(register_name, &table);
+
+    std::unique_ptr<bfrt::BfRtTableKey> key;
+    std::unique_ptr<bfrt::BfRtTableData> data;
+    table->keyAllocate(&key);
+    table->dataAllocate(&data);
+
+    register_key(table, key.get(), index);
+
+    table->tableEntryGet(*session, dev_tgt, *key,
+                         bfrt::BfRtTable::BfRtTableGetFlag::GET_FROM_HW,
+                         data.get());
+
+    std::vector<bf_rt_id_t> ids;
+    table->dataFieldIdListGet(&ids);
+
+    // Registers hold one value per pipe, the first one is as good as any.
+    std::vector<uint64_t> pipe_values;
+    data->getValue(ids[0], &pipe_values);
+    memcpy(value, &pipe_values[0], size);
+}
+
+static void switch_register_write(const char *register_name, uint32_t index,
+                                  bytes_t value) {
+    const bfrt::BfRtTable *table;
+    bfrt_info->bfrtTableFromNameGet(register_name, &table);
+
+    std::unique_ptr<bfrt::BfRtTableKey> key;
+    std::unique_ptr<bfrt::BfRtTableData> data;
+    table->keyAllocate(&key);
+    table->dataAllocate(&data);
+
+    register_key(table, key.get(), index);
+
+    std::vector<bf_rt_id_t> ids;
+    table->dataFieldIdListGet(&ids);
+
+    uint64_t register_value = 0;
+    memcpy(&register_value, value.data, value.size);
+    data->setValue(ids[0], register_value);
+
+    table->tableEntryMod(*session, dev_tgt, *key, *data);
+    session->sessionCompleteOperations();
+}
+
+/*@{STATE}@*/
+
+// Sets up the multicast group the switch broadcasts with: a single node
+// replicating to every port. Each port is pruned through the L2 exclusion id
+// of the same number, so packets do not go back out of their ingress port.
+static void switch_broadcast_init() {
+    const bfrt::BfRtTable *node_table;
+    const bfrt::BfRtTable *mgid_table;
+    const bfrt::BfRtTable *prune_table;
+    bfrt_info->bfrtTableFromNameGet("$pre.node", &node_table);
+    bfrt_info->bfrtTableFromNameGet("$pre.mgid", &mgid_table);
+    bfrt_info->bfrtTableFromNameGet("$pre.prune", &prune_table);
+
+    std::vector<bf_rt_id_t> ports;
+    for (uint16_t port = 0; port < SWITCH_PORTS; port++) {
+        ports.push_back(port);
+    }
+
+    std::unique_ptr<bfrt::BfRtTableKey> key;
+    std::unique_ptr<bfrt::BfRtTableData> data;
+    bf_rt_id_t field_id;
+
+    node_table->keyAllocate(&key);
+    node_table->dataAllocate(&data);
+    node_table->keyFieldIdGet("$MULTICAST_NODE_ID", &field_id);
+    key->setValue(field_id, (uint64_t)BROADCAST_MCAST_NODE);
+    node_table->dataFieldIdGet("$MULTICAST_RID", &field_id);
+    data->setValue(field_id, (uint64_t)0);
+    node_table->dataFieldIdGet("$DEV_PORT", &field_id);
+    data->setValue(field_id, ports);
+    node_table->tableEntryAdd(*session, dev_tgt, *key, *data);
+
+    mgid_table->keyAllocate(&key);
+    mgid_table->dataAllocate(&data);
+    mgid_table->keyFieldIdGet("$MGID", &field_id);
+    key->setValue(field_id, (uint64_t)BROADCAST_MCAST_GROUP);
+    mgid_table->dataFieldIdGet("$MULTICAST_NODE_ID", &field_id);
+    data->setValue(field_id, std::vector<bf_rt_id_t>{BROADCAST_MCAST_NODE});
+    mgid_table->dataFieldIdGet("$MULTICAST_NODE_L1_XID_VALID", &field_id);
+    data->setValue(field_id, std::vector<bool>{false});
+    mgid_table->dataFieldIdGet("$MULTICAST_NODE_L1_XID", &field_id);
+    data->setValue(field_id, std::vector<bf_rt_id_t>{0});
+    mgid_table->tableEntryAdd(*session, dev_tgt, *key, *data);
+
+    for (bf_rt_id_t port : ports) {
+        prune_table->keyAllocate(&key);
+        prune_table->dataAllocate(&data);
+        prune_table->keyFieldIdGet("$MULTICAST_L2_XID", &field_id);
+        key->setValue(field_id, (uint64_t)port);
+        prune_table->dataFieldIdGet("$DEV_PORT", &field_id);
+        data->setValue(field_id, std::vector<bf_rt_id_t>{port});
+        prune_table->tableEntryAdd(*session, dev_tgt, *key, *data);
+    }
+
+    session->sessionCompleteOperations();
+}
+
+bool nf_init() {
+/*@{NF_INIT}@*/
+}
+
+// Picks up where the switch left off, on the code path that sent the packet to
+// the controller.
+int nf_process(uint16_t code_path, const uint8_t *cpu_fields, uint16_t device,
+               uint8_t *packet, uint16_t packet_length, time_ns_t now) {
+    uint8_t *cursor = packet;
+
+/*@{NF_PROCESS}@*/
+}
+
+static int nf_init_device(uint16_t device, struct rte_mempool *mbuf_pool) {
+    int retval;
+
+    struct rte_eth_conf device_conf = {0};
+
+    retval = rte_eth_dev_configure(device, 1, 1, &device_conf);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_tx_queue_setup(device, 0, TX_QUEUE_SIZE,
+                                    rte_eth_dev_socket_id(device), NULL);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_rx_queue_setup(device, 0, RX_QUEUE_SIZE,
+                                    rte_eth_dev_socket_id(device), NULL,
+                                    mbuf_pool);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_dev_start(device);
+    if (retval != 0) {
+        return retval;
+    }
+
+    rte_eth_promiscuous_enable(device);
+
+    return 0;
+}
+
+static void worker_main(void) {
+    if (!nf_init()) {
+        rte_exit(EXIT_FAILURE, "Error initializing NF");
+    }
+
+    NF_INFO("Core %u processing packets from the switch.", rte_lcore_id());
+
+    while (1) {
+        struct rte_mbuf *rx_mbufs[BATCH_SIZE];
+        struct rte_mbuf *tx_mbufs[BATCH_SIZE];
+        uint16_t tx_count = 0;
+
+        uint16_t rx_count = rte_eth_rx_burst(CPU_DEVICE, 0, rx_mbufs,
+                                             BATCH_SIZE);
+
+        for (uint16_t n = 0; n < rx_count; n++) {
+            uint8_t *data = rte_pktmbuf_mtod(rx_mbufs[n], uint8_t *);
+            time_ns_t now = current_time();
+
+            uint16_t code_path = load_be16(data);
+            uint16_t in_port = load_be16(data + 2) & 0x1ff;
+
+            uint8_t *packet = data + CPU_HEADER_SIZE;
+            uint16_t packet_length = rx_mbufs[n]->pkt_len - CPU_HEADER_SIZE;
+
+            uint16_t out_port = nf_process(code_path, data + 6, in_port,
+                                           packet, packet_length, now);
+
+            if (out_port == DROP) {
+                rte_pktmbuf_free(rx_mbufs[n]);
+                continue;
+            }
+
+            // The switch forwards (or broadcasts) the packet and strips the
+            // CPU header.
+            store_be16(data + 4, out_port);
+            tx_mbufs[tx_count++] = rx_mbufs[n];
+        }
+
+        uint16_t sent = rte_eth_tx_burst(CPU_DEVICE, 0, tx_mbufs, tx_count);
+        for (uint16_t n = sent; n < tx_count; n++) {
+            rte_pktmbuf_free(tx_mbufs[n]);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int ret = rte_eal_init(argc, argv);
+    if (ret < 0) {
+        rte_exit(EXIT_FAILURE, "Error with EAL initialization, ret=%d\n", ret);
+    }
+
+    struct rte_mempool *mbuf_pool =
+        rte_pktmbuf_pool_create("MEMPOOL", MEMPOOL_BUFFER_COUNT, 0, 0,
+                                RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+    if (mbuf_pool == NULL) {
+        rte_exit(EXIT_FAILURE, "Cannot create pool: %s\n",
+                 rte_strerror(rte_errno));
+    }
+
+    ret = nf_init_device(CPU_DEVICE, mbuf_pool);
+    if (ret != 0) {
+        rte_exit(EXIT_FAILURE, "Cannot init CPU device: %d", ret);
+    }
+
+    switch_init();
+    switch_broadcast_init();
+    worker_main();
+
+    return 0;
+}
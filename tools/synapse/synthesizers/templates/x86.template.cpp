@@ -0,0 +1,210 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <lib/verified/cht.h>
+#include <lib/verified/double-chain.h>
+#include <lib/verified/map.h>
+#include <lib/verified/vector.h>
+#include <lib/unverified/sketch.h>
+#include <lib/unverified/hash.h>
+#include <lib/unverified/expirator.h>
+
+#include <lib/verified/expirator.h>
+#include <lib/verified/packet-io.h>
+#include <lib/verified/tcpudp_hdr.h>
+#include <lib/verified/vigor-time.h>
+#ifdef __cplusplus
+}
+#endif
+
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_udp.h>
+
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#define NF_INFO(text, ...)                                                     \
+    printf(text "\n", ##__VA_ARGS__);                                          \
+    fflush(stdout);
+
+#define BATCH_SIZE 32
+#define MAX_NUM_DEVICES 32
+
+#define DROP ((uint16_t)-1)
+#define FLOOD ((uint16_t)-2)
+
+static const uint16_t RX_QUEUE_SIZE = 1024;
+static const uint16_t TX_QUEUE_SIZE = 1024;
+
+static const unsigned MEMPOOL_BUFFER_COUNT = 2048;
+
+// Values are read straight from memory, with the same byte order KLEE used
+// when building the expressions.
+template <typename T> static inline T load(const uint8_t *ptr, size_t bytes) {
+    T value = 0;
+    memcpy(&value, ptr, bytes);
+    return value;
+}
+
+/*@{STATE}@*/
+
+bool nf_init() {
+/*@{NF_INIT}@*/
+}
+
+int nf_process(uint16_t device, uint8_t *packet, uint16_t packet_length,
+               time_ns_t now) {
+    uint8_t *cursor = packet;
+
+/*@{NF_PROCESS}@*/
+}
+
+struct tx_batch_t {
+    struct rte_mbuf *mbufs[BATCH_SIZE];
+    uint16_t count;
+};
+
+static struct tx_batch_t tx_batches[MAX_NUM_DEVICES];
+
+static void tx_flush(uint16_t device) {
+    struct tx_batch_t *batch = &tx_batches[device];
+
+    uint16_t sent = rte_eth_tx_burst(device, 0, batch->mbufs, batch->count);
+    for (uint16_t n = sent; n < batch->count; n++) {
+        rte_pktmbuf_free(batch->mbufs[n]);
+    }
+
+    batch->count = 0;
+}
+
+static void tx_enqueue(uint16_t device, struct rte_mbuf *mbuf) {
+    struct tx_batch_t *batch = &tx_batches[device];
+
+    batch->mbufs[batch->count++] = mbuf;
+    if (batch->count == BATCH_SIZE) {
+        tx_flush(device);
+    }
+}
+
+// Sends the packet to every device except the one it came from.
+static void flood(struct rte_mbuf *mbuf, uint16_t nb_devices) {
+    rte_mbuf_refcnt_set(mbuf, nb_devices - 1);
+    for (uint16_t device = 0; device < nb_devices; device++) {
+        if (device != mbuf->port) {
+            tx_enqueue(device, mbuf);
+        }
+    }
+}
+
+static int nf_init_device(uint16_t device, struct rte_mempool *mbuf_pool) {
+    int retval;
+
+    struct rte_eth_conf device_conf = {0};
+
+    retval = rte_eth_dev_configure(device, 1, 1, &device_conf);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_tx_queue_setup(device, 0, TX_QUEUE_SIZE,
+                                    rte_eth_dev_socket_id(device), NULL);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_rx_queue_setup(device, 0, RX_QUEUE_SIZE,
+                                    rte_eth_dev_socket_id(device), NULL,
+                                    mbuf_pool);
+    if (retval != 0) {
+        return retval;
+    }
+
+    retval = rte_eth_dev_start(device);
+    if (retval != 0) {
+        return retval;
+    }
+
+    rte_eth_promiscuous_enable(device);
+
+    return 0;
+}
+
+static void worker_main(void) {
+    if (!nf_init()) {
+        rte_exit(EXIT_FAILURE, "Error initializing NF");
+    }
+
+    NF_INFO("Core %u forwarding packets.", rte_lcore_id());
+
+    uint16_t nb_devices = rte_eth_dev_count_avail();
+
+    while (1) {
+        for (uint16_t dev = 0; dev < nb_devices; dev++) {
+            struct rte_mbuf *mbufs[BATCH_SIZE];
+            uint16_t rx_count = rte_eth_rx_burst(dev, 0, mbufs, BATCH_SIZE);
+
+            for (uint16_t n = 0; n < rx_count; n++) {
+                uint8_t *data = rte_pktmbuf_mtod(mbufs[n], uint8_t *);
+                packet_state_total_length(data, &(mbufs[n]->pkt_len));
+                time_ns_t now = current_time();
+
+                uint16_t dst_device =
+                    nf_process(mbufs[n]->port, data, mbufs[n]->pkt_len, now);
+
+                if (dst_device == DROP) {
+                    rte_pktmbuf_free(mbufs[n]);
+                } else if (dst_device == FLOOD) {
+                    flood(mbufs[n], nb_devices);
+                } else {
+                    tx_enqueue(dst_device, mbufs[n]);
+                }
+            }
+        }
+
+        for (uint16_t dev = 0; dev < nb_devices; dev++) {
+            tx_flush(dev);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int ret = rte_eal_init(argc, argv);
+    if (ret < 0) {
+        rte_exit(EXIT_FAILURE, "Error with EAL initialization, ret=%d\n", ret);
+    }
+
+    unsigned nb_devices = rte_eth_dev_count_avail();
+    if (nb_devices > MAX_NUM_DEVICES) {
+        rte_exit(EXIT_FAILURE, "Too many devices: %u\n", nb_devices);
+    }
+
+    struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create(
+        "MEMPOOL", MEMPOOL_BUFFER_COUNT * nb_devices, 0, 0,
+        RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+    if (mbuf_pool == NULL) {
+        rte_exit(EXIT_FAILURE, "Cannot create pool: %s\n",
+                 rte_strerror(rte_errno));
+    }
+
+    for (uint16_t device = 0; device < nb_devices; device++) {
+        ret = nf_init_device(device, mbuf_pool);
+        if (ret == 0) {
+            NF_INFO("Initialized device %" PRIu16 ".", device);
+        } else {
+            rte_exit(EXIT_FAILURE, "Cannot init device %" PRIu16 ": %d",
+                     device, ret);
+        }
+    }
+
+    worker_main();
+
+    return 0;
+}
@@ -4,13 +4,18 @@ namespace synapse {
 namespace tofino {
 
 const char *const MARKER_CPU_HEADER = "CPU_HEADER";
+const char *const MARKER_RECIRC_HEADER = "RECIRC_HEADER";
 const char *const MARKER_CUSTOM_HEADERS = "CUSTOM_HEADERS";
 
 const char *const MARKER_INGRESS_HEADERS = "INGRESS_HEADERS";
 const char *const MARKER_INGRESS_METADATA = "INGRESS_METADATA";
 const char *const MARKER_INGRESS_PARSER = "INGRESS_PARSER";
+const char *const MARKER_INGRESS_PARSER_RECIRC_PORTS =
+    "INGRESS_PARSER_RECIRC_PORTS";
 const char *const MARKER_INGRESS_CONTROL = "INGRESS_CONTROL";
 const char *const MARKER_INGRESS_CONTROL_APPLY = "INGRESS_CONTROL_APPLY";
+const char *const MARKER_INGRESS_CONTROL_APPLY_RECIRC =
+    "INGRESS_CONTROL_APPLY_RECIRC";
 const char *const MARKER_INGRESS_DEPARSER = "INGRESS_DEPARSER";
 
 const char *const MARKER_EGRESS_HEADERS = "EGRESS_HEADERS";
@@ -0,0 +1,103 @@
+#include "cpu_header.h"
+#include "../../targets/tofino/tofino.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace synapse {
+namespace tofino {
+
+code_t get_cpu_hdr_field_name(const symbol_t &symbol) {
+  code_t name = symbol.array->name;
+
+  for (char &c : name) {
+    if (!std::isalnum(c) && c != '_') {
+      c = '_';
+    }
+  }
+
+  return name;
+}
+
+std::vector<cpu_hdr_field_t> get_cpu_hdr_fields(const EP *ep) {
+  std::vector<cpu_hdr_field_t> fields;
+  std::unordered_set<code_t> names;
+  bits_t offset = 0;
+
+  const EPNode *root = ep->get_root();
+
+  if (!root) {
+    return fields;
+  }
+
+  root->visit_nodes([&fields, &names, &offset](const EPNode *node) {
+    const Module *module = node->get_module();
+
+    if (module->get_type() != ModuleType::Tofino_SendToController) {
+      return EPNodeVisitAction::VISIT_CHILDREN;
+    }
+
+    const SendToController *send_to_controller =
+        static_cast<const SendToController *>(module);
+    const symbols_t &symbols = send_to_controller->get_symbols();
+
+    // Symbols are unordered, but the layout must not change between runs.
+    std::vector<code_t> new_names;
+    std::unordered_map<code_t, klee::Expr::Width> widths;
+
+    for (const symbol_t &symbol : symbols) {
+      code_t name = get_cpu_hdr_field_name(symbol);
+
+      if (names.find(name) == names.end()) {
+        new_names.push_back(name);
+        widths[name] = symbol.expr->getWidth();
+      }
+    }
+
+    std::sort(new_names.begin(), new_names.end());
+
+    for (const code_t &name : new_names) {
+      klee::Expr::Width width = widths.at(name);
+      assert(width % 8 == 0 && "CPU header fields must be byte aligned");
+
+      fields.push_back({name, width, offset});
+      names.insert(name);
+      offset += width;
+    }
+
+    // Everything past this point runs on the controller.
+    return EPNodeVisitAction::SKIP_CHILDREN;
+  });
+
+  return fields;
+}
+
+// Vector registers are named after the part of the value they hold, see
+// TofinoModuleGenerator::build_vector_registers().
+static int get_vector_register_part(const Register *reg) {
+  size_t separator = reg->id.find_last_of('_');
+  assert(separator != std::string::npos);
+  return std::stoi(reg->id.substr(separator + 1));
+}
+
+std::vector<const Register *> get_vector_registers(const EP *ep, addr_t obj) {
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+
+  std::vector<const Register *> regs;
+  for (const DS *ds : tofino_ctx->get_ds(obj)) {
+    assert(ds->type == DSType::REGISTER);
+    regs.push_back(static_cast<const Register *>(ds));
+  }
+
+  std::sort(regs.begin(), regs.end(),
+            [](const Register *r1, const Register *r2) {
+              return get_vector_register_part(r1) <
+                     get_vector_register_part(r2);
+            });
+
+  return regs;
+}
+
+} // namespace tofino
+} // namespace synapse
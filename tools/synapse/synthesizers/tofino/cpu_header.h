@@ -0,0 +1,38 @@
+#pragma once
+
+#include "klee-util.h"
+#include "call-paths-to-bdd.h"
+
+#include "../synthesizer.h"
+#include "../../targets/tofino/data_structures/register.h"
+
+#include <vector>
+
+namespace synapse {
+namespace tofino {
+
+// The fixed part of the CPU header (code path, ingress port and egress port),
+// found before the fields listed below.
+constexpr bits_t CPU_HEADER_FIXED_SIZE = 48;
+
+struct cpu_hdr_field_t {
+  code_t name;
+  klee::Expr::Width width;
+
+  // Counted from the end of the fixed part of the header.
+  bits_t offset;
+};
+
+// Data plane state the switch sends to the controller along with the packet.
+// Every code path that goes to the controller shares the same header, with a
+// field for each symbol any of them needs. Both the P4 program and the
+// controller are synthesized from this layout.
+std::vector<cpu_hdr_field_t> get_cpu_hdr_fields(const EP *ep);
+code_t get_cpu_hdr_field_name(const symbol_t &symbol);
+
+// Registers holding a vector, in the order of the parts of the value they
+// hold (LSB first). Both sides split and join vector values with it.
+std::vector<const Register *> get_vector_registers(const EP *ep, addr_t obj);
+
+} // namespace tofino
+} // namespace synapse
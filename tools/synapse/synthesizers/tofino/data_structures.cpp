@@ -3,33 +3,157 @@
 namespace synapse {
 namespace tofino {
 
+void TofinoSynthesizer::init_phv_containers(const TNAProperties &properties) {
+  free_phv_containers[8] = properties.phv_8bit_containers;
+  free_phv_containers[16] = properties.phv_16bit_containers;
+  free_phv_containers[32] = properties.phv_32bit_containers;
+}
+
+// Takes the smallest free containers that hold the given width. Running out of
+// containers is left for the compiler to report, as headers and metadata are
+// not accounted for here.
+void TofinoSynthesizer::allocate_phv_containers(bits_t width) {
+  while (width > 0) {
+    auto chosen = free_phv_containers.end();
+
+    for (auto it = free_phv_containers.begin(); it != free_phv_containers.end();
+         ++it) {
+      if (it->second > 0) {
+        chosen = it;
+      }
+
+      if (it->second > 0 && it->first >= width) {
+        break;
+      }
+    }
+
+    if (chosen == free_phv_containers.end()) {
+      Log::wrn() << "Out of PHV containers\n";
+      return;
+    }
+
+    chosen->second--;
+    width = chosen->first >= width ? 0 : width - chosen->first;
+  }
+}
+
+// Packs consecutive fields together, as long as they fit in the widest PHV
+// container still free. A wider group would be split across smaller
+// containers anyway. Fields keep their order (the first one on the MSB), so
+// the controller can still split the packed value.
+std::vector<klee::ref<klee::Expr>> TofinoSynthesizer::pack_fields(
+    const std::vector<klee::ref<klee::Expr>> &fields) {
+  std::vector<klee::ref<klee::Expr>> packed;
+  klee::ref<klee::Expr> group;
+
+  bits_t max_container = 0;
+  for (const auto &[size, count] : free_phv_containers) {
+    if (count > 0) {
+      max_container = size;
+    }
+  }
+
+  for (klee::ref<klee::Expr> field : fields) {
+    bits_t width = field->getWidth();
+
+    if (!group.isNull() && group->getWidth() % 8 == 0 && width % 8 == 0 &&
+        group->getWidth() + width <= max_container) {
+      group = kutil::solver_toolbox.exprBuilder->Concat(group, field);
+      continue;
+    }
+
+    if (!group.isNull()) {
+      packed.push_back(group);
+    }
+
+    group = field;
+  }
+
+  if (!group.isNull()) {
+    packed.push_back(group);
+  }
+
+  return packed;
+}
+
+// Consecutive keys coming from contiguous bits of the same variable are
+// matched as a single field, saving match keys and exact match crossbar.
+std::vector<code_t> TofinoSynthesizer::transpile_keys(
+    const std::vector<klee::ref<klee::Expr>> &keys) {
+  std::vector<code_t> fields;
+
+  size_t i = 0;
+  while (i < keys.size()) {
+    size_t end = i + 1;
+    code_t field = transpiler.transpile(keys[i]);
+
+    klee::ref<klee::Expr> merged = keys[i];
+    for (size_t j = i + 1; j < keys.size(); j++) {
+      merged = kutil::solver_toolbox.exprBuilder->Concat(merged, keys[j]);
+
+      var_t var;
+      if (get_var(merged, var)) {
+        field = var.name;
+        end = j + 1;
+      }
+    }
+
+    fields.push_back(field);
+    i = end;
+  }
+
+  return fields;
+}
+
 void TofinoSynthesizer::transpile_table(
     code_builder_t &builder, const Table *table,
     const std::vector<klee::ref<klee::Expr>> &keys,
     const std::vector<klee::ref<klee::Expr>> &values) {
+  std::vector<klee::ref<klee::Expr>> packed_values = pack_fields(values);
+
+  for (size_t i = 0; i < packed_values.size(); i++) {
+    code_t param = table->id + "_value_" + std::to_string(i);
+    var_stacks.back().emplace_back(param, packed_values[i]);
+  }
+
+  declare_table(builder, table, keys, packed_values);
+}
+
+// Declares the table and the action data it sets, once.
+void TofinoSynthesizer::declare_table(
+    code_builder_t &builder, const Table *table,
+    const std::vector<klee::ref<klee::Expr>> &keys,
+    const std::vector<klee::ref<klee::Expr>> &packed_values) {
+  if (declared_tables.find(table->id) != declared_tables.end()) {
+    return;
+  }
+
+  declared_tables.insert(table->id);
+
   code_t action_name = table->id + "_get_value";
+  size_t total_values = packed_values.size();
 
   std::vector<code_t> action_params;
-  size_t total_values = values.size();
   for (size_t i = 0; i < total_values; i++) {
-    klee::ref<klee::Expr> value = values[i];
-    code_t param = table->id + "_value_" + std::to_string(i);
-    action_params.push_back(param);
-    var_stacks.back().emplace_back(param, value);
+    action_params.push_back(table->id + "_value_" + std::to_string(i));
+  }
+
+  for (size_t i = 0; i < total_values; i++) {
+    allocate_phv_containers(packed_values[i]->getWidth());
 
     builder.indent();
-    builder << type_from_expr(value);
+    builder << type_from_expr(packed_values[i]);
     builder << " ";
-    builder << param;
+    builder << action_params[i];
     builder << ";\n";
   }
 
-  if (!values.empty()) {
+  if (!packed_values.empty()) {
     builder.indent();
     builder << "action " << action_name << "(";
 
     for (size_t i = 0; i < total_values; i++) {
-      klee::ref<klee::Expr> value = values[i];
+      klee::ref<klee::Expr> value = packed_values[i];
 
       if (i != 0) {
         builder << ", ";
@@ -68,9 +192,9 @@ void TofinoSynthesizer::transpile_table(
   builder << "key = {\n";
   builder.inc();
 
-  for (klee::ref<klee::Expr> key : keys) {
+  for (const code_t &key : transpile_keys(keys)) {
     builder.indent();
-    builder << transpiler.transpile(key) << ": exact;\n";
+    builder << key << ": exact;\n";
   }
 
   builder.dec();
@@ -80,7 +204,7 @@ void TofinoSynthesizer::transpile_table(
   builder.indent();
   builder << "actions = {";
 
-  if (!values.empty()) {
+  if (!packed_values.empty()) {
     builder << "\n";
     builder.inc();
 
@@ -102,10 +226,441 @@ void TofinoSynthesizer::transpile_table(
   builder << "\n";
 }
 
+// Declares the register along with one register action per action it was
+// placed with, once. Writes and swaps take their operand from <id>_value.
+void TofinoSynthesizer::transpile_register(code_builder_t &builder,
+                                           const Register *reg) {
+  if (declared_registers.find(reg->id) != declared_registers.end()) {
+    return;
+  }
+
+  declared_registers.insert(reg->id);
+
+  code_t value_type = "bit<" + std::to_string(reg->value) + ">";
+  code_t index_type = "bit<" + std::to_string(reg->index) + ">";
+
+  builder.indent();
+  builder << "Register<" << value_type << ", " << index_type << ">("
+          << reg->num_entries << ", 0) " << reg->id << ";\n";
+
+  bool has_operand = reg->actions.count(RegisterAction::WRITE) ||
+                     reg->actions.count(RegisterAction::SWAP);
+
+  if (has_operand) {
+    builder.indent();
+    builder << value_type << " " << reg->id << "_value;\n";
+  }
+
+  // Fixed order, so the output does not depend on the hashing of the set.
+  const std::vector<std::pair<RegisterAction, code_t>> actions = {
+      {RegisterAction::READ, "read"},
+      {RegisterAction::WRITE, "write"},
+      {RegisterAction::SWAP, "swap"},
+      {RegisterAction::INC, "inc"},
+  };
+
+  for (const auto &[action, action_name] : actions) {
+    if (!reg->actions.count(action)) {
+      continue;
+    }
+
+    builder.indent();
+    builder << "RegisterAction<" << value_type << ", " << index_type << ", "
+            << value_type << ">(" << reg->id << ") " << reg->id << "_"
+            << action_name << " = {\n";
+    builder.inc();
+
+    builder.indent();
+    builder << "void apply(inout " << value_type << " value, out "
+            << value_type << " out_value) {\n";
+    builder.inc();
+
+    switch (action) {
+    case RegisterAction::READ:
+      builder.indent();
+      builder << "out_value = value;\n";
+      break;
+    case RegisterAction::WRITE:
+      builder.indent();
+      builder << "value = " << reg->id << "_value;\n";
+      builder.indent();
+      builder << "out_value = value;\n";
+      break;
+    case RegisterAction::SWAP:
+      builder.indent();
+      builder << "out_value = value;\n";
+      builder.indent();
+      builder << "value = " << reg->id << "_value;\n";
+      break;
+    case RegisterAction::INC:
+      builder.indent();
+      builder << "value = value |+| 1;\n";
+      builder.indent();
+      builder << "out_value = value;\n";
+      break;
+    }
+
+    builder.dec();
+    builder.indent();
+    builder << "}\n";
+
+    builder.dec();
+    builder.indent();
+    builder << "};\n";
+  }
+
+  builder << "\n";
+}
+
+static code_t type_from_width(bits_t width) {
+  return "bit<" + std::to_string(width) + ">";
+}
+
+// Declares a register action on the expirator returning a single bit, and
+// leaves the builder inside its apply block for the caller to fill.
+static void open_expirator_action(code_builder_t &builder,
+                                  const Register &expirator,
+                                  const code_t &action_name) {
+  code_t timestamp_type = type_from_width(expirator.value);
+  code_t slot_type = type_from_width(expirator.index);
+
+  builder.indent();
+  builder << "RegisterAction<" << timestamp_type << ", " << slot_type
+          << ", bit<1>>(" << expirator.id << ") " << expirator.id << "_"
+          << action_name << " = {\n";
+  builder.inc();
+
+  builder.indent();
+  builder << "void apply(inout " << timestamp_type
+          << " value, out bit<1> out_value) {\n";
+  builder.inc();
+}
+
+static void close_expirator_action(code_builder_t &builder) {
+  builder.dec();
+  builder.indent();
+  builder << "}\n";
+
+  builder.dec();
+  builder.indent();
+  builder << "};\n";
+}
+
+// Writes the body of an expirator action that only updates the slot (and
+// returns 1) when the condition holds.
+static void transpile_expirator_update(code_builder_t &builder,
+                                       const code_t &condition,
+                                       const code_t &new_value) {
+  builder.indent();
+  builder << "if (" << condition << ") {\n";
+  builder.inc();
+
+  builder.indent();
+  builder << "value = " << new_value << ";\n";
+  builder.indent();
+  builder << "out_value = 1;\n";
+
+  builder.dec();
+  builder.indent();
+  builder << "} else {\n";
+  builder.inc();
+
+  builder.indent();
+  builder << "out_value = 0;\n";
+
+  builder.dec();
+  builder.indent();
+  builder << "}\n";
+}
+
+// Declares what every access to the cached table shares, once. The expirator
+// holds the timestamp of the entry in each cache slot (0 if the slot is
+// free), and its actions implement the policy: touch refreshes a live entry,
+// claim takes the slot for a new one, and free releases it. Admission control
+// adds the count-min sketch rows and the threshold they are compared against.
+// Each access declares the table it applies itself.
 void TofinoSynthesizer::transpile_fcfs_cached_table(
-    code_builder_t &builder, const FCFSCachedTable *table,
+    code_builder_t &builder, const EP *ep, const FCFSCachedTable *table) {
+  if (declared_cached_tables.find(table->id) != declared_cached_tables.end()) {
+    return;
+  }
+
+  declared_cached_tables.insert(table->id);
+
+  const Register &expirator = table->cache_expirator;
+  code_t timestamp_type = type_from_width(expirator.value);
+
+  const Context &ctx = ep->get_ctx();
+  const std::optional<expiration_data_t> &expiration =
+      ctx.get_expiration_data();
+
+  // Without an expiration time, entries only leave the cache when deleted.
+  code_t live = "value != 0";
+
+  if (expiration.has_value()) {
+    // Timestamps only keep bits [47:16] of the MAC timestamp.
+    builder.indent();
+    builder << "const " << timestamp_type << " " << table->id
+            << "_expiration = "
+            << std::to_string(expiration->expiration_time >> 16) << ";\n";
+
+    live = now.name + " - value < " + table->id + "_expiration";
+  }
+
+  if (!table->admission_sketch.empty()) {
+    const Register &row = table->admission_sketch.front();
+
+    builder.indent();
+    builder << "const " << type_from_width(row.value) << " " << table->id
+            << "_threshold = " << table->admission_threshold << ";\n";
+  }
+
+  builder << "\n";
+
+  for (const Register &row : table->admission_sketch) {
+    transpile_register(builder, &row);
+  }
+
+  builder.indent();
+  builder << "Register<" << timestamp_type << ", "
+          << type_from_width(expirator.index) << ">(" << expirator.num_entries
+          << ", 0) " << expirator.id << ";\n";
+
+  open_expirator_action(builder, expirator, "touch");
+  transpile_expirator_update(builder, live, now.name);
+  close_expirator_action(builder);
+
+  // LRU evicts whatever the slot holds, the other policies wait for the entry
+  // in it to expire.
+  open_expirator_action(builder, expirator, "claim");
+  if (table->policy == CachePolicy::LRU_APPROX) {
+    transpile_expirator_update(builder, "true", now.name);
+  } else {
+    transpile_expirator_update(builder, "!(" + live + ")", now.name);
+  }
+  close_expirator_action(builder);
+
+  open_expirator_action(builder, expirator, "free");
+  transpile_expirator_update(builder, "true", "0");
+  close_expirator_action(builder);
+
+  builder << "\n";
+
+  for (const Register &cache_key : table->cache_keys) {
+    transpile_register(builder, &cache_key);
+  }
+}
+
+// Every access applies a table of its own, taken in the order the accesses
+// are synthesized. They all hold the same entries.
+const Table *
+TofinoSynthesizer::get_cached_table_table(const FCFSCachedTable *table) {
+  size_t &accesses = cached_table_accesses[table->id];
+  assert(accesses < table->tables.size() && "Not enough tables");
+  return &table->tables[accesses++];
+}
+
+// Hashes the key into its cache slot, returning the variable holding it.
+code_t TofinoSynthesizer::transpile_cache_slot(
+    const FCFSCachedTable *table,
+    const std::vector<klee::ref<klee::Expr>> &keys) {
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  code_t slot_type = type_from_width(table->cache_expirator.index);
+  code_t hash = get_unique_var_name(table->id + "_hash");
+  code_t slot = get_unique_var_name(table->id + "_slot");
+
+  ingress.indent();
+  ingress << "Hash<" << slot_type << ">(HashAlgorithm_t.CRC32) " << hash
+          << ";\n";
+
+  ingress_apply.indent();
+  ingress_apply << slot_type << " " << slot << " = " << hash << ".get({";
+
+  bool first = true;
+  for (const code_t &key : transpile_keys(keys)) {
+    if (!first) {
+      ingress_apply << ", ";
+    }
+    ingress_apply << key;
+    first = false;
+  }
+
+  ingress_apply << "});\n";
+
+  return slot;
+}
+
+// Looks the key up in the table first, and then in the cache. A hit in the
+// cache finds the key in the slot it hashes to, with a live entry. The value
+// of cached entries is their slot. Returns the variable telling whether the
+// key was found.
+code_t TofinoSynthesizer::transpile_cache_read(
+    const FCFSCachedTable *table,
     const std::vector<klee::ref<klee::Expr>> &keys,
-    const std::vector<klee::ref<klee::Expr>> &values) {}
+    klee::ref<klee::Expr> value, const symbol_t &map_has_this_key) {
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  const Table *cache_table = get_cached_table_table(table);
+  transpile_table(ingress, cache_table, keys, {value});
+
+  code_t hit = "hit_" + cache_table->id;
+
+  ingress_apply.indent();
+  ingress_apply << "bool " << hit << " = " << cache_table->id
+                << ".apply().hit;\n";
+
+  ingress_apply.indent();
+  ingress_apply << "if (!" << hit << ") {\n";
+  ingress_apply.inc();
+
+  code_t slot = transpile_cache_slot(table, keys);
+
+  // A colliding key refreshes the slot too, which only delays its expiration.
+  ingress_apply.indent();
+  ingress_apply << "if (" << table->cache_expirator.id << "_touch.execute("
+                << slot << ") == 1) {\n";
+  ingress_apply.inc();
+
+  assert(keys.size() == table->cache_keys.size());
+
+  std::vector<code_t> matches;
+  for (size_t i = 0; i < table->cache_keys.size(); i++) {
+    const Register &cache_key = table->cache_keys[i];
+    code_t cached = get_unique_var_name(cache_key.id + "_cached");
+
+    ingress_apply.indent();
+    ingress_apply << type_from_width(cache_key.value) << " " << cached
+                  << " = " << cache_key.id << "_read.execute(" << slot
+                  << ");\n";
+
+    matches.push_back(cached + " == " + transpiler.transpile(keys[i]));
+  }
+
+  ingress_apply.indent();
+  ingress_apply << "if (";
+  for (size_t i = 0; i < matches.size(); i++) {
+    if (i != 0) {
+      ingress_apply << " && ";
+    }
+    ingress_apply << matches[i];
+  }
+  ingress_apply << ") {\n";
+  ingress_apply.inc();
+
+  ingress_apply.indent();
+  ingress_apply << hit << " = true;\n";
+
+  ingress_apply.indent();
+  ingress_apply << cache_table->id << "_value_0 = (" << type_from_expr(value)
+                << ")" << slot << ";\n";
+
+  // Closes the key match, the live entry and the table miss blocks.
+  for (int i = 0; i < 3; i++) {
+    ingress_apply.dec();
+    ingress_apply.indent();
+    ingress_apply << "}\n";
+  }
+
+  var_stacks.back().emplace_back(hit, map_has_this_key, true);
+
+  return hit;
+}
+
+// Takes the cache slot of the key for a new entry, if the policy lets it. On
+// success, sets the failure flag to false and the value to the slot. Both
+// variables are declared by the caller.
+void TofinoSynthesizer::transpile_cache_write(
+    const FCFSCachedTable *table,
+    const std::vector<klee::ref<klee::Expr>> &keys, const var_t &value,
+    const code_t &failed) {
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  code_t slot = transpile_cache_slot(table, keys);
+  std::vector<code_t> key_codes = transpile_keys(keys);
+
+  // Blocks opened in the apply, closed at the end.
+  int blocks = 0;
+
+  if (!table->admission_sketch.empty()) {
+    code_t count = get_unique_var_name(table->id + "_count");
+
+    for (size_t i = 0; i < table->admission_sketch.size(); i++) {
+      const Register &row = table->admission_sketch[i];
+      code_t row_type = type_from_width(row.value);
+      code_t index_type = type_from_width(row.index);
+      code_t hash = get_unique_var_name(row.id + "_hash");
+      code_t row_count = get_unique_var_name(row.id + "_count");
+
+      ingress.indent();
+      ingress << "Hash<" << index_type << ">(HashAlgorithm_t.CRC32) " << hash
+              << ";\n";
+
+      // Salting the key with the row number gives each row its own hash.
+      ingress_apply.indent();
+      ingress_apply << row_type << " " << row_count << " = " << row.id
+                    << "_inc.execute(" << hash << ".get({(bit<8>)" << i;
+      for (const code_t &key : key_codes) {
+        ingress_apply << ", " << key;
+      }
+      ingress_apply << "}));\n";
+
+      ingress_apply.indent();
+      if (i == 0) {
+        ingress_apply << row_type << " " << count << " = " << row_count
+                      << ";\n";
+      } else {
+        ingress_apply << "if (" << row_count << " < " << count << ") {\n";
+        ingress_apply.inc();
+        ingress_apply.indent();
+        ingress_apply << count << " = " << row_count << ";\n";
+        ingress_apply.dec();
+        ingress_apply.indent();
+        ingress_apply << "}\n";
+      }
+    }
+
+    ingress_apply.indent();
+    ingress_apply << "if (" << count << " >= " << table->id
+                  << "_threshold) {\n";
+    ingress_apply.inc();
+    blocks++;
+  }
+
+  ingress_apply.indent();
+  ingress_apply << "if (" << table->cache_expirator.id << "_claim.execute("
+                << slot << ") == 1) {\n";
+  ingress_apply.inc();
+  blocks++;
+
+  assert(keys.size() == table->cache_keys.size());
+  for (size_t i = 0; i < table->cache_keys.size(); i++) {
+    const Register &cache_key = table->cache_keys[i];
+
+    ingress_apply.indent();
+    ingress_apply << cache_key.id << "_value = "
+                  << transpiler.transpile(keys[i]) << ";\n";
+
+    ingress_apply.indent();
+    ingress_apply << cache_key.id << "_swap.execute(" << slot << ");\n";
+  }
+
+  ingress_apply.indent();
+  ingress_apply << failed << " = false;\n";
+
+  ingress_apply.indent();
+  ingress_apply << value.name << " = (" << type_from_var(value) << ")" << slot
+                << ";\n";
+
+  for (int i = 0; i < blocks; i++) {
+    ingress_apply.dec();
+    ingress_apply.indent();
+    ingress_apply << "}\n";
+  }
+}
 
 } // namespace tofino
 } // namespace synapse
\ No newline at end of file
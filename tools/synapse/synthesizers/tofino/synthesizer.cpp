@@ -30,40 +30,56 @@ static const Parser &get_tofino_parser(const EP *ep) {
   return tna.parser;
 }
 
+static const TNAProperties &get_tofino_properties(const EP *ep) {
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+  const TNA &tna = tofino_ctx->get_tna();
+  return tna.get_properties();
+}
+
 TofinoSynthesizer::TofinoSynthesizer(const std::filesystem::path &out_dir,
                                      const bdd::BDD *bdd)
     : Synthesizer(TEMPLATE_FILENAME,
                   {
                       {MARKER_CPU_HEADER, 1},
+                      {MARKER_RECIRC_HEADER, 1},
                       {MARKER_CUSTOM_HEADERS, 0},
                       {MARKER_INGRESS_HEADERS, 1},
                       {MARKER_INGRESS_METADATA, 1},
                       {MARKER_INGRESS_PARSER, 1},
+                      {MARKER_INGRESS_PARSER_RECIRC_PORTS, 3},
                       {MARKER_INGRESS_CONTROL, 1},
-                      {MARKER_INGRESS_CONTROL_APPLY, 2},
+                      {MARKER_INGRESS_CONTROL_APPLY, 3},
+                      {MARKER_INGRESS_CONTROL_APPLY_RECIRC, 3},
                       {MARKER_INGRESS_DEPARSER, 2},
                       {MARKER_EGRESS_HEADERS, 1},
                       {MARKER_EGRESS_METADATA, 1},
                   },
                   out_dir / OUTPUT_FILENAME),
-      var_stacks(1), transpiler(this) {
+      var_stacks(1), transpiler(this),
+      apply_marker(MARKER_INGRESS_CONTROL_APPLY) {
   symbol_t device = bdd->get_device();
   symbol_t time = bdd->get_time();
 
   // Hack
-  var_stacks.back().emplace_back(
-      "ig_intr_md.ingress_port",
-      kutil::solver_toolbox.exprBuilder->Extract(device.expr, 0, 16));
+  ingress_port =
+      var_t("ig_intr_md.ingress_port",
+            kutil::solver_toolbox.exprBuilder->Extract(device.expr, 0, 16));
+  now = var_t("ig_intr_md.ingress_mac_tstamp[47:16]", time);
 
-  var_stacks.back().emplace_back("ig_intr_md.ingress_mac_tstamp[47:16]", time);
+  var_stacks.back().push_back(ingress_port);
+  var_stacks.back().push_back(now);
 }
 
 void TofinoSynthesizer::visit(const EP *ep) {
+  init_phv_containers(get_tofino_properties(ep));
   EPVisitor::visit(ep);
+  transpile_recirculations(ep);
 
   // Transpile the parser after the whole EP has been visited so we have all the
   // headers available.
   transpile_parser(get_tofino_parser(ep));
+  transpile_cpu_header(ep);
 
   Synthesizer::dump();
 }
@@ -71,7 +87,10 @@ void TofinoSynthesizer::visit(const EP *ep) {
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *node) {
   EPVisitor::visit(ep, node);
 
-  if (is_branching_node(node)) {
+  // What follows a recirculation runs on the next pass through the pipeline,
+  // see transpile_recirculations().
+  if (is_branching_node(node) ||
+      node->get_module()->get_type() == ModuleType::Tofino_Recirculate) {
     return;
   }
 
@@ -300,10 +319,89 @@ bool TofinoSynthesizer::get_hdr_var(klee::ref<klee::Expr> expr,
   return false;
 }
 
+void TofinoSynthesizer::transpile_cpu_header(const EP *ep) {
+  code_builder_t &cpu_hdr = get(MARKER_CPU_HEADER);
+
+  for (const cpu_hdr_field_t &field : get_cpu_hdr_fields(ep)) {
+    cpu_hdr.indent();
+    cpu_hdr << "bit<" << field.width << "> " << field.name << ";\n";
+  }
+}
+
+// Each recirculation resumes on the next pass through the pipeline, under the
+// code path it set in the recirculation header. The data plane state it
+// carried over is taken from the header, and the original ingress port
+// replaces the recirculation port.
+void TofinoSynthesizer::transpile_recirculations(const EP *ep) {
+  apply_marker = MARKER_INGRESS_CONTROL_APPLY_RECIRC;
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  // Recirculations found along the way are appended to the pending ones.
+  for (size_t i = 0; i < pending_recirculations.size(); i++) {
+    const EPNode *ep_node = pending_recirculations[i];
+    const Recirculate *recirc =
+        static_cast<const Recirculate *>(ep_node->get_module());
+
+    ingress_apply.indent();
+    ingress_apply << "if (hdr.recirc.code_path == " << ep_node->get_id()
+                  << ") {\n";
+    ingress_apply.inc();
+
+    var_stacks.emplace_back();
+
+    for (const var_t &hdr : hdrs) {
+      var_stacks.back().emplace_back(hdr.name + ".data", hdr.expr);
+    }
+
+    code_t in_port = get_unique_var_name("in_port");
+    ingress_apply.indent();
+    ingress_apply << type_from_expr(ingress_port.expr) << " " << in_port
+                  << " = (" << type_from_expr(ingress_port.expr)
+                  << ")hdr.recirc.in_port;\n";
+    var_stacks.back().emplace_back(in_port, ingress_port.expr);
+
+    for (const symbol_t &symbol : recirc->get_symbols()) {
+      code_t field = get_cpu_hdr_field_name(symbol);
+      code_t var = get_unique_var_name(field);
+
+      ingress_apply.indent();
+      ingress_apply << type_from_expr(symbol.expr) << " " << var
+                    << " = hdr.recirc." << field << ";\n";
+      var_stacks.back().emplace_back(var, symbol);
+    }
+
+    ingress_apply.indent();
+    ingress_apply << "hdr.recirc.setInvalid();\n";
+
+    for (const EPNode *child : ep_node->get_children()) {
+      visit(ep, child);
+    }
+
+    var_stacks.pop_back();
+
+    ingress_apply.dec();
+    ingress_apply.indent();
+    ingress_apply << "}\n";
+  }
+
+  code_builder_t &recirc_hdr = get(MARKER_RECIRC_HEADER);
+  for (const auto &[field, width] : recirc_hdr_fields) {
+    recirc_hdr.indent();
+    recirc_hdr << "bit<" << width << "> " << field << ";\n";
+  }
+
+  code_builder_t &parser_recirc_ports =
+      get(MARKER_INGRESS_PARSER_RECIRC_PORTS);
+  for (int port : recirc_ports) {
+    parser_recirc_ports.indent();
+    parser_recirc_ports << "RECIRCULATION_PORT + " << port
+                        << ": parse_recirc;\n";
+  }
+}
+
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::SendToController *node) {
-  code_builder_t &ingress_apply = get(MARKER_INGRESS_CONTROL_APPLY);
-  code_builder_t &cpu_hdr = get(MARKER_CPU_HEADER);
+  code_builder_t &ingress_apply = get(apply_marker);
 
   const symbols_t &symbols = node->get_symbols();
 
@@ -314,22 +412,15 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
     ingress_apply.indent();
     ingress_apply << "hdr.cpu.";
-    ingress_apply << var.name;
+    ingress_apply << get_cpu_hdr_field_name(symbol);
     ingress_apply << " = ";
-    ingress_apply << var.name;
-    ingress_apply << ";\n";
 
     if (var.is_bool) {
-      cpu_hdr.indent();
-      cpu_hdr << "@padding bit<7> pad_";
-      cpu_hdr << var.name;
-      cpu_hdr << ";\n";
+      ingress_apply << "(" << type_from_expr(symbol.expr) << ")(bit<1>)";
     }
 
-    cpu_hdr.indent();
-    cpu_hdr << type_from_var(var);
-    cpu_hdr << " ";
-    cpu_hdr << var.name << ";\n";
+    ingress_apply << var.name;
+    ingress_apply << ";\n";
   }
 
   ingress_apply.indent();
@@ -340,8 +431,46 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::Recirculate *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  var_t in_port;
+  bool found = get_var(ingress_port.expr, in_port);
+  assert(found && "Ingress port not found");
+
+  ingress_apply.indent();
+  ingress_apply << "hdr.recirc.setValid();\n";
+
+  ingress_apply.indent();
+  ingress_apply << "hdr.recirc.code_path = " << ep_node->get_id() << ";\n";
+
+  ingress_apply.indent();
+  ingress_apply << "hdr.recirc.in_port = (port_t)" << in_port.name << ";\n";
+
+  for (const symbol_t &symbol : node->get_symbols()) {
+    var_t var;
+    bool found = get_var(symbol.expr, var);
+    assert(found && "Symbol not found");
+
+    code_t field = get_cpu_hdr_field_name(symbol);
+    recirc_hdr_fields[field] = symbol.expr->getWidth();
+
+    ingress_apply.indent();
+    ingress_apply << "hdr.recirc." << field << " = ";
+
+    if (var.is_bool) {
+      ingress_apply << "(" << type_from_expr(symbol.expr) << ")(bit<1>)";
+    }
+
+    ingress_apply << var.name << ";\n";
+  }
+
+  int port = node->get_recirc_port();
+
+  ingress_apply.indent();
+  ingress_apply << "fwd(RECIRCULATION_PORT + " << port << ");\n";
+
+  recirc_ports.insert(port);
+  pending_recirculations.push_back(ep_node);
 }
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
@@ -349,7 +478,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::If *node) {
-  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress = get(apply_marker);
 
   const std::vector<klee::ref<klee::Expr>> &conditions = node->get_conditions();
 
@@ -409,7 +538,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::IfSimple *node) {
-  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress = get(apply_marker);
 
   klee::ref<klee::Expr> condition = node->get_condition();
 
@@ -456,7 +585,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::Forward *node) {
   int dst_device = node->get_dst_device();
 
-  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress = get(apply_marker);
 
   ingress.indent();
   ingress << "fwd(";
@@ -466,7 +595,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::Drop *node) {
-  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress = get(apply_marker);
   ingress.indent();
   ingress << "drop();\n";
 }
@@ -476,8 +605,14 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::Broadcast *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(apply_marker);
+
+  var_t in_port;
+  bool found = get_var(ingress_port.expr, in_port);
+  assert(found && "Ingress port not found");
+
+  ingress.indent();
+  ingress << "broadcast((port_t)" << in_port.name << ");\n";
 }
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
@@ -507,7 +642,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::ModifyHeader *node) {
-  code_builder_t &ingress_apply = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress_apply = get(apply_marker);
 
   klee::ref<klee::Expr> hdr = node->get_hdr();
 
@@ -529,7 +664,7 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::SimpleTableLookup *node) {
   code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
-  code_builder_t &ingress_apply = get(MARKER_INGRESS_CONTROL_APPLY);
+  code_builder_t &ingress_apply = get(apply_marker);
 
   DS_ID table_id = node->get_table_id();
   const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
@@ -559,38 +694,264 @@ void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::VectorRegisterLookup *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  const bdd::Call *vector_borrow =
+      static_cast<const bdd::Call *>(node->get_node());
+  const call_t &call = vector_borrow->get_call();
+
+  klee::ref<klee::Expr> index = call.args.at("index").expr;
+  klee::ref<klee::Expr> value = call.extra_vars.at("borrowed_cell").second;
+
+  std::vector<const Register *> regs =
+      get_vector_registers(ep, node->get_obj());
+  std::vector<klee::ref<klee::Expr>> partitions =
+      Register::partition_value(get_tofino_properties(ep), value);
+  assert(regs.size() == partitions.size());
+
+  code_t index_code = transpiler.transpile(index);
+
+  for (size_t i = 0; i < regs.size(); i++) {
+    const Register *reg = regs[i];
+    transpile_register(ingress, reg);
+
+    code_t part = get_unique_var_name(reg->id + "_part");
+
+    ingress_apply.indent();
+    ingress_apply << type_from_expr(partitions[i]) << " " << part << " = "
+                  << reg->id << "_read.execute(" << index_code << ");\n";
+
+    var_stacks.back().emplace_back(part, partitions[i]);
+  }
 }
 
+// Only the registers holding modified bytes are written. Each gets a register
+// action of its own, which builds the new value from the old one in the
+// stateful ALU.
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::VectorRegisterUpdate *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  std::vector<const Register *> regs =
+      get_vector_registers(ep, node->get_obj());
+  std::vector<klee::ref<klee::Expr>> old_partitions =
+      Register::partition_value(get_tofino_properties(ep),
+                                node->get_read_value());
+  assert(regs.size() == old_partitions.size());
+
+  std::unordered_map<int, klee::ref<klee::Expr>> modified_bytes;
+  for (const modification_t &mod : node->get_modifications()) {
+    modified_bytes[mod.byte] = mod.expr;
+  }
+
+  code_t index_code = transpiler.transpile(node->get_index());
+
+  bits_t offset = 0;
+  for (size_t i = 0; i < regs.size(); i++) {
+    const Register *reg = regs[i];
+    klee::ref<klee::Expr> old_partition = old_partitions[i];
+    bits_t width = old_partition->getWidth();
+
+    assert(offset % 8 == 0 && width % 8 == 0);
+
+    klee::ref<klee::Expr> new_partition;
+    bool modified = false;
+
+    for (bits_t byte_offset = 0; byte_offset < width; byte_offset += 8) {
+      klee::ref<klee::Expr> byte;
+
+      auto found_it = modified_bytes.find((offset + byte_offset) / 8);
+      if (found_it != modified_bytes.end()) {
+        byte = found_it->second;
+        modified = true;
+      } else {
+        byte = kutil::solver_toolbox.exprBuilder->Extract(old_partition,
+                                                          byte_offset, 8);
+      }
+
+      if (new_partition.isNull()) {
+        new_partition = byte;
+      } else {
+        new_partition =
+            kutil::solver_toolbox.exprBuilder->Concat(byte, new_partition);
+      }
+    }
+
+    offset += width;
+
+    if (!modified) {
+      continue;
+    }
+
+    transpile_register(ingress, reg);
+
+    code_t value_type = type_from_expr(old_partition);
+    code_t index_type = "bit<" + std::to_string(reg->index) + ">";
+    code_t action_name = get_unique_var_name(reg->id + "_update");
+
+    // Inside the register action, the old value is the value operand.
+    var_stacks.emplace_back();
+    var_stacks.back().emplace_back("value", old_partition);
+    code_t new_value = transpiler.transpile(new_partition);
+    var_stacks.pop_back();
+
+    ingress.indent();
+    ingress << "RegisterAction<" << value_type << ", " << index_type << ", "
+            << value_type << ">(" << reg->id << ") " << action_name
+            << " = {\n";
+    ingress.inc();
+
+    ingress.indent();
+    ingress << "void apply(inout " << value_type << " value, out "
+            << value_type << " out_value) {\n";
+    ingress.inc();
+
+    ingress.indent();
+    ingress << "out_value = value;\n";
+    ingress.indent();
+    ingress << "value = " << new_value << ";\n";
+
+    ingress.dec();
+    ingress.indent();
+    ingress << "}\n";
+
+    ingress.dec();
+    ingress.indent();
+    ingress << "};\n";
+    ingress << "\n";
+
+    ingress_apply.indent();
+    ingress_apply << action_name << ".execute(" << index_code << ");\n";
+  }
 }
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::FCFSCachedTableRead *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+
+  const FCFSCachedTable *table = static_cast<const FCFSCachedTable *>(
+      get_tofino_ds(ep, node->get_id()));
+  std::vector<klee::ref<klee::Expr>> keys =
+      Register::partition_value(get_tofino_properties(ep), node->get_key());
+
+  transpile_fcfs_cached_table(ingress, ep, table);
+  transpile_cache_read(table, keys, node->get_value(),
+                       node->get_map_has_this_key());
 }
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::FCFSCachedTableReadOrWrite *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  const FCFSCachedTable *table = static_cast<const FCFSCachedTable *>(
+      get_tofino_ds(ep, node->get_id()));
+  std::vector<klee::ref<klee::Expr>> keys =
+      Register::partition_value(get_tofino_properties(ep), node->get_key());
+
+  transpile_fcfs_cached_table(ingress, ep, table);
+
+  var_t value(get_unique_var_name("cache_value"), node->get_write_value());
+  code_t failed = get_unique_var_name("cache_write_failed");
+
+  ingress_apply.indent();
+  ingress_apply << type_from_var(value) << " " << value.name << " = 0;\n";
+
+  code_t hit = transpile_cache_read(table, keys, node->get_read_value(),
+                                    node->get_map_has_this_key());
+
+  // Keys found are not written, so the write does not fail.
+  ingress_apply.indent();
+  ingress_apply << "bool " << failed << " = false;\n";
+
+  ingress_apply.indent();
+  ingress_apply << "if (!" << hit << ") {\n";
+  ingress_apply.inc();
+
+  ingress_apply.indent();
+  ingress_apply << failed << " = true;\n";
+
+  transpile_cache_write(table, keys, value, failed);
+
+  ingress_apply.dec();
+  ingress_apply.indent();
+  ingress_apply << "}\n";
+
+  var_stacks.back().push_back(value);
+  var_stacks.back().emplace_back(failed, node->get_cache_write_failed(), true);
 }
 
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::FCFSCachedTableWrite *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  const FCFSCachedTable *table = static_cast<const FCFSCachedTable *>(
+      get_tofino_ds(ep, node->get_id()));
+  std::vector<klee::ref<klee::Expr>> keys =
+      Register::partition_value(get_tofino_properties(ep), node->get_key());
+
+  transpile_fcfs_cached_table(ingress, ep, table);
+
+  // Writes only happen for keys not yet in the map, so there is no table to
+  // look the key up in first.
+  var_t value(get_unique_var_name("cache_value"), node->get_write_value());
+  code_t failed = get_unique_var_name("cache_write_failed");
+
+  ingress_apply.indent();
+  ingress_apply << type_from_var(value) << " " << value.name << " = 0;\n";
+
+  ingress_apply.indent();
+  ingress_apply << "bool " << failed << " = true;\n";
+
+  transpile_cache_write(table, keys, value, failed);
+
+  var_stacks.back().push_back(value);
+  var_stacks.back().emplace_back(failed, node->get_cache_write_failed(), true);
 }
 
+// Entries in the table were inserted by the controller, which must delete
+// them too. Cached entries are freed in the data plane. A key colliding with
+// the deleted one loses its slot as well, just like any LRU eviction.
 void TofinoSynthesizer::visit(const EP *ep, const EPNode *ep_node,
                               const tofino::FCFSCachedTableDelete *node) {
-  // TODO:
-  assert(false && "TODO");
+  code_builder_t &ingress = get(MARKER_INGRESS_CONTROL);
+  code_builder_t &ingress_apply = get(apply_marker);
+
+  const FCFSCachedTable *table = static_cast<const FCFSCachedTable *>(
+      get_tofino_ds(ep, node->get_id()));
+  std::vector<klee::ref<klee::Expr>> keys =
+      Register::partition_value(get_tofino_properties(ep), node->get_key());
+
+  transpile_fcfs_cached_table(ingress, ep, table);
+
+  const Table *cache_table = get_cached_table_table(table);
+  transpile_table(ingress, cache_table, keys, {});
+
+  code_t failed = get_unique_var_name("cache_delete_failed");
+
+  ingress_apply.indent();
+  ingress_apply << "bool " << failed << " = " << cache_table->id
+                << ".apply().hit;\n";
+
+  ingress_apply.indent();
+  ingress_apply << "if (!" << failed << ") {\n";
+  ingress_apply.inc();
+
+  code_t slot = transpile_cache_slot(table, keys);
+
+  ingress_apply.indent();
+  ingress_apply << table->cache_expirator.id << "_free.execute(" << slot
+                << ");\n";
+
+  ingress_apply.dec();
+  ingress_apply.indent();
+  ingress_apply << "}\n";
+
+  var_stacks.back().emplace_back(failed, node->get_cached_delete_failed(),
+                                 true);
 }
 
 code_t TofinoSynthesizer::get_unique_var_name(const code_t &prefix) {
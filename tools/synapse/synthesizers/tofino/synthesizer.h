@@ -7,8 +7,11 @@
 #include "../../targets/tofino/tofino.h"
 #include "../../targets/tofino/data_structures/data_structures.h"
 #include "constants.h"
+#include "cpu_header.h"
 #include "transpiler.h"
 
+#include <map>
+#include <set>
 #include <stack>
 #include <optional>
 #include <filesystem>
@@ -41,6 +44,31 @@ private:
   std::vector<var_t> hdrs;
   Transpiler transpiler;
 
+  var_t ingress_port;
+  var_t now;
+
+  // Where the code of the current pass through the pipeline goes.
+  marker_t apply_marker;
+
+  // Recirculations whose next pass is yet to be synthesized, and the fields of
+  // the recirculation header they need (along with their widths).
+  std::vector<const EPNode *> pending_recirculations;
+  std::map<code_t, klee::Expr::Width> recirc_hdr_fields;
+  std::set<int> recirc_ports;
+
+  // Tables and registers already declared. Every access to the same data
+  // structure shares its declaration (and action data, for tables).
+  std::unordered_set<DS_ID> declared_tables;
+  std::unordered_set<DS_ID> declared_registers;
+
+  // Cached tables already declared, and how many of their tables the accesses
+  // visited so far took. Each access to a cached table applies its own table.
+  std::unordered_set<DS_ID> declared_cached_tables;
+  std::unordered_map<DS_ID, size_t> cached_table_accesses;
+
+  // PHV containers not yet taken by action data, indexed by their size.
+  std::map<bits_t, int> free_phv_containers;
+
 public:
   TofinoSynthesizer(const std::filesystem::path &out_dir, const bdd::BDD *bdd);
 
@@ -78,15 +106,37 @@ private:
   bool get_var(klee::ref<klee::Expr> expr, var_t &out_var) const;
   bool get_hdr_var(klee::ref<klee::Expr> expr, var_t &out_var) const;
 
+  void init_phv_containers(const TNAProperties &properties);
+  void allocate_phv_containers(bits_t width);
+  std::vector<klee::ref<klee::Expr>>
+  pack_fields(const std::vector<klee::ref<klee::Expr>> &fields);
+  std::vector<code_t>
+  transpile_keys(const std::vector<klee::ref<klee::Expr>> &keys);
+
   void transpile_parser(const Parser &parser);
+  void transpile_cpu_header(const EP *ep);
+  void transpile_recirculations(const EP *ep);
   void transpile_table(code_builder_t &builder, const Table *table,
                        const std::vector<klee::ref<klee::Expr>> &keys,
                        const std::vector<klee::ref<klee::Expr>> &values);
   void
-  transpile_fcfs_cached_table(code_builder_t &builder,
-                              const FCFSCachedTable *table,
+  declare_table(code_builder_t &builder, const Table *table,
+                const std::vector<klee::ref<klee::Expr>> &keys,
+                const std::vector<klee::ref<klee::Expr>> &packed_values);
+  void transpile_register(code_builder_t &builder, const Register *reg);
+  void transpile_fcfs_cached_table(code_builder_t &builder, const EP *ep,
+                                   const FCFSCachedTable *table);
+
+  const Table *get_cached_table_table(const FCFSCachedTable *table);
+  code_t transpile_cache_slot(const FCFSCachedTable *table,
+                              const std::vector<klee::ref<klee::Expr>> &keys);
+  code_t transpile_cache_read(const FCFSCachedTable *table,
                               const std::vector<klee::ref<klee::Expr>> &keys,
-                              const std::vector<klee::ref<klee::Expr>> &values);
+                              klee::ref<klee::Expr> value,
+                              const symbol_t &map_has_this_key);
+  void transpile_cache_write(const FCFSCachedTable *table,
+                             const std::vector<klee::ref<klee::Expr>> &keys,
+                             const var_t &value, const code_t &failed);
 
   void dbg_vars() const;
 
@@ -7,6 +7,33 @@ namespace tofino {
 Transpiler::Transpiler(const TofinoSynthesizer *_synthesizer)
     : synthesizer(_synthesizer) {}
 
+static void unsupported_expr(const klee::Expr &e, const std::string &reason) {
+  klee::ref<klee::Expr> expr = const_cast<klee::Expr *>(&e);
+  Log::err() << "Unable to synthesize " << kutil::expr_to_string(expr, true)
+             << " on the Tofino: " << reason << "\n";
+  exit(1);
+}
+
+// The Tofino only divides by powers of two, as shifts and masks.
+static std::optional<unsigned> get_log2(klee::ref<klee::Expr> expr) {
+  if (!kutil::is_constant(expr) || expr->getWidth() > 64) {
+    return std::nullopt;
+  }
+
+  uint64_t value = kutil::solver_toolbox.value_from_expr(expr);
+
+  if (value == 0 || (value & (value - 1)) != 0) {
+    return std::nullopt;
+  }
+
+  unsigned log2 = 0;
+  while ((value >>= 1) != 0) {
+    log2++;
+  }
+
+  return log2;
+}
+
 code_t Transpiler::transpile(klee::ref<klee::Expr> expr) {
   Log::dbg() << "Transpile: " << kutil::expr_to_string(expr, false) << "\n";
 
@@ -46,18 +73,27 @@ klee::ExprVisitor::Action Transpiler::visitRead(const klee::ReadExpr &e) {
   Log::dbg() << kutil::expr_to_string(expr) << "\n";
   synthesizer->dbg_vars();
 
-  assert(false && "TODO");
+  assert(false && "Variable not found");
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action
 Transpiler::visitNotOptimized(const klee::NotOptimizedExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+  builder << transpile(e.getKid(0));
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitSelect(const klee::SelectExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> cond = e.getKid(0);
+  klee::ref<klee::Expr> on_true = e.getKid(1);
+  klee::ref<klee::Expr> on_false = e.getKid(2);
+
+  builder << "(" << transpile(cond) << " ? " << transpile(on_true) << " : "
+          << transpile(on_false) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
@@ -72,25 +108,75 @@ klee::ExprVisitor::Action Transpiler::visitConcat(const klee::ConcatExpr &e) {
     return klee::ExprVisitor::Action::skipChildren();
   }
 
-  Log::dbg() << kutil::expr_to_string(expr) << "\n";
-  synthesizer->dbg_vars();
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  builder << "(";
+  builder << transpile(lhs);
+  builder << " ++ ";
+  builder << transpile(rhs);
+  builder << ")";
 
-  assert(false && "TODO");
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitExtract(const klee::ExtractExpr &e) {
-  assert(false && "TODO");
+  klee::ref<klee::Expr> expr = const_cast<klee::ExtractExpr *>(&e);
+
+  code_builder_t &builder = builders.top();
+
+  TofinoSynthesizer::var_t var;
+  if (synthesizer->get_var(expr, var)) {
+    builder << var.name;
+    return klee::ExprVisitor::Action::skipChildren();
+  }
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+  unsigned offset = e.offset;
+  klee::Expr::Width width = e.getWidth();
+
+  builder << "(";
+  builder << transpile(kid);
+  builder << ")[" << offset + width - 1 << ":" << offset << "]";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitZExt(const klee::ZExtExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> expr = const_cast<klee::ZExtExpr *>(&e);
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  builder << "(" << synthesizer->type_from_expr(expr) << ")";
+
+  // Booleans only cast to a single bit.
+  if (kid->getWidth() == klee::Expr::Bool) {
+    builder << "(bit<1>)";
+  }
+
+  builder << "(" << transpile(kid) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitSExt(const klee::SExtExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> expr = const_cast<klee::SExtExpr *>(&e);
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  // Widening a signed value extends its sign.
+  builder << "(" << synthesizer->type_from_expr(expr) << ")";
+  builder << "(int<" << e.getWidth() << ">)";
+  builder << "(int<" << kid->getWidth() << ">)";
+
+  if (kid->getWidth() == klee::Expr::Bool) {
+    builder << "(bit<1>)";
+  }
+
+  builder << "(" << transpile(kid) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
@@ -121,32 +207,70 @@ klee::ExprVisitor::Action Transpiler::visitSub(const klee::SubExpr &e) {
 }
 
 klee::ExprVisitor::Action Transpiler::visitMul(const klee::MulExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  builder << "(" << transpile(lhs) << " * " << transpile(rhs) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitUDiv(const klee::UDivExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  std::optional<unsigned> log2 = get_log2(rhs);
+  if (!log2.has_value()) {
+    unsupported_expr(e, "the divisor is not a power of two");
+  }
+
+  builder << "(" << transpile(lhs) << " >> " << *log2 << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitSDiv(const klee::SDivExpr &e) {
-  assert(false && "TODO");
+  unsupported_expr(e, "no signed division");
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitURem(const klee::URemExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  std::optional<unsigned> log2 = get_log2(rhs);
+  if (!log2.has_value()) {
+    unsupported_expr(e, "the divisor is not a power of two");
+  }
+
+  uint64_t mask = kutil::solver_toolbox.value_from_expr(rhs) - 1;
+  builder << "(" << transpile(lhs) << " & " << mask << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitSRem(const klee::SRemExpr &e) {
-  assert(false && "TODO");
+  unsupported_expr(e, "no signed division");
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitNot(const klee::NotExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> kid = e.getKid(0);
+
+  if (e.getWidth() == klee::Expr::Bool) {
+    builder << "!(" << transpile(kid) << ")";
+  } else {
+    builder << "~(" << transpile(kid) << ")";
+  }
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
@@ -177,22 +301,52 @@ klee::ExprVisitor::Action Transpiler::visitOr(const klee::OrExpr &e) {
 }
 
 klee::ExprVisitor::Action Transpiler::visitXor(const klee::XorExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  // Booleans have no bitwise operators.
+  const char *op = e.getWidth() == klee::Expr::Bool ? " != " : " ^ ";
+  builder << "(" << transpile(lhs) << op << transpile(rhs) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitShl(const klee::ShlExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  builder << "(" << transpile(lhs) << " << " << transpile(rhs) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitLShr(const klee::LShrExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  builder << "(" << transpile(lhs) << " >> " << transpile(rhs) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
 klee::ExprVisitor::Action Transpiler::visitAShr(const klee::AShrExpr &e) {
-  assert(false && "TODO");
+  code_builder_t &builder = builders.top();
+
+  klee::ref<klee::Expr> expr = const_cast<klee::AShrExpr *>(&e);
+  klee::ref<klee::Expr> lhs = e.getKid(0);
+  klee::ref<klee::Expr> rhs = e.getKid(1);
+
+  // Shifting a signed value right extends its sign.
+  builder << "(" << synthesizer->type_from_expr(expr) << ")";
+  builder << "((int<" << e.getWidth() << ">)(" << transpile(lhs) << ") >> "
+          << transpile(rhs) << ")";
+
   return klee::ExprVisitor::Action::skipChildren();
 }
 
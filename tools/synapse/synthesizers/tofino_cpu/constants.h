@@ -0,0 +1,10 @@
+#pragma once
+
+namespace synapse {
+namespace tofino_cpu {
+
+const char *const TEMPLATE_FILENAME = "tofino_cpu.template.cpp";
+const char *const OUTPUT_FILENAME = "tofino_cpu.cpp";
+
+} // namespace tofino_cpu
+} // namespace synapse
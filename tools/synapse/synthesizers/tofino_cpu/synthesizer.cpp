@@ -0,0 +1,605 @@
+#include "synthesizer.h"
+
+namespace synapse {
+namespace tofino_cpu {
+
+using tofino::cpu_hdr_field_t;
+using tofino::DS;
+using tofino::DSType;
+using tofino::FCFSCachedTable;
+using tofino::Register;
+using tofino::Table;
+using tofino::TofinoContext;
+
+static const std::vector<DS *> &get_tofino_ds(const EP *ep, addr_t obj) {
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+  return tofino_ctx->get_ds(obj);
+}
+
+static std::vector<const Table *> get_tables(const EP *ep, addr_t obj) {
+  std::vector<const Table *> tables;
+
+  for (const DS *ds : get_tofino_ds(ep, obj)) {
+    if (ds->type == DSType::TABLE) {
+      tables.push_back(static_cast<const Table *>(ds));
+    }
+  }
+
+  return tables;
+}
+
+static const FCFSCachedTable *get_cached_table(const EP *ep,
+                                              tofino::DS_ID id) {
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+  const DS *ds = tofino_ctx->get_ds_from_id(id);
+  assert(ds && ds->type == DSType::FCFS_CACHED_TABLE);
+  return static_cast<const FCFSCachedTable *>(ds);
+}
+
+// Tables split the original key into multiple fields, MSB first. The copy on
+// the controller is indexed by the original key.
+static klee::ref<klee::Expr>
+join_keys(const std::vector<klee::ref<klee::Expr>> &keys) {
+  assert(!keys.empty());
+
+  klee::ref<klee::Expr> key = keys.back();
+  for (auto it = keys.rbegin() + 1; it != keys.rend(); ++it) {
+    key = kutil::solver_toolbox.exprBuilder->Concat(*it, key);
+  }
+
+  return key;
+}
+
+// Tables only ever mirror maps, vectors and dchains.
+static void unsupported_table_op(const std::string &op, const code_t &state,
+                                 const std::string &reason) {
+  Log::err() << "Unable to synthesize a table " << op << " on " << state
+             << ": " << reason << "\n";
+  exit(1);
+}
+
+TofinoCPUSynthesizer::TofinoCPUSynthesizer(const std::filesystem::path &out_dir,
+                                           const bdd::BDD *_bdd)
+    : CPUSynthesizer(TEMPLATE_FILENAME, out_dir / OUTPUT_FILENAME, _bdd,
+                     {ModuleType::TofinoCPU_If,
+                      ModuleType::Tofino_SendToController}),
+      bdd(_bdd) {}
+
+void TofinoCPUSynthesizer::visit(const EP *ep) {
+  transpile_state(bdd);
+  transpile_cpu_header(ep);
+
+  code_builder_t &nf_process = get(cpu::MARKER_NF_PROCESS);
+
+  nf_process.indent();
+  nf_process << "switch (code_path) {\n";
+
+  EPVisitor::visit(ep);
+
+  nf_process.indent();
+  nf_process << "}\n";
+
+  nf_process.indent();
+  nf_process << "return DROP;\n";
+
+  Synthesizer::dump();
+}
+
+void TofinoCPUSynthesizer::transpile_cpu_header(const EP *ep) {
+  code_builder_t &state = get(cpu::MARKER_STATE);
+
+  bits_t size = tofino::CPU_HEADER_FIXED_SIZE;
+  for (const cpu_hdr_field_t &field : tofino::get_cpu_hdr_fields(ep)) {
+    cpu_hdr_fields[field.name] = field;
+    size += field.width;
+  }
+
+  state.indent();
+  state << "static const uint16_t CPU_HEADER_SIZE = " << size / 8 << ";\n";
+
+  // The ports the switch broadcasts to.
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+  const tofino::TNAProperties &properties =
+      tofino_ctx->get_tna().get_properties();
+
+  state.indent();
+  state << "static const uint16_t SWITCH_PORTS = " << properties.total_ports
+        << ";\n";
+}
+
+code_t TofinoCPUSynthesizer::build_stable_key(klee::ref<klee::Expr> key) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  code_t key_ptr = build_buffer(key);
+  code_t name = get_unique_var_name("stable_key");
+  bytes_t size = key->getWidth() / 8;
+
+  builder.indent();
+  builder << "uint8_t *" << name << " = (uint8_t *)malloc(" << size << ");\n";
+
+  builder.indent();
+  builder << "memcpy(" << name << ", " << key_ptr << ", " << size << ");\n";
+
+  return name;
+}
+
+code_t TofinoCPUSynthesizer::build_bytes(
+    const std::vector<klee::ref<klee::Expr>> &exprs) {
+  code_builder_t builder;
+
+  builder << "{";
+
+  for (size_t i = 0; i < exprs.size(); i++) {
+    if (i != 0) {
+      builder << ", ";
+    }
+
+    bytes_t size = exprs[i]->getWidth() / 8;
+    builder << "{" << build_buffer(exprs[i]) << ", " << size << "}";
+  }
+
+  builder << "}";
+
+  return builder.dump();
+}
+
+void TofinoCPUSynthesizer::table_write(
+    const Table *table, const std::vector<klee::ref<klee::Expr>> &keys,
+    const std::vector<klee::ref<klee::Expr>> &values) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  code_t action = "NoAction";
+  if (!values.empty()) {
+    action = "Ingress." + table->id + "_get_value";
+  }
+
+  code_t keys_bytes = build_bytes(keys);
+  code_t values_bytes = build_bytes(values);
+
+  builder.indent();
+  builder << "switch_table_write(\"Ingress." << table->id << "\", \"" << action
+          << "\", " << keys_bytes << ", " << values_bytes << ");\n";
+}
+
+void TofinoCPUSynthesizer::table_erase(
+    const Table *table, const std::vector<klee::ref<klee::Expr>> &keys) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  code_t keys_bytes = build_bytes(keys);
+
+  builder.indent();
+  builder << "switch_table_erase(\"Ingress." << table->id << "\", "
+          << keys_bytes << ");\n";
+}
+
+// Everything after this node runs on the controller. The switch already
+// parsed the packet and computed the symbols the rest of the NF needs, so the
+// controller starts by getting them back.
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino::SendToController *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  builder.indent();
+  builder << "case " << ep_node->get_id() << ": {\n";
+  builder.inc();
+  push_vars();
+
+  std::vector<const bdd::Call *> chunks;
+  for (const bdd::Node *prev = node->get_node()->get_prev(); prev;
+       prev = prev->get_prev()) {
+    if (prev->get_type() != bdd::NodeType::CALL) {
+      continue;
+    }
+
+    const bdd::Call *call_node = static_cast<const bdd::Call *>(prev);
+    if (call_node->get_call().function_name == "packet_borrow_next_chunk") {
+      chunks.insert(chunks.begin(), call_node);
+    }
+  }
+
+  for (const bdd::Call *call_node : chunks) {
+    const call_t &call = call_node->get_call();
+
+    klee::ref<klee::Expr> chunk = call.args.at("chunk").out;
+    klee::ref<klee::Expr> the_chunk = call.extra_vars.at("the_chunk").second;
+    klee::ref<klee::Expr> length = call.args.at("length").expr;
+
+    parse_header(kutil::expr_addr_to_obj_addr(chunk), the_chunk, length);
+  }
+
+  for (const symbol_t &symbol : node->get_symbols()) {
+    const cpu_hdr_field_t &field =
+        cpu_hdr_fields.at(tofino::get_cpu_hdr_field_name(symbol));
+    code_t name = "cpu_" + field.name;
+
+    builder.indent();
+    builder << "uint8_t " << name << "[" << field.width / 8 << "];\n";
+
+    builder.indent();
+    builder << "cpu_field(" << name << ", cpu_fields + " << field.offset / 8
+            << ", " << field.width / 8 << ");\n";
+
+    add_var(name, symbol.expr, true);
+  }
+
+  for (const EPNode *child : ep_node->get_children()) {
+    visit(ep, child);
+  }
+
+  pop_vars();
+  builder.dec();
+  builder.indent();
+  builder << "}\n";
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::If *node) {
+  branch(ep, ep_node, node->get_condition());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::Forward *node) {
+  forward(node->get_dst_device());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::Broadcast *node) {
+  broadcast();
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::Drop *node) {
+  drop();
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::ParseHeader *node) {
+  parse_header(node->get_chunk_addr(), node->get_chunk(), node->get_length());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::ModifyHeader *node) {
+  modify_header(node->get_chunk_addr(), node->get_changes());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::ChecksumUpdate *node) {
+  checksum_update(node->get_ip_hdr_addr(), node->get_l4_hdr_addr(),
+                  node->get_checksum());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::MapGet *node) {
+  map_get(node->get_map_addr(), node->get_key(), node->get_value_out(),
+          node->get_map_has_this_key().expr);
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::MapPut *node) {
+  map_put(node->get_map_addr(), node->get_key_addr(), node->get_value());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::MapErase *node) {
+  map_erase(node->get_map_addr(), node->get_key());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::VectorRead *node) {
+  vector_read(node->get_vector_addr(), node->get_index(),
+              node->get_value_addr(), node->get_value());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::VectorWrite *node) {
+  vector_write(node->get_vector_addr(), node->get_index(),
+               node->get_value_addr(), node->get_modifications());
+}
+
+void TofinoCPUSynthesizer::visit(
+    const EP *ep, const EPNode *ep_node,
+    const tofino_cpu::DchainAllocateNewIndex *node) {
+  dchain_allocate_new_index(node->get_dchain_addr(), node->get_time(),
+                            node->get_index_out(), node->get_out_of_space());
+}
+
+void TofinoCPUSynthesizer::visit(
+    const EP *ep, const EPNode *ep_node,
+    const tofino_cpu::DchainRejuvenateIndex *node) {
+  dchain_rejuvenate_index(node->get_dchain_addr(), node->get_index(),
+                          node->get_time());
+}
+
+void TofinoCPUSynthesizer::visit(
+    const EP *ep, const EPNode *ep_node,
+    const tofino_cpu::DchainIsIndexAllocated *node) {
+  dchain_is_index_allocated(node->get_dchain_addr(), node->get_index(),
+                            node->get_is_allocated().expr);
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::DchainFreeIndex *node) {
+  dchain_free_index(node->get_dchain_addr(), node->get_index());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SketchComputeHashes *node) {
+  sketch_compute_hashes(node->get_sketch_addr(), node->get_key());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SketchExpire *node) {
+  sketch_expire(node->get_sketch_addr(), node->get_time());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SketchFetch *node) {
+  sketch_fetch(node->get_sketch_addr(), node->get_overflow());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SketchRefresh *node) {
+  sketch_refresh(node->get_sketch_addr(), node->get_time());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SketchTouchBuckets *node) {
+  sketch_touch_buckets(node->get_sketch_addr(), node->get_time(),
+                       node->get_success());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::ChtFindBackend *node) {
+  cht_find_backend(node->get_cht_addr(), node->get_backends_addr(),
+                   node->get_hash(), node->get_height(), node->get_capacity(),
+                   node->get_backend(), node->get_found());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::HashObj *node) {
+  hash_obj(node->get_obj_addr(), node->get_size(), node->get_hash());
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SimpleTableLookup *node) {
+  addr_t obj = node->get_obj();
+  const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
+  const std::vector<klee::ref<klee::Expr>> &values = node->get_values();
+  const std::optional<symbol_t> &found = node->get_found();
+
+  klee::ref<klee::Expr> found_expr;
+  if (found.has_value()) {
+    found_expr = found->expr;
+  }
+
+  const cpu::CPUSynthesizer::state_t &state = get_state(obj);
+
+  switch (state.type) {
+  case StateType::Map: {
+    assert(values.size() == 1);
+    map_get(obj, join_keys(keys), values[0], found_expr);
+  } break;
+  case StateType::Vector: {
+    assert(keys.size() == 1 && values.size() == 1);
+    vector_borrow(obj, keys[0], values[0]);
+  } break;
+  case StateType::Dchain: {
+    assert(keys.size() == 1);
+    dchain_is_index_allocated(obj, keys[0], found_expr);
+  } break;
+  case StateType::Sketch: {
+    unsupported_table_op("lookup", state.name, "sketches are not tables");
+  } break;
+  }
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SimpleTableUpdate *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  addr_t obj = node->get_obj();
+  const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
+  const std::vector<klee::ref<klee::Expr>> &values = node->get_values();
+  const cpu::CPUSynthesizer::state_t &state = get_state(obj);
+
+  switch (state.type) {
+  case StateType::Map: {
+    assert(values.size() == 1);
+    code_t key = build_stable_key(join_keys(keys));
+
+    builder.indent();
+    builder << "map_put(" << state.name << ", " << key << ", "
+            << transpile(values[0]) << ");\n";
+  } break;
+  case StateType::Vector: {
+    assert(keys.size() == 1 && values.size() == 1);
+    code_t value = build_buffer(values[0]);
+    code_t cell = vector_borrow(obj, keys[0], values[0]);
+
+    builder.indent();
+    builder << "memcpy(" << cell << ", " << value << ", "
+            << values[0]->getWidth() / 8 << ");\n";
+
+    builder.indent();
+    builder << "vector_return(" << state.name << ", " << transpile(keys[0])
+            << ", " << cell << ");\n";
+  } break;
+  case StateType::Dchain: {
+    assert(keys.size() == 1);
+    dchain_allocate_new_index(obj, bdd->get_time().expr, keys[0],
+                              std::nullopt);
+  } break;
+  case StateType::Sketch: {
+    unsupported_table_op("update", state.name, "sketches are not tables");
+  } break;
+  }
+
+  for (const Table *table : get_tables(ep, obj)) {
+    table_write(table, keys, values);
+  }
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::SimpleTableDelete *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  addr_t obj = node->get_obj();
+  const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
+  const cpu::CPUSynthesizer::state_t &state = get_state(obj);
+
+  switch (state.type) {
+  case StateType::Map: {
+    code_t key = build_buffer(join_keys(keys));
+    code_t trash = get_unique_var_name("trash");
+
+    builder.indent();
+    builder << "void *" << trash << ";\n";
+
+    builder.indent();
+    builder << "map_erase(" << state.name << ", " << key << ", &" << trash
+            << ");\n";
+
+    builder.indent();
+    builder << "free(" << trash << ");\n";
+  } break;
+  case StateType::Dchain: {
+    assert(keys.size() == 1);
+    dchain_free_index(obj, keys[0]);
+  } break;
+  case StateType::Vector: {
+    unsupported_table_op("delete", state.name, "vectors keep every entry");
+  } break;
+  case StateType::Sketch: {
+    unsupported_table_op("delete", state.name, "sketches are not tables");
+  } break;
+  }
+
+  for (const Table *table : get_tables(ep, obj)) {
+    table_erase(table, keys);
+  }
+}
+
+// The switch updates the registers on its own, so the controller reads them
+// back instead of trusting its copy.
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::VectorRegisterLookup *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  addr_t obj = node->get_obj();
+  klee::ref<klee::Expr> index = node->get_index();
+
+  code_t cell = vector_borrow(obj, index, node->get_value());
+
+  bits_t offset = 0;
+  for (const Register *reg : tofino::get_vector_registers(ep, obj)) {
+    builder.indent();
+    builder << "switch_register_read(\"Ingress." << reg->id << "\", "
+            << transpile(index) << ", " << cell << " + " << offset / 8 << ", "
+            << reg->value / 8 << ");\n";
+
+    offset += reg->value;
+  }
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::VectorRegisterUpdate *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  addr_t obj = node->get_obj();
+  klee::ref<klee::Expr> index = node->get_index();
+  const cpu::CPUSynthesizer::state_t &vector = get_state(obj);
+  code_t cell = get_unique_var_name("vector_value");
+
+  builder.indent();
+  builder << "uint8_t *" << cell << ";\n";
+
+  builder.indent();
+  builder << "vector_borrow(" << vector.name << ", " << transpile(index)
+          << ", (void **)&" << cell << ");\n";
+
+  for (const modification_t &mod : node->get_modifications()) {
+    builder.indent();
+    builder << cell << "[" << mod.byte << "] = " << transpile(mod.expr)
+            << ";\n";
+  }
+
+  builder.indent();
+  builder << "vector_return(" << vector.name << ", " << transpile(index)
+          << ", " << cell << ");\n";
+
+  bits_t offset = 0;
+  for (const Register *reg : tofino::get_vector_registers(ep, obj)) {
+    builder.indent();
+    builder << "switch_register_write(\"Ingress." << reg->id << "\", "
+            << transpile(index) << ", {" << cell << " + " << offset / 8
+            << ", " << reg->value / 8 << "});\n";
+
+    offset += reg->value;
+  }
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::FCFSCachedTableRead *node) {
+  const std::optional<symbol_t> &found = node->get_found();
+
+  klee::ref<klee::Expr> found_expr;
+  if (found.has_value()) {
+    found_expr = found->expr;
+  }
+
+  map_get(node->get_obj(), join_keys(node->get_keys()), node->get_value(),
+          found_expr);
+}
+
+void TofinoCPUSynthesizer::visit(const EP *ep, const EPNode *ep_node,
+                                 const tofino_cpu::FCFSCachedTableWrite *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
+  klee::ref<klee::Expr> value = node->get_value();
+
+  const cpu::CPUSynthesizer::state_t &map = get_state(node->get_obj());
+  code_t key = build_stable_key(join_keys(keys));
+
+  builder.indent();
+  builder << "map_put(" << map.name << ", " << key << ", " << transpile(value)
+          << ");\n";
+
+  const FCFSCachedTable *cached_table = get_cached_table(ep, node->get_id());
+  for (const Table &table : cached_table->tables) {
+    table_write(&table, keys, {value});
+  }
+}
+
+void TofinoCPUSynthesizer::visit(
+    const EP *ep, const EPNode *ep_node,
+    const tofino_cpu::FCFSCachedTableDelete *node) {
+  code_builder_t &builder = get(cpu::MARKER_NF_PROCESS);
+
+  const std::vector<klee::ref<klee::Expr>> &keys = node->get_keys();
+
+  const cpu::CPUSynthesizer::state_t &map = get_state(node->get_obj());
+  code_t key = build_buffer(join_keys(keys));
+  code_t trash = get_unique_var_name("trash");
+
+  builder.indent();
+  builder << "void *" << trash << ";\n";
+
+  builder.indent();
+  builder << "map_erase(" << map.name << ", " << key << ", &" << trash
+          << ");\n";
+
+  builder.indent();
+  builder << "free(" << trash << ");\n";
+
+  const FCFSCachedTable *cached_table = get_cached_table(ep, node->get_id());
+  for (const Table &table : cached_table->tables) {
+    table_erase(&table, keys);
+  }
+}
+
+} // namespace tofino_cpu
+} // namespace synapse
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../cpu/synthesizer.h"
+#include "../tofino/cpu_header.h"
+#include "../../targets/tofino/tofino.h"
+#include "../../targets/tofino_cpu/tofino_cpu.h"
+#include "constants.h"
+
+#include <filesystem>
+
+namespace synapse {
+namespace tofino_cpu {
+
+// The switch controller. Keeps its own copy of every data structure, and
+// mirrors each change it makes into the tables and registers the switch
+// implements them with.
+class TofinoCPUSynthesizer : public cpu::CPUSynthesizer {
+public:
+  TofinoCPUSynthesizer(const std::filesystem::path &out_dir,
+                       const bdd::BDD *bdd);
+
+  void visit(const EP *ep) override;
+  using cpu::CPUSynthesizer::visit;
+
+  DECLARE_VISIT(tofino::SendToController)
+
+  DECLARE_VISIT(tofino_cpu::If)
+  DECLARE_VISIT(tofino_cpu::Forward)
+  DECLARE_VISIT(tofino_cpu::Broadcast)
+  DECLARE_VISIT(tofino_cpu::Drop)
+  DECLARE_VISIT(tofino_cpu::ParseHeader)
+  DECLARE_VISIT(tofino_cpu::ModifyHeader)
+  DECLARE_VISIT(tofino_cpu::ChecksumUpdate)
+  DECLARE_VISIT(tofino_cpu::MapGet)
+  DECLARE_VISIT(tofino_cpu::MapPut)
+  DECLARE_VISIT(tofino_cpu::MapErase)
+  DECLARE_VISIT(tofino_cpu::VectorRead)
+  DECLARE_VISIT(tofino_cpu::VectorWrite)
+  DECLARE_VISIT(tofino_cpu::DchainAllocateNewIndex)
+  DECLARE_VISIT(tofino_cpu::DchainRejuvenateIndex)
+  DECLARE_VISIT(tofino_cpu::DchainIsIndexAllocated)
+  DECLARE_VISIT(tofino_cpu::DchainFreeIndex)
+  DECLARE_VISIT(tofino_cpu::SketchComputeHashes)
+  DECLARE_VISIT(tofino_cpu::SketchExpire)
+  DECLARE_VISIT(tofino_cpu::SketchFetch)
+  DECLARE_VISIT(tofino_cpu::SketchRefresh)
+  DECLARE_VISIT(tofino_cpu::SketchTouchBuckets)
+  DECLARE_VISIT(tofino_cpu::ChtFindBackend)
+  DECLARE_VISIT(tofino_cpu::HashObj)
+  DECLARE_VISIT(tofino_cpu::SimpleTableLookup)
+  DECLARE_VISIT(tofino_cpu::SimpleTableUpdate)
+  DECLARE_VISIT(tofino_cpu::SimpleTableDelete)
+  DECLARE_VISIT(tofino_cpu::VectorRegisterLookup)
+  DECLARE_VISIT(tofino_cpu::VectorRegisterUpdate)
+  DECLARE_VISIT(tofino_cpu::FCFSCachedTableRead)
+  DECLARE_VISIT(tofino_cpu::FCFSCachedTableWrite)
+  DECLARE_VISIT(tofino_cpu::FCFSCachedTableDelete)
+
+private:
+  const bdd::BDD *bdd;
+  std::unordered_map<code_t, tofino::cpu_hdr_field_t> cpu_hdr_fields;
+
+  void transpile_cpu_header(const EP *ep);
+
+  code_t build_stable_key(klee::ref<klee::Expr> key);
+  code_t build_bytes(const std::vector<klee::ref<klee::Expr>> &exprs);
+
+  void table_write(const tofino::Table *table,
+                   const std::vector<klee::ref<klee::Expr>> &keys,
+                   const std::vector<klee::ref<klee::Expr>> &values);
+  void table_erase(const tofino::Table *table,
+                   const std::vector<klee::ref<klee::Expr>> &keys);
+};
+
+} // namespace tofino_cpu
+} // namespace synapse
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace synapse {
+namespace x86 {
+
+const char *const TEMPLATE_FILENAME = "x86.template.cpp";
+const char *const OUTPUT_FILENAME = "x86.cpp";
+
+} // namespace x86
+} // namespace synapse
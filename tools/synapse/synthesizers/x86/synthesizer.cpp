@@ -0,0 +1,166 @@
+#include "synthesizer.h"
+
+namespace synapse {
+namespace x86 {
+
+x86Synthesizer::x86Synthesizer(const std::filesystem::path &out_dir,
+                               const bdd::BDD *_bdd)
+    : CPUSynthesizer(TEMPLATE_FILENAME, out_dir / OUTPUT_FILENAME, _bdd,
+                     {ModuleType::x86_If}),
+      bdd(_bdd) {}
+
+void x86Synthesizer::visit(const EP *ep) {
+  transpile_state(bdd);
+  EPVisitor::visit(ep);
+  Synthesizer::dump();
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::If *node) {
+  branch(ep, ep_node, node->get_condition());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::Forward *node) {
+  forward(node->get_dst_device());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::Broadcast *node) {
+  broadcast();
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::Drop *node) {
+  drop();
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ParseHeader *node) {
+  parse_header(node->get_chunk_addr(), node->get_chunk(), node->get_length());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ModifyHeader *node) {
+  modify_header(node->get_chunk_addr(), node->get_changes());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ChecksumUpdate *node) {
+  checksum_update(node->get_ip_hdr_addr(), node->get_l4_hdr_addr(),
+                  node->get_checksum());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::MapGet *node) {
+  map_get(node->get_map_addr(), node->get_key(), node->get_value_out(),
+          node->get_map_has_this_key().expr);
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::MapPut *node) {
+  map_put(node->get_map_addr(), node->get_key_addr(), node->get_value());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::MapErase *node) {
+  map_erase(node->get_map_addr(), node->get_key());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::CoalescedMapGet *node) {
+  coalesced_map_get(node->get_map_addr(), node->get_key(),
+                    node->get_value_out(), node->get_map_has_this_key().expr,
+                    node->get_dchain_addr(), node->get_time(),
+                    node->get_vector_reads());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ExpireItemsSingleMap *node) {
+  expire_items_single_map(node->get_dchain_addr(), node->get_vector_addr(),
+                          node->get_map_addr(), node->get_time(),
+                          node->get_total_freed());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ExpireItemsSingleMapIteratively *node) {
+  expire_items_single_map_iteratively(node->get_vector_addr(),
+                                      node->get_map_addr(), node->get_start(),
+                                      node->get_n_elems());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::VectorRead *node) {
+  vector_read(node->get_vector_addr(), node->get_index(),
+              node->get_value_addr(), node->get_value());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::VectorWrite *node) {
+  vector_write(node->get_vector_addr(), node->get_index(),
+               node->get_value_addr(), node->get_modifications());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::DchainAllocateNewIndex *node) {
+  dchain_allocate_new_index(node->get_dchain_addr(), node->get_time(),
+                            node->get_index_out(), node->get_out_of_space());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::DchainRejuvenateIndex *node) {
+  dchain_rejuvenate_index(node->get_dchain_addr(), node->get_index(),
+                          node->get_time());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::DchainIsIndexAllocated *node) {
+  dchain_is_index_allocated(node->get_dchain_addr(), node->get_index(),
+                            node->get_is_allocated().expr);
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::DchainFreeIndex *node) {
+  dchain_free_index(node->get_dchain_addr(), node->get_index());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::SketchComputeHashes *node) {
+  sketch_compute_hashes(node->get_sketch_addr(), node->get_key());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::SketchExpire *node) {
+  sketch_expire(node->get_sketch_addr(), node->get_time());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::SketchFetch *node) {
+  sketch_fetch(node->get_sketch_addr(), node->get_overflow());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::SketchRefresh *node) {
+  sketch_refresh(node->get_sketch_addr(), node->get_time());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::SketchTouchBuckets *node) {
+  sketch_touch_buckets(node->get_sketch_addr(), node->get_time(),
+                       node->get_success());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::ChtFindBackend *node) {
+  cht_find_backend(node->get_cht_addr(), node->get_backends_addr(),
+                   node->get_hash(), node->get_height(), node->get_capacity(),
+                   node->get_backend(), node->get_found());
+}
+
+void x86Synthesizer::visit(const EP *ep, const EPNode *ep_node,
+                           const x86::HashObj *node) {
+  hash_obj(node->get_obj_addr(), node->get_size(), node->get_hash());
+}
+
+} // namespace x86
+} // namespace synapse
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../cpu/synthesizer.h"
+#include "../../targets/x86/x86.h"
+#include "constants.h"
+
+#include <filesystem>
+
+namespace synapse {
+namespace x86 {
+
+class x86Synthesizer : public cpu::CPUSynthesizer {
+public:
+  x86Synthesizer(const std::filesystem::path &out_dir, const bdd::BDD *bdd);
+
+  void visit(const EP *ep) override;
+  using cpu::CPUSynthesizer::visit;
+
+  DECLARE_VISIT(x86::If)
+  DECLARE_VISIT(x86::Forward)
+  DECLARE_VISIT(x86::Broadcast)
+  DECLARE_VISIT(x86::Drop)
+  DECLARE_VISIT(x86::ParseHeader)
+  DECLARE_VISIT(x86::ModifyHeader)
+  DECLARE_VISIT(x86::ChecksumUpdate)
+  DECLARE_VISIT(x86::MapGet)
+  DECLARE_VISIT(x86::MapPut)
+  DECLARE_VISIT(x86::MapErase)
+  DECLARE_VISIT(x86::CoalescedMapGet)
+  DECLARE_VISIT(x86::ExpireItemsSingleMap)
+  DECLARE_VISIT(x86::ExpireItemsSingleMapIteratively)
+  DECLARE_VISIT(x86::VectorRead)
+  DECLARE_VISIT(x86::VectorWrite)
+  DECLARE_VISIT(x86::DchainAllocateNewIndex)
+  DECLARE_VISIT(x86::DchainRejuvenateIndex)
+  DECLARE_VISIT(x86::DchainIsIndexAllocated)
+  DECLARE_VISIT(x86::DchainFreeIndex)
+  DECLARE_VISIT(x86::SketchComputeHashes)
+  DECLARE_VISIT(x86::SketchExpire)
+  DECLARE_VISIT(x86::SketchFetch)
+  DECLARE_VISIT(x86::SketchRefresh)
+  DECLARE_VISIT(x86::SketchTouchBuckets)
+  DECLARE_VISIT(x86::ChtFindBackend)
+  DECLARE_VISIT(x86::HashObj)
+
+private:
+  const bdd::BDD *bdd;
+};
+
+} // namespace x86
+} // namespace synapse
@@ -4,6 +4,8 @@
 
 #include "klee-util.h"
 
+#include <map>
+
 namespace synapse {
 
 static void log_bdd_pre_processing(
@@ -390,6 +392,182 @@ void Context::update_traffic_fractions(TargetType old_target,
   new_target_fraction = std::min(new_target_fraction, 1.0);
 }
 
+static int get_key_bytes(const call_t &call) {
+  auto found_it = call.args.find("key");
+
+  if (found_it == call.args.end() || found_it->second.in.isNull()) {
+    return 0;
+  }
+
+  return found_it->second.in->getWidth() / 8;
+}
+
+void Context::add_module_cost(const EPNode *new_node) {
+  const Module *module = new_node->get_module();
+  TargetType target = module->get_target();
+
+  if (target == TargetType::Tofino) {
+    return;
+  }
+
+  constraints_t constraints = get_node_constraints(new_node);
+  add_module_cost(target, module->get_name(), module->get_node(), constraints);
+
+  if (module->get_type() == ModuleType::x86_CoalescedMapGet) {
+    const x86::CoalescedMapGet *coalesced_map_get =
+        static_cast<const x86::CoalescedMapGet *>(module);
+    add_coalesced_map_get_cost(target, coalesced_map_get->get_dchain_addr(),
+                               coalesced_map_get->get_vector_reads(),
+                               constraints);
+  }
+}
+
+// The map_get is costed as the module itself, and the operations fused into
+// it as the modules they replace, as they still run on their own.
+void Context::add_coalesced_map_get_cost(
+    TargetType target, std::optional<addr_t> dchain_addr,
+    const std::vector<coalesced_vector_read_t> &vector_reads,
+    const constraints_t &constraints) {
+  if (dchain_addr.has_value()) {
+    add_fused_module_cost(target, "DchainRejuvenateIndex", *dchain_addr,
+                          constraints);
+  }
+
+  for (const coalesced_vector_read_t &vector_read : vector_reads) {
+    add_fused_module_cost(target, "VectorRead", vector_read.vector_addr,
+                          constraints);
+  }
+}
+
+CPUPerfModel *Context::get_mutable_perf_model(TargetType target) {
+  switch (target) {
+  case TargetType::Tofino:
+    // The Tofino pipeline runs at line rate, regardless of the modules.
+    return nullptr;
+  case TargetType::TofinoCPU: {
+    tofino_cpu::TofinoCPUContext *tofino_cpu_ctx =
+        get_mutable_target_ctx<tofino_cpu::TofinoCPUContext>();
+    return &tofino_cpu_ctx->get_mutable_perf_model();
+  }
+  case TargetType::x86: {
+    x86::x86Context *x86_ctx = get_mutable_target_ctx<x86::x86Context>();
+    return &x86_ctx->get_mutable_perf_model();
+  }
+  }
+
+  assert(false && "Unknown target");
+  return nullptr;
+}
+
+// Every entry of these is eventually touched by the traffic.
+uint64_t Context::get_working_set_bytes(addr_t obj) const {
+  if (vector_configs.find(obj) != vector_configs.end()) {
+    const bdd::vector_config_t &cfg = vector_configs.at(obj);
+    return cfg.capacity * (cfg.elem_size / 8);
+  }
+
+  if (dchain_configs.find(obj) != dchain_configs.end()) {
+    const bdd::dchain_config_t &cfg = dchain_configs.at(obj);
+    return cfg.index_range * 2 * sizeof(uint64_t);
+  }
+
+  if (sketch_configs.find(obj) != sketch_configs.end()) {
+    const bdd::sketch_config_t &cfg = sketch_configs.at(obj);
+    return cfg.capacity * sizeof(uint32_t);
+  }
+
+  if (cht_configs.find(obj) != cht_configs.end()) {
+    const bdd::cht_config_t &cfg = cht_configs.at(obj);
+    return cfg.capacity * cfg.height * sizeof(uint32_t);
+  }
+
+  return 0;
+}
+
+void Context::add_fused_module_cost(TargetType target,
+                                    const std::string &module, addr_t obj,
+                                    const constraints_t &constraints) {
+  CPUPerfModel *perf_model = get_mutable_perf_model(target);
+
+  if (!perf_model) {
+    return;
+  }
+
+  std::optional<double> fraction = profiler->get_fraction(constraints);
+  assert(fraction.has_value());
+
+  module_load_t load = {
+      .fraction = *fraction,
+      .key_bytes = 0,
+      .working_set_bytes = get_working_set_bytes(obj),
+  };
+
+  perf_model->add_module(module, load);
+}
+
+void Context::add_module_cost(TargetType target, const std::string &module,
+                              const bdd::Node *node,
+                              const constraints_t &constraints) {
+  CPUPerfModel *perf_model = get_mutable_perf_model(target);
+
+  if (!perf_model) {
+    return;
+  }
+
+  std::optional<double> fraction = profiler->get_fraction(constraints);
+  assert(fraction.has_value());
+
+  module_load_t load = {
+      .fraction = *fraction,
+      .key_bytes = 0,
+      .working_set_bytes = 0,
+  };
+
+  if (node->get_type() != bdd::NodeType::CALL) {
+    perf_model->add_module(module, load);
+    return;
+  }
+
+  const bdd::Call *call_node = static_cast<const bdd::Call *>(node);
+  const call_t &call = call_node->get_call();
+
+  load.key_bytes = get_key_bytes(call);
+
+  auto get_obj = [&call](const std::string &arg, addr_t &obj) {
+    auto found_it = call.args.find(arg);
+    if (found_it == call.args.end() || found_it->second.expr.isNull()) {
+      return false;
+    }
+    obj = kutil::expr_addr_to_obj_addr(found_it->second.expr);
+    return true;
+  };
+
+  addr_t obj;
+
+  // Only the entries actually used by the traffic are touched, so we prefer
+  // the number of flows observed by the profiler over the capacity.
+  if (get_obj("map", obj) && map_configs.find(obj) != map_configs.end()) {
+    const bdd::map_config_t &cfg = map_configs.at(obj);
+    uint64_t entries = cfg.capacity;
+
+    auto key_it = call.args.find("key");
+    if (key_it != call.args.end() && !key_it->second.in.isNull()) {
+      std::optional<FlowStats> flow_stats =
+          profiler->get_flow_stats(constraints, key_it->second.in);
+      if (flow_stats.has_value()) {
+        entries = std::min(entries, flow_stats->total_flows);
+      }
+    }
+
+    load.working_set_bytes = entries * (cfg.key_size / 8 + sizeof(uint64_t));
+  } else if (get_obj("vector", obj) || get_obj("chain", obj) ||
+             get_obj("sketch", obj) || get_obj("cht", obj)) {
+    load.working_set_bytes = get_working_set_bytes(obj);
+  }
+
+  perf_model->add_module(module, load);
+}
+
 void Context::update_constraints_per_node(ep_node_id_t node,
                                           const constraints_t &constraints) {
   assert(constraints_per_node.find(node) == constraints_per_node.end());
@@ -501,6 +679,10 @@ std::ostream &operator<<(std::ostream &os, PlacementDecision decision) {
 }
 
 void Context::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "~~~~~~~~~~~~~~~~~~~~~~~~ Context ~~~~~~~~~~~~~~~~~~~~~~~~\n";
   Log::dbg() << "Traffic fractions:\n";
   for (const auto &[target, fraction] : traffic_fraction_per_target) {
@@ -529,4 +711,30 @@ void Context::log_debug() const {
   Log::dbg() << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n";
 }
 
+size_t Context::hash() const {
+  std::map<addr_t, PlacementDecision> sorted_placements(
+      placement_decisions.begin(), placement_decisions.end());
+  std::map<TargetType, TargetContext *> sorted_target_ctxs(
+      target_ctxs.begin(), target_ctxs.end());
+
+  size_t seed = 0;
+
+  for (const auto &[obj, decision] : sorted_placements) {
+    hash_combine(seed, obj);
+    hash_combine(seed, static_cast<size_t>(decision));
+  }
+
+  for (const auto &[target, target_ctx] : sorted_target_ctxs) {
+    hash_combine(seed, static_cast<size_t>(target));
+    hash_combine(seed, target_ctx->hash());
+
+    auto found_it = traffic_fraction_per_target.find(target);
+    if (found_it != traffic_fraction_per_target.end()) {
+      hash_combine(seed, std::hash<double>{}(found_it->second));
+    }
+  }
+
+  return seed;
+}
+
 } // namespace synapse
\ No newline at end of file
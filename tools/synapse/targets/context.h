@@ -15,6 +15,7 @@
 namespace synapse {
 
 class EP;
+class CPUPerfModel;
 
 enum class PlacementDecision {
   Tofino_SimpleTable,
@@ -48,7 +49,19 @@ public:
   virtual ~TargetContext() {}
 
   virtual TargetContext *clone() const = 0;
-  virtual uint64_t estimate_throughput_pps() const = 0;
+
+  // Packets per second processed by the target, given the fraction of the
+  // total traffic that it receives.
+  virtual uint64_t estimate_throughput_pps(double traffic_fraction) const = 0;
+
+  // Upper bound on estimate_throughput_pps, whatever the traffic fraction,
+  // both on this context and on every context derived from it by placing
+  // more modules.
+  virtual uint64_t bound_throughput_pps() const = 0;
+
+  // Summarizes the resources used on the target. Equal contexts must hash
+  // equally, as this is used to detect duplicate execution plans.
+  virtual size_t hash() const = 0;
 };
 
 class Context {
@@ -108,9 +121,18 @@ public:
   void update_traffic_fractions(TargetType old_target, TargetType new_target,
                                 double fraction);
 
+  void add_module_cost(const EPNode *new_node);
+  void add_module_cost(TargetType target, const std::string &module,
+                       const bdd::Node *node, const constraints_t &constraints);
+  void add_coalesced_map_get_cost(
+      TargetType target, std::optional<addr_t> dchain_addr,
+      const std::vector<coalesced_vector_read_t> &vector_reads,
+      const constraints_t &constraints);
+
   void update_throughput_estimates(const EP *ep);
   uint64_t get_throughput_estimate_pps() const;
   uint64_t get_throughput_speculation_pps() const;
+  uint64_t get_throughput_bound_pps() const;
 
   void add_hit_rate_estimation(const constraints_t &constraints,
                                klee::ref<klee::Expr> new_constraint,
@@ -120,7 +142,19 @@ public:
 
   void log_debug() const;
 
+  // Combines the placement decisions, the traffic going to each target and
+  // the resources used on them.
+  size_t hash() const;
+
 private:
+  CPUPerfModel *get_mutable_perf_model(TargetType target);
+  uint64_t get_working_set_bytes(addr_t obj) const;
+
+  // Cost of an operation on an object, fused into a module placed on a
+  // different node.
+  void add_fused_module_cost(TargetType target, const std::string &module,
+                             addr_t obj, const constraints_t &constraints);
+
   void update_throughput_speculation(const EP *ep);
   void update_throughput_estimate();
   void allow_profiler_mutation();
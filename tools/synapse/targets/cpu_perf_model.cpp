@@ -0,0 +1,373 @@
+#include "cpu_perf_model.h"
+#include "../log.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace synapse {
+
+// Default costs of the modules that run on both CPU targets, in cycles.
+// Stateful operations are dominated by hashing the key and by the memory
+// accesses into the data structure.
+static const std::unordered_map<std::string, module_cost_t>
+    default_module_costs{
+        {"ParseHeader", {5, 0, 0}},
+        {"ModifyHeader", {5, 0, 0}},
+        {"ChecksumUpdate", {40, 0, 0}},
+        {"If", {2, 0, 0}},
+        {"Then", {0, 0, 0}},
+        {"Else", {0, 0, 0}},
+        {"Ignore", {0, 0, 0}},
+        {"Forward", {0, 0, 0}},
+        {"Drop", {0, 0, 0}},
+        {"Broadcast", {0, 0, 0}},
+        {"MapGet", {60, 2, 2}},
+        {"MapPut", {90, 2, 3}},
+        {"MapErase", {80, 2, 3}},
+        // Only the map lookup. The operations fused into it still run on
+        // their own data structures, and are costed as such.
+        {"CoalescedMapGet", {60, 2, 2}},
+        {"VectorRead", {15, 0, 1}},
+        {"VectorWrite", {20, 0, 1}},
+        {"DchainAllocateNewIndex", {40, 0, 2}},
+        {"DchainRejuvenateIndex", {30, 0, 2}},
+        {"DchainIsIndexAllocated", {10, 0, 1}},
+        {"DchainFreeIndex", {30, 0, 2}},
+        {"SketchComputeHashes", {20, 4, 0}},
+        {"SketchTouchBuckets", {30, 0, 4}},
+        {"SketchFetch", {30, 0, 4}},
+        {"SketchRefresh", {30, 0, 4}},
+        {"SketchExpire", {40, 0, 4}},
+        {"HashObj", {30, 3, 0}},
+        {"ChtFindBackend", {60, 2, 2}},
+        {"ExpireItemsSingleMap", {100, 0, 2}},
+        {"ExpireItemsSingleMapIteratively", {100, 0, 2}},
+    };
+
+// Modules that only exist on the switch controller. Reads are served from the
+// controller's copy of the switch state, while writes go through the driver
+// and program the switch.
+static const std::unordered_map<std::string, module_cost_t>
+    default_tofino_cpu_module_costs{
+        {"SimpleTableLookup", {60, 2, 2}},
+        {"SimpleTableUpdate", {20'000, 0, 0}},
+        {"SimpleTableDelete", {20'000, 0, 0}},
+        {"VectorRegisterLookup", {15, 0, 1}},
+        {"VectorRegisterUpdate", {10'000, 0, 0}},
+        {"FCFSCachedTableRead", {60, 2, 2}},
+        {"FCFSCachedTableWrite", {20'000, 0, 0}},
+        {"FCFSCachedTableDelete", {20'000, 0, 0}},
+    };
+
+cpu_perf_params_t default_x86_perf_params() {
+  cpu_perf_params_t params = {
+      .clock_hz = 3e9,
+      .cores = 16,
+      .io_cycles = 400,
+      .cache_bytes = 32 * 1024 * 1024,
+      .miss_penalty_cycles = 200,
+      .module_costs = default_module_costs,
+  };
+
+  return params;
+}
+
+cpu_perf_params_t default_tofino_cpu_perf_params() {
+  cpu_perf_params_t params = {
+      .clock_hz = 2e9,
+      .cores = 1,
+      .io_cycles = 20'000,
+      .cache_bytes = 8 * 1024 * 1024,
+      .miss_penalty_cycles = 200,
+      .module_costs = default_module_costs,
+  };
+
+  params.module_costs.insert(default_tofino_cpu_module_costs.begin(),
+                             default_tofino_cpu_module_costs.end());
+
+  return params;
+}
+
+static void override_params(const json &j, cpu_perf_params_t &params) {
+  if (j.contains("clock_hz")) {
+    j.at("clock_hz").get_to(params.clock_hz);
+  }
+
+  if (j.contains("cores")) {
+    j.at("cores").get_to(params.cores);
+  }
+
+  if (j.contains("io_cycles")) {
+    j.at("io_cycles").get_to(params.io_cycles);
+  }
+
+  if (j.contains("cache_bytes")) {
+    j.at("cache_bytes").get_to(params.cache_bytes);
+  }
+
+  if (j.contains("miss_penalty_cycles")) {
+    j.at("miss_penalty_cycles").get_to(params.miss_penalty_cycles);
+  }
+
+  if (!j.contains("modules")) {
+    return;
+  }
+
+  for (const auto &kv : j.at("modules").items()) {
+    module_cost_t &cost = params.module_costs[kv.key()];
+    const json &module = kv.value();
+
+    if (module.contains("base_cycles")) {
+      module.at("base_cycles").get_to(cost.base_cycles);
+    }
+
+    if (module.contains("cycles_per_key_byte")) {
+      module.at("cycles_per_key_byte").get_to(cost.cycles_per_key_byte);
+    }
+
+    if (module.contains("mem_accesses")) {
+      module.at("mem_accesses").get_to(cost.mem_accesses);
+    }
+  }
+}
+
+struct cost_sample_t {
+  double cycles;
+  double key_bytes;
+
+  // Cycles lost to cache misses on each memory access.
+  double miss_cycles;
+};
+
+// Least squares fit of cycles = base + k * key_bytes + m * miss_cycles.
+// Regressors that do not vary across the samples are left out of the fit.
+static module_cost_t
+fit_module_cost(const std::vector<cost_sample_t> &samples) {
+  bool fit_key_bytes = false;
+  bool fit_misses = false;
+
+  for (const cost_sample_t &sample : samples) {
+    fit_key_bytes |= sample.key_bytes != samples[0].key_bytes;
+    fit_misses |= sample.miss_cycles > 0;
+  }
+
+  auto regressors = [fit_key_bytes, fit_misses](const cost_sample_t &sample) {
+    std::vector<double> x{1};
+    if (fit_key_bytes) {
+      x.push_back(sample.key_bytes);
+    }
+    if (fit_misses) {
+      x.push_back(sample.miss_cycles);
+    }
+    return x;
+  };
+
+  size_t n = 1 + fit_key_bytes + fit_misses;
+
+  // Normal equations, (X^T X) b = X^T y, as an augmented matrix.
+  std::vector<std::vector<double>> a(n, std::vector<double>(n + 1, 0));
+
+  for (const cost_sample_t &sample : samples) {
+    std::vector<double> x = regressors(sample);
+    for (size_t r = 0; r < n; r++) {
+      for (size_t c = 0; c < n; c++) {
+        a[r][c] += x[r] * x[c];
+      }
+      a[r][n] += x[r] * sample.cycles;
+    }
+  }
+
+  // Gaussian elimination with partial pivoting.
+  for (size_t c = 0; c < n; c++) {
+    size_t pivot = c;
+    for (size_t r = c + 1; r < n; r++) {
+      if (std::abs(a[r][c]) > std::abs(a[pivot][c])) {
+        pivot = r;
+      }
+    }
+
+    std::swap(a[c], a[pivot]);
+
+    if (a[c][c] == 0) {
+      continue;
+    }
+
+    for (size_t r = 0; r < n; r++) {
+      if (r == c) {
+        continue;
+      }
+
+      double factor = a[r][c] / a[c][c];
+      for (size_t k = c; k <= n; k++) {
+        a[r][k] -= factor * a[c][k];
+      }
+    }
+  }
+
+  std::vector<double> b(n, 0);
+  for (size_t r = 0; r < n; r++) {
+    b[r] = a[r][r] != 0 ? std::max(0.0, a[r][n] / a[r][r]) : 0;
+  }
+
+  size_t i = 0;
+  module_cost_t cost;
+  cost.base_cycles = b[i++];
+  cost.cycles_per_key_byte = fit_key_bytes ? b[i++] : 0;
+  cost.mem_accesses = fit_misses ? b[i++] : 0;
+
+  return cost;
+}
+
+static double time_unit_to_ns(const std::string &time_unit) {
+  if (time_unit == "us") {
+    return 1e3;
+  }
+
+  if (time_unit == "ms") {
+    return 1e6;
+  }
+
+  if (time_unit == "s") {
+    return 1e9;
+  }
+
+  assert(time_unit == "ns" && "Unknown time unit");
+  return 1;
+}
+
+// Calibrates the parameters with the results of the synapse-bench
+// microbenchmarks (Google Benchmark JSON output). Only benchmarks labeled
+// with a module name are used.
+static void calibrate_params(const json &j, cpu_perf_params_t &params) {
+  const json &context = j.at("context");
+
+  if (context.contains("mhz_per_cpu")) {
+    params.clock_hz = context.at("mhz_per_cpu").get<double>() * 1e6;
+  }
+
+  // The largest cache the benchmarks report replaces the default, even if it
+  // is smaller.
+  if (context.contains("caches") && !context.at("caches").empty()) {
+    uint64_t cache_bytes = 0;
+    for (const json &cache : context.at("caches")) {
+      uint64_t size = cache.at("size").get<uint64_t>();
+      cache_bytes = std::max(cache_bytes, size);
+    }
+    params.cache_bytes = cache_bytes;
+  }
+
+  std::unordered_map<std::string, std::vector<cost_sample_t>> samples;
+
+  for (const json &benchmark : j.at("benchmarks")) {
+    if (!benchmark.contains("label") ||
+        benchmark.value("run_type", "iteration") != "iteration") {
+      continue;
+    }
+
+    std::string module = benchmark.at("label");
+    double time_ns = benchmark.at("cpu_time").get<double>() *
+                     time_unit_to_ns(benchmark.at("time_unit"));
+    double working_set = benchmark.value("working_set_bytes", 0.0);
+
+    double miss_rate = 0;
+    if (working_set > params.cache_bytes) {
+      miss_rate = 1 - params.cache_bytes / working_set;
+    }
+
+    cost_sample_t sample = {
+        .cycles = time_ns * params.clock_hz / 1e9,
+        .key_bytes = benchmark.value("key_bytes", 0.0),
+        .miss_cycles = miss_rate * params.miss_penalty_cycles,
+    };
+
+    samples[module].push_back(sample);
+  }
+
+  for (const auto &[module, module_samples] : samples) {
+    params.module_costs[module] = fit_module_cost(module_samples);
+  }
+}
+
+void parse_cpu_perf_params(const std::string &filename,
+                           cpu_perf_params_t &x86_params,
+                           cpu_perf_params_t &tofino_cpu_params) {
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    Log::err() << "Unable to open CPU performance parameters " << filename
+               << "\n";
+    exit(1);
+  }
+
+  json j = json::parse(file);
+
+  if (j.contains("benchmarks")) {
+    calibrate_params(j, x86_params);
+    return;
+  }
+
+  if (j.contains("x86")) {
+    override_params(j.at("x86"), x86_params);
+  }
+
+  if (j.contains("tofino_cpu")) {
+    override_params(j.at("tofino_cpu"), tofino_cpu_params);
+  }
+}
+
+CPUPerfModel::CPUPerfModel(const cpu_perf_params_t &_params)
+    : params(std::make_shared<const cpu_perf_params_t>(_params)),
+      module_cycles(0) {}
+
+CPUPerfModel::CPUPerfModel(const CPUPerfModel &other)
+    : params(other.params), module_cycles(other.module_cycles) {}
+
+double CPUPerfModel::get_module_cycles(const std::string &module,
+                                       const module_load_t &load) const {
+  auto found_it = params->module_costs.find(module);
+  assert(found_it != params->module_costs.end() && "Module without a cost");
+
+  const module_cost_t &cost = found_it->second;
+
+  double hit_rate = 1;
+  if (load.working_set_bytes > params->cache_bytes) {
+    hit_rate = params->cache_bytes / (double)load.working_set_bytes;
+  }
+
+  double cycles = cost.base_cycles;
+  cycles += cost.cycles_per_key_byte * load.key_bytes;
+  cycles += cost.mem_accesses * (1 - hit_rate) * params->miss_penalty_cycles;
+
+  return cycles;
+}
+
+void CPUPerfModel::add_module(const std::string &module,
+                              const module_load_t &load) {
+  module_cycles += load.fraction * get_module_cycles(module, load);
+}
+
+uint64_t CPUPerfModel::estimate_throughput_pps(double traffic_fraction) const {
+  double cycles_per_pkt = params->io_cycles;
+
+  if (traffic_fraction > 0) {
+    cycles_per_pkt += module_cycles / traffic_fraction;
+  }
+
+  return (params->clock_hz * params->cores) / cycles_per_pkt;
+}
+
+uint64_t CPUPerfModel::bound_throughput_pps() const {
+  double cycles_per_pkt = params->io_cycles + module_cycles;
+  return (params->clock_hz * params->cores) / cycles_per_pkt;
+}
+
+size_t CPUPerfModel::hash() const { return std::hash<double>{}(module_cycles); }
+
+} // namespace synapse
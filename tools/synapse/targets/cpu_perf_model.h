@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace synapse {
+
+// Cost of a module, in CPU cycles per packet that goes through it.
+struct module_cost_t {
+  double base_cycles;
+  double cycles_per_key_byte;
+
+  // Memory accesses into the module's data structure. These become cache
+  // misses as the working set of the data structure outgrows the cache.
+  double mem_accesses;
+};
+
+// What a module is subjected to, given where it was placed and the traffic
+// that reaches it.
+struct module_load_t {
+  // Fraction of the total traffic going through the module.
+  double fraction;
+  int key_bytes;
+
+  // Bytes of the module's data structure touched by the traffic (0 if the
+  // module is stateless).
+  uint64_t working_set_bytes;
+};
+
+struct cpu_perf_params_t {
+  double clock_hz;
+  int cores;
+
+  // Cycles spent receiving and sending each packet, regardless of the
+  // modules it goes through.
+  double io_cycles;
+
+  uint64_t cache_bytes;
+  double miss_penalty_cycles;
+
+  // Indexed by module name, which is shared by a module and its generator.
+  // Every module placed on a CPU target must have one (even if free).
+  std::unordered_map<std::string, module_cost_t> module_costs;
+};
+
+cpu_perf_params_t default_x86_perf_params();
+cpu_perf_params_t default_tofino_cpu_perf_params();
+
+// Overrides the given parameters with the ones found on a JSON file. This can
+// either be the output of the synapse-bench microbenchmarks (Google Benchmark
+// JSON), to which the x86 parameters are fitted, or a file with the following
+// format (every field is optional):
+// {
+//   "x86": {
+//     "clock_hz": 3e9,
+//     "cores": 16,
+//     "io_cycles": 400,
+//     "cache_bytes": 33554432,
+//     "miss_penalty_cycles": 200,
+//     "modules": {
+//       "MapGet": {
+//         "base_cycles": 60,
+//         "cycles_per_key_byte": 2,
+//         "mem_accesses": 2
+//       }
+//     }
+//   },
+//   "tofino_cpu": { ... }
+// }
+void parse_cpu_perf_params(const std::string &filename,
+                           cpu_perf_params_t &x86_params,
+                           cpu_perf_params_t &tofino_cpu_params);
+
+// Throughput model for the targets that process packets on general purpose
+// CPUs (the x86 server and the switch controller). It accumulates the cycles
+// spent by each module placed on the target, weighted by the fraction of the
+// traffic going through it.
+class CPUPerfModel {
+private:
+  std::shared_ptr<const cpu_perf_params_t> params;
+
+  // Cycles spent on modules, per packet of the total traffic.
+  double module_cycles;
+
+public:
+  CPUPerfModel(const cpu_perf_params_t &params);
+  CPUPerfModel(const CPUPerfModel &other);
+
+  double get_module_cycles(const std::string &module,
+                           const module_load_t &load) const;
+  void add_module(const std::string &module, const module_load_t &load);
+
+  // Packets per second this target can process, given the fraction of the
+  // total traffic that it receives.
+  uint64_t estimate_throughput_pps(double traffic_fraction) const;
+
+  // Upper bound on estimate_throughput_pps, for any traffic fraction and any
+  // modules added later: neither can the fraction go above 1 nor the module
+  // cycles go down.
+  uint64_t bound_throughput_pps() const;
+
+  size_t hash() const;
+};
+
+} // namespace synapse
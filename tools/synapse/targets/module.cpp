@@ -0,0 +1,13 @@
+#include "module.h"
+#include "../util.h"
+
+namespace synapse {
+
+size_t Module::hash() const {
+  size_t seed = static_cast<size_t>(type);
+  hash_combine(seed, static_cast<size_t>(target));
+  hash_combine(seed, static_cast<size_t>(next_target));
+  return seed;
+}
+
+} // namespace synapse
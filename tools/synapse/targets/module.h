@@ -83,6 +83,7 @@ enum class ModuleType {
   x86_MapGet,
   x86_MapPut,
   x86_MapErase,
+  x86_CoalescedMapGet,
   x86_VectorRead,
   x86_VectorWrite,
   x86_DchainAllocateNewIndex,
@@ -140,6 +141,12 @@ public:
   virtual void visit(EPVisitor &visitor, const EP *ep,
                      const EPNode *ep_node) const = 0;
   virtual Module *clone() const = 0;
+
+  // Hashes what tells this module apart from others generated from the same
+  // BDD node. Modules with parameters that are not fixed by their type and
+  // node (e.g. the configuration of the data structures they use) must mix
+  // them in.
+  virtual size_t hash() const;
 };
 
 } // namespace synapse
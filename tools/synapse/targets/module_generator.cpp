@@ -2,6 +2,7 @@
 
 #include "../execution_plan/execution_plan.h"
 #include "../log.h"
+#include "../instrumentation.h"
 
 namespace synapse {
 
@@ -122,6 +123,8 @@ ModuleGenerator::generate(const EP *ep, const bdd::Node *node,
     return products;
   }
 
+  InstrumentationScope scope("reorder");
+
   for (const __generator_product_t &product : node_products) {
     std::vector<EP *> reordered = get_reordered(product.ep);
 
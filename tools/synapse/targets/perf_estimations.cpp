@@ -2,6 +2,7 @@
 #include "target.h"
 #include "targets.h"
 #include "module_generator.h"
+#include "../instrumentation.h"
 
 #include "klee-util.h"
 
@@ -36,7 +37,8 @@ static uint64_t estimate_throughput_pps_from_ctx(const Context &ctx) {
     } break;
     }
 
-    uint64_t target_estimation_pps = target_ctx->estimate_throughput_pps();
+    uint64_t target_estimation_pps =
+        target_ctx->estimate_throughput_pps(traffic_fraction);
     estimation_pps += target_estimation_pps * traffic_fraction;
   }
 
@@ -218,6 +220,10 @@ Context::node_speculation_t Context::get_best_speculation(
       new_speculation->skip.insert(current_speculation.skip.begin(),
                                    current_speculation.skip.end());
 
+      constraints_t constraints = node->get_ordered_branch_constraints();
+      new_speculation->ctx.add_module_cost(current_target, modgen->get_name(),
+                                           node, constraints);
+
       if (!best_local_speculation.has_value()) {
         best_local_speculation = new_speculation;
         best_local_module = modgen->get_name();
@@ -325,8 +331,15 @@ void Context::update_throughput_speculation(const EP *ep) {
 }
 
 void Context::update_throughput_estimates(const EP *ep) {
-  update_throughput_estimate();
-  update_throughput_speculation(ep);
+  {
+    InstrumentationScope scope("estimation");
+    update_throughput_estimate();
+  }
+
+  {
+    InstrumentationScope scope("speculation");
+    update_throughput_speculation(ep);
+  }
 }
 
 uint64_t Context::get_throughput_estimate_pps() const {
@@ -337,4 +350,17 @@ uint64_t Context::get_throughput_speculation_pps() const {
   return throughput_speculation_pps;
 }
 
+// The estimation weighs the throughput of each target by its traffic fraction.
+// Fractions are clamped to [0,1] but not normalized, so the bounds are added
+// up instead of taking the largest one.
+uint64_t Context::get_throughput_bound_pps() const {
+  uint64_t bound_pps = 0;
+
+  for (const auto &[target, target_ctx] : target_ctxs) {
+    bound_pps += target_ctx->bound_throughput_pps();
+  }
+
+  return bound_pps;
+}
+
 } // namespace synapse
\ No newline at end of file
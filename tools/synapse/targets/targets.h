@@ -11,11 +11,15 @@
 
 namespace synapse {
 
-inline targets_t build_targets(const Profiler *profiler) {
+inline targets_t build_targets(const Profiler *profiler,
+                               tofino::PipeStatePolicy pipe_state_policy,
+                               const cpu_perf_params_t &x86_params,
+                               const cpu_perf_params_t &tofino_cpu_params) {
   return {
-      new tofino::TofinoTarget(tofino::TNAVersion::TNA2, profiler),
-      new tofino_cpu::TofinoCPUTarget(),
-      new x86::x86Target(),
+      new tofino::TofinoTarget(tofino::TNAVersion::TNA2, pipe_state_policy,
+                               profiler),
+      new tofino_cpu::TofinoCPUTarget(tofino_cpu_params),
+      new x86::x86Target(x86_params),
   };
 }
 
@@ -3,6 +3,26 @@
 namespace synapse {
 namespace tofino {
 
+// Rows of the count-min sketch, each one in its own register, and how many
+// counters each row has per cache slot. Wider rows overestimate less.
+constexpr int ADMISSION_SKETCH_ROWS = 3;
+constexpr int ADMISSION_SKETCH_WIDTH_PER_SLOT = 4;
+constexpr bits_t ADMISSION_COUNTER_SIZE = 16;
+
+std::string cache_policy_to_string(CachePolicy policy) {
+  switch (policy) {
+  case CachePolicy::FCFS:
+    return "FCFS";
+  case CachePolicy::COUNT_MIN_ADMISSION:
+    return "CountMinAdmission";
+  case CachePolicy::LRU_APPROX:
+    return "LRUApprox";
+  }
+
+  assert(false && "Unknown cache policy");
+  return "";
+}
+
 static bits_t index_size_from_cache_capacity(int cache_capacity) {
   // Log base 2 of the cache capacity
   // Assert cache capacity is a power of 2
@@ -20,8 +40,12 @@ static Register build_cache_expirator(const TNAProperties &properties, DS_ID id,
                                       int cache_capacity) {
   bits_t hash_size = index_size_from_cache_capacity(cache_capacity);
   bits_t timestamp_size = 32;
-  return Register(properties, id + "_expirator", cache_capacity, hash_size,
-                  timestamp_size, {RegisterAction::WRITE});
+
+  // Lookups refresh live entries (READ), inserts claim stale slots (SWAP) and
+  // deletes free them (WRITE).
+  return Register(
+      properties, id + "_expirator", cache_capacity, hash_size, timestamp_size,
+      {RegisterAction::READ, RegisterAction::WRITE, RegisterAction::SWAP});
 }
 
 static std::vector<Register>
@@ -43,26 +67,56 @@ build_cache_keys(const TNAProperties &properties, DS_ID id,
   return cache_keys;
 }
 
+static std::vector<Register>
+build_admission_sketch(const TNAProperties &properties, DS_ID id,
+                       CachePolicy policy, int cache_capacity) {
+  std::vector<Register> admission_sketch;
+
+  if (policy != CachePolicy::COUNT_MIN_ADMISSION) {
+    return admission_sketch;
+  }
+
+  int width = cache_capacity * ADMISSION_SKETCH_WIDTH_PER_SLOT;
+  bits_t hash_size = index_size_from_cache_capacity(width);
+
+  for (int i = 0; i < ADMISSION_SKETCH_ROWS; i++) {
+    Register row(properties, id + "_sketch_" + std::to_string(i), width,
+                 hash_size, ADMISSION_COUNTER_SIZE, {RegisterAction::INC});
+    admission_sketch.push_back(row);
+  }
+
+  return admission_sketch;
+}
+
 FCFSCachedTable::FCFSCachedTable(const TNAProperties &properties, DS_ID _id,
-                                 int _cache_capacity, int _num_entries,
+                                 const cache_config_t &config, int _num_entries,
                                  const std::vector<bits_t> &_keys_sizes)
     : DS(DSType::FCFS_CACHED_TABLE, _id + "_FCFSCachedTable"),
-      cache_capacity(_cache_capacity), num_entries(_num_entries),
-      keys_sizes(_keys_sizes), tables({
-                                   build_table(id, 0, num_entries, keys_sizes),
-                               }),
+      policy(config.policy), cache_capacity(config.capacity),
+      admission_threshold(config.admission_threshold),
+      num_entries(_num_entries), keys_sizes(_keys_sizes),
+      tables({
+          build_table(id, 0, num_entries, keys_sizes),
+      }),
       cache_expirator(build_cache_expirator(properties, _id, cache_capacity)),
-      cache_keys(build_cache_keys(properties, id, keys_sizes, cache_capacity)) {
-}
+      cache_keys(build_cache_keys(properties, id, keys_sizes, cache_capacity)),
+      admission_sketch(
+          build_admission_sketch(properties, id, policy, cache_capacity)) {}
 
 FCFSCachedTable::FCFSCachedTable(const FCFSCachedTable &other)
-    : DS(DSType::FCFS_CACHED_TABLE, other.id),
-      cache_capacity(other.cache_capacity), num_entries(other.num_entries),
-      keys_sizes(other.keys_sizes), tables(other.tables),
-      cache_expirator(other.cache_expirator), cache_keys(other.cache_keys) {}
+    : DS(DSType::FCFS_CACHED_TABLE, other.id), policy(other.policy),
+      cache_capacity(other.cache_capacity),
+      admission_threshold(other.admission_threshold),
+      num_entries(other.num_entries), keys_sizes(other.keys_sizes),
+      tables(other.tables), cache_expirator(other.cache_expirator),
+      cache_keys(other.cache_keys), admission_sketch(other.admission_sketch) {}
 
 DS *FCFSCachedTable::clone() const { return new FCFSCachedTable(*this); }
 
+cache_config_t FCFSCachedTable::get_config() const {
+  return {policy, cache_capacity, admission_threshold};
+}
+
 DS_ID FCFSCachedTable::add_table() {
   Table new_table = build_table(id, tables.size(), num_entries, keys_sizes);
   tables.push_back(new_table);
@@ -70,11 +124,19 @@ DS_ID FCFSCachedTable::add_table() {
 }
 
 void FCFSCachedTable::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "\n";
   Log::dbg() << "======== FCFS CACHED TABLE ========\n";
   Log::dbg() << "ID:      " << id << "\n";
   Log::dbg() << "Entries: " << num_entries << "\n";
   Log::dbg() << "Cache:   " << cache_capacity << "\n";
+  Log::dbg() << "Policy:  " << cache_policy_to_string(policy) << "\n";
+  if (policy == CachePolicy::COUNT_MIN_ADMISSION) {
+    Log::dbg() << "Admit:   " << admission_threshold << " pkts\n";
+  }
   for (const Table &table : tables) {
     table.log_debug();
   }
@@ -82,12 +144,16 @@ void FCFSCachedTable::log_debug() const {
   for (const Register &cache_key : cache_keys) {
     cache_key.log_debug();
   }
+  for (const Register &row : admission_sketch) {
+    row.log_debug();
+  }
   Log::dbg() << "==============================\n";
 }
 
 std::vector<std::unordered_set<const DS *>>
 FCFSCachedTable::get_internal_ds() const {
-  // Access to the table comes first, then the expirator, and finally the keys.
+  // Access to the table comes first, then the admission sketch (if any), the
+  // expirator, and finally the keys.
 
   std::vector<std::unordered_set<const DS *>> internal_ds;
 
@@ -95,6 +161,12 @@ FCFSCachedTable::get_internal_ds() const {
   for (const Table &table : tables)
     internal_ds.back().insert(&table);
 
+  if (!admission_sketch.empty()) {
+    internal_ds.emplace_back();
+    for (const Register &row : admission_sketch)
+      internal_ds.back().insert(&row);
+  }
+
   internal_ds.emplace_back();
   internal_ds.back().insert(&cache_expirator);
 
@@ -12,8 +12,34 @@
 namespace synapse {
 namespace tofino {
 
+// How the cache picks which flows it holds.
+enum class CachePolicy {
+  // Flows take free slots in the order they show up, and keep them until
+  // they expire.
+  FCFS,
+  // Like FCFS, but flows are only admitted once a count-min sketch has seen
+  // enough of their packets, keeping small flows from taking the slots.
+  COUNT_MIN_ADMISSION,
+  // Every miss takes over its slot. Each slot ends up holding the flow that
+  // used it last, i.e. LRU with a single way per slot.
+  LRU_APPROX,
+};
+
+std::string cache_policy_to_string(CachePolicy policy);
+
+struct cache_config_t {
+  CachePolicy policy;
+  int capacity;
+
+  // Packets counted by the sketch before admitting a flow. Only used by
+  // COUNT_MIN_ADMISSION.
+  int admission_threshold;
+};
+
 struct FCFSCachedTable : public DS {
+  CachePolicy policy;
   int cache_capacity;
+  int admission_threshold;
   int num_entries;
   std::vector<bits_t> keys_sizes;
 
@@ -21,14 +47,20 @@ struct FCFSCachedTable : public DS {
   Register cache_expirator;
   std::vector<Register> cache_keys;
 
-  FCFSCachedTable(const TNAProperties &properties, DS_ID id, int cache_capacity,
-                  int num_entries, const std::vector<bits_t> &keys_sizes);
+  // One register per row of the count-min sketch. Empty unless admission is
+  // controlled.
+  std::vector<Register> admission_sketch;
+
+  FCFSCachedTable(const TNAProperties &properties, DS_ID id,
+                  const cache_config_t &config, int num_entries,
+                  const std::vector<bits_t> &keys_sizes);
 
   FCFSCachedTable(const FCFSCachedTable &other);
 
   DS *clone() const override;
   void log_debug() const override;
 
+  cache_config_t get_config() const;
   DS_ID add_table();
   std::vector<std::unordered_set<const DS *>> get_internal_ds() const;
 };
@@ -26,6 +26,10 @@ bits_t Register::get_consumed_sram() const {
 int Register::get_num_logical_ids() const { return (int)actions.size(); }
 
 void Register::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "\n";
   Log::dbg() << "========== REGISTER ==========\n";
   Log::dbg() << "ID:       " << id << "\n";
@@ -49,6 +53,9 @@ void Register::log_debug() const {
     case RegisterAction::SWAP:
       ss << "SWAP";
       break;
+    case RegisterAction::INC:
+      ss << "INC";
+      break;
     }
     first = false;
   }
@@ -15,6 +15,7 @@ enum class RegisterAction {
   READ,  // No modification
   WRITE, // Overwrites the current value
   SWAP,  // Returns the old value
+  INC,   // Increments, and returns the new value
 };
 
 struct Register : public DS {
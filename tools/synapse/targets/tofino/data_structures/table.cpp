@@ -31,6 +31,10 @@ bits_t Table::get_consumed_sram() const {
 }
 
 void Table::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "\n";
   Log::dbg() << "=========== TABLE ============\n";
   Log::dbg() << "ID:      " << id << "\n";
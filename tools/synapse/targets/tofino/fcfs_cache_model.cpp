@@ -0,0 +1,218 @@
+#include "fcfs_cache_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace synapse {
+namespace tofino {
+
+// Capacities that improve the hit rate of the previous one by less than this
+// are not worth their resources.
+constexpr double MIN_HIT_RATE_GAIN = 0.01;
+
+// Enough to pin down the fill point to double precision.
+constexpr int BISECTION_ITERATIONS = 64;
+
+FCFSCacheModel::FCFSCacheModel(const FlowStats &flow_stats, bool _churn)
+    : total_flows(0), total_packets(0), churn(_churn) {
+  for (uint64_t packets : flow_stats.packets_per_flow) {
+    if (packets > 0) {
+      flows_per_size[packets]++;
+    }
+  }
+
+  // Profiles without the distribution only have the average.
+  if (flows_per_size.empty() && flow_stats.avg_pkts_per_flow > 0) {
+    flows_per_size[flow_stats.avg_pkts_per_flow] = flow_stats.total_flows;
+  }
+
+  for (const auto &[packets, flows] : flows_per_size) {
+    total_flows += flows;
+    total_packets += packets * flows;
+  }
+}
+
+double FCFSCacheModel::get_hit_rate(CachePolicy policy, int capacity) const {
+  if (total_packets == 0) {
+    return 1;
+  }
+
+  switch (policy) {
+  case CachePolicy::FCFS:
+    // Every flow fits. The other policies still miss (the packets before a
+    // flow is admitted, or collisions on a slot).
+    if ((uint64_t)capacity >= total_flows) {
+      return 1;
+    }
+    if (churn) {
+      return get_hit_rate_with_churn(capacity);
+    }
+    return get_hit_rate_without_churn(capacity);
+  case CachePolicy::COUNT_MIN_ADMISSION:
+    return get_hit_rate_with_admission(capacity,
+                                       get_admission_threshold(capacity));
+  case CachePolicy::LRU_APPROX:
+    return get_hit_rate_with_lru(capacity);
+  }
+
+  assert(false && "Unknown cache policy");
+  return 0;
+}
+
+// Lower thresholds let in smaller flows, while higher ones miss more packets
+// of each cached flow (or leave slots empty). Only the measured flow sizes
+// are worth trying, as the hit rate is linear in between.
+int FCFSCacheModel::get_admission_threshold(int capacity) const {
+  int best_threshold = 1;
+  double best_hit_rate = get_hit_rate_with_admission(capacity, 1);
+
+  for (const auto &[packets, flows] : flows_per_size) {
+    double hit_rate = get_hit_rate_with_admission(capacity, packets);
+
+    if (hit_rate > best_hit_rate) {
+      best_threshold = packets;
+      best_hit_rate = hit_rate;
+    }
+  }
+
+  return best_threshold;
+}
+
+// A flow with k packets has already shown up after a fraction x of the trace
+// with probability 1 - (1 - x)^k. The cache fills at the x where the expected
+// number of flows seen matches its capacity, and those are the ones cached.
+double FCFSCacheModel::get_hit_rate_without_churn(int capacity) const {
+  auto seen_probability = [](uint64_t packets, double x) {
+    return 1 - std::pow(1 - x, packets);
+  };
+
+  double low = 0;
+  double high = 1;
+
+  for (int i = 0; i < BISECTION_ITERATIONS; i++) {
+    double x = (low + high) / 2;
+    double seen_flows = 0;
+
+    for (const auto &[packets, flows] : flows_per_size) {
+      seen_flows += flows * seen_probability(packets, x);
+    }
+
+    if (seen_flows < capacity) {
+      low = x;
+    } else {
+      high = x;
+    }
+  }
+
+  double cached_packets = 0;
+  for (const auto &[packets, flows] : flows_per_size) {
+    cached_packets += packets * flows * seen_probability(packets, low);
+  }
+
+  return cached_packets / total_packets;
+}
+
+double FCFSCacheModel::get_hit_rate_with_churn(int capacity) const {
+  return get_hit_rate_with_admission(capacity, 0);
+}
+
+double FCFSCacheModel::get_hit_rate_with_admission(int capacity,
+                                                   int threshold) const {
+  uint64_t slots = capacity;
+  uint64_t cached_packets = 0;
+
+  for (auto it = flows_per_size.rbegin(); it != flows_per_size.rend(); it++) {
+    if (it->first <= (uint64_t)threshold) {
+      break;
+    }
+
+    uint64_t cached_flows = std::min(slots, it->second);
+    cached_packets += (it->first - threshold) * cached_flows;
+    slots -= cached_flows;
+
+    if (slots == 0) {
+      break;
+    }
+  }
+
+  return cached_packets / static_cast<double>(total_packets);
+}
+
+// The other packets of the trace are spread over every slot, so between two
+// packets of a flow with k packets, its slot sees (N - k) / (C * k) packets
+// from other flows on average. The packet hits if there were none, which we
+// approximate by k / (k + (N - k) / C).
+double FCFSCacheModel::get_hit_rate_with_lru(int capacity) const {
+  double cached_packets = 0;
+
+  for (const auto &[packets, flows] : flows_per_size) {
+    double others = (total_packets - packets) / static_cast<double>(capacity);
+    double hit_probability = packets / (packets + others);
+    cached_packets += packets * flows * hit_probability;
+  }
+
+  return cached_packets / total_packets;
+}
+
+// Policies with the same cost use the same resources.
+static int get_policy_cost(CachePolicy policy) {
+  switch (policy) {
+  case CachePolicy::FCFS:
+  case CachePolicy::LRU_APPROX:
+    return 0;
+  case CachePolicy::COUNT_MIN_ADMISSION:
+    return 1;
+  }
+
+  assert(false && "Unknown cache policy");
+  return 0;
+}
+
+std::vector<cache_config_t> FCFSCacheModel::get_pareto_configs(
+    const std::unordered_set<int> &candidates) const {
+  const std::vector<CachePolicy> policies = {
+      CachePolicy::FCFS,
+      CachePolicy::LRU_APPROX,
+      CachePolicy::COUNT_MIN_ADMISSION,
+  };
+
+  std::vector<int> sorted(candidates.begin(), candidates.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<cache_config_t> configs;
+  std::vector<double> hit_rates;
+
+  // Smaller and cheaper configurations come first, so each one only needs to
+  // be compared with the ones already kept.
+  for (int capacity : sorted) {
+    for (CachePolicy policy : policies) {
+      double hit_rate = get_hit_rate(policy, capacity);
+      bool dominated = false;
+
+      for (size_t i = 0; i < configs.size(); i++) {
+        if (get_policy_cost(configs[i].policy) <= get_policy_cost(policy) &&
+            hit_rate < hit_rates[i] + MIN_HIT_RATE_GAIN) {
+          dominated = true;
+          break;
+        }
+      }
+
+      if (dominated) {
+        continue;
+      }
+
+      int threshold = policy == CachePolicy::COUNT_MIN_ADMISSION
+                          ? get_admission_threshold(capacity)
+                          : 0;
+
+      configs.push_back({policy, capacity, threshold});
+      hit_rates.push_back(hit_rate);
+    }
+  }
+
+  return configs;
+}
+
+} // namespace tofino
+} // namespace synapse
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../../profiler.h"
+#include "data_structures/fcfs_cached_table.h"
+
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+namespace synapse {
+namespace tofino {
+
+// Expected hit rate of a cache in front of a map, under the flow size
+// distribution measured for that map. Packets are assumed to be randomly
+// interleaved.
+//
+// FCFS: without expiration, the cache keeps the first flows it sees, and
+// larger flows show up earlier so they are more likely to be cached. With
+// expiration, slots held by flows that go idle are recycled, and the cache
+// ends up holding the flows that stay active, i.e. the largest ones.
+//
+// Count-min admission: only flows past the admission threshold take slots, so
+// the cache holds the largest flows, minus the packets counted before their
+// admission. The threshold is the one that maximizes the hit rate.
+//
+// Approximate LRU: a packet hits if the last packet hashed to its slot was
+// from the same flow.
+class FCFSCacheModel {
+private:
+  // Number of flows with each number of packets.
+  std::map<uint64_t, uint64_t> flows_per_size;
+  uint64_t total_flows;
+  uint64_t total_packets;
+  bool churn;
+
+public:
+  FCFSCacheModel(const FlowStats &flow_stats, bool churn);
+
+  // Fraction of the packets whose flow is cached.
+  double get_hit_rate(CachePolicy policy, int capacity) const;
+
+  int get_admission_threshold(int capacity) const;
+
+  // Out of every policy and candidate capacity, the configurations that
+  // improve the hit rate in a meaningful way over the smaller and cheaper
+  // ones. The others spend more resources for no gain.
+  std::vector<cache_config_t>
+  get_pareto_configs(const std::unordered_set<int> &candidates) const;
+
+private:
+  double get_hit_rate_without_churn(int capacity) const;
+  double get_hit_rate_with_churn(int capacity) const;
+  double get_hit_rate_with_admission(int capacity, int threshold) const;
+  double get_hit_rate_with_lru(int capacity) const;
+};
+
+} // namespace tofino
+} // namespace synapse
@@ -95,28 +95,27 @@ protected:
     fcfs_cached_table_data_t cached_table_data =
         get_cached_table_data(ep, map_erase);
 
-    std::unordered_set<int> allowed_cache_capacities =
-        enumerate_fcfs_cache_table_capacities(cached_table_data.num_entries);
+    std::vector<cache_config_t> allowed_cache_configs =
+        enumerate_fcfs_cache_table_configs(ep, cached_table_data.obj,
+                                           cached_table_data.num_entries);
 
     double chosen_success_estimation = 0;
-    int chosen_cache_capacity = 0;
     bool successfully_placed = false;
 
     // We can use a different method for picking the right estimation depending
     // on the time it takes to find a solution.
-    for (int cache_capacity : allowed_cache_capacities) {
+    for (const cache_config_t &cache_config : allowed_cache_configs) {
       double success_estimation = get_cache_delete_success_estimation_rel(
-          ep, node, cache_capacity, cached_table_data.num_entries);
+          ep, node, cache_config.capacity, cached_table_data.num_entries);
 
       if (!can_get_or_build_fcfs_cached_table(
               ep, node, cached_table_data.obj, cached_table_data.key,
-              cached_table_data.num_entries, chosen_cache_capacity)) {
+              cached_table_data.num_entries, cache_config)) {
         continue;
       }
 
       if (success_estimation > chosen_success_estimation) {
         chosen_success_estimation = success_estimation;
-        chosen_cache_capacity = cache_capacity;
       }
 
       successfully_placed = true;
@@ -127,6 +126,7 @@ protected:
     }
 
     Context new_ctx = ctx;
+    steer_to_state_pipe(ep, node, new_ctx);
     const Profiler *profiler = new_ctx.get_profiler();
     constraints_t constraints = node->get_ordered_branch_constraints();
 
@@ -193,14 +193,15 @@ protected:
 
     symbol_t cache_delete_failed = create_symbol("cache_delete_failed", 32);
 
-    std::unordered_set<int> allowed_cache_capacities =
-        enumerate_fcfs_cache_table_capacities(cached_table_data.num_entries);
+    std::vector<cache_config_t> allowed_cache_configs =
+        enumerate_fcfs_cache_table_configs(ep, cached_table_data.obj,
+                                           cached_table_data.num_entries);
 
-    for (int cache_capacity : allowed_cache_capacities) {
+    for (const cache_config_t &cache_config : allowed_cache_configs) {
       std::optional<__generator_product_t> product =
           concretize_cached_table_delete(ep, node, map_erase, dchain_free_index,
                                          cached_table_data, cache_delete_failed,
-                                         cache_capacity);
+                                         cache_config);
 
       if (product.has_value()) {
         products.push_back(*product);
@@ -221,7 +222,8 @@ private:
       const EP *ep, const bdd::Node *node, const bdd::Call *map_erase,
       const std::optional<const bdd::Node *> &dchain_free_index,
       const fcfs_cached_table_data_t &cached_table_data,
-      const symbol_t &cache_delete_failed, int cache_capacity) const {
+      const symbol_t &cache_delete_failed,
+      const cache_config_t &cache_config) const {
     map_coalescing_objs_t map_objs;
     if (!get_map_coalescing_objs_from_map_op(ep, map_erase, map_objs)) {
       return std::nullopt;
@@ -229,7 +231,7 @@ private:
 
     FCFSCachedTable *cached_table = build_or_reuse_fcfs_cached_table(
         ep, map_erase, cached_table_data.obj, cached_table_data.key,
-        cached_table_data.num_entries, cache_capacity);
+        cached_table_data.num_entries, cache_config);
 
     if (!cached_table) {
       return std::nullopt;
@@ -247,6 +249,7 @@ private:
     EPNode *cached_table_delete_node = new EPNode(module);
 
     EP *new_ep = new EP(*ep);
+    steer_to_state_pipe(ep, node, new_ep);
 
     bdd::Node *on_cache_delete_success;
     bdd::Node *on_cache_delete_failed;
@@ -309,7 +312,8 @@ private:
     // new_ep->inspect();
 
     std::stringstream descr;
-    descr << "capacity=" << cached_table->cache_capacity;
+    descr << "policy=" << cache_policy_to_string(cached_table->policy);
+    descr << " capacity=" << cached_table->cache_capacity;
 
     return __generator_product_t(new_ep, descr.str());
   }
@@ -91,12 +91,13 @@ protected:
         get_future_vector_key_ops(ep, node, cached_table_data, map_objs);
 
     Context new_ctx = ctx;
+    steer_to_state_pipe(ep, node, new_ctx);
     speculation_t speculation(new_ctx);
     for (const bdd::Call *vector_op : vector_ops) {
       speculation.skip.insert(vector_op->get_id());
     }
 
-    return ctx;
+    return speculation;
   }
 
   virtual std::vector<__generator_product_t>
@@ -126,13 +127,14 @@ protected:
     fcfs_cached_table_data_t cached_table_data =
         get_cached_table_data(ep, map_get);
 
-    std::unordered_set<int> allowed_cache_capacities =
-        enumerate_fcfs_cache_table_capacities(cached_table_data.num_entries);
+    std::vector<cache_config_t> allowed_cache_configs =
+        enumerate_fcfs_cache_table_configs(ep, cached_table_data.obj,
+                                           cached_table_data.num_entries);
 
-    for (int cache_capacity : allowed_cache_capacities) {
+    for (const cache_config_t &cache_config : allowed_cache_configs) {
       std::optional<__generator_product_t> product =
           concretize_cached_table_read(ep, node, map_objs, cached_table_data,
-                                       cache_capacity);
+                                       cache_config);
 
       if (product.has_value()) {
         products.push_back(*product);
@@ -155,10 +157,10 @@ private:
       const EP *ep, const bdd::Node *node,
       const map_coalescing_objs_t &map_objs,
       const fcfs_cached_table_data_t &cached_table_data,
-      int cache_capacity) const {
+      const cache_config_t &cache_config) const {
     FCFSCachedTable *cached_table = build_or_reuse_fcfs_cached_table(
         ep, node, cached_table_data.obj, cached_table_data.key,
-        cached_table_data.num_entries, cache_capacity);
+        cached_table_data.num_entries, cache_config);
 
     if (!cached_table) {
       return std::nullopt;
@@ -174,6 +176,7 @@ private:
     EPNode *ep_node = new EPNode(module);
 
     EP *new_ep = new EP(*ep);
+    steer_to_state_pipe(ep, node, new_ep);
 
     const bdd::Node *new_next;
     bdd::BDD *bdd = delete_future_vector_key_ops(
@@ -187,7 +190,8 @@ private:
     // new_ep->inspect();
 
     std::stringstream descr;
-    descr << "capacity=" << cached_table->cache_capacity;
+    descr << "policy=" << cache_policy_to_string(cached_table->policy);
+    descr << " capacity=" << cached_table->cache_capacity;
 
     return __generator_product_t(new_ep, descr.str());
   }
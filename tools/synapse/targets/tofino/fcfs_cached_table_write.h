@@ -94,28 +94,28 @@ protected:
     fcfs_cached_table_data_t cached_table_data =
         get_cached_table_data(ep, future_map_puts);
 
-    std::unordered_set<int> allowed_cache_capacities =
-        enumerate_fcfs_cache_table_capacities(cached_table_data.num_entries);
+    std::vector<cache_config_t> allowed_cache_configs =
+        enumerate_fcfs_cache_table_configs(ep, future_map_puts[0],
+                                           cached_table_data.key,
+                                           cached_table_data.num_entries);
 
     double chosen_success_estimation = 0;
-    int chosen_cache_capacity = 0;
     bool successfully_placed = false;
 
     // We can use a different method for picking the right estimation depending
     // on the time it takes to find a solution.
-    for (int cache_capacity : allowed_cache_capacities) {
+    for (const cache_config_t &cache_config : allowed_cache_configs) {
       double success_estimation = get_cache_success_estimation_rel(
-          ep, node, future_map_puts[0], cached_table_data.key, cache_capacity);
+          ep, node, future_map_puts[0], cached_table_data.key, cache_config);
 
       if (!can_get_or_build_fcfs_cached_table(
               ep, node, cached_table_data.obj, cached_table_data.key,
-              cached_table_data.num_entries, chosen_cache_capacity)) {
+              cached_table_data.num_entries, cache_config)) {
         continue;
       }
 
       if (success_estimation > chosen_success_estimation) {
         chosen_success_estimation = success_estimation;
-        chosen_cache_capacity = cache_capacity;
       }
 
       successfully_placed = true;
@@ -126,6 +126,7 @@ protected:
     }
 
     Context new_ctx = ctx;
+    steer_to_state_pipe(ep, node, new_ctx);
     const Profiler *profiler = new_ctx.get_profiler();
     constraints_t constraints = node->get_ordered_branch_constraints();
 
@@ -186,13 +187,15 @@ protected:
     fcfs_cached_table_data_t cached_table_data =
         get_cached_table_data(ep, future_map_puts);
 
-    std::unordered_set<int> allowed_cache_capacities =
-        enumerate_fcfs_cache_table_capacities(cached_table_data.num_entries);
+    std::vector<cache_config_t> allowed_cache_configs =
+        enumerate_fcfs_cache_table_configs(ep, future_map_puts[0],
+                                           cached_table_data.key,
+                                           cached_table_data.num_entries);
 
-    for (int cache_capacity : allowed_cache_capacities) {
+    for (const cache_config_t &cache_config : allowed_cache_configs) {
       std::optional<__generator_product_t> product =
           concretize_cached_table_write(ep, node, map_objs, cached_table_data,
-                                        cache_write_failed, cache_capacity,
+                                        cache_write_failed, cache_config,
                                         future_map_puts);
 
       if (product.has_value()) {
@@ -217,11 +220,11 @@ private:
       const EP *ep, const bdd::Node *node,
       const map_coalescing_objs_t &map_objs,
       const fcfs_cached_table_data_t &cached_table_data,
-      const symbol_t &cache_write_failed, int cache_capacity,
+      const symbol_t &cache_write_failed, const cache_config_t &cache_config,
       const std::vector<const bdd::Call *> &future_map_puts) const {
     FCFSCachedTable *cached_table = build_or_reuse_fcfs_cached_table(
         ep, node, cached_table_data.obj, cached_table_data.key,
-        cached_table_data.num_entries, cache_capacity);
+        cached_table_data.num_entries, cache_config);
 
     if (!cached_table) {
       return std::nullopt;
@@ -240,6 +243,7 @@ private:
     EPNode *cached_table_write_node = new EPNode(module);
 
     EP *new_ep = new EP(*ep);
+    steer_to_state_pipe(ep, node, new_ep);
 
     bdd::Node *on_cache_write_success;
     bdd::Node *on_cache_write_failed;
@@ -276,7 +280,7 @@ private:
 
     double cache_write_success_estimation_rel =
         get_cache_success_estimation_rel(ep, node, future_map_puts[0],
-                                         cached_table_data.key, cache_capacity);
+                                         cached_table_data.key, cache_config);
 
     new_ep->update_node_constraints(then_node, else_node,
                                     cache_write_success_condition);
@@ -300,7 +304,8 @@ private:
     // new_ep->inspect();
 
     std::stringstream descr;
-    descr << "capacity=" << cache_capacity;
+    descr << "policy=" << cache_policy_to_string(cache_config.policy);
+    descr << " capacity=" << cache_config.capacity;
     descr << " hit-rate=" << cache_write_success_estimation_rel;
 
     return __generator_product_t(new_ep, descr.str());
@@ -309,7 +314,7 @@ private:
   double get_cache_success_estimation_rel(const EP *ep, const bdd::Node *node,
                                           const bdd::Node *map_put,
                                           klee::ref<klee::Expr> key,
-                                          int cache_capacity) const {
+                                          const cache_config_t &config) const {
     const Context &ctx = ep->get_ctx();
     const Profiler *profiler = ctx.get_profiler();
     constraints_t constraints = node->get_ordered_branch_constraints();
@@ -323,11 +328,10 @@ private:
         profiler->get_flow_stats(full_write_constraints, key);
     assert(flow_stats.has_value());
 
-    uint64_t cached_packets =
-        std::min(flow_stats->total_packets,
-                 flow_stats->avg_pkts_per_flow * cache_capacity);
+    bool churn = ctx.get_expiration_data().has_value();
     double expected_cached_fraction =
-        cached_packets / static_cast<double>(flow_stats->total_packets);
+        FCFSCacheModel(*flow_stats, churn)
+            .get_hit_rate(config.policy, config.capacity);
 
     return fraction.value() * expected_cached_fraction;
   }
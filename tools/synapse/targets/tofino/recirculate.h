@@ -90,7 +90,8 @@ private:
     const TofinoContext *ctx = get_tofino_ctx(ep);
     const TNA &tna = ctx->get_tna();
     const TNAProperties &properties = tna.get_properties();
-    return properties.total_recirc_ports;
+    // Each pipe recirculates its own traffic through its own ports.
+    return properties.total_recirc_ports / properties.pipes;
   }
 
   EP *generate_new_ep(const EP *ep, const bdd::Node *node,
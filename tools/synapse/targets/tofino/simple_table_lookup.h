@@ -137,10 +137,105 @@ protected:
     EPLeaf leaf(ep_node, node->get_next());
     new_ep->process_leaf(ep_node, {leaf});
 
+    if (call_node->get_call().function_name == "map_get") {
+      std::optional<__generator_product_t> coalesced_product =
+          concretize_coalesced_table_lookup(ep, call_node);
+
+      if (coalesced_product.has_value()) {
+        products.push_back(*coalesced_product);
+      }
+    }
+
     return products;
   }
 
 private:
+  // A single table for the map, with the vector values read with the index
+  // it finds as extra action data. The dchain is only used for linking them,
+  // so it has nothing to keep on the switch.
+  std::optional<__generator_product_t>
+  concretize_coalesced_table_lookup(const EP *ep,
+                                    const bdd::Call *map_get) const {
+    map_coalescing_objs_t map_objs;
+    if (!get_map_coalescing_objs_from_map_op(ep, map_get, map_objs)) {
+      return std::nullopt;
+    }
+
+    coalesced_map_ops_t ops = get_coalesced_map_ops(map_get, map_objs);
+
+    if (ops.empty()) {
+      return std::nullopt;
+    }
+
+    addr_t obj;
+    int num_entries;
+    std::vector<klee::ref<klee::Expr>> keys;
+    std::vector<klee::ref<klee::Expr>> values;
+    std::optional<symbol_t> hit;
+    DS_ID id;
+
+    table_data_from_map_op(ep, map_get, obj, num_entries, keys, values, hit,
+                           id);
+    id = "coalesced_map_" + std::to_string(map_get->get_id());
+
+    std::unordered_set<addr_t> coalesced_objs;
+
+    if (ops.dchain_rejuvenation.has_value()) {
+      coalesced_objs.insert(map_objs.dchain);
+    }
+
+    for (const bdd::Call *vector_read : ops.vector_reads) {
+      const call_t &call = vector_read->get_call();
+      klee::ref<klee::Expr> vector = call.args.at("vector").expr;
+      klee::ref<klee::Expr> cell = call.extra_vars.at("borrowed_cell").second;
+
+      coalesced_objs.insert(kutil::expr_addr_to_obj_addr(vector));
+      values.push_back(cell);
+    }
+
+    const Context &ctx = ep->get_ctx();
+    for (addr_t coalesced_obj : coalesced_objs) {
+      if (!ctx.can_place(coalesced_obj,
+                         PlacementDecision::Tofino_SimpleTable)) {
+        return std::nullopt;
+      }
+    }
+
+    std::unordered_set<DS_ID> deps;
+    Table *table =
+        build_table(ep, map_get, id, num_entries, keys, values, hit, deps);
+
+    if (!table) {
+      return std::nullopt;
+    }
+
+    Module *module = new SimpleTableLookup(map_get, id, obj, keys, values, hit);
+    EPNode *ep_node = new EPNode(module);
+
+    EP *new_ep = new EP(*ep);
+
+    const bdd::Node *new_next;
+    bdd::BDD *new_bdd =
+        delete_coalesced_map_ops(new_ep, map_get, ops, new_next);
+
+    place_simple_table(new_ep, obj, table, deps);
+
+    TofinoContext *tofino_ctx = get_mutable_tofino_ctx(new_ep);
+    for (addr_t coalesced_obj : coalesced_objs) {
+      place(new_ep, coalesced_obj, PlacementDecision::Tofino_SimpleTable);
+      tofino_ctx->save_ds(coalesced_obj, table);
+    }
+
+    EPLeaf leaf(ep_node, new_next);
+    new_ep->process_leaf(ep_node, {leaf});
+    new_ep->replace_bdd(new_bdd);
+
+    std::stringstream descr;
+    descr << "coalesced=" << coalesced_objs.size() + 1;
+
+    return __generator_product_t(new_ep, descr.str());
+  }
+
   Table *build_table(const EP *ep, const bdd::Node *node, DS_ID id,
                      int num_entries,
                      const std::vector<klee::ref<klee::Expr>> &keys,
@@ -0,0 +1,250 @@
+#include "exact_placer.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#define EXACT_PLACER_MAX_STATES 100'000
+
+namespace synapse {
+namespace tofino {
+
+// Requests that were served again with new dependencies might now depend on
+// requests made after them. Returns false if the dependencies are cyclic.
+static bool
+sort_requests(const std::vector<PlacementRequest> &requests,
+              std::vector<const PlacementRequest *> &sorted_requests) {
+  std::unordered_set<DS_ID> requested;
+  for (const PlacementRequest &request : requests) {
+    requested.insert(request.ds_id);
+  }
+
+  std::unordered_set<DS_ID> sorted;
+
+  while (sorted_requests.size() < requests.size()) {
+    const PlacementRequest *next = nullptr;
+
+    for (const PlacementRequest &request : requests) {
+      if (sorted.find(request.ds_id) != sorted.end()) {
+        continue;
+      }
+
+      bool ready = true;
+      for (DS_ID dependency : request.deps) {
+        if (requested.find(dependency) != requested.end() &&
+            sorted.find(dependency) == sorted.end()) {
+          ready = false;
+          break;
+        }
+      }
+
+      if (ready) {
+        next = &request;
+        break;
+      }
+    }
+
+    if (!next) {
+      return false;
+    }
+
+    sorted_requests.push_back(next);
+    sorted.insert(next->ds_id);
+  }
+
+  return true;
+}
+
+ExactPlacer::ExactPlacer(const std::vector<PlacementRequest> &_requests,
+                         const std::vector<Stage> &empty_stages)
+    : cyclic_deps(false), stages(empty_stages),
+      remaining_sram(_requests.size() + 1, 0),
+      remaining_map_ram(_requests.size() + 1, 0), explored_states(0) {
+  if (!sort_requests(_requests, requests)) {
+    cyclic_deps = true;
+    return;
+  }
+
+  for (size_t i = requests.size(); i > 0; i--) {
+    remaining_sram[i - 1] = remaining_sram[i] + requests[i - 1]->sram;
+    remaining_map_ram[i - 1] = remaining_map_ram[i] + requests[i - 1]->map_ram;
+  }
+}
+
+PlacementStatus ExactPlacer::solve(std::vector<Stage> &solution_stages,
+                                   ds_stages_t &solution_ds_stages) {
+  if (cyclic_deps) {
+    return PlacementStatus::INCONSISTENT_PLACEMENT;
+  }
+
+  if (!search(0)) {
+    return PlacementStatus::NO_AVAILABLE_STAGE;
+  }
+
+  solution_stages = stages;
+  solution_ds_stages = ds_stages;
+  return PlacementStatus::SUCCESS;
+}
+
+bool ExactPlacer::fits_remaining(size_t i) const {
+  bits_t available_sram = 0;
+  bits_t available_map_ram = 0;
+
+  for (const Stage &stage : stages) {
+    available_sram += stage.available_sram;
+    available_map_ram += stage.available_map_ram;
+  }
+
+  return remaining_sram[i] <= available_sram &&
+         remaining_map_ram[i] <= available_map_ram;
+}
+
+bool ExactPlacer::search(size_t i) {
+  if (i == requests.size()) {
+    return true;
+  }
+
+  if (++explored_states > EXACT_PLACER_MAX_STATES) {
+    return false;
+  }
+
+  if (!fits_remaining(i)) {
+    return false;
+  }
+
+  const PlacementRequest &request = *requests[i];
+  int soonest_stage_id = get_soonest_stage(request);
+
+  int total_stages = stages.size();
+  for (int stage_id = soonest_stage_id; stage_id < total_stages; stage_id++) {
+    std::vector<allocation_t> allocations;
+
+    if (!find_allocations(request, stage_id, allocations)) {
+      continue;
+    }
+
+    // Tables skip the stages they can't use, so starting on a stage they
+    // skipped would just repeat the assignment starting on the next one.
+    if (allocations[0].stage_id != stage_id) {
+      continue;
+    }
+
+    allocate(request, allocations);
+
+    if (search(i + 1)) {
+      return true;
+    }
+
+    deallocate(request, allocations);
+
+    if (explored_states > EXACT_PLACER_MAX_STATES) {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+int ExactPlacer::get_soonest_stage(const PlacementRequest &request) const {
+  int soonest_stage_id = 0;
+
+  for (DS_ID dependency : request.deps) {
+    auto found_it = ds_stages.find(dependency);
+
+    if (found_it != ds_stages.end()) {
+      int last_stage_id = found_it->second.back();
+      soonest_stage_id = std::max(soonest_stage_id, last_stage_id + 1);
+    }
+  }
+
+  return soonest_stage_id;
+}
+
+bool ExactPlacer::find_allocations(
+    const PlacementRequest &request, int start_stage_id,
+    std::vector<allocation_t> &allocations) const {
+  bits_t requested_sram = request.sram;
+
+  int total_stages = stages.size();
+  for (int stage_id = start_stage_id; stage_id < total_stages; stage_id++) {
+    const Stage *stage = &stages[stage_id];
+
+    if (request.xbar > stage->available_exact_match_xbar) {
+      continue;
+    }
+
+    if (stage->available_logical_ids < request.logical_ids) {
+      continue;
+    }
+
+    // Same rules as the SimplePlacer: tables can be split across multiple
+    // stages, registers can't.
+    if (request.type == DSType::REGISTER) {
+      if (request.sram > stage->available_sram ||
+          request.map_ram > stage->available_map_ram) {
+        continue;
+      }
+
+      allocations.push_back({
+          .stage_id = stage_id,
+          .sram = request.sram,
+          .map_ram = request.map_ram,
+          .xbar = request.xbar,
+          .logical_ids = request.logical_ids,
+      });
+
+      return true;
+    }
+
+    if (stage->available_sram == 0) {
+      continue;
+    }
+
+    bits_t amount_placed = std::min(requested_sram, stage->available_sram);
+
+    allocations.push_back({
+        .stage_id = stage_id,
+        .sram = amount_placed,
+        .map_ram = 0,
+        .xbar = request.xbar,
+        .logical_ids = request.logical_ids,
+    });
+
+    requested_sram -= amount_placed;
+
+    if (requested_sram == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ExactPlacer::allocate(const PlacementRequest &request,
+                           const std::vector<allocation_t> &allocations) {
+  for (const allocation_t &allocation : allocations) {
+    Stage *stage = &stages[allocation.stage_id];
+
+    stage->available_sram -= allocation.sram;
+    stage->available_map_ram -= allocation.map_ram;
+    stage->available_exact_match_xbar -= allocation.xbar;
+    stage->available_logical_ids -= allocation.logical_ids;
+    ds_stages[request.ds_id].push_back(allocation.stage_id);
+  }
+}
+
+void ExactPlacer::deallocate(const PlacementRequest &request,
+                             const std::vector<allocation_t> &allocations) {
+  for (const allocation_t &allocation : allocations) {
+    Stage *stage = &stages[allocation.stage_id];
+
+    stage->available_sram += allocation.sram;
+    stage->available_map_ram += allocation.map_ram;
+    stage->available_exact_match_xbar += allocation.xbar;
+    stage->available_logical_ids += allocation.logical_ids;
+  }
+
+  ds_stages.erase(request.ds_id);
+}
+
+} // namespace tofino
+} // namespace synapse
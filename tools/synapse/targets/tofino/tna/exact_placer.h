@@ -0,0 +1,60 @@
+#pragma once
+
+#include "simple_placer.h"
+
+namespace synapse {
+namespace tofino {
+
+// Solves the placement of every requested data structure from scratch,
+// exploring all the stage assignments that respect the dependencies and the
+// per stage resources. Requests are assigned in the order they were made
+// (as long as dependencies allow it), trying the soonest stages first, so the
+// first solution found is the greedy one whenever that one exists. The search
+// gives up after exploring a bounded number of states.
+class ExactPlacer {
+private:
+  struct allocation_t {
+    int stage_id;
+    bits_t sram;
+    bits_t map_ram;
+    bits_t xbar;
+    int logical_ids;
+  };
+
+  // Sorted so that every request comes after its dependencies.
+  std::vector<const PlacementRequest *> requests;
+  bool cyclic_deps;
+
+  std::vector<Stage> stages;
+  ds_stages_t ds_stages;
+
+  // Resources still requested by the requests from each index onwards, used
+  // to prune assignments that can no longer fit.
+  std::vector<bits_t> remaining_sram;
+  std::vector<bits_t> remaining_map_ram;
+
+  size_t explored_states;
+
+public:
+  ExactPlacer(const std::vector<PlacementRequest> &requests,
+              const std::vector<Stage> &empty_stages);
+
+  PlacementStatus solve(std::vector<Stage> &solution_stages,
+                        ds_stages_t &solution_ds_stages);
+
+private:
+  bool search(size_t i);
+  bool fits_remaining(size_t i) const;
+
+  int get_soonest_stage(const PlacementRequest &request) const;
+  bool find_allocations(const PlacementRequest &request, int start_stage_id,
+                        std::vector<allocation_t> &allocations) const;
+
+  void allocate(const PlacementRequest &request,
+                const std::vector<allocation_t> &allocations);
+  void deallocate(const PlacementRequest &request,
+                  const std::vector<allocation_t> &allocations);
+};
+
+} // namespace tofino
+} // namespace synapse
@@ -318,6 +318,10 @@ public:
   }
 
   void log_debug() const {
+    if (!Log::is_debug_active()) {
+      return;
+    }
+
     Log::dbg() << "******  Parser ******\n";
     if (initial_state)
       Log::dbg() << initial_state->dump();
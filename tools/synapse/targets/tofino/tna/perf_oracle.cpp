@@ -1,39 +1,45 @@
 #include "perf_oracle.h"
 
 #include "tna.h"
+#include "../../../util.h"
 
 #include <cmath>
 
-#define NEWTON_MAX_ITERATIONS 10
-#define NEWTON_PRECISION 1e-3
+// Enough to reach the precision of a double.
+#define ACCEPTANCE_RATIO_ITERATIONS 64
 
 namespace synapse {
 namespace tofino {
 
 PerfOracle::PerfOracle(const TNAProperties *properties, int _avg_pkt_bytes)
-    : total_ports(properties->total_ports),
+    : pipes(properties->pipes), total_ports(properties->total_ports),
       port_capacity_bps(properties->port_capacity_bps),
-      total_recirc_ports(properties->total_recirc_ports),
+      recirc_ports_per_pipe(properties->total_recirc_ports / properties->pipes),
       recirc_port_capacity_bps(properties->recirc_port_capacity_bps),
-      avg_pkt_bytes(_avg_pkt_bytes),
-      recirc_ports_usage(properties->total_recirc_ports), non_recirc_traffic(1),
+      avg_pkt_bytes(_avg_pkt_bytes), recirc_ports_usage(recirc_ports_per_pipe),
+      non_recirc_traffic(1), steered_traffic(0), cross_pipe_utilization(0),
       throughput_pps(port_capacity_bps * total_ports) {
-  for (int port = 0; port < total_recirc_ports; port++) {
+  assert(recirc_ports_per_pipe > 0);
+
+  for (int port = 0; port < recirc_ports_per_pipe; port++) {
     recirc_ports_usage[port].port = port;
     recirc_ports_usage[port].steering_fraction = 0;
+    recirc_ports_usage[port].utilization = 0;
   }
 
   update_estimate_throughput_pps();
 }
 
 PerfOracle::PerfOracle(const PerfOracle &other)
-    : total_ports(other.total_ports),
+    : pipes(other.pipes), total_ports(other.total_ports),
       port_capacity_bps(other.port_capacity_bps),
-      total_recirc_ports(other.total_recirc_ports),
+      recirc_ports_per_pipe(other.recirc_ports_per_pipe),
       recirc_port_capacity_bps(other.recirc_port_capacity_bps),
       avg_pkt_bytes(other.avg_pkt_bytes),
       recirc_ports_usage(other.recirc_ports_usage),
       non_recirc_traffic(other.non_recirc_traffic),
+      steered_traffic(other.steered_traffic),
+      cross_pipe_utilization(other.cross_pipe_utilization),
       throughput_pps(other.throughput_pps) {}
 
 static bool fractions_le(double f0, double f1) {
@@ -50,7 +56,7 @@ static void clamp_fraction(double &fraction) {
 void PerfOracle::add_recirculated_traffic(int port, int port_recirculations,
                                           double fraction,
                                           std::optional<int> prev_recirc_port) {
-  assert(port < total_recirc_ports);
+  assert(port < recirc_ports_per_pipe);
   assert(port_recirculations > 0);
 
   assert(fraction >= 0);
@@ -91,11 +97,21 @@ void PerfOracle::add_recirculated_traffic(int port, int port_recirculations,
   update_estimate_throughput_pps();
 }
 
+void PerfOracle::add_steered_traffic(double fraction) {
+  assert(fraction >= 0);
+  assert(fraction <= 1);
+
+  steered_traffic += fraction;
+  clamp_fraction(steered_traffic);
+
+  update_estimate_throughput_pps();
+}
+
 void PerfOracle::steer_recirculation_traffic(int source_port,
                                              int destination_port,
                                              double fraction) {
-  assert(source_port < total_recirc_ports);
-  assert(destination_port < total_recirc_ports);
+  assert(source_port < recirc_ports_per_pipe);
+  assert(destination_port < recirc_ports_per_pipe);
 
   assert(fraction >= 0);
   assert(fraction <= 1);
@@ -110,139 +126,128 @@ void PerfOracle::steer_recirculation_traffic(int source_port,
   clamp_fraction(source_usage.steering_fraction);
 }
 
-static uint64_t single_recirc_estimate(uint64_t Tin, uint64_t Cp) {
-  uint64_t Tout = std::min(Tin, Cp);
-  return Tout;
-}
-
-static uint64_t double_recirc_estimate(uint64_t Tin, uint64_t Cr, uint64_t Cp,
-                                       double s) {
-  uint64_t Ts = (-Tin + sqrt(Tin * Tin + 4 * Cr * Tin * s)) / 2;
-  uint64_t Tout_in = (Tin / (double)(Tin + Ts)) * Cr * (1.0 - s);
-  uint64_t Tout_s = (Ts / (double)(Tin + Ts)) * Cr;
-  uint64_t Tout = Tout_in + Tout_s;
-  return std::min(std::min(Tin, Cp), Tout);
-}
-
-// Coefficients are in increasing order: x^0, x^1, x^2, ...
-// min and max are inclusive
-static double newton_root_finder(double *coefficients, int n_coefficients,
-                                 uint64_t min, uint64_t max) {
-  double x = (min + max) / 2.0;
-  int it = 0;
-
-  while (it < NEWTON_MAX_ITERATIONS) {
-    double f = 0;
-    double df_dx = 0;
-
-    // It's very important to compute each term in this order, otherwise we
-    // don't converge (precision loss)
-    for (int c = n_coefficients; c >= 0; c--) {
-      f += coefficients[c] * pow(x, c);
-
-      if (c > 0) {
-        df_dx += c * coefficients[c] * pow(x, c - 1);
-      }
+// Fraction of the traffic offered to a recirculation port that it serves,
+// given the traffic entering it for the first time (Tin) and, for each
+// consecutive recirculation, the fraction of that traffic that goes through
+// it that many times (r[0] = 1 >= r[1] >= ...).
+//
+// A saturated port serves all of its passes with the same acceptance ratio a,
+// so the k-th pass is offered Tin * r[k] * a^k, and the traffic it serves,
+//    Tin * (r[0] * a + r[1] * a^2 + r[2] * a^3 + ...),
+// must match its capacity Cr. This grows monotonically with a, so its root in
+// [0,1] is found by bisection, whatever the number of recirculations.
+static double recirc_acceptance_ratio(double Tin, double Cr,
+                                      const std::vector<double> &r) {
+  auto served = [Tin, &r](double a) {
+    double total = 0;
+    double a_pow = a;
+
+    for (double rk : r) {
+      total += Tin * rk * a_pow;
+      a_pow *= a;
     }
 
-    if (std::abs(f) <= NEWTON_PRECISION) {
-      break;
-    }
+    return total;
+  };
 
-    x = x - f / df_dx;
-    it++;
+  if (served(1) <= Cr) {
+    return 1;
   }
 
-  return x;
-}
+  double min = 0;
+  double max = 1;
 
-static uint64_t triple_recirc_estimate(uint64_t Tin, uint64_t Cr, uint64_t Cp,
-                                       double s0, double s1) {
-  double a = (s1 / s0) * (1.0 / Tin);
-  double b = 1;
-  double c = Tin;
-  double d = -1.0 * Tin * Cr * s0;
+  for (int it = 0; it < ACCEPTANCE_RATIO_ITERATIONS; it++) {
+    double a = (min + max) / 2;
 
-  double Ts0_coefficients[] = {d, c, b, a};
-  double Ts0 = newton_root_finder(Ts0_coefficients, 4, 0, Cr);
-  double Ts1 = Ts0 * Ts0 * (1.0 / Tin) * (s1 / s0);
-
-  double Tout_in = (Tin / (double)(Tin + Ts0 + Ts1)) * Cr * (1.0 - s0);
-  double Tout_s0 = (Ts0 / (double)(Tin + Ts0 + Ts1)) * Cr * (1.0 - s1);
-  double Tout_s1 = (Ts1 / (double)(Tin + Ts0 + Ts1)) * Cr;
-
-  uint64_t Tout = Tout_in + Tout_s0 + Tout_s1;
+    if (served(a) > Cr) {
+      max = a;
+    } else {
+      min = a;
+    }
+  }
 
-  return std::min(std::min(Tin, Cp), Tout);
+  return min;
 }
 
 void PerfOracle::update_estimate_throughput_pps() {
   uint64_t Tswitch_bps = port_capacity_bps * total_ports;
-  uint64_t throughput_bps = 0;
+  uint64_t Tpipe_bps = Tswitch_bps / pipes;
 
-  for (const RecircPortUsage &usage : recirc_ports_usage) {
-    size_t recirc_depth = usage.fractions.size();
+  // Throughput of the recirculated traffic on a single pipe.
+  uint64_t pipe_recirc_throughput_bps = 0;
+
+  // Recirculation capacity left on each pipe.
+  double pipe_recirc_slack_bps = 0;
+
+  for (RecircPortUsage &usage : recirc_ports_usage) {
+    usage.utilization = 0;
 
-    if (recirc_depth == 0) {
+    if (usage.fractions.empty() || usage.fractions[0] == 0) {
+      // Nothing to recirculate actually
       continue;
     }
 
-    uint64_t Tin_bps = Tswitch_bps * usage.fractions[0];
-    uint64_t Tsteering_bps = Tswitch_bps * usage.steering_fraction;
-    uint64_t Tout_bps = 0;
-
-    switch (recirc_depth) {
-    case 1: {
-      // Single recirculation, easy
-      Tout_bps = single_recirc_estimate(Tin_bps, port_capacity_bps);
-    } break;
-    case 2: {
-      // Recirculation surplus
-      // s is relative to the first recirculation
-
-      assert(fractions_le(usage.fractions[1], usage.fractions[0]));
-
-      if (usage.fractions[0] == 0) {
-        // Nothing to recirculate actually
-        Tout_bps = 0;
-        break;
-      }
-
-      double s = usage.fractions[1] / usage.fractions[0];
-
-      Tout_bps = double_recirc_estimate(Tin_bps, recirc_port_capacity_bps,
-                                        port_capacity_bps, s);
-    } break;
-    case 3: {
-      // s1 is relative to s0
-      // s0 is relative to the first recirculation
-
-      assert(fractions_le(usage.fractions[2], usage.fractions[1]));
-      assert(fractions_le(usage.fractions[1], usage.fractions[0]));
-
-      if (usage.fractions[0] == 0 || usage.fractions[1] == 0) {
-        // Nothing to recirculate actually
-        Tout_bps = 0;
-        break;
-      }
-
-      double s0 = usage.fractions[1] / usage.fractions[0];
-      double s1 = usage.fractions[2] / usage.fractions[1];
-
-      Tout_bps = triple_recirc_estimate(Tin_bps, recirc_port_capacity_bps,
-                                        port_capacity_bps, s0, s1);
-    } break;
-    default: {
-      assert(false && "TODO");
+    // Relative to the first recirculation. Each recirculation carries at
+    // most as much traffic as the previous one.
+    std::vector<double> r(usage.fractions.size());
+    r[0] = 1;
+    for (size_t i = 1; i < usage.fractions.size(); i++) {
+      r[i] = std::min(r[i - 1], usage.fractions[i] / usage.fractions[0]);
     }
+
+    double Tin_bps = Tpipe_bps * usage.fractions[0];
+    double Cr_bps = recirc_port_capacity_bps;
+    double a = recirc_acceptance_ratio(Tin_bps, Cr_bps, r);
+
+    // Served passes leave the port unless they are recirculated again.
+    double offered_bps = 0;
+    double Tout_bps = 0;
+    double a_pow = 1;
+
+    for (size_t i = 0; i < r.size(); i++) {
+      double next_r = i + 1 < r.size() ? r[i + 1] : 0;
+
+      offered_bps += Tin_bps * r[i] * a_pow;
+      a_pow *= a;
+      Tout_bps += Tin_bps * (r[i] - next_r) * a_pow;
     }
 
-    Tsteering_bps = std::min(Tsteering_bps, Tout_bps);
-    throughput_bps += Tout_bps - Tsteering_bps;
+    usage.utilization = offered_bps / Cr_bps;
+    pipe_recirc_slack_bps += std::max(0.0, Cr_bps - offered_bps);
+
+    Tout_bps = std::min(Tout_bps, std::min(Tin_bps, (double)port_capacity_bps));
+
+    uint64_t Tsteering_bps = Tpipe_bps * usage.steering_fraction;
+    Tsteering_bps = std::min(Tsteering_bps, (uint64_t)Tout_bps);
+    pipe_recirc_throughput_bps += (uint64_t)Tout_bps - Tsteering_bps;
   }
 
+  // Unused recirculation ports still have their capacity.
+  int unused_ports = recirc_ports_per_pipe;
+  for (const RecircPortUsage &usage : recirc_ports_usage) {
+    if (!usage.fractions.empty() && usage.fractions[0] > 0) {
+      unused_ports--;
+    }
+  }
+  pipe_recirc_slack_bps += unused_ports * (double)recirc_port_capacity_bps;
+
+  uint64_t throughput_bps = pipes * pipe_recirc_throughput_bps;
   throughput_bps += non_recirc_traffic * Tswitch_bps;
 
+  // Steered traffic coming from the other pipes can only use what is left of
+  // the recirculation capacity of the pipe holding the state.
+  double Tcross_bps = steered_traffic * Tpipe_bps * (pipes - 1);
+  double Tcross_dropped_bps = std::max(0.0, Tcross_bps - pipe_recirc_slack_bps);
+
+  double pipe_recirc_capacity_bps =
+      recirc_ports_per_pipe * (double)recirc_port_capacity_bps;
+  cross_pipe_utilization =
+      (pipe_recirc_capacity_bps - pipe_recirc_slack_bps + Tcross_bps) /
+      pipe_recirc_capacity_bps;
+
+  throughput_bps -= std::min((double)throughput_bps, Tcross_dropped_bps);
+
   uint64_t old_estimate_pps = throughput_pps;
   uint64_t new_estimate_pps = throughput_bps / (avg_pkt_bytes * 8);
 
@@ -253,21 +258,60 @@ void PerfOracle::update_estimate_throughput_pps() {
 
 uint64_t PerfOracle::estimate_throughput_pps() const { return throughput_pps; }
 
+const std::vector<RecircPortUsage> &PerfOracle::get_recirc_ports_usage() const {
+  return recirc_ports_usage;
+}
+
+double PerfOracle::get_max_recirc_port_utilization() const {
+  double max_utilization = 0;
+
+  for (const RecircPortUsage &usage : recirc_ports_usage) {
+    max_utilization = std::max(max_utilization, usage.utilization);
+  }
+
+  if (steered_traffic > 0) {
+    max_utilization = std::max(max_utilization, cross_pipe_utilization);
+  }
+
+  return max_utilization;
+}
+
 void PerfOracle::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "====== PerfOracle ======\n";
   Log::dbg() << "Non recirculated: " << non_recirc_traffic << "\n";
-  Log::dbg() << "Recirculations:\n";
+  Log::dbg() << "Steered to the state pipe: " << steered_traffic;
+  Log::dbg() << " (utilization=" << cross_pipe_utilization << ")\n";
+  Log::dbg() << "Recirculations (per pipe):\n";
   for (const RecircPortUsage &usage : recirc_ports_usage) {
     Log::dbg() << "  Port " << usage.port << ":";
     for (size_t i = 0; i < usage.fractions.size(); i++) {
       Log::dbg() << " " << usage.fractions[i];
     }
-    Log::dbg() << " (steering=" << usage.steering_fraction << ")";
+    Log::dbg() << " (steering=" << usage.steering_fraction;
+    Log::dbg() << ", utilization=" << usage.utilization << ")";
     Log::dbg() << "\n";
   }
   Log::dbg() << "Estimate: " << estimate_throughput_pps() << " pps\n";
   Log::dbg() << "========================\n";
 }
 
+size_t PerfOracle::hash() const {
+  size_t seed = std::hash<double>{}(non_recirc_traffic);
+  hash_combine(seed, std::hash<double>{}(steered_traffic));
+
+  for (const RecircPortUsage &usage : recirc_ports_usage) {
+    for (double fraction : usage.fractions) {
+      hash_combine(seed, std::hash<double>{}(fraction));
+    }
+    hash_combine(seed, std::hash<double>{}(usage.steering_fraction));
+  }
+
+  return seed;
+}
+
 } // namespace tofino
 } // namespace synapse
\ No newline at end of file
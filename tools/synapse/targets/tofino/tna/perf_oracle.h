@@ -9,6 +9,9 @@ namespace tofino {
 
 struct TNAProperties;
 
+// Recirculation ports are local to each pipe, and every pipe recirculates its
+// own traffic. The usage is the same on every pipe, so it is kept for the
+// ports of a single one.
 struct RecircPortUsage {
   int port;
 
@@ -23,19 +26,30 @@ struct RecircPortUsage {
   // This avoids us double counting the contribution of recirculation traffic to
   // the final throughput estimation.
   double steering_fraction;
+
+  // Traffic offered to the port (over all the passes through it), relative
+  // to its capacity. Above 1 the port is saturated and drops traffic.
+  double utilization;
 };
 
 class PerfOracle {
 private:
+  int pipes;
   int total_ports;
   uint64_t port_capacity_bps;
-  int total_recirc_ports;
+  int recirc_ports_per_pipe;
   uint64_t recirc_port_capacity_bps;
   int avg_pkt_bytes;
 
   std::vector<RecircPortUsage> recirc_ports_usage;
   double non_recirc_traffic;
 
+  // Fraction of the traffic that accesses state kept on a single pipe (the
+  // first one). Packets entering the other pipes must be recirculated into
+  // it, through its recirculation ports.
+  double steered_traffic;
+  double cross_pipe_utilization;
+
   uint64_t throughput_pps;
 
 public:
@@ -45,8 +59,14 @@ public:
   void add_recirculated_traffic(int port, int port_recirculations,
                                 double fraction,
                                 std::optional<int> prev_recirc_port);
+  void add_steered_traffic(double fraction);
   uint64_t estimate_throughput_pps() const;
+
+  const std::vector<RecircPortUsage> &get_recirc_ports_usage() const;
+  double get_max_recirc_port_utilization() const;
+
   void log_debug() const;
+  size_t hash() const;
 
 private:
   void steer_recirculation_traffic(int source_port, int destination_port,
@@ -1,7 +1,13 @@
 #include "simple_placer.h"
+#include "exact_placer.h"
 #include "tna.h"
 
 #include "../../../log.h"
+#include "../../../util.h"
+
+#include <algorithm>
+
+#define MAX_PLACEMENT_LAYERS 16
 
 namespace synapse {
 namespace tofino {
@@ -48,7 +54,6 @@ static std::vector<Stage> create_stages(const TNAProperties *properties) {
         .available_exact_match_xbar = properties->exact_match_xbar_per_stage,
         .available_logical_ids =
             properties->max_logical_sram_and_tcam_tables_per_stage,
-        .tables = {},
     };
 
     stages.push_back(s);
@@ -57,37 +62,134 @@ static std::vector<Stage> create_stages(const TNAProperties *properties) {
   return stages;
 }
 
+// Requests for data structures that were already placed only add new
+// dependencies.
+static void merge_request(std::vector<PlacementRequest> &requests,
+                          const PlacementRequest &request) {
+  for (PlacementRequest &old_request : requests) {
+    if (old_request.ds_id == request.ds_id) {
+      old_request.deps.insert(request.deps.begin(), request.deps.end());
+      return;
+    }
+  }
+
+  requests.push_back(request);
+}
+
+static std::vector<const PlacementLayer *>
+get_layers(const std::shared_ptr<const PlacementLayer> &top) {
+  std::vector<const PlacementLayer *> layers;
+
+  for (const PlacementLayer *layer = top.get(); layer;
+       layer = layer->parent.get()) {
+    layers.push_back(layer);
+  }
+
+  std::reverse(layers.begin(), layers.end());
+  return layers;
+}
+
+// Merges every layer into a single one, bounding the cost of going through
+// them on lookups.
+static std::shared_ptr<const PlacementLayer>
+flatten(const std::shared_ptr<const PlacementLayer> &top) {
+  PlacementLayer flat = {
+      .parent = nullptr,
+      .depth = 0,
+      .requests = {},
+      .ds_stages = {},
+  };
+
+  for (const PlacementLayer *layer : get_layers(top)) {
+    for (const PlacementRequest &request : layer->requests) {
+      merge_request(flat.requests, request);
+    }
+
+    flat.ds_stages.insert(layer->ds_stages.begin(), layer->ds_stages.end());
+  }
+
+  return std::make_shared<const PlacementLayer>(std::move(flat));
+}
+
 SimplePlacer::SimplePlacer(const TNAProperties *_properties)
-    : properties(_properties), stages(create_stages(_properties)) {}
+    : properties(_properties), stages(create_stages(_properties)),
+      base(nullptr), delta({nullptr, 0, {}, {}}),
+      exact_cache(std::make_shared<exact_cache_t>()) {}
 
 SimplePlacer::SimplePlacer(const SimplePlacer &other)
-    : properties(other.properties), stages(other.stages) {}
+    : properties(other.properties), stages(other.stages), base(other.base),
+      delta({nullptr, 0, {}, {}}), exact_cache(other.exact_cache) {
+  if (other.delta.requests.empty()) {
+    return;
+  }
 
-static int get_soonest_available_stage(const std::vector<Stage> &stages,
-                                       const std::unordered_set<DS_ID> &deps) {
-  const Stage *soonest_stage = nullptr;
+  PlacementLayer layer = other.delta;
+  layer.parent = other.base;
+  layer.depth = other.base ? other.base->depth + 1 : 0;
 
-  for (auto it = stages.rbegin(); it != stages.rend(); it++) {
-    const Stage *stage = &(*it);
+  base = std::make_shared<const PlacementLayer>(std::move(layer));
 
-    bool can_place = true;
-    for (DS_ID dependency : deps) {
-      if (stage->tables.find(dependency) != stage->tables.end()) {
-        can_place = false;
-        break;
-      }
+  if (base->depth >= MAX_PLACEMENT_LAYERS) {
+    base = flatten(base);
+  }
+}
+
+const std::vector<int> *SimplePlacer::get_ds_stages(DS_ID ds_id) const {
+  auto found_it = delta.ds_stages.find(ds_id);
+  if (found_it != delta.ds_stages.end()) {
+    return &found_it->second;
+  }
+
+  for (const PlacementLayer *layer = base.get(); layer;
+       layer = layer->parent.get()) {
+    found_it = layer->ds_stages.find(ds_id);
+    if (found_it != layer->ds_stages.end()) {
+      return &found_it->second;
     }
+  }
 
-    if (can_place) {
-      soonest_stage = stage;
+  return nullptr;
+}
+
+// The stage right after the last one holding a dependency, or -1 if there is
+// no such stage.
+int SimplePlacer::get_soonest_available_stage(
+    const std::unordered_set<DS_ID> &deps) const {
+  int soonest_stage_id = 0;
+
+  for (DS_ID dependency : deps) {
+    const std::vector<int> *ds_stages = get_ds_stages(dependency);
+
+    if (ds_stages) {
+      soonest_stage_id = std::max(soonest_stage_id, ds_stages->back() + 1);
     }
   }
 
-  if (soonest_stage) {
-    return soonest_stage->stage_id;
+  if (soonest_stage_id >= static_cast<int>(stages.size())) {
+    return -1;
   }
 
-  return -1;
+  return soonest_stage_id;
+}
+
+std::vector<PlacementRequest> SimplePlacer::get_requests() const {
+  std::vector<PlacementRequest> requests;
+
+  for (const PlacementLayer *layer : get_layers(base)) {
+    for (const PlacementRequest &request : layer->requests) {
+      merge_request(requests, request);
+    }
+  }
+
+  for (const PlacementRequest &request : delta.requests) {
+    merge_request(requests, request);
+  }
+
+  return requests;
+}
+
+void SimplePlacer::add_request(const PlacementRequest &request) {
+  merge_request(delta.requests, request);
 }
 
 struct SimplePlacer::placement_t {
@@ -100,8 +202,9 @@ struct SimplePlacer::placement_t {
 };
 
 void SimplePlacer::concretize_placement(
-    Stage *stage, const SimplePlacer::placement_t &placement) {
-  assert(stage->stage_id == placement.stage_id);
+    const SimplePlacer::placement_t &placement) {
+  assert(placement.stage_id < static_cast<int>(stages.size()));
+  Stage *stage = &stages[placement.stage_id];
 
   assert(stage->available_sram >= placement.sram);
   assert(stage->available_map_ram >= placement.map_ram);
@@ -112,34 +215,30 @@ void SimplePlacer::concretize_placement(
   stage->available_map_ram -= placement.map_ram;
   stage->available_exact_match_xbar -= placement.xbar;
   stage->available_logical_ids -= placement.logical_ids;
-  stage->tables.insert(placement.obj);
+  delta.ds_stages[placement.obj].push_back(placement.stage_id);
 }
 
 bool SimplePlacer::is_already_placed(DS_ID ds_id) const {
-  for (const Stage &stage : stages) {
-    if (stage.tables.find(ds_id) != stage.tables.end()) {
-      return true;
-    }
-  }
-
-  return false;
+  return get_ds_stages(ds_id) != nullptr;
 }
 
 PlacementStatus
 SimplePlacer::is_consistent(DS_ID ds_id,
                             const std::unordered_set<DS_ID> &deps) const {
-  int soonest_stage_id = get_soonest_available_stage(stages, deps);
+  int soonest_stage_id = get_soonest_available_stage(deps);
 
-  int total_stages = stages.size();
-  for (int stage_id = soonest_stage_id; stage_id < total_stages; stage_id++) {
-    const Stage *stage = &stages[stage_id];
+  if (soonest_stage_id < 0) {
+    return PlacementStatus::INCONSISTENT_PLACEMENT;
+  }
 
-    if (stage->tables.find(ds_id) != stage->tables.end()) {
-      return PlacementStatus::SUCCESS;
-    }
+  const std::vector<int> *ds_stages = get_ds_stages(ds_id);
+  assert(ds_stages);
+
+  if (ds_stages->back() < soonest_stage_id) {
+    return PlacementStatus::INCONSISTENT_PLACEMENT;
   }
 
-  return PlacementStatus::INCONSISTENT_PLACEMENT;
+  return PlacementStatus::SUCCESS;
 }
 
 bool SimplePlacer::is_self_dependent(
@@ -162,7 +261,7 @@ SimplePlacer::find_placements(const Table *table,
     return PlacementStatus::XBAR_CONSUME_EXCEEDS_LIMIT;
   }
 
-  int soonest_stage_id = get_soonest_available_stage(stages, deps);
+  int soonest_stage_id = get_soonest_available_stage(deps);
   assert(soonest_stage_id < static_cast<int>(stages.size()));
 
   if (soonest_stage_id < 0) {
@@ -221,7 +320,7 @@ SimplePlacer::find_placements(const Register *reg,
                               std::vector<placement_t> &placements) const {
   assert(!is_already_placed(reg->id));
 
-  int soonest_stage_id = get_soonest_available_stage(stages, deps);
+  int soonest_stage_id = get_soonest_available_stage(deps);
   assert(soonest_stage_id < static_cast<int>(stages.size()));
 
   if (soonest_stage_id < 0) {
@@ -279,36 +378,64 @@ SimplePlacer::find_placements(const Register *reg,
 
 void SimplePlacer::place(const Table *table,
                          const std::unordered_set<DS_ID> &deps) {
+  PlacementRequest request = build_request(table, deps);
+
   if (is_already_placed(table->id)) {
+    // Keep the current placement if it can't be made consistent.
+    if (is_consistent(table->id, deps) != PlacementStatus::SUCCESS) {
+      place_exact(request);
+    } else {
+      add_request(request);
+    }
+
     return;
   }
 
   std::vector<placement_t> placements;
   PlacementStatus status = find_placements(table, deps, placements);
-  assert(status == PlacementStatus::SUCCESS && "Cannot place table");
+
+  if (status != PlacementStatus::SUCCESS) {
+    status = place_exact(request);
+    assert(status == PlacementStatus::SUCCESS && "Cannot place table");
+    return;
+  }
 
   for (const placement_t &placement : placements) {
-    assert(placement.stage_id < static_cast<int>(stages.size()));
-    Stage *stage = &stages[placement.stage_id];
-    concretize_placement(stage, placement);
+    concretize_placement(placement);
   }
+
+  add_request(request);
 }
 
 void SimplePlacer::place(const Register *reg,
                          const std::unordered_set<DS_ID> &deps) {
+  PlacementRequest request = build_request(reg, deps);
+
   if (is_already_placed(reg->id)) {
+    // Keep the current placement if it can't be made consistent.
+    if (is_consistent(reg->id, deps) != PlacementStatus::SUCCESS) {
+      place_exact(request);
+    } else {
+      add_request(request);
+    }
+
     return;
   }
 
   std::vector<placement_t> placements;
   PlacementStatus status = find_placements(reg, deps, placements);
-  assert(status == PlacementStatus::SUCCESS && "Cannot place register");
+
+  if (status != PlacementStatus::SUCCESS) {
+    status = place_exact(request);
+    assert(status == PlacementStatus::SUCCESS && "Cannot place register");
+    return;
+  }
 
   for (const placement_t &placement : placements) {
-    assert(placement.stage_id < static_cast<int>(stages.size()));
-    Stage *stage = &stages[placement.stage_id];
-    concretize_placement(stage, placement);
+    concretize_placement(placement);
   }
+
+  add_request(request);
 }
 
 void SimplePlacer::place(const FCFSCachedTable *cached_table,
@@ -358,11 +485,15 @@ SimplePlacer::can_place(const Table *table,
     return PlacementStatus::SELF_DEPENDENCE;
   }
 
+  PlacementStatus status;
+
   if (is_already_placed(table->id)) {
-    return is_consistent(table->id, deps);
+    status = is_consistent(table->id, deps);
+  } else {
+    status = find_placements(table, deps, placements);
   }
 
-  return find_placements(table, deps, placements);
+  return try_exact_placement(status, build_request(table, deps));
 }
 
 PlacementStatus
@@ -374,16 +505,22 @@ SimplePlacer::can_place(const Register *reg,
     return PlacementStatus::SELF_DEPENDENCE;
   }
 
+  PlacementStatus status;
+
   if (is_already_placed(reg->id)) {
-    return is_consistent(reg->id, deps);
+    status = is_consistent(reg->id, deps);
+  } else {
+    status = find_placements(reg, deps, placements);
   }
 
-  return find_placements(reg, deps, placements);
+  return try_exact_placement(status, build_request(reg, deps));
 }
 
 PlacementStatus
 SimplePlacer::can_place(const FCFSCachedTable *cached_table,
                         const std::unordered_set<DS_ID> &_deps) const {
+  // Copies share the placement layers and the exact placement cache, so this
+  // only copies the stage budgets.
   SimplePlacer snapshot = *this;
 
   std::vector<std::unordered_set<const DS *>> candidates =
@@ -431,12 +568,184 @@ SimplePlacer::can_place(const DS *ds,
   return status;
 }
 
+PlacementRequest
+SimplePlacer::build_request(const Table *table,
+                            const std::unordered_set<DS_ID> &deps) const {
+  PlacementRequest request = {
+      .ds_id = table->id,
+      .type = DSType::TABLE,
+      .sram = table->get_consumed_sram(),
+      .map_ram = 0,
+      .xbar = table->get_match_xbar_consume(),
+      .logical_ids = 1,
+      .deps = deps,
+  };
+
+  return request;
+}
+
+PlacementRequest
+SimplePlacer::build_request(const Register *reg,
+                            const std::unordered_set<DS_ID> &deps) const {
+  PlacementRequest request = {
+      .ds_id = reg->id,
+      .type = DSType::REGISTER,
+      .sram = reg->get_consumed_sram(),
+      .map_ram = reg->get_consumed_sram(),
+      .xbar = reg->index,
+      .logical_ids = reg->get_num_logical_ids(),
+      .deps = deps,
+  };
+
+  return request;
+}
+
+static void hash_request(size_t &seed, const PlacementRequest &request) {
+  hash_combine(seed, std::hash<DS_ID>()(request.ds_id));
+  hash_combine(seed, static_cast<size_t>(request.type));
+  hash_combine(seed, request.sram);
+  hash_combine(seed, request.map_ram);
+  hash_combine(seed, request.xbar);
+  hash_combine(seed, request.logical_ids);
+
+  // Unordered, so that the iteration order of the set doesn't matter.
+  size_t deps_seed = 0;
+  for (const DS_ID &dep : request.deps) {
+    deps_seed ^= std::hash<DS_ID>()(dep);
+  }
+  hash_combine(seed, deps_seed);
+}
+
+size_t SimplePlacer::exact_cache_key(const PlacementRequest &request) const {
+  size_t seed = hash();
+
+  for (const PlacementRequest &served : get_requests()) {
+    hash_request(seed, served);
+  }
+
+  hash_request(seed, request);
+  return seed;
+}
+
+PlacementStatus
+SimplePlacer::try_exact_placement(PlacementStatus greedy_status,
+                                  const PlacementRequest &request) const {
+  switch (greedy_status) {
+  case PlacementStatus::NO_AVAILABLE_STAGE:
+  case PlacementStatus::TOO_LARGE:
+  case PlacementStatus::INCONSISTENT_PLACEMENT:
+    break;
+  default:
+    // Either it succeeded, or no placement could ever fix it.
+    return greedy_status;
+  }
+
+  size_t key = exact_cache_key(request);
+
+  auto cached_it = exact_cache->find(key);
+  if (cached_it != exact_cache->end()) {
+    if (cached_it->second != PlacementStatus::SUCCESS) {
+      return greedy_status;
+    }
+
+    return PlacementStatus::SUCCESS;
+  }
+
+  std::vector<Stage> solution_stages;
+  ds_stages_t solution_ds_stages;
+
+  PlacementStatus status =
+      solve_exact(request, solution_stages, solution_ds_stages);
+  exact_cache->insert({key, status});
+
+  if (status != PlacementStatus::SUCCESS) {
+    return greedy_status;
+  }
+
+  return PlacementStatus::SUCCESS;
+}
+
+PlacementStatus
+SimplePlacer::solve_exact(const PlacementRequest &request,
+                          std::vector<Stage> &solution_stages,
+                          ds_stages_t &solution_ds_stages) const {
+  std::vector<PlacementRequest> requests = get_requests();
+  merge_request(requests, request);
+
+  ExactPlacer exact_placer(requests, create_stages(properties));
+  return exact_placer.solve(solution_stages, solution_ds_stages);
+}
+
+PlacementStatus SimplePlacer::place_exact(const PlacementRequest &request) {
+  size_t key = exact_cache_key(request);
+
+  // Don't search again for a solution we already know doesn't exist.
+  auto cached_it = exact_cache->find(key);
+  if (cached_it != exact_cache->end() &&
+      cached_it->second != PlacementStatus::SUCCESS) {
+    return cached_it->second;
+  }
+
+  std::vector<Stage> solution_stages;
+  ds_stages_t solution_ds_stages;
+
+  PlacementStatus status =
+      solve_exact(request, solution_stages, solution_ds_stages);
+  exact_cache->insert({key, status});
+
+  if (status != PlacementStatus::SUCCESS) {
+    return status;
+  }
+
+  Log::dbg() << "Greedy placement of " << request.ds_id
+             << " failed, placement solved again from scratch.\n";
+
+  std::vector<PlacementRequest> requests = get_requests();
+  merge_request(requests, request);
+
+  // The new placement has nothing in common with the previous layers.
+  PlacementLayer layer = {
+      .parent = nullptr,
+      .depth = 0,
+      .requests = requests,
+      .ds_stages = solution_ds_stages,
+  };
+
+  stages = solution_stages;
+  base = std::make_shared<const PlacementLayer>(std::move(layer));
+  delta = {nullptr, 0, {}, {}};
+
+  return PlacementStatus::SUCCESS;
+}
+
 void SimplePlacer::log_debug() const {
+  if (!Log::is_debug_active()) {
+    return;
+  }
+
   Log::dbg() << "\n";
   Log::dbg() << "====================== SimplePlacer ======================\n";
 
+  std::vector<std::vector<DS_ID>> stage_objs(stages.size());
+
+  for (const PlacementLayer *layer : get_layers(base)) {
+    for (const auto &[ds_id, ds_stages] : layer->ds_stages) {
+      for (int stage_id : ds_stages) {
+        stage_objs[stage_id].push_back(ds_id);
+      }
+    }
+  }
+
+  for (const auto &[ds_id, ds_stages] : delta.ds_stages) {
+    for (int stage_id : ds_stages) {
+      stage_objs[stage_id].push_back(ds_id);
+    }
+  }
+
   for (const Stage &stage : stages) {
-    if (stage.tables.empty()) {
+    const std::vector<DS_ID> &objs = stage_objs[stage.stage_id];
+
+    if (objs.empty()) {
       continue;
     }
 
@@ -492,7 +801,7 @@ void SimplePlacer::log_debug() const {
 
     ss << "Objs=[";
     bool first = true;
-    for (DS_ID table_id : stage.tables) {
+    for (DS_ID table_id : objs) {
       if (!first) {
         ss << ",";
       }
@@ -507,5 +816,19 @@ void SimplePlacer::log_debug() const {
   Log::dbg() << "==========================================================\n";
 }
 
+size_t SimplePlacer::hash() const {
+  size_t seed = 0;
+
+  for (const Stage &stage : stages) {
+    hash_combine(seed, stage.available_sram);
+    hash_combine(seed, stage.available_tcam);
+    hash_combine(seed, stage.available_map_ram);
+    hash_combine(seed, stage.available_exact_match_xbar);
+    hash_combine(seed, stage.available_logical_ids);
+  }
+
+  return seed;
+}
+
 } // namespace tofino
 } // namespace synapse
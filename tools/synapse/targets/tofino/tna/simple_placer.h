@@ -2,6 +2,8 @@
 
 #include "../data_structures/data_structures.h"
 
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace synapse {
@@ -20,6 +22,8 @@ enum class PlacementStatus {
 
 std::ostream &operator<<(std::ostream &os, const PlacementStatus &status);
 
+// Resources left on a stage. Which data structures were placed on each stage
+// is kept on the placement layers, so that copying the budgets is cheap.
 struct Stage {
   int stage_id;
   bits_t available_sram;
@@ -27,16 +31,52 @@ struct Stage {
   bits_t available_map_ram;
   bits_t available_exact_match_xbar;
   int available_logical_ids;
-  std::unordered_set<DS_ID> tables;
+};
+
+typedef std::unordered_map<DS_ID, std::vector<int>> ds_stages_t;
+
+// What a table or register asks from the pipeline. The placer keeps every
+// request it served, so that the whole placement can be solved again.
+struct PlacementRequest {
+  DS_ID ds_id;
+  DSType type;
+  bits_t sram;
+  bits_t map_ram;
+  bits_t xbar;
+  int logical_ids;
+  std::unordered_set<DS_ID> deps;
+};
+
+// Placements made by a placer. Copies of a placer share the layers of the
+// original, and only keep the placements they make themselves on a new one.
+struct PlacementLayer {
+  std::shared_ptr<const PlacementLayer> parent;
+  int depth;
+
+  // In the order they were made. Requests for data structures placed on
+  // previous layers only add new dependencies.
+  std::vector<PlacementRequest> requests;
+
+  // Stages holding the data structures placed on this layer.
+  ds_stages_t ds_stages;
 };
 
 struct TNAProperties;
 
+// Outcomes of the ExactPlacer, indexed by the hash of the placer and of the
+// request it was asked to add. Shared by all the copies of a placer.
+typedef std::unordered_map<size_t, PlacementStatus> exact_cache_t;
+
 class SimplePlacer {
 private:
   const TNAProperties *properties;
   std::vector<Stage> stages;
 
+  std::shared_ptr<const PlacementLayer> base;
+  PlacementLayer delta;
+
+  std::shared_ptr<exact_cache_t> exact_cache;
+
 public:
   SimplePlacer(const TNAProperties *properties);
   SimplePlacer(const SimplePlacer &other);
@@ -47,6 +87,10 @@ public:
 
   void log_debug() const;
 
+  // Only the resources left on each stage, not which data structures hold
+  // them.
+  size_t hash() const;
+
 private:
   struct placement_t;
 
@@ -55,6 +99,10 @@ private:
   void place(const FCFSCachedTable *cached_table,
              const std::unordered_set<DS_ID> &deps);
 
+  const std::vector<int> *get_ds_stages(DS_ID ds_id) const;
+  int get_soonest_available_stage(const std::unordered_set<DS_ID> &deps) const;
+  std::vector<PlacementRequest> get_requests() const;
+
   bool is_already_placed(DS_ID ds_id) const;
   bool is_self_dependent(DS_ID ds_id,
                          const std::unordered_set<DS_ID> &deps) const;
@@ -75,7 +123,26 @@ private:
                                   const std::unordered_set<DS_ID> &deps,
                                   std::vector<placement_t> &placements) const;
 
-  void concretize_placement(Stage *stage, const placement_t &placement);
+  void concretize_placement(const placement_t &placement);
+  void add_request(const PlacementRequest &request);
+
+  PlacementRequest build_request(const Table *table,
+                                 const std::unordered_set<DS_ID> &deps) const;
+  PlacementRequest build_request(const Register *reg,
+                                 const std::unordered_set<DS_ID> &deps) const;
+
+  // When the greedy placement fails, the whole placement is solved again
+  // (along with the new request) with the ExactPlacer. Speculation asks the
+  // same questions over and over, so the outcomes are cached. Two different
+  // placements colliding on the same key would share an answer; the key
+  // covers every request served so far to make that unlikely.
+  size_t exact_cache_key(const PlacementRequest &request) const;
+  PlacementStatus try_exact_placement(PlacementStatus greedy_status,
+                                      const PlacementRequest &request) const;
+  PlacementStatus solve_exact(const PlacementRequest &request,
+                              std::vector<Stage> &solution_stages,
+                              ds_stages_t &solution_ds_stages) const;
+  PlacementStatus place_exact(const PlacementRequest &request);
 };
 
 } // namespace tofino
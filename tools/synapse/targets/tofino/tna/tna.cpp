@@ -1,4 +1,5 @@
 #include "tna.h"
+#include "../../../util.h"
 
 namespace synapse {
 namespace tofino {
@@ -65,12 +66,15 @@ static TNAProperties properties_from_version(TNAVersion version) {
   return properties;
 }
 
-TNA::TNA(TNAVersion version, int avg_pkt_bytes)
+TNA::TNA(TNAVersion version, PipeStatePolicy pipe_state_policy,
+         int avg_pkt_bytes)
     : version(version), properties(properties_from_version(version)),
-      simple_placer(&properties), perf_oracle(&properties, avg_pkt_bytes) {}
+      pipe_state_policy(pipe_state_policy), simple_placer(&properties),
+      perf_oracle(&properties, avg_pkt_bytes) {}
 
 TNA::TNA(const TNA &other)
     : version(other.version), properties(other.properties),
+      pipe_state_policy(other.pipe_state_policy),
       simple_placer(other.simple_placer), perf_oracle(other.perf_oracle),
       parser(other.parser) {}
 
@@ -142,5 +146,11 @@ void TNA::log_debug_perf_oracle() const { perf_oracle.log_debug(); }
 const PerfOracle &TNA::get_perf_oracle() const { return perf_oracle; }
 PerfOracle &TNA::get_mutable_perf_oracle() { return perf_oracle; }
 
+size_t TNA::hash() const {
+  size_t seed = simple_placer.hash();
+  hash_combine(seed, perf_oracle.hash());
+  return seed;
+}
+
 } // namespace tofino
 } // namespace synapse
\ No newline at end of file
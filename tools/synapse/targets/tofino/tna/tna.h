@@ -11,6 +11,13 @@ namespace tofino {
 
 enum class TNAVersion { TNA1, TNA2 };
 
+// Each pipe has its own stages, so state written by the data plane on one
+// pipe is not visible to packets going through the others. That state can
+// either be replicated on every pipe (which is only correct if flows always
+// enter through the same pipe), or kept on a single pipe, to which the
+// packets entering the other ones are steered.
+enum class PipeStatePolicy { REPLICATE, STEER };
+
 struct TNAProperties {
   uint64_t port_capacity_bps;
   int total_ports;
@@ -40,6 +47,7 @@ class TNA {
 private:
   const TNAVersion version;
   const TNAProperties properties;
+  const PipeStatePolicy pipe_state_policy;
 
   SimplePlacer simple_placer;
   PerfOracle perf_oracle;
@@ -47,11 +55,13 @@ private:
 public:
   Parser parser;
 
-  TNA(TNAVersion version, int avg_pkt_bytes);
+  TNA(TNAVersion version, PipeStatePolicy pipe_state_policy,
+      int avg_pkt_bytes);
   TNA(const TNA &other);
 
   TNAVersion get_version() const { return version; }
   const TNAProperties &get_properties() const { return properties; }
+  PipeStatePolicy get_pipe_state_policy() const { return pipe_state_policy; }
 
   // Tofino compiler complains if we access more than 4 bytes of the packet on
   // the same if statement.
@@ -72,6 +82,8 @@ public:
 
   const PerfOracle &get_perf_oracle() const;
   PerfOracle &get_mutable_perf_oracle();
+
+  size_t hash() const;
 };
 
 } // namespace tofino
@@ -31,7 +31,8 @@ namespace synapse {
 namespace tofino {
 
 struct TofinoTarget : public Target {
-  TofinoTarget(TNAVersion version, const Profiler *profiler)
+  TofinoTarget(TNAVersion version, PipeStatePolicy pipe_state_policy,
+               const Profiler *profiler)
       : Target(TargetType::Tofino,
                {
                    new SendToControllerGenerator(),
@@ -56,7 +57,7 @@ struct TofinoTarget : public Target {
                    new FCFSCachedTableWriteGenerator(),
                    new FCFSCachedTableDeleteGenerator(),
                },
-               new TofinoContext(version, profiler)) {}
+               new TofinoContext(version, pipe_state_policy, profiler)) {}
 };
 
 } // namespace tofino
@@ -5,20 +5,27 @@
 #include "../module.h"
 
 #include "../../visualizers/ep_visualizer.h"
+#include "../../instrumentation.h"
 
 #include <algorithm>
 
 namespace synapse {
 namespace tofino {
 
-TofinoContext::TofinoContext(TNAVersion _version, const Profiler *profiler)
-    : tna(_version, profiler->get_avg_pkt_bytes()) {}
+TofinoContext::TofinoContext(TNAVersion _version,
+                             PipeStatePolicy _pipe_state_policy,
+                             const Profiler *profiler)
+    : tna(_version, _pipe_state_policy, profiler->get_avg_pkt_bytes()) {}
 
-TofinoContext::TofinoContext(const TofinoContext &other) : tna(other.tna) {
+// Data structures shared by multiple objects (e.g. the ones of a coalesced
+// map) are cloned only once.
+TofinoContext::TofinoContext(const TofinoContext &other)
+    : tna(other.tna), steering_nodes(other.steering_nodes) {
   for (const auto &kv : other.obj_to_ds) {
     std::vector<DS *> new_ds;
     for (const auto &ds : kv.second) {
-      DS *clone = ds->clone();
+      auto found_it = id_to_ds.find(ds->id);
+      DS *clone = found_it != id_to_ds.end() ? found_it->second : ds->clone();
       new_ds.push_back(clone);
       id_to_ds[clone->id] = clone;
     }
@@ -27,11 +34,8 @@ TofinoContext::TofinoContext(const TofinoContext &other) : tna(other.tna) {
 }
 
 TofinoContext::~TofinoContext() {
-  for (auto &kv : obj_to_ds) {
-    for (auto &ds : kv.second) {
-      delete ds;
-    }
-    kv.second.clear();
+  for (auto &kv : id_to_ds) {
+    delete kv.second;
   }
   obj_to_ds.clear();
   id_to_ds.clear();
@@ -48,7 +52,8 @@ const std::vector<DS *> &TofinoContext::get_ds(addr_t addr) const {
 }
 
 void TofinoContext::save_ds(addr_t addr, DS *ds) {
-  assert(id_to_ds.find(ds->id) == id_to_ds.end() &&
+  auto found_it = id_to_ds.find(ds->id);
+  assert((found_it == id_to_ds.end() || found_it->second == ds) &&
          "Duplicate data structure ID");
   obj_to_ds[addr].push_back(ds);
   id_to_ds[ds->id] = ds;
@@ -175,8 +180,11 @@ static const EPNode *get_ep_node_from_bdd_node(const EP *ep,
   std::vector<EPLeaf> leaves = ep->get_leaves();
   std::vector<const EPNode *> ep_nodes;
 
+  // The leaf of an EP with no modules yet has no node.
   for (const EPLeaf &leaf : leaves) {
-    ep_nodes.push_back(leaf.node);
+    if (leaf.node) {
+      ep_nodes.push_back(leaf.node);
+    }
   }
 
   while (!ep_nodes.empty()) {
@@ -255,6 +263,7 @@ TofinoContext::get_stateful_deps(const EP *ep, const bdd::Node *node) const {
 
 void TofinoContext::place(EP *ep, addr_t obj, DS *ds,
                           const std::unordered_set<DS_ID> &deps) {
+  InstrumentationScope scope("placement");
   save_ds(obj, ds);
   tna.place(ds, deps);
 }
@@ -262,6 +271,7 @@ void TofinoContext::place(EP *ep, addr_t obj, DS *ds,
 void TofinoContext::place_many(EP *ep, addr_t obj,
                                const std::vector<std::unordered_set<DS *>> &ds,
                                const std::unordered_set<DS_ID> &_deps) {
+  InstrumentationScope scope("placement");
   std::unordered_set<DS_ID> deps = _deps;
 
   for (const std::unordered_set<DS *> &ds_list : ds) {
@@ -275,6 +285,7 @@ void TofinoContext::place_many(EP *ep, addr_t obj,
 
 bool TofinoContext::check_placement(
     const EP *ep, const DS *ds, const std::unordered_set<DS_ID> &deps) const {
+  InstrumentationScope scope("placement");
   PlacementStatus status = tna.can_place(ds, deps);
 
   if (status != PlacementStatus::SUCCESS) {
@@ -289,6 +300,7 @@ bool TofinoContext::check_placement(
 bool TofinoContext::check_many_placements(
     const EP *ep, const std::vector<std::unordered_set<DS *>> &ds,
     const std::unordered_set<DS_ID> &deps) const {
+  InstrumentationScope scope("placement");
   PlacementStatus status = tna.can_place_many(ds, deps);
 
   if (status != PlacementStatus::SUCCESS) {
@@ -317,10 +329,52 @@ void TofinoContext::add_recirculated_traffic(
                                   prev_recirc_port);
 }
 
-uint64_t TofinoContext::estimate_throughput_pps() const {
+void TofinoContext::add_steered_traffic(const bdd::Node *node,
+                                        double fraction) {
+  PerfOracle &oracle = tna.get_mutable_perf_oracle();
+  oracle.add_steered_traffic(fraction);
+  steering_nodes.insert(node->get_id());
+}
+
+bool TofinoContext::is_steered(const bdd::Node *node) const {
+  while (node) {
+    if (steering_nodes.find(node->get_id()) != steering_nodes.end()) {
+      return true;
+    }
+    node = node->get_prev();
+  }
+
+  return false;
+}
+
+uint64_t
+TofinoContext::estimate_throughput_pps(double traffic_fraction) const {
+  // The oracle already accounts for the traffic that leaves the pipeline.
+  const PerfOracle &oracle = tna.get_perf_oracle();
+  return oracle.estimate_throughput_pps();
+}
+
+uint64_t TofinoContext::bound_throughput_pps() const {
+  // The oracle never raises its estimate as more traffic is recirculated or
+  // steered, nor does it depend on the traffic fraction.
   const PerfOracle &oracle = tna.get_perf_oracle();
   return oracle.estimate_throughput_pps();
 }
 
+size_t TofinoContext::hash() const {
+  std::vector<DS_ID> ids;
+  for (const auto &[id, ds] : id_to_ds) {
+    ids.push_back(id);
+  }
+  std::sort(ids.begin(), ids.end());
+
+  size_t seed = tna.hash();
+  for (const DS_ID &id : ids) {
+    hash_combine(seed, std::hash<DS_ID>{}(id));
+  }
+
+  return seed;
+}
+
 } // namespace tofino
 } // namespace synapse
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "data_structures/data_structures.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <optional>
 
 namespace synapse {
@@ -16,8 +17,12 @@ private:
   std::unordered_map<addr_t, std::vector<DS *>> obj_to_ds;
   std::unordered_map<DS_ID, DS *> id_to_ds;
 
+  // BDD nodes whose traffic was steered to the pipe holding the state.
+  std::unordered_set<bdd::node_id_t> steering_nodes;
+
 public:
-  TofinoContext(TNAVersion version, const Profiler *profiler);
+  TofinoContext(TNAVersion version, PipeStatePolicy pipe_state_policy,
+                const Profiler *profiler);
   TofinoContext(const TofinoContext &other);
 
   ~TofinoContext();
@@ -26,7 +31,12 @@ public:
     return new TofinoContext(*this);
   }
 
-  virtual uint64_t estimate_throughput_pps() const override;
+  virtual uint64_t
+  estimate_throughput_pps(double traffic_fraction) const override;
+
+  virtual uint64_t bound_throughput_pps() const override;
+
+  virtual size_t hash() const override;
 
   const TNA &get_tna() const { return tna; }
   TNA &get_mutable_tna() { return tna; }
@@ -39,6 +49,10 @@ public:
   void add_recirculated_traffic(int port, int port_recirculations,
                                 double fraction,
                                 std::optional<int> prev_recirc_port);
+  void add_steered_traffic(const bdd::Node *node, double fraction);
+
+  // If the traffic reaching the node was already steered on its way there.
+  bool is_steered(const bdd::Node *node) const;
 
   void parser_transition(const EP *ep, const bdd::Node *node,
                          klee::ref<klee::Expr> hdr);
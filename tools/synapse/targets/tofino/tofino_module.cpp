@@ -3,6 +3,79 @@
 namespace synapse {
 namespace tofino {
 
+size_t TofinoModule::hash() const {
+  std::unordered_set<DS_ID> generated_ds = get_generated_ds();
+  std::vector<DS_ID> ids(generated_ds.begin(), generated_ds.end());
+  std::sort(ids.begin(), ids.end());
+
+  size_t seed = Module::hash();
+  for (const DS_ID &id : ids) {
+    hash_combine(seed, std::hash<DS_ID>{}(id));
+  }
+
+  return seed;
+}
+
+static bool is_pipe_local_state(const Module *module) {
+  switch (module->get_type()) {
+  case ModuleType::Tofino_VectorRegisterLookup:
+  case ModuleType::Tofino_VectorRegisterUpdate:
+  case ModuleType::Tofino_FCFSCachedTableRead:
+  case ModuleType::Tofino_FCFSCachedTableReadOrWrite:
+  case ModuleType::Tofino_FCFSCachedTableWrite:
+  case ModuleType::Tofino_FCFSCachedTableDelete:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Traffic that already went through stateful modules was steered by them,
+// be they placed or only speculated.
+static bool is_steered(const EP *ep, const bdd::Node *node,
+                       const TofinoContext *tofino_ctx) {
+  for (const EPNode *prev : ep->get_prev_nodes()) {
+    if (is_pipe_local_state(prev->get_module())) {
+      return true;
+    }
+  }
+
+  return tofino_ctx->is_steered(node);
+}
+
+void TofinoModuleGenerator::steer_to_state_pipe(const EP *ep,
+                                                const bdd::Node *node,
+                                                EP *new_ep) const {
+  TofinoContext *tofino_ctx = get_mutable_tofino_ctx(new_ep);
+  const TNA &tna = tofino_ctx->get_tna();
+
+  if (tna.get_pipe_state_policy() != PipeStatePolicy::STEER ||
+      is_steered(ep, node, tofino_ctx)) {
+    return;
+  }
+
+  tofino_ctx->add_steered_traffic(node, ep->get_active_leaf_hit_rate());
+}
+
+void TofinoModuleGenerator::steer_to_state_pipe(const EP *ep,
+                                                const bdd::Node *node,
+                                                Context &ctx) const {
+  TofinoContext *tofino_ctx = ctx.get_mutable_target_ctx<TofinoContext>();
+  const TNA &tna = tofino_ctx->get_tna();
+
+  if (tna.get_pipe_state_policy() != PipeStatePolicy::STEER ||
+      is_steered(ep, node, tofino_ctx)) {
+    return;
+  }
+
+  constraints_t constraints = node->get_ordered_branch_constraints();
+  const Profiler *profiler = ctx.get_profiler();
+  std::optional<double> fraction = profiler->get_fraction(constraints);
+  assert(fraction.has_value());
+
+  tofino_ctx->add_steered_traffic(node, *fraction);
+}
+
 std::unordered_set<DS *> TofinoModuleGenerator::build_vector_registers(
     const EP *ep, const bdd::Node *node, const vector_register_data_t &data,
     std::unordered_set<DS_ID> &rids, std::unordered_set<DS_ID> &deps) const {
@@ -134,14 +207,18 @@ static FCFSCachedTable *build_fcfs_cached_table(const EP *ep,
                                                 const bdd::Node *node,
                                                 klee::ref<klee::Expr> key,
                                                 int num_entries,
-                                                int cache_capacity) {
+                                                const cache_config_t &config) {
   const Context &ctx = ep->get_ctx();
   const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
   const TNA &tna = tofino_ctx->get_tna();
   const TNAProperties &properties = tna.get_properties();
 
   DS_ID id = "cached_table_" + std::to_string(node->get_id()) + "_" +
-             std::to_string(cache_capacity);
+             std::to_string(config.capacity);
+
+  if (config.policy != CachePolicy::FCFS) {
+    id += "_" + cache_policy_to_string(config.policy);
+  }
 
   std::vector<klee::ref<klee::Expr>> keys =
       Register::partition_value(properties, key);
@@ -150,8 +227,8 @@ static FCFSCachedTable *build_fcfs_cached_table(const EP *ep,
     keys_sizes.push_back(key->getWidth());
   }
 
-  FCFSCachedTable *cached_table = new FCFSCachedTable(
-      properties, id, cache_capacity, num_entries, keys_sizes);
+  FCFSCachedTable *cached_table =
+      new FCFSCachedTable(properties, id, config, num_entries, keys_sizes);
 
   std::unordered_set<DS_ID> deps = tofino_ctx->get_stateful_deps(ep, node);
   if (!tofino_ctx->check_placement(ep, cached_table, deps)) {
@@ -162,8 +239,10 @@ static FCFSCachedTable *build_fcfs_cached_table(const EP *ep,
   return cached_table;
 }
 
-static FCFSCachedTable *
-reuse_fcfs_cached_table(const EP *ep, const bdd::Node *node, addr_t obj) {
+static FCFSCachedTable *reuse_fcfs_cached_table(const EP *ep,
+                                                const bdd::Node *node,
+                                                addr_t obj,
+                                                const cache_config_t &config) {
   const Context &ctx = ep->get_ctx();
   const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
 
@@ -177,6 +256,12 @@ reuse_fcfs_cached_table(const EP *ep, const bdd::Node *node, addr_t obj) {
   assert(ds[0]->type == DSType::FCFS_CACHED_TABLE);
 
   FCFSCachedTable *cached_table = static_cast<FCFSCachedTable *>(ds[0]);
+
+  if (cached_table->policy != config.policy ||
+      cached_table->cache_capacity != config.capacity) {
+    return nullptr;
+  }
+
   cached_table->add_table();
 
   std::unordered_set<DS_ID> deps = tofino_ctx->get_stateful_deps(ep, node);
@@ -189,7 +274,7 @@ reuse_fcfs_cached_table(const EP *ep, const bdd::Node *node, addr_t obj) {
 
 FCFSCachedTable *TofinoModuleGenerator::build_or_reuse_fcfs_cached_table(
     const EP *ep, const bdd::Node *node, addr_t obj, klee::ref<klee::Expr> key,
-    int num_entries, int cache_capacity) const {
+    int num_entries, const cache_config_t &config) const {
   FCFSCachedTable *cached_table = nullptr;
 
   const Context &ctx = ep->get_ctx();
@@ -197,14 +282,9 @@ FCFSCachedTable *TofinoModuleGenerator::build_or_reuse_fcfs_cached_table(
       ctx.check_placement(obj, PlacementDecision::Tofino_FCFSCachedTable);
 
   if (already_placed) {
-    cached_table = reuse_fcfs_cached_table(ep, node, obj);
-
-    if (!cached_table || cached_table->cache_capacity != cache_capacity) {
-      return nullptr;
-    }
+    cached_table = reuse_fcfs_cached_table(ep, node, obj, config);
   } else {
-    cached_table =
-        build_fcfs_cached_table(ep, node, key, num_entries, cache_capacity);
+    cached_table = build_fcfs_cached_table(ep, node, key, num_entries, config);
   }
 
   return cached_table;
@@ -236,7 +316,7 @@ FCFSCachedTable *TofinoModuleGenerator::get_fcfs_cached_table(
 
 bool TofinoModuleGenerator::can_get_or_build_fcfs_cached_table(
     const EP *ep, const bdd::Node *node, addr_t obj, klee::ref<klee::Expr> key,
-    int num_entries, int cache_capacity) const {
+    int num_entries, const cache_config_t &config) const {
   FCFSCachedTable *cached_table = nullptr;
 
   const Context &ctx = ep->get_ctx();
@@ -246,15 +326,11 @@ bool TofinoModuleGenerator::can_get_or_build_fcfs_cached_table(
   if (already_placed) {
     cached_table = get_fcfs_cached_table(ep, node, obj);
 
-    if (!cached_table || cached_table->cache_capacity != cache_capacity) {
-      return false;
-    }
-
-    return true;
+    return cached_table && cached_table->policy == config.policy &&
+           cached_table->cache_capacity == config.capacity;
   }
 
-  cached_table =
-      build_fcfs_cached_table(ep, node, key, num_entries, cache_capacity);
+  cached_table = build_fcfs_cached_table(ep, node, key, num_entries, config);
 
   if (!cached_table) {
     return false;
@@ -322,5 +398,73 @@ TofinoModuleGenerator::enumerate_fcfs_cache_table_capacities(
   return capacities;
 }
 
+std::vector<cache_config_t>
+TofinoModuleGenerator::enumerate_fcfs_cache_table_configs(
+    const EP *ep, addr_t obj, int num_entries) const {
+  const Context &ctx = ep->get_ctx();
+  const TofinoContext *tofino_ctx = ctx.get_target_ctx<TofinoContext>();
+
+  if (tofino_ctx->has_ds(obj)) {
+    const std::vector<DS *> &ds = tofino_ctx->get_ds(obj);
+
+    assert(ds.size() == 1);
+    assert(ds[0]->type == DSType::FCFS_CACHED_TABLE);
+
+    const FCFSCachedTable *cached_table =
+        static_cast<const FCFSCachedTable *>(ds[0]);
+    return {cached_table->get_config()};
+  }
+
+  std::vector<cache_config_t> configs;
+  for (int capacity : enumerate_fcfs_cache_table_capacities(num_entries)) {
+    configs.push_back({CachePolicy::FCFS, capacity, 0});
+  }
+
+  return configs;
+}
+
+std::vector<cache_config_t>
+TofinoModuleGenerator::enumerate_fcfs_cache_table_configs(
+    const EP *ep, const bdd::Node *map_op, klee::ref<klee::Expr> key,
+    int num_entries) const {
+  std::unordered_set<int> candidates =
+      enumerate_fcfs_cache_table_capacities(num_entries);
+
+  const Context &ctx = ep->get_ctx();
+  const Profiler *profiler = ctx.get_profiler();
+  constraints_t constraints = map_op->get_ordered_branch_constraints();
+
+  std::optional<FlowStats> flow_stats =
+      profiler->get_flow_stats(constraints, key);
+
+  // Without the flow sizes, there is nothing to tell the policies apart.
+  if (!flow_stats.has_value()) {
+    std::vector<cache_config_t> configs;
+    for (int capacity : candidates) {
+      configs.push_back({CachePolicy::FCFS, capacity, 0});
+    }
+    return configs;
+  }
+
+  bool churn = ctx.get_expiration_data().has_value();
+  FCFSCacheModel model(*flow_stats, churn);
+  std::vector<cache_config_t> configs = model.get_pareto_configs(candidates);
+
+  if (Log::is_debug_active()) {
+    Log::dbg() << "Cache configurations for node " << map_op->get_id()
+               << " (" << configs.size() << "/" << candidates.size()
+               << " capacities):\n";
+    for (const cache_config_t &config : configs) {
+      double hit_rate = model.get_hit_rate(config.policy, config.capacity);
+      Log::dbg() << "  policy=" << cache_policy_to_string(config.policy)
+                 << " capacity=" << config.capacity
+                 << " hit-rate=" << hit_rate << " controller=" << 1 - hit_rate
+                 << "\n";
+    }
+  }
+
+  return configs;
+}
+
 } // namespace tofino
-} // namespace synapse
\ No newline at end of file
+} // namespace synapse
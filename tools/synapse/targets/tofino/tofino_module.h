@@ -3,6 +3,7 @@
 #include "../module.h"
 #include "../module_generator.h"
 #include "tofino_context.h"
+#include "fcfs_cache_model.h"
 
 namespace synapse {
 namespace tofino {
@@ -18,6 +19,10 @@ public:
       : Module(_type, TargetType::Tofino, _next_type, _name, node) {}
 
   virtual std::unordered_set<DS_ID> get_generated_ds() const { return {}; }
+
+  // Data structure ids encode their configuration (e.g. the capacity and
+  // policy of cached tables).
+  virtual size_t hash() const override;
 };
 
 class TofinoModuleGenerator : public ModuleGenerator {
@@ -52,6 +57,15 @@ protected:
 
   symbols_t get_dataplane_state(const EP *ep, const bdd::Node *node) const;
 
+  // With the STEER pipe state policy, the first stateful module on a path
+  // sends the traffic coming from the other pipes to the pipe holding the
+  // state. Speculation must steer as well, or it would miss the cost of the
+  // cross pipe traffic.
+  void steer_to_state_pipe(const EP *ep, const bdd::Node *node,
+                           EP *new_ep) const;
+  void steer_to_state_pipe(const EP *ep, const bdd::Node *node,
+                           Context &ctx) const;
+
   struct vector_register_data_t {
     addr_t obj;
     int num_entries;
@@ -83,11 +97,12 @@ protected:
   FCFSCachedTable *
   build_or_reuse_fcfs_cached_table(const EP *ep, const bdd::Node *node,
                                    addr_t obj, klee::ref<klee::Expr> key,
-                                   int num_entries, int cache_capacity) const;
+                                   int num_entries,
+                                   const cache_config_t &config) const;
   bool can_get_or_build_fcfs_cached_table(const EP *ep, const bdd::Node *node,
                                           addr_t obj, klee::ref<klee::Expr> key,
                                           int num_entries,
-                                          int cache_capacity) const;
+                                          const cache_config_t &config) const;
   bool can_place_fcfs_cached_table(const EP *ep,
                                    const map_coalescing_objs_t &map_objs) const;
   void place_fcfs_cached_table(EP *ep, const bdd::Node *node,
@@ -95,6 +110,19 @@ protected:
                                FCFSCachedTable *ds) const;
   std::unordered_set<int>
   enumerate_fcfs_cache_table_capacities(int num_entries) const;
+
+  // The configuration of the cached table already placed for the object, or
+  // FCFS caches of every capacity if there is none yet.
+  std::vector<cache_config_t>
+  enumerate_fcfs_cache_table_configs(const EP *ep, addr_t obj,
+                                     int num_entries) const;
+
+  // Only the configurations worth trying under the flow size distribution
+  // seen by the map operation.
+  std::vector<cache_config_t>
+  enumerate_fcfs_cache_table_configs(const EP *ep, const bdd::Node *map_op,
+                                     klee::ref<klee::Expr> key,
+                                     int num_entries) const;
 };
 
 } // namespace tofino
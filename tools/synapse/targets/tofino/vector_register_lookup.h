@@ -79,6 +79,7 @@ protected:
         get_future_vector_return(ep, node, vector_register_data.obj);
 
     Context new_ctx = ctx;
+    steer_to_state_pipe(ep, node, new_ctx);
     speculation_t speculation(new_ctx);
 
     if (vector_return) {
@@ -132,6 +133,7 @@ protected:
 
     EP *new_ep = new EP(*ep);
     products.emplace_back(new_ep);
+    steer_to_state_pipe(ep, node, new_ep);
 
     const bdd::Node *new_next;
     bdd::BDD *bdd = delete_future_vector_return(
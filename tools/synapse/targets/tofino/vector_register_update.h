@@ -100,6 +100,7 @@ protected:
     }
 
     Context new_ctx = ctx;
+    steer_to_state_pipe(ep, node, new_ctx);
     speculation_t speculation(new_ctx);
     speculation.skip.insert(vector_return->get_id());
 
@@ -162,6 +163,7 @@ protected:
 
     EP *new_ep = new EP(*ep);
     products.emplace_back(new_ep);
+    steer_to_state_pipe(ep, node, new_ep);
 
     const bdd::Node *new_next;
     bdd::BDD *bdd =
@@ -18,7 +18,7 @@ public:
                          klee::ref<klee::Expr> _index_out,
                          const symbol_t &_out_of_space)
       : TofinoCPUModule(ModuleType::TofinoCPU_DchainAllocateNewIndex,
-                        "DchainAllocate", node),
+                        "DchainAllocateNewIndex", node),
         dchain_addr(_dchain_addr), time(_time), index_out(_index_out),
         out_of_space(_out_of_space) {}
 
@@ -26,7 +26,7 @@ public:
                          klee::ref<klee::Expr> _time,
                          klee::ref<klee::Expr> _index_out)
       : TofinoCPUModule(ModuleType::TofinoCPU_DchainAllocateNewIndex,
-                        "DchainAllocate", node),
+                        "DchainAllocateNewIndex", node),
         dchain_addr(_dchain_addr), time(_time), index_out(_index_out),
         out_of_space(std::nullopt) {}
 
@@ -16,7 +16,7 @@ public:
                         klee::ref<klee::Expr> _index,
                         klee::ref<klee::Expr> _time)
       : TofinoCPUModule(ModuleType::TofinoCPU_DchainRejuvenateIndex,
-                        "DchainRejuvenate", node),
+                        "DchainRejuvenateIndex", node),
         dchain_addr(_dchain_addr), index(_index), time(_time) {}
 
   virtual void visit(EPVisitor &visitor, const EP *ep,
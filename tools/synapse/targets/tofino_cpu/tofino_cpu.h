@@ -43,7 +43,7 @@ namespace synapse {
 namespace tofino_cpu {
 
 struct TofinoCPUTarget : public Target {
-  TofinoCPUTarget()
+  TofinoCPUTarget(const cpu_perf_params_t &params)
       : Target(TargetType::TofinoCPU,
                {
                    new IgnoreGenerator(),
@@ -81,7 +81,7 @@ struct TofinoCPUTarget : public Target {
                    new FCFSCachedTableWriteGenerator(),
                    new FCFSCachedTableDeleteGenerator(),
                },
-               new TofinoCPUContext()) {}
+               new TofinoCPUContext(params)) {}
 };
 
 } // namespace tofino_cpu
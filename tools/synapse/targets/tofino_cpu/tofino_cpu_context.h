@@ -1,24 +1,35 @@
 #pragma once
 
 #include "../context.h"
+#include "../cpu_perf_model.h"
 
 namespace synapse {
 namespace tofino_cpu {
 
 class TofinoCPUContext : public TargetContext {
 private:
-  uint64_t capacity_pps;
+  CPUPerfModel perf_model;
 
 public:
-  TofinoCPUContext() : capacity_pps(100'000) {}
+  TofinoCPUContext(const cpu_perf_params_t &params) : perf_model(params) {}
 
   virtual TargetContext *clone() const override {
     return new TofinoCPUContext(*this);
   }
 
-  virtual uint64_t estimate_throughput_pps() const override {
-    return capacity_pps;
+  virtual uint64_t
+  estimate_throughput_pps(double traffic_fraction) const override {
+    return perf_model.estimate_throughput_pps(traffic_fraction);
   }
+
+  virtual uint64_t bound_throughput_pps() const override {
+    return perf_model.bound_throughput_pps();
+  }
+
+  virtual size_t hash() const override { return perf_model.hash(); }
+
+  const CPUPerfModel &get_perf_model() const { return perf_model; }
+  CPUPerfModel &get_mutable_perf_model() { return perf_model; }
 };
 
 } // namespace tofino_cpu
@@ -14,7 +14,7 @@ private:
 public:
   ChecksumUpdate(const bdd::Node *node, addr_t _ip_hdr_addr,
                  addr_t _l4_hdr_addr, symbol_t _checksum)
-      : x86Module(ModuleType::x86_ChecksumUpdate, "SetIpChecksum", node),
+      : x86Module(ModuleType::x86_ChecksumUpdate, "ChecksumUpdate", node),
         ip_hdr_addr(_ip_hdr_addr), l4_hdr_addr(_l4_hdr_addr),
         checksum(_checksum) {}
 
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "x86_module.h"
+
+namespace synapse {
+namespace x86 {
+
+// A map_get fused with the operations on the coalesced objects of the map
+// that use the index it finds: the rejuvenation of that index, and the reads
+// from the vectors it indexes. They only happen if the key is found.
+class CoalescedMapGet : public x86Module {
+private:
+  addr_t map_addr;
+  addr_t key_addr;
+  klee::ref<klee::Expr> key;
+  klee::ref<klee::Expr> value_out;
+  klee::ref<klee::Expr> success;
+  symbol_t map_has_this_key;
+  std::optional<addr_t> dchain_addr;
+  klee::ref<klee::Expr> time;
+  std::vector<coalesced_vector_read_t> vector_reads;
+
+public:
+  CoalescedMapGet(const bdd::Node *node, addr_t _map_addr, addr_t _key_addr,
+                  klee::ref<klee::Expr> _key, klee::ref<klee::Expr> _value_out,
+                  klee::ref<klee::Expr> _success,
+                  const symbol_t &_map_has_this_key,
+                  std::optional<addr_t> _dchain_addr,
+                  klee::ref<klee::Expr> _time,
+                  const std::vector<coalesced_vector_read_t> &_vector_reads)
+      : x86Module(ModuleType::x86_CoalescedMapGet, "CoalescedMapGet", node),
+        map_addr(_map_addr), key_addr(_key_addr), key(_key),
+        value_out(_value_out), success(_success),
+        map_has_this_key(_map_has_this_key), dchain_addr(_dchain_addr),
+        time(_time), vector_reads(_vector_reads) {}
+
+  virtual void visit(EPVisitor &visitor, const EP *ep,
+                     const EPNode *ep_node) const override {
+    visitor.visit(ep, ep_node, this);
+  }
+
+  virtual Module *clone() const override {
+    Module *cloned =
+        new CoalescedMapGet(node, map_addr, key_addr, key, value_out, success,
+                            map_has_this_key, dchain_addr, time, vector_reads);
+    return cloned;
+  }
+
+  addr_t get_map_addr() const { return map_addr; }
+  addr_t get_key_addr() const { return key_addr; }
+  klee::ref<klee::Expr> get_key() const { return key; }
+  klee::ref<klee::Expr> get_value_out() const { return value_out; }
+  klee::ref<klee::Expr> get_success() const { return success; }
+  const symbol_t &get_map_has_this_key() const { return map_has_this_key; }
+  std::optional<addr_t> get_dchain_addr() const { return dchain_addr; }
+  klee::ref<klee::Expr> get_time() const { return time; }
+
+  const std::vector<coalesced_vector_read_t> &get_vector_reads() const {
+    return vector_reads;
+  }
+};
+
+class CoalescedMapGetGenerator : public x86ModuleGenerator {
+public:
+  CoalescedMapGetGenerator()
+      : x86ModuleGenerator(ModuleType::x86_CoalescedMapGet,
+                           "CoalescedMapGet") {}
+
+protected:
+  bool bdd_node_match_pattern(const bdd::Node *node) const {
+    if (node->get_type() != bdd::NodeType::CALL) {
+      return false;
+    }
+
+    const bdd::Call *call_node = static_cast<const bdd::Call *>(node);
+    const call_t &call = call_node->get_call();
+
+    if (call.function_name != "map_get") {
+      return false;
+    }
+
+    return true;
+  }
+
+  virtual std::optional<speculation_t>
+  speculate(const EP *ep, const bdd::Node *node,
+            const Context &ctx) const override {
+    if (!bdd_node_match_pattern(node)) {
+      return std::nullopt;
+    }
+
+    const bdd::Call *call_node = static_cast<const bdd::Call *>(node);
+
+    coalesced_map_ops_t ops;
+    if (!get_coalesced_ops(ep, call_node, ops)) {
+      return std::nullopt;
+    }
+
+    speculation_t speculation(ctx);
+
+    std::optional<addr_t> dchain_addr;
+    std::vector<coalesced_vector_read_t> vector_reads;
+    get_coalesced_objs(ops, dchain_addr, vector_reads);
+
+    constraints_t constraints = node->get_ordered_branch_constraints();
+    speculation.ctx.add_coalesced_map_get_cost(TargetType::x86, dchain_addr,
+                                               vector_reads, constraints);
+
+    if (ops.dchain_rejuvenation.has_value()) {
+      speculation.skip.insert((*ops.dchain_rejuvenation)->get_id());
+    }
+
+    for (const bdd::Call *vector_read : ops.vector_reads) {
+      speculation.skip.insert(vector_read->get_id());
+    }
+
+    for (const bdd::Call *vector_return : ops.vector_returns) {
+      speculation.skip.insert(vector_return->get_id());
+    }
+
+    return speculation;
+  }
+
+  virtual std::vector<__generator_product_t>
+  process_node(const EP *ep, const bdd::Node *node) const override {
+    std::vector<__generator_product_t> products;
+
+    if (!bdd_node_match_pattern(node)) {
+      return products;
+    }
+
+    const bdd::Call *call_node = static_cast<const bdd::Call *>(node);
+    const call_t &call = call_node->get_call();
+
+    coalesced_map_ops_t ops;
+    if (!get_coalesced_ops(ep, call_node, ops)) {
+      return products;
+    }
+
+    klee::ref<klee::Expr> map_addr_expr = call.args.at("map").expr;
+    klee::ref<klee::Expr> key_addr_expr = call.args.at("key").expr;
+    klee::ref<klee::Expr> key = call.args.at("key").in;
+    klee::ref<klee::Expr> success = call.ret;
+    klee::ref<klee::Expr> value_out = call.args.at("value_out").out;
+
+    symbols_t symbols = call_node->get_locally_generated_symbols();
+
+    symbol_t map_has_this_key;
+    bool found = get_symbol(symbols, "map_has_this_key", map_has_this_key);
+    assert(found && "Symbol map_has_this_key not found");
+
+    addr_t map_addr = kutil::expr_addr_to_obj_addr(map_addr_expr);
+    addr_t key_addr = kutil::expr_addr_to_obj_addr(key_addr_expr);
+
+    std::optional<addr_t> dchain_addr;
+    std::vector<coalesced_vector_read_t> vector_reads;
+    get_coalesced_objs(ops, dchain_addr, vector_reads);
+
+    klee::ref<klee::Expr> time;
+    if (ops.dchain_rejuvenation.has_value()) {
+      const call_t &rejuvenation = (*ops.dchain_rejuvenation)->get_call();
+      time = rejuvenation.args.at("time").expr;
+    }
+
+    Module *module =
+        new CoalescedMapGet(node, map_addr, key_addr, key, value_out, success,
+                            map_has_this_key, dchain_addr, time, vector_reads);
+    EPNode *ep_node = new EPNode(module);
+
+    EP *new_ep = new EP(*ep);
+    products.emplace_back(new_ep);
+
+    const bdd::Node *new_next;
+    bdd::BDD *new_bdd = delete_coalesced_map_ops(new_ep, node, ops, new_next);
+
+    place(new_ep, map_addr, PlacementDecision::x86_Map);
+
+    if (dchain_addr.has_value()) {
+      place(new_ep, *dchain_addr, PlacementDecision::x86_Dchain);
+    }
+
+    for (const coalesced_vector_read_t &vector_read : vector_reads) {
+      place(new_ep, vector_read.vector_addr, PlacementDecision::x86_Vector);
+    }
+
+    EPLeaf leaf(ep_node, new_next);
+    new_ep->process_leaf(ep_node, {leaf});
+    new_ep->replace_bdd(new_bdd);
+
+    return products;
+  }
+
+private:
+  void
+  get_coalesced_objs(const coalesced_map_ops_t &ops,
+                     std::optional<addr_t> &dchain_addr,
+                     std::vector<coalesced_vector_read_t> &vector_reads) const {
+    if (ops.dchain_rejuvenation.has_value()) {
+      const call_t &rejuvenation = (*ops.dchain_rejuvenation)->get_call();
+      dchain_addr =
+          kutil::expr_addr_to_obj_addr(rejuvenation.args.at("chain").expr);
+    }
+
+    for (const bdd::Call *vector_read : ops.vector_reads) {
+      const call_t &call = vector_read->get_call();
+
+      klee::ref<klee::Expr> vector_addr_expr = call.args.at("vector").expr;
+      klee::ref<klee::Expr> value_addr_expr = call.args.at("val_out").out;
+
+      vector_reads.push_back({
+          kutil::expr_addr_to_obj_addr(vector_addr_expr),
+          kutil::expr_addr_to_obj_addr(value_addr_expr),
+          call.extra_vars.at("borrowed_cell").second,
+      });
+    }
+  }
+
+  bool get_coalesced_ops(const EP *ep, const bdd::Call *map_get,
+                         coalesced_map_ops_t &ops) const {
+    if (!can_place(ep, map_get, "map", PlacementDecision::x86_Map)) {
+      return false;
+    }
+
+    map_coalescing_objs_t map_objs;
+    if (!get_map_coalescing_objs_from_map_op(ep, map_get, map_objs)) {
+      return false;
+    }
+
+    ops = get_coalesced_map_ops(map_get, map_objs);
+
+    if (ops.empty()) {
+      return false;
+    }
+
+    const Context &ctx = ep->get_ctx();
+
+    if (ops.dchain_rejuvenation.has_value() &&
+        !ctx.can_place(map_objs.dchain, PlacementDecision::x86_Dchain)) {
+      return false;
+    }
+
+    for (const bdd::Call *vector_read : ops.vector_reads) {
+      const call_t &call = vector_read->get_call();
+      addr_t vector = kutil::expr_addr_to_obj_addr(call.args.at("vector").expr);
+
+      if (!ctx.can_place(vector, PlacementDecision::x86_Vector)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+} // namespace x86
+} // namespace synapse
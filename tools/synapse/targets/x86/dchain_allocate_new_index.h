@@ -17,16 +17,16 @@ public:
                          klee::ref<klee::Expr> _time,
                          klee::ref<klee::Expr> _index_out,
                          const symbol_t &_out_of_space)
-      : x86Module(ModuleType::x86_DchainAllocateNewIndex, "DchainAllocate",
-                  node),
+      : x86Module(ModuleType::x86_DchainAllocateNewIndex,
+                  "DchainAllocateNewIndex", node),
         dchain_addr(_dchain_addr), time(_time), index_out(_index_out),
         out_of_space(_out_of_space) {}
 
   DchainAllocateNewIndex(const bdd::Node *node, addr_t _dchain_addr,
                          klee::ref<klee::Expr> _time,
                          klee::ref<klee::Expr> _index_out)
-      : x86Module(ModuleType::x86_DchainAllocateNewIndex, "DchainAllocate",
-                  node),
+      : x86Module(ModuleType::x86_DchainAllocateNewIndex,
+                  "DchainAllocateNewIndex", node),
         dchain_addr(_dchain_addr), time(_time), index_out(_index_out),
         out_of_space(std::nullopt) {}
 
@@ -15,8 +15,8 @@ public:
   DchainRejuvenateIndex(const bdd::Node *node, addr_t _dchain_addr,
                         klee::ref<klee::Expr> _index,
                         klee::ref<klee::Expr> _time)
-      : x86Module(ModuleType::x86_DchainRejuvenateIndex, "DchainRejuvenate",
-                  node),
+      : x86Module(ModuleType::x86_DchainRejuvenateIndex,
+                  "DchainRejuvenateIndex", node),
         dchain_addr(_dchain_addr), index(_index), time(_time) {}
 
   virtual void visit(EPVisitor &visitor, const EP *ep,
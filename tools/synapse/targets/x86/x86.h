@@ -17,6 +17,7 @@
 #include "map_get.h"
 #include "map_put.h"
 #include "map_erase.h"
+#include "coalesced_map_get.h"
 #include "vector_read.h"
 #include "vector_write.h"
 #include "dchain_allocate_new_index.h"
@@ -37,7 +38,7 @@ namespace synapse {
 namespace x86 {
 
 struct x86Target : public Target {
-  x86Target()
+  x86Target(const cpu_perf_params_t &params)
       : Target(TargetType::x86,
                {
                    new IgnoreGenerator(),
@@ -55,6 +56,7 @@ struct x86Target : public Target {
                    new MapGetGenerator(),
                    new MapPutGenerator(),
                    new MapEraseGenerator(),
+                   new CoalescedMapGetGenerator(),
                    new VectorReadGenerator(),
                    new VectorWriteGenerator(),
                    new DchainRejuvenateIndexGenerator(),
@@ -69,7 +71,7 @@ struct x86Target : public Target {
                    new HashObjGenerator(),
                    new ChtFindBackendGenerator(),
                },
-               new x86Context()) {}
+               new x86Context(params)) {}
 };
 
 } // namespace x86
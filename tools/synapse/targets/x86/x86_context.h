@@ -2,24 +2,35 @@
 
 #include "data_structures/data_structures.h"
 #include "../context.h"
+#include "../cpu_perf_model.h"
 
 namespace synapse {
 namespace x86 {
 
 class x86Context : public TargetContext {
 private:
-  uint64_t capacity_pps;
+  CPUPerfModel perf_model;
 
 public:
-  x86Context() : capacity_pps(120'000'000) {}
+  x86Context(const cpu_perf_params_t &params) : perf_model(params) {}
 
   virtual TargetContext *clone() const override {
     return new x86Context(*this);
   }
 
-  virtual uint64_t estimate_throughput_pps() const override {
-    return capacity_pps;
+  virtual uint64_t
+  estimate_throughput_pps(double traffic_fraction) const override {
+    return perf_model.estimate_throughput_pps(traffic_fraction);
   }
+
+  virtual uint64_t bound_throughput_pps() const override {
+    return perf_model.bound_throughput_pps();
+  }
+
+  virtual size_t hash() const override { return perf_model.hash(); }
+
+  const CPUPerfModel &get_perf_model() const { return perf_model; }
+  CPUPerfModel &get_mutable_perf_model() { return perf_model; }
 };
 
 } // namespace x86
@@ -1381,6 +1381,8 @@ void add_non_branch_nodes_to_bdd(
     anchor = clone;
   }
 
+  bdd->update_index(new_current);
+
   // bdd->inspect();
 }
 
@@ -1388,7 +1390,8 @@ static bdd::Branch *create_new_branch(bdd::BDD *bdd, const bdd::Node *current,
                                       klee::ref<klee::Expr> condition) {
   bdd::node_id_t &id = bdd->get_mutable_id();
   bdd::NodeManager &manager = bdd->get_mutable_manager();
-  klee::ConstraintManager constraints = current->get_constraints();
+  const bdd::SharedConstraints &constraints =
+      current->get_shared_constraints();
   bdd::Branch *new_branch = new bdd::Branch(id++, constraints, condition);
   manager.add_node(new_branch);
   return new_branch;
@@ -1449,6 +1452,8 @@ void add_branch_to_bdd(const EP *ep, bdd::BDD *bdd, const bdd::Node *current,
 
   new_branch->set_prev(anchor);
 
+  bdd->update_index(new_branch);
+
   // bdd->inspect();
 }
 
@@ -1466,6 +1471,8 @@ void delete_non_branch_node_from_bdd(const EP *ep, bdd::BDD *bdd,
 
   new_current = anchor_next->get_mutable_next();
 
+  bdd->remove_from_index(anchor_next);
+
   switch (anchor->get_type()) {
   case bdd::NodeType::CALL:
   case bdd::NodeType::ROUTE: {
@@ -1491,6 +1498,8 @@ void delete_non_branch_node_from_bdd(const EP *ep, bdd::BDD *bdd,
   new_current->set_prev(anchor);
   manager.free_node(anchor_next);
 
+  bdd->update_index(new_current);
+
   // bdd->inspect();
 }
 
@@ -1512,6 +1521,8 @@ void delete_branch_node_from_bdd(const EP *ep, bdd::BDD *bdd,
   bdd::Node *target_on_true = anchor_next->get_mutable_on_true();
   bdd::Node *target_on_false = anchor_next->get_mutable_on_false();
 
+  bdd->remove_from_index(anchor_next);
+
   if (direction_to_keep) {
     new_current = target_on_true;
     target_on_false->recursive_free_children(manager);
@@ -1547,6 +1558,8 @@ void delete_branch_node_from_bdd(const EP *ep, bdd::BDD *bdd,
   new_current->set_prev(anchor);
   manager.free_node(anchor_next);
 
+  bdd->update_index(new_current);
+
   // bdd->inspect();
 }
 
@@ -1735,6 +1748,175 @@ get_coalescing_nodes_from_key(const bdd::BDD *bdd, const bdd::Node *node,
   return filtered_nodes;
 }
 
+// The branch right after the map_get that checks if the key was found. Returns
+// the side taken when it was.
+static const bdd::Node *get_map_get_hit_side(const bdd::Call *map_get) {
+  symbols_t symbols = map_get->get_locally_generated_symbols();
+
+  symbol_t map_has_this_key;
+  bool found = get_symbol(symbols, "map_has_this_key", map_has_this_key);
+  assert(found && "Symbol map_has_this_key not found");
+
+  const bdd::Node *node = map_get->get_next();
+  while (node && node->get_type() == bdd::NodeType::CALL) {
+    node = node->get_next();
+  }
+
+  if (!node || node->get_type() != bdd::NodeType::BRANCH) {
+    return nullptr;
+  }
+
+  const bdd::Branch *branch = static_cast<const bdd::Branch *>(node);
+  klee::ref<klee::Expr> condition = branch->get_condition();
+
+  kutil::SymbolRetriever retriever;
+  retriever.visit(condition);
+
+  const std::unordered_set<std::string> &used_symbols =
+      retriever.get_retrieved_strings();
+
+  if (used_symbols.size() != 1 ||
+      used_symbols.count(map_has_this_key.array->name) == 0) {
+    return nullptr;
+  }
+
+  klee::ConstraintManager hit;
+  hit.addConstraint(kutil::solver_toolbox.exprBuilder->Not(
+      kutil::solver_toolbox.exprBuilder->Eq(
+          map_has_this_key.expr, kutil::solver_toolbox.exprBuilder->Constant(
+                                     0, map_has_this_key.expr->getWidth()))));
+
+  if (kutil::solver_toolbox.is_expr_always_true(hit, condition)) {
+    return branch->get_on_true();
+  }
+
+  if (kutil::solver_toolbox.is_expr_always_false(hit, condition)) {
+    return branch->get_on_false();
+  }
+
+  return nullptr;
+}
+
+coalesced_map_ops_t get_coalesced_map_ops(const bdd::Call *map_get,
+                                          const map_coalescing_objs_t &data) {
+  coalesced_map_ops_t ops;
+
+  const call_t &mg_call = map_get->get_call();
+  assert(mg_call.function_name == "map_get");
+  klee::ref<klee::Expr> index = mg_call.args.at("value_out").out;
+
+  const bdd::Node *hit_side = get_map_get_hit_side(map_get);
+
+  if (!hit_side) {
+    return ops;
+  }
+
+  auto uses_index = [&index](const call_t &call) {
+    return kutil::solver_toolbox.are_exprs_always_equal(
+        call.args.at("index").expr, index);
+  };
+
+  const bdd::Node *node = hit_side;
+  while (node && node->get_type() == bdd::NodeType::CALL) {
+    const bdd::Call *call_node = static_cast<const bdd::Call *>(node);
+    const call_t &call = call_node->get_call();
+
+    if (call.function_name == "dchain_rejuvenate_index" &&
+        kutil::expr_addr_to_obj_addr(call.args.at("chain").expr) ==
+            data.dchain &&
+        uses_index(call)) {
+      ops.dchain_rejuvenation = call_node;
+      break;
+    }
+
+    node = node->get_next();
+  }
+
+  std::vector<const bdd::Call *> vector_borrows =
+      get_future_functions(hit_side, {"vector_borrow"});
+
+  std::unordered_set<addr_t> written_vectors;
+  std::vector<const bdd::Call *> candidates;
+
+  for (const bdd::Call *vector_borrow : vector_borrows) {
+    const call_t &call = vector_borrow->get_call();
+    addr_t vector = kutil::expr_addr_to_obj_addr(call.args.at("vector").expr);
+
+    if (vector != data.vector_key &&
+        data.vectors_values.find(vector) == data.vectors_values.end()) {
+      continue;
+    }
+
+    if (!uses_index(call)) {
+      continue;
+    }
+
+    if (!is_vector_read(vector_borrow)) {
+      written_vectors.insert(vector);
+      continue;
+    }
+
+    candidates.push_back(vector_borrow);
+  }
+
+  for (const bdd::Call *vector_borrow : candidates) {
+    const call_t &call = vector_borrow->get_call();
+    addr_t vector = kutil::expr_addr_to_obj_addr(call.args.at("vector").expr);
+
+    if (written_vectors.find(vector) != written_vectors.end()) {
+      continue;
+    }
+
+    ops.vector_reads.push_back(vector_borrow);
+
+    for (const bdd::Call *vector_return :
+         get_future_vector_return(vector_borrow)) {
+      ops.vector_returns.push_back(vector_return);
+    }
+  }
+
+  return ops;
+}
+
+bdd::BDD *delete_coalesced_map_ops(const EP *ep, const bdd::Node *node,
+                                   const coalesced_map_ops_t &ops,
+                                   const bdd::Node *&new_next) {
+  const bdd::BDD *old_bdd = ep->get_bdd();
+  bdd::BDD *new_bdd = new bdd::BDD(*old_bdd);
+
+  const bdd::Node *next = node->get_next();
+  new_next = next ? new_bdd->get_node_by_id(next->get_id()) : nullptr;
+
+  std::vector<const bdd::Call *> targets = ops.vector_reads;
+  targets.insert(targets.end(), ops.vector_returns.begin(),
+                 ops.vector_returns.end());
+
+  if (ops.dchain_rejuvenation.has_value()) {
+    targets.push_back(*ops.dchain_rejuvenation);
+  }
+
+  std::unordered_set<bdd::node_id_t> deleted;
+
+  for (const bdd::Call *target : targets) {
+    // The same return can match more than one read.
+    if (!deleted.insert(target->get_id()).second) {
+      continue;
+    }
+
+    bool replace_next = new_next && new_next->get_id() == target->get_id();
+
+    bdd::Node *replacement;
+    delete_non_branch_node_from_bdd(ep, new_bdd, target->get_id(),
+                                    replacement);
+
+    if (replace_next) {
+      new_next = replacement;
+    }
+  }
+
+  return new_bdd;
+}
+
 symbol_t create_symbol(const std::string &label, bits_t size) {
   const klee::Array *array;
 
@@ -1812,6 +1994,10 @@ std::string throughput2str(uint64_t thpt, const std::string &units,
   return ss.str();
 }
 
+void hash_combine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
 bool get_map_coalescing_objs_from_dchain_op(const EP *ep,
                                             const bdd::Call *dchain_op,
                                             map_coalescing_objs_t &map_objs) {
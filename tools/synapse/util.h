@@ -136,6 +136,40 @@ get_coalescing_nodes_from_key(const bdd::BDD *bdd, const bdd::Node *node,
                               klee::ref<klee::Expr> key,
                               const map_coalescing_objs_t &data);
 
+// A read from a coalesced vector, into the cell borrowed at value_addr.
+struct coalesced_vector_read_t {
+  addr_t vector_addr;
+  addr_t value_addr;
+  klee::ref<klee::Expr> value;
+};
+
+// Operations on the coalesced objects of a map that only depend on the index
+// found by a map_get, and so can be served by the same lookup: reads from the
+// vectors indexed by it (as long as the vector is never written with that
+// index), and the rejuvenation of the index (as long as every path where the
+// key is found rejuvenates it, before branching).
+struct coalesced_map_ops_t {
+  std::vector<const bdd::Call *> vector_reads;
+
+  // Returns of the vector reads, which don't modify the vectors.
+  std::vector<const bdd::Call *> vector_returns;
+
+  std::optional<const bdd::Call *> dchain_rejuvenation;
+
+  bool empty() const {
+    return vector_reads.empty() && !dchain_rejuvenation.has_value();
+  }
+};
+
+coalesced_map_ops_t get_coalesced_map_ops(const bdd::Call *map_get,
+                                          const map_coalescing_objs_t &data);
+
+// Removes the coalesced operations from a copy of the EP's BDD. The new next
+// node replaces the next node of the given one, as it might be removed.
+bdd::BDD *delete_coalesced_map_ops(const EP *ep, const bdd::Node *node,
+                                   const coalesced_map_ops_t &ops,
+                                   const bdd::Node *&new_next);
+
 klee::ref<klee::Expr> get_chunk_from_borrow(const bdd::Node *node);
 bool borrow_has_var_len(const bdd::Node *node);
 
@@ -210,4 +244,7 @@ std::string int2hr(uint64_t value);
 std::string throughput2str(uint64_t thpt, const std::string &units,
                            bool human_readable = false);
 
+// Mixes a value into a running hash, like boost::hash_combine.
+void hash_combine(size_t &seed, size_t value);
+
 } // namespace synapse
\ No newline at end of file
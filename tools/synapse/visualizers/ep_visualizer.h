@@ -107,6 +107,7 @@ public:
   DECLARE_VISIT(x86::MapGet)
   DECLARE_VISIT(x86::MapPut)
   DECLARE_VISIT(x86::MapErase)
+  DECLARE_VISIT(x86::CoalescedMapGet)
   DECLARE_VISIT(x86::ExpireItemsSingleMap)
   DECLARE_VISIT(x86::ExpireItemsSingleMapIteratively)
   DECLARE_VISIT(x86::VectorRead)
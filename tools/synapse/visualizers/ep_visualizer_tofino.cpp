@@ -186,6 +186,9 @@ void EPVisualizer::visit(const EP *ep, const EPNode *ep_node,
   label_builder << ", ";
   label_builder << "size=";
   label_builder << cached_table->cache_capacity;
+  label_builder << ", ";
+  label_builder << "policy=";
+  label_builder << cache_policy_to_string(cached_table->policy);
 
   std::string label = label_builder.str();
   function_call(ep_node, bdd_node, target, label);
@@ -214,6 +217,9 @@ void EPVisualizer::visit(const EP *ep, const EPNode *ep_node,
   label_builder << ", ";
   label_builder << "size=";
   label_builder << cached_table->cache_capacity;
+  label_builder << ", ";
+  label_builder << "policy=";
+  label_builder << cache_policy_to_string(cached_table->policy);
 
   std::string label = label_builder.str();
   function_call(ep_node, bdd_node, target, label);
@@ -242,6 +248,9 @@ void EPVisualizer::visit(const EP *ep, const EPNode *ep_node,
   label_builder << ", ";
   label_builder << "size=";
   label_builder << cached_table->cache_capacity;
+  label_builder << ", ";
+  label_builder << "policy=";
+  label_builder << cache_policy_to_string(cached_table->policy);
 
   std::string label = label_builder.str();
   function_call(ep_node, bdd_node, target, label);
@@ -270,6 +279,9 @@ void EPVisualizer::visit(const EP *ep, const EPNode *ep_node,
   label_builder << ", ";
   label_builder << "size=";
   label_builder << cached_table->cache_capacity;
+  label_builder << ", ";
+  label_builder << "policy=";
+  label_builder << cache_policy_to_string(cached_table->policy);
 
   std::string label = label_builder.str();
   function_call(ep_node, bdd_node, target, label);
@@ -44,6 +44,7 @@ SHOW_MODULE_NAME(x86::ChecksumUpdate)
 SHOW_MODULE_NAME(x86::MapGet)
 SHOW_MODULE_NAME(x86::MapPut)
 SHOW_MODULE_NAME(x86::MapErase)
+SHOW_MODULE_NAME(x86::CoalescedMapGet)
 SHOW_MODULE_NAME(x86::ExpireItemsSingleMap)
 SHOW_MODULE_NAME(x86::ExpireItemsSingleMapIteratively)
 SHOW_MODULE_NAME(x86::VectorRead)
@@ -30,6 +30,14 @@ static std::string stringify_score(const Score &score) {
   return score_str;
 }
 
+// Descriptions are only kept on detailed search spaces.
+static std::string stringify_bdd_node(const bdd_node_data_t &data) {
+  if (data.description.empty()) {
+    return std::to_string(data.id);
+  }
+  return data.description;
+}
+
 static bool should_highlight(const SSNode *ssnode,
                              const std::set<ep_id_t> &highlight) {
   return highlight.find(ssnode->ep_id) != highlight.end();
@@ -79,8 +87,8 @@ static void visit_definitions(std::stringstream &ss,
   ss << "<td ";
   // ss << "bgcolor=\"" << target_color << "\"";
   ss << ">";
-  if (ssnode->module_data) {
-    ss << bold("HR: ") << ssnode->module_data->hit_rate;
+  if (ssnode->module_data && ssnode->module_data->hit_rate) {
+    ss << bold("HR: ") << *ssnode->module_data->hit_rate;
   } else {
     ss << bold("HR: ") << "None";
   }
@@ -101,7 +109,11 @@ static void visit_definitions(std::stringstream &ss,
   ss << ">";
 
   ss << bold("Score: ");
-  ss << stringify_score(ssnode->score);
+  if (ssnode->score) {
+    ss << stringify_score(*ssnode->score);
+  } else {
+    ss << "None";
+  }
   ss << "</td>\n";
 
   indent(3);
@@ -148,7 +160,7 @@ static void visit_definitions(std::stringstream &ss,
   ss << ">";
   if (ssnode->bdd_node_data) {
     ss << bold("Processed: ");
-    ss << ssnode->bdd_node_data->description;
+    ss << stringify_bdd_node(*ssnode->bdd_node_data);
   }
   ss << "</td>\n";
 
@@ -167,7 +179,7 @@ static void visit_definitions(std::stringstream &ss,
     ss << " colspan=\"2\"";
     ss << ">";
     ss << bold("Next: ");
-    ss << ssnode->next_bdd_node_data->description;
+    ss << stringify_bdd_node(*ssnode->next_bdd_node_data);
     ss << "</td>\n";
 
     indent(3);
@@ -176,7 +188,20 @@ static void visit_definitions(std::stringstream &ss,
 
   // Metadata rows
 
-  for (const auto &[name, value] : ssnode->metadata) {
+  std::vector<std::pair<std::string, std::string>> metadata;
+  if (ssnode->module_data) {
+    int avg_pkt_bytes = search_space->get_avg_pkt_bytes();
+    metadata = {
+        {"Speculation",
+         SearchSpace::build_meta_throughput(ssnode->throughput_speculation_pps,
+                                            avg_pkt_bytes)},
+        {"Throughput",
+         SearchSpace::build_meta_throughput(ssnode->throughput_estimate_pps,
+                                            avg_pkt_bytes)},
+    };
+  }
+
+  for (const auto &[name, value] : metadata) {
     indent(3);
     ss << "<tr>\n";
 
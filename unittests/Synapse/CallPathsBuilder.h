@@ -0,0 +1,96 @@
+#pragma once
+
+#include "call-paths-to-bdd.h"
+#include "klee-util.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Builds BDDs out of hand written call paths. Every path starts by receiving
+// a packet and reading the time, and sees every symbol.
+class CallPathsBuilder {
+private:
+  symbols_t symbols;
+  std::vector<call_path_t *> cps;
+
+public:
+  CallPathsBuilder() {
+    add_symbol("DEVICE", 32);
+    add_symbol("pkt_len", 32);
+    add_symbol("next_time", 64);
+  }
+
+  ~CallPathsBuilder() {
+    for (call_path_t *cp : cps) {
+      delete cp;
+    }
+  }
+
+  klee::ref<klee::Expr> add_symbol(const std::string &name, bits_t width) {
+    const klee::Array *array;
+    klee::ref<klee::Expr> expr =
+        kutil::solver_toolbox.create_new_symbol(name, width, array);
+    symbols.insert({name, array, expr});
+    return expr;
+  }
+
+  klee::ref<klee::Expr> get_symbol(const std::string &name) const {
+    symbol_t symbol;
+    bool found = ::get_symbol(symbols, name, symbol);
+    assert(found && "Symbol not found");
+    return symbol.expr;
+  }
+
+  // Taken by packets meeting every constraint.
+  call_path_t *add_path(const std::vector<klee::ref<klee::Expr>> &constraints =
+                            std::vector<klee::ref<klee::Expr>>()) {
+    call_path_t *cp = new call_path_t;
+    cp->file_name = "path" + std::to_string(cps.size());
+
+    for (klee::ref<klee::Expr> constraint : constraints) {
+      cp->constraints.addConstraint(constraint);
+    }
+
+    cps.push_back(cp);
+
+    add_call(cp, "packet_receive");
+    add_call(cp, "current_time");
+
+    return cp;
+  }
+
+  static call_t &add_call(call_path_t *cp, const std::string &fname) {
+    cp->calls.emplace_back();
+    cp->calls.back().function_name = fname;
+    return cp->calls.back();
+  }
+
+  static void set_arg(call_t &call, const std::string &name,
+                      klee::ref<klee::Expr> expr,
+                      klee::ref<klee::Expr> in = nullptr,
+                      klee::ref<klee::Expr> out = nullptr) {
+    arg_t &arg = call.args[name];
+    arg.expr = expr;
+    arg.in = in;
+    arg.out = out;
+  }
+
+  static void forward(call_path_t *cp, int device) {
+    call_t &call = add_call(cp, "packet_send");
+    set_arg(call, "dst_device", constant(device, 16));
+  }
+
+  static klee::ref<klee::Expr> constant(uint64_t value, bits_t width = 64) {
+    return kutil::solver_toolbox.exprBuilder->Constant(value, width);
+  }
+
+  // Building the BDD consumes the calls of every path.
+  std::shared_ptr<bdd::BDD> build() {
+    for (call_path_t *cp : cps) {
+      cp->symbols = symbols;
+    }
+
+    return std::make_shared<bdd::BDD>(call_paths_t(cps));
+  }
+};
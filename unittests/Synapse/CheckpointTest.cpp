@@ -0,0 +1,219 @@
+#include "gtest/gtest.h"
+
+#include "CallPathsBuilder.h"
+
+#include "checkpoint.h"
+#include "heuristics/heuristics.h"
+#include "profiler.h"
+#include "random_engine.h"
+#include "search.h"
+#include "targets/targets.h"
+
+#include <cstdio>
+
+using namespace synapse;
+
+namespace {
+
+constexpr unsigned SEED = 0;
+
+std::string get_checkpoint_file(const std::string &name) {
+  return testing::TempDir() + "synapse-" + name + ".checkpoint";
+}
+
+// Packets from the first device are forwarded to the second, and the rest to
+// the first.
+std::shared_ptr<bdd::BDD> build_nf() {
+  CallPathsBuilder builder;
+
+  klee::ref<klee::Expr> from_first = kutil::solver_toolbox.exprBuilder->Eq(
+      builder.get_symbol("DEVICE"), CallPathsBuilder::constant(0, 32));
+
+  call_path_t *first = builder.add_path({from_first});
+  CallPathsBuilder::forward(first, 1);
+
+  call_path_t *rest =
+      builder.add_path({kutil::solver_toolbox.exprBuilder->Not(from_first)});
+  CallPathsBuilder::forward(rest, 0);
+
+  return builder.build();
+}
+
+class CheckpointTest : public testing::Test {
+protected:
+  std::shared_ptr<bdd::BDD> bdd;
+  std::shared_ptr<Profiler> profiler;
+  targets_t targets;
+
+  void SetUp() override {
+    RandomEngine::seed(SEED);
+
+    bdd = build_nf();
+    profiler = std::make_shared<Profiler>(bdd.get());
+    targets = build_targets(profiler.get(), tofino::PipeStatePolicy::REPLICATE,
+                            default_x86_perf_params(),
+                            default_tofino_cpu_perf_params());
+  }
+
+  void TearDown() override { delete_targets(targets); }
+
+  std::unique_ptr<SearchEngine<BFSComparator>>
+  build_engine(BFS &heuristic, const checkpoint_cfg_t &checkpoint_cfg) {
+    return std::make_unique<SearchEngine<BFSComparator>>(
+        bdd, &heuristic, profiler, targets, true,
+        std::unordered_set<ep_id_t>(), false, false, false, 0,
+        checkpoint_cfg);
+  }
+};
+
+struct search_result_t {
+  size_t ep_hash;
+  uint64_t pps;
+  uint64_t steps;
+  uint64_t duplicates;
+};
+
+// Runs an engine that was already started until the search is over.
+search_result_t run_started(SearchEngineBase &engine) {
+  while (engine.step()) {
+  }
+
+  search_report_t report = engine.finish();
+
+  search_result_t result = {
+      .ep_hash = report.solution.ep ? report.solution.ep->hash() : 0,
+      .pps = report.solution.ep
+                 ? report.solution.ep->estimate_throughput_pps()
+                 : 0,
+      .steps = report.meta.steps,
+      .duplicates = report.meta.duplicates,
+  };
+
+  delete report.solution.ep;
+  delete report.solution.search_space;
+
+  return result;
+}
+
+TEST(CheckpointFileTest, SaveAndLoad) {
+  checkpoint_t checkpoint;
+  checkpoint.bdd_hash = "bdd";
+  checkpoint.seed = 7;
+  checkpoint.random_state = "1 2 3";
+  checkpoint.elapsed_time = 42;
+  checkpoint.steps = 100;
+  checkpoint.backtracks = 10;
+  checkpoint.avg_bdd_size = 20;
+  checkpoint.generated = 300;
+  checkpoint.duplicates = 30;
+  checkpoint.pruned = 3;
+  checkpoint.visits_per_node = {{0, 1}, {5, 2}};
+  checkpoint.avg_children_per_node = {{0, 1.5}, {5, 2.25}};
+  checkpoint.seen_eps = {11, 22, 33};
+  checkpoint.frontier = {
+      {.path = {}, .random_number = 1},
+      {.path = {{0, 1}, {4, 0}}, .random_number = 2},
+  };
+
+  std::string file = get_checkpoint_file("file");
+  checkpoint.save(file);
+  checkpoint_t loaded = checkpoint_t::load(file);
+  std::remove(file.c_str());
+
+  EXPECT_EQ(loaded.bdd_hash, checkpoint.bdd_hash);
+  EXPECT_EQ(loaded.seed, checkpoint.seed);
+  EXPECT_EQ(loaded.random_state, checkpoint.random_state);
+  EXPECT_EQ(loaded.elapsed_time, checkpoint.elapsed_time);
+  EXPECT_EQ(loaded.steps, checkpoint.steps);
+  EXPECT_EQ(loaded.backtracks, checkpoint.backtracks);
+  EXPECT_EQ(loaded.avg_bdd_size, checkpoint.avg_bdd_size);
+  EXPECT_EQ(loaded.generated, checkpoint.generated);
+  EXPECT_EQ(loaded.duplicates, checkpoint.duplicates);
+  EXPECT_EQ(loaded.pruned, checkpoint.pruned);
+  EXPECT_EQ(loaded.visits_per_node, checkpoint.visits_per_node);
+  EXPECT_EQ(loaded.avg_children_per_node, checkpoint.avg_children_per_node);
+  EXPECT_EQ(loaded.seen_eps, checkpoint.seen_eps);
+
+  ASSERT_EQ(loaded.frontier.size(), checkpoint.frontier.size());
+  for (size_t i = 0; i < loaded.frontier.size(); i++) {
+    const checkpoint_ep_t &ep = loaded.frontier[i];
+    const checkpoint_ep_t &expected = checkpoint.frontier[i];
+
+    EXPECT_EQ(ep.random_number, expected.random_number);
+    ASSERT_EQ(ep.path.size(), expected.path.size());
+
+    for (size_t j = 0; j < ep.path.size(); j++) {
+      EXPECT_EQ(ep.path[j].modgen, expected.path[j].modgen);
+      EXPECT_EQ(ep.path[j].product, expected.path[j].product);
+    }
+  }
+}
+
+TEST_F(CheckpointTest, ResumedSearchMatchesUninterrupted) {
+  BFS uninterrupted_heuristic;
+  auto uninterrupted = build_engine(uninterrupted_heuristic, {"", 0, false});
+  uninterrupted->start();
+  search_result_t expected = run_started(*uninterrupted);
+
+  ASSERT_NE(expected.ep_hash, 0u);
+  ASSERT_GT(expected.steps, 1u);
+
+  // The later steps leave complete EPs on the frontier.
+  for (uint64_t interrupted_steps = 1; interrupted_steps < expected.steps;
+       interrupted_steps++) {
+    SCOPED_TRACE("Interrupted after " + std::to_string(interrupted_steps) +
+                 " steps");
+
+    // Checkpoints are made before every step, so the last one holds the
+    // frontier left by all the steps but the last.
+    std::string file = get_checkpoint_file("resume");
+
+    RandomEngine::seed(SEED);
+    BFS interrupted_heuristic;
+    auto interrupted = build_engine(interrupted_heuristic, {file, 0, false});
+    interrupted->start();
+    for (uint64_t i = 0; i < interrupted_steps; i++) {
+      ASSERT_TRUE(interrupted->step());
+    }
+    interrupted.reset();
+
+    checkpoint_t checkpoint = checkpoint_t::load(file);
+    EXPECT_EQ(checkpoint.bdd_hash, bdd->hash());
+    EXPECT_EQ(checkpoint.seed, SEED);
+    EXPECT_EQ(checkpoint.steps, interrupted_steps - 1);
+    EXPECT_FALSE(checkpoint.frontier.empty());
+
+    // The seed is drawn anew, and the replay brings back the random state of
+    // the interrupted search.
+    RandomEngine::seed(SEED);
+    BFS resumed_heuristic;
+    auto resumed = build_engine(resumed_heuristic, {file, 0, true});
+    resumed->start();
+    EXPECT_EQ(resumed_heuristic.size(), checkpoint.frontier.size());
+
+    search_result_t result = run_started(*resumed);
+    std::remove(file.c_str());
+
+    EXPECT_EQ(result.ep_hash, expected.ep_hash);
+    EXPECT_EQ(result.pps, expected.pps);
+    EXPECT_EQ(result.steps, expected.steps);
+    EXPECT_EQ(result.duplicates, expected.duplicates);
+  }
+}
+
+TEST_F(CheckpointTest, RefusesAnotherBDD) {
+  checkpoint_t checkpoint{};
+  checkpoint.bdd_hash = "another";
+  checkpoint.seed = SEED;
+
+  std::string file = get_checkpoint_file("another");
+  checkpoint.save(file);
+
+  BFS heuristic;
+  auto engine = build_engine(heuristic, {file, 0, true});
+  EXPECT_EXIT(engine->start(), testing::ExitedWithCode(1), "another BDD");
+
+  std::remove(file.c_str());
+}
+
+} // namespace
@@ -0,0 +1,223 @@
+#include "gtest/gtest.h"
+
+#include "CallPathsBuilder.h"
+
+#include "execution_plan/execution_plan.h"
+#include "profiler.h"
+#include "random_engine.h"
+#include "targets/targets.h"
+#include "util.h"
+
+using namespace synapse;
+
+namespace {
+
+constexpr addr_t MAP = 0x100;
+constexpr addr_t DCHAIN = 0x200;
+constexpr addr_t VECTOR = 0x300;
+constexpr addr_t KEY_ADDR = 0x1000;
+constexpr addr_t VALUE_OUT_ADDR = 0x2000;
+constexpr addr_t CELL_ADDR = 0x3000;
+
+constexpr bdd::node_id_t MAP_GET_ID = 0;
+
+struct nf_cfg_t {
+  addr_t dchain = DCHAIN;
+  addr_t vector = VECTOR;
+
+  // The hit side writes the cell back.
+  bool write_vector = false;
+
+  // The hit side is told apart by something other than map_has_this_key.
+  bool check_other_symbol = false;
+};
+
+// A map_get followed by the check of whether the key was found. When it was,
+// the index is rejuvenated and a value is read from a vector with it.
+std::shared_ptr<bdd::BDD> build_nf(const nf_cfg_t &cfg) {
+  CallPathsBuilder builder;
+
+  klee::ref<klee::Expr> key = builder.get_symbol("DEVICE");
+  klee::ref<klee::Expr> found = builder.add_symbol("map_has_this_key", 32);
+  klee::ref<klee::Expr> index = builder.add_symbol("allocated_index", 32);
+  klee::ref<klee::Expr> cell = builder.add_symbol("vector_data", 32);
+  klee::ref<klee::Expr> time = builder.get_symbol("next_time");
+
+  klee::ref<klee::Expr> checked =
+      cfg.check_other_symbol ? builder.get_symbol("pkt_len") : found;
+  klee::ref<klee::Expr> hit = kutil::solver_toolbox.exprBuilder->Not(
+      kutil::solver_toolbox.exprBuilder->Eq(
+          checked, CallPathsBuilder::constant(0, 32)));
+  klee::ref<klee::Expr> miss = kutil::solver_toolbox.exprBuilder->Eq(
+      checked, CallPathsBuilder::constant(0, 32));
+
+  auto add_map_get = [&](call_path_t *cp) {
+    call_t &call = CallPathsBuilder::add_call(cp, "map_get");
+    CallPathsBuilder::set_arg(call, "map", CallPathsBuilder::constant(MAP));
+    CallPathsBuilder::set_arg(call, "key",
+                              CallPathsBuilder::constant(KEY_ADDR), key);
+    CallPathsBuilder::set_arg(call, "value_out",
+                              CallPathsBuilder::constant(VALUE_OUT_ADDR),
+                              nullptr, index);
+    call.ret = found;
+  };
+
+  call_path_t *hit_path = builder.add_path({hit});
+  add_map_get(hit_path);
+
+  call_t &rejuvenate =
+      CallPathsBuilder::add_call(hit_path, "dchain_rejuvenate_index");
+  CallPathsBuilder::set_arg(rejuvenate, "chain",
+                            CallPathsBuilder::constant(cfg.dchain));
+  CallPathsBuilder::set_arg(rejuvenate, "index", index);
+  CallPathsBuilder::set_arg(rejuvenate, "time", time);
+
+  call_t &borrow = CallPathsBuilder::add_call(hit_path, "vector_borrow");
+  CallPathsBuilder::set_arg(borrow, "vector",
+                            CallPathsBuilder::constant(cfg.vector));
+  CallPathsBuilder::set_arg(borrow, "index", index);
+  CallPathsBuilder::set_arg(borrow, "val_out",
+                            CallPathsBuilder::constant(VALUE_OUT_ADDR + 8),
+                            nullptr, CallPathsBuilder::constant(CELL_ADDR));
+  borrow.extra_vars["borrowed_cell"] = {cell, cell};
+
+  klee::ref<klee::Expr> returned =
+      cfg.write_vector ? CallPathsBuilder::constant(7, 32) : cell;
+
+  call_t &ret = CallPathsBuilder::add_call(hit_path, "vector_return");
+  CallPathsBuilder::set_arg(ret, "vector",
+                            CallPathsBuilder::constant(cfg.vector));
+  CallPathsBuilder::set_arg(ret, "index", index);
+  CallPathsBuilder::set_arg(ret, "value", CallPathsBuilder::constant(CELL_ADDR),
+                            returned);
+
+  CallPathsBuilder::forward(hit_path, 1);
+
+  call_path_t *miss_path = builder.add_path({miss});
+  add_map_get(miss_path);
+  CallPathsBuilder::forward(miss_path, 0);
+
+  return builder.build();
+}
+
+map_coalescing_objs_t get_coalescing_objs() {
+  return {
+      .map = MAP,
+      .dchain = DCHAIN,
+      .vector_key = 0,
+      .vectors_values = {VECTOR},
+  };
+}
+
+const bdd::Call *get_map_get(const bdd::BDD *bdd) {
+  const bdd::Node *node = bdd->get_node_by_id(MAP_GET_ID);
+  assert(node && node->get_type() == bdd::NodeType::CALL);
+  return static_cast<const bdd::Call *>(node);
+}
+
+const std::string &get_fname(const bdd::Call *call) {
+  return call->get_call().function_name;
+}
+
+TEST(CoalescedMapGetTest, FusesReadsAndRejuvenation) {
+  std::shared_ptr<bdd::BDD> bdd = build_nf({});
+  coalesced_map_ops_t ops =
+      get_coalesced_map_ops(get_map_get(bdd.get()), get_coalescing_objs());
+
+  ASSERT_TRUE(ops.dchain_rejuvenation.has_value());
+  EXPECT_EQ(get_fname(*ops.dchain_rejuvenation), "dchain_rejuvenate_index");
+
+  ASSERT_EQ(ops.vector_reads.size(), 1u);
+  EXPECT_EQ(get_fname(ops.vector_reads[0]), "vector_borrow");
+
+  ASSERT_EQ(ops.vector_returns.size(), 1u);
+  EXPECT_EQ(get_fname(ops.vector_returns[0]), "vector_return");
+}
+
+TEST(CoalescedMapGetTest, KeepsVectorWrites) {
+  nf_cfg_t cfg;
+  cfg.write_vector = true;
+
+  std::shared_ptr<bdd::BDD> bdd = build_nf(cfg);
+  coalesced_map_ops_t ops =
+      get_coalesced_map_ops(get_map_get(bdd.get()), get_coalescing_objs());
+
+  EXPECT_TRUE(ops.dchain_rejuvenation.has_value());
+  EXPECT_TRUE(ops.vector_reads.empty());
+  EXPECT_TRUE(ops.vector_returns.empty());
+}
+
+TEST(CoalescedMapGetTest, IgnoresOtherObjects) {
+  nf_cfg_t cfg;
+  cfg.dchain = DCHAIN + 1;
+  cfg.vector = VECTOR + 1;
+
+  std::shared_ptr<bdd::BDD> bdd = build_nf(cfg);
+  coalesced_map_ops_t ops =
+      get_coalesced_map_ops(get_map_get(bdd.get()), get_coalescing_objs());
+
+  EXPECT_TRUE(ops.empty());
+}
+
+TEST(CoalescedMapGetTest, NeedsTheHitCheck) {
+  nf_cfg_t cfg;
+  cfg.check_other_symbol = true;
+
+  std::shared_ptr<bdd::BDD> bdd = build_nf(cfg);
+  coalesced_map_ops_t ops =
+      get_coalesced_map_ops(get_map_get(bdd.get()), get_coalescing_objs());
+
+  EXPECT_TRUE(ops.empty());
+}
+
+TEST(CoalescedMapGetTest, DeletesFusedOps) {
+  RandomEngine::seed(0);
+
+  std::shared_ptr<bdd::BDD> bdd = build_nf({});
+  std::shared_ptr<Profiler> profiler = std::make_shared<Profiler>(bdd.get());
+  targets_t targets = build_targets(
+      profiler.get(), tofino::PipeStatePolicy::REPLICATE,
+      default_x86_perf_params(), default_tofino_cpu_perf_params());
+
+  EP ep(bdd, targets, profiler);
+
+  const bdd::Call *map_get = get_map_get(ep.get_bdd());
+  coalesced_map_ops_t ops =
+      get_coalesced_map_ops(map_get, get_coalescing_objs());
+  ASSERT_FALSE(ops.empty());
+
+  const bdd::Node *new_next;
+  std::unique_ptr<bdd::BDD> new_bdd(
+      delete_coalesced_map_ops(&ep, map_get, ops, new_next));
+
+  // The check of the key is still there, and the side where it was found
+  // goes straight to forwarding the packet.
+  ASSERT_TRUE(new_next);
+  ASSERT_EQ(new_next->get_type(), bdd::NodeType::BRANCH);
+  EXPECT_EQ(new_next, new_bdd->get_node_by_id(map_get->get_next()->get_id()));
+
+  for (const bdd::Call *deleted :
+       {*ops.dchain_rejuvenation, ops.vector_reads[0], ops.vector_returns[0]}) {
+    EXPECT_FALSE(new_bdd->get_node_by_id(deleted->get_id()));
+  }
+
+  std::vector<const bdd::Call *> remaining = get_future_functions(
+      new_bdd->get_root(),
+      {"dchain_rejuvenate_index", "vector_borrow", "vector_return"});
+  EXPECT_TRUE(remaining.empty());
+
+  const bdd::Branch *branch = static_cast<const bdd::Branch *>(new_next);
+  for (const bdd::Node *side :
+       {branch->get_on_true(), branch->get_on_false()}) {
+    EXPECT_EQ(side->get_type(), bdd::NodeType::ROUTE);
+    EXPECT_EQ(side->get_prev(), new_next);
+  }
+
+  // The EP's BDD is left untouched.
+  EXPECT_EQ(ep.get_bdd()->size(), bdd->size());
+  EXPECT_EQ(new_bdd->size(), bdd->size() - 3);
+
+  delete_targets(targets);
+}
+
+} // namespace
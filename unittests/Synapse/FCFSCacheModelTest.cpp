@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include "targets/tofino/fcfs_cache_model.h"
+
+#include <initializer_list>
+#include <utility>
+
+using namespace synapse;
+using namespace synapse::tofino;
+
+namespace {
+
+// Flows given as (packets, flows) pairs.
+FlowStats
+build_flow_stats(std::initializer_list<std::pair<uint64_t, uint64_t>> sizes) {
+  FlowStats stats{};
+
+  for (const auto &[packets, flows] : sizes) {
+    for (uint64_t i = 0; i < flows; i++) {
+      stats.packets_per_flow.push_back(packets);
+    }
+
+    stats.total_packets += packets * flows;
+    stats.total_flows += flows;
+  }
+
+  stats.avg_pkts_per_flow = stats.total_packets / stats.total_flows;
+  return stats;
+}
+
+double get_fcfs_hit_rate(const FlowStats &stats, bool churn, int capacity) {
+  FCFSCacheModel model(stats, churn);
+  return model.get_hit_rate(CachePolicy::FCFS, capacity);
+}
+
+TEST(FCFSCacheModelTest, EveryFlowFits) {
+  FlowStats stats = build_flow_stats({{10, 90}, {1, 10}});
+
+  EXPECT_EQ(get_fcfs_hit_rate(stats, false, 100), 1);
+  EXPECT_EQ(get_fcfs_hit_rate(stats, true, 100), 1);
+  EXPECT_EQ(get_fcfs_hit_rate(stats, false, 1000), 1);
+}
+
+TEST(FCFSCacheModelTest, EmptyProfile) {
+  FlowStats stats{};
+  EXPECT_EQ(get_fcfs_hit_rate(stats, false, 10), 1);
+}
+
+TEST(FCFSCacheModelTest, UniformFlowsWithoutChurn) {
+  FlowStats stats = build_flow_stats({{10, 100}});
+
+  // Every flow is as likely to be cached, so the cache holds C of the N flows.
+  EXPECT_NEAR(get_fcfs_hit_rate(stats, false, 25), 0.25, 1e-9);
+  EXPECT_NEAR(get_fcfs_hit_rate(stats, false, 50), 0.5, 1e-9);
+}
+
+TEST(FCFSCacheModelTest, AverageOnlyProfile) {
+  FlowStats stats{};
+  stats.total_packets = 1000;
+  stats.total_flows = 100;
+  stats.avg_pkts_per_flow = 10;
+
+  EXPECT_NEAR(get_fcfs_hit_rate(stats, false, 25), 0.25, 1e-9);
+}
+
+TEST(FCFSCacheModelTest, LargeFlowsShowUpFirst) {
+  FlowStats stats = build_flow_stats({{100, 1}, {1, 99}});
+
+  double hit_rate = get_fcfs_hit_rate(stats, false, 1);
+
+  // Better than caching a random flow, but the large flow can still lose its
+  // slot to a small one that shows up earlier.
+  EXPECT_GT(hit_rate, 100.0 / 199 / 100);
+  EXPECT_LT(hit_rate, 100.0 / 199);
+}
+
+TEST(FCFSCacheModelTest, ChurnKeepsTheLargestFlows) {
+  FlowStats stats = build_flow_stats({{100, 1}, {1, 99}});
+
+  EXPECT_DOUBLE_EQ(get_fcfs_hit_rate(stats, true, 1), 100.0 / 199);
+  EXPECT_DOUBLE_EQ(get_fcfs_hit_rate(stats, true, 11), 110.0 / 199);
+}
+
+TEST(FCFSCacheModelTest, HitRateGrowsWithCapacity) {
+  FlowStats stats = build_flow_stats({{1000, 3}, {50, 20}, {2, 200}});
+
+  for (bool churn : {false, true}) {
+    double last_hit_rate = 0;
+
+    for (int capacity = 1; capacity <= 256; capacity *= 2) {
+      double hit_rate = get_fcfs_hit_rate(stats, churn, capacity);
+      EXPECT_GE(hit_rate, last_hit_rate);
+      EXPECT_LE(hit_rate, 1);
+      last_hit_rate = hit_rate;
+    }
+  }
+}
+
+TEST(FCFSCacheModelTest, AdmissionThreshold) {
+  FlowStats stats = build_flow_stats({{10, 2}, {1, 100}});
+  FCFSCacheModel model(stats, false);
+
+  // Admitting flows after their first packet keeps the single packet flows
+  // out, and only costs that packet of each large flow.
+  EXPECT_EQ(model.get_admission_threshold(2), 1);
+  EXPECT_DOUBLE_EQ(model.get_hit_rate(CachePolicy::COUNT_MIN_ADMISSION, 2),
+                   18.0 / 120);
+}
+
+TEST(FCFSCacheModelTest, AdmissionBeatsFCFSWithoutChurn) {
+  FlowStats stats = build_flow_stats({{1000, 1}, {20, 50}});
+  FCFSCacheModel model(stats, false);
+
+  double hit_rate = model.get_hit_rate(CachePolicy::COUNT_MIN_ADMISSION, 1);
+
+  // The slot goes to the largest flow, minus the packet counted before its
+  // admission, instead of the first flow that shows up.
+  EXPECT_DOUBLE_EQ(hit_rate, 999.0 / 2000);
+  EXPECT_GT(hit_rate, model.get_hit_rate(CachePolicy::FCFS, 1));
+  EXPECT_LT(hit_rate, get_fcfs_hit_rate(stats, true, 1));
+}
+
+TEST(FCFSCacheModelTest, ApproximateLRU) {
+  FlowStats stats = build_flow_stats({{10, 100}});
+  FCFSCacheModel model(stats, false);
+
+  // Between two packets of a flow, its slot sees (N - k) / C other packets.
+  double others = (1000.0 - 10) / 25;
+  EXPECT_DOUBLE_EQ(model.get_hit_rate(CachePolicy::LRU_APPROX, 25),
+                   10 / (10 + others));
+
+  // Collisions still evict flows when there are as many slots as flows.
+  EXPECT_LT(model.get_hit_rate(CachePolicy::LRU_APPROX, 100), 1);
+}
+
+TEST(FCFSCacheModelTest, ParetoConfigsDropDominatedPolicies) {
+  FlowStats stats = build_flow_stats({{10, 100}});
+  FCFSCacheModel model(stats, false);
+
+  // Every flow is alike, so FCFS is never beaten.
+  std::vector<cache_config_t> configs = model.get_pareto_configs({10, 100});
+
+  ASSERT_EQ(configs.size(), 2u);
+  for (const cache_config_t &config : configs) {
+    EXPECT_EQ(config.policy, CachePolicy::FCFS);
+  }
+  EXPECT_EQ(configs[0].capacity, 10);
+  EXPECT_EQ(configs[1].capacity, 100);
+}
+
+TEST(FCFSCacheModelTest, ParetoConfigsKeepBetterPolicies) {
+  FlowStats stats = build_flow_stats({{1000, 1}, {1, 999}});
+  FCFSCacheModel model(stats, false);
+
+  std::vector<cache_config_t> configs = model.get_pareto_configs({1});
+
+  // Each policy keeps more of the elephant flow than the previous one.
+  ASSERT_EQ(configs.size(), 3u);
+  EXPECT_EQ(configs[0].policy, CachePolicy::FCFS);
+  EXPECT_EQ(configs[1].policy, CachePolicy::LRU_APPROX);
+  EXPECT_EQ(configs[2].policy, CachePolicy::COUNT_MIN_ADMISSION);
+  EXPECT_EQ(configs[2].admission_threshold, 1);
+
+  double last_hit_rate = 0;
+  for (const cache_config_t &config : configs) {
+    double hit_rate = model.get_hit_rate(config.policy, config.capacity);
+    EXPECT_GT(hit_rate, last_hit_rate);
+    last_hit_rate = hit_rate;
+  }
+}
+
+} // namespace
@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+
+#include "targets/tofino/tna/perf_oracle.h"
+#include "targets/tofino/tna/tna.h"
+
+#include <cmath>
+
+using namespace synapse::tofino;
+
+namespace {
+
+constexpr uint64_t GBPS = 1'000'000'000;
+constexpr int PKT_BYTES = 1000;
+
+// Two pipes with two front panel ports and one recirculation port each, all
+// running at the same speed.
+TNAProperties get_properties() {
+  TNAProperties properties{};
+  properties.port_capacity_bps = 100 * GBPS;
+  properties.total_ports = 4;
+  properties.recirc_port_capacity_bps = 100 * GBPS;
+  properties.total_recirc_ports = 2;
+  properties.pipes = 2;
+  return properties;
+}
+
+constexpr double SWITCH_BPS = 400.0 * GBPS;
+constexpr double PIPE_BPS = SWITCH_BPS / 2;
+constexpr double RECIRC_BPS = 100.0 * GBPS;
+
+double to_pps(double bps) { return bps / (PKT_BYTES * 8); }
+
+// Throughput of a switch whose recirculated traffic leaves each pipe at
+// pipe_recirc_out_bps, with the rest of the traffic never recirculated.
+double expected_pps(double pipe_recirc_out_bps, double non_recirc) {
+  return to_pps(2 * pipe_recirc_out_bps + non_recirc * SWITCH_BPS);
+}
+
+// Truncations to whole bits and packets on the way.
+constexpr double PPS_TOLERANCE = 4;
+
+TEST(PerfOracleTest, NoRecirculation) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  EXPECT_EQ(oracle.estimate_throughput_pps(), to_pps(SWITCH_BPS));
+  EXPECT_EQ(oracle.get_max_recirc_port_utilization(), 0);
+}
+
+TEST(PerfOracleTest, UnsaturatedRecirculation) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  oracle.add_recirculated_traffic(0, 1, 0.25, std::nullopt);
+
+  // Every recirculated packet is served and leaves the port.
+  EXPECT_NEAR(oracle.estimate_throughput_pps(),
+              expected_pps(0.25 * PIPE_BPS, 0.75), PPS_TOLERANCE);
+  EXPECT_DOUBLE_EQ(oracle.get_max_recirc_port_utilization(),
+                   0.25 * PIPE_BPS / RECIRC_BPS);
+}
+
+TEST(PerfOracleTest, SaturatedSingleRecirculation) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  oracle.add_recirculated_traffic(0, 1, 1, std::nullopt);
+
+  // The port serves a = Cr / Tin of the traffic offered to it.
+  double a = RECIRC_BPS / PIPE_BPS;
+
+  EXPECT_NEAR(oracle.estimate_throughput_pps(), expected_pps(PIPE_BPS * a, 0),
+              PPS_TOLERANCE);
+  EXPECT_DOUBLE_EQ(oracle.get_max_recirc_port_utilization(),
+                   PIPE_BPS / RECIRC_BPS);
+}
+
+TEST(PerfOracleTest, SaturatedDoubleRecirculation) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  oracle.add_recirculated_traffic(0, 1, 1, std::nullopt);
+  oracle.add_recirculated_traffic(0, 2, 1, 0);
+
+  // Tin * (a + a^2) = Cr, and only the packets served twice leave the port.
+  double a = (-1 + std::sqrt(1 + 4 * RECIRC_BPS / PIPE_BPS)) / 2;
+
+  EXPECT_NEAR(oracle.estimate_throughput_pps(),
+              expected_pps(PIPE_BPS * a * a, 0), PPS_TOLERANCE);
+}
+
+TEST(PerfOracleTest, PartialSecondRecirculation) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  oracle.add_recirculated_traffic(0, 1, 1, std::nullopt);
+  oracle.add_recirculated_traffic(0, 2, 0.5, 0);
+
+  // Tin * (a + 0.5 * a^2) = Cr. Half of the packets leave after the first
+  // pass, and the other half after the second.
+  double c = RECIRC_BPS / PIPE_BPS;
+  double a = -1 + std::sqrt(1 + 2 * c);
+  double out_bps = PIPE_BPS * (0.5 * a + 0.5 * a * a);
+
+  EXPECT_NEAR(oracle.estimate_throughput_pps(), expected_pps(out_bps, 0),
+              PPS_TOLERANCE);
+}
+
+TEST(PerfOracleTest, DeepRecirculationBisection) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  const int passes = 5;
+
+  oracle.add_recirculated_traffic(0, 1, 1, std::nullopt);
+  for (int pass = 2; pass <= passes; pass++) {
+    oracle.add_recirculated_traffic(0, pass, 1, 0);
+  }
+
+  // No closed form past the second pass, so recover a from the packets that
+  // leave the port (Tin * a^5) and check that the port is exactly saturated.
+  double out_bps =
+      oracle.estimate_throughput_pps() * (PKT_BYTES * 8) / properties.pipes;
+  double a = std::pow(out_bps / PIPE_BPS, 1.0 / passes);
+
+  double served_bps = 0;
+  for (int pass = 1; pass <= passes; pass++) {
+    served_bps += PIPE_BPS * std::pow(a, pass);
+  }
+
+  EXPECT_NEAR(served_bps / RECIRC_BPS, 1, 1e-6);
+}
+
+TEST(PerfOracleTest, MoreRecirculationsNeverHelp) {
+  TNAProperties properties = get_properties();
+  PerfOracle oracle(&properties, PKT_BYTES);
+
+  oracle.add_recirculated_traffic(0, 1, 0.8, std::nullopt);
+  uint64_t last_pps = oracle.estimate_throughput_pps();
+
+  for (int pass = 2; pass <= 8; pass++) {
+    oracle.add_recirculated_traffic(0, pass, 0.8, 0);
+
+    uint64_t pps = oracle.estimate_throughput_pps();
+    EXPECT_LT(pps, last_pps);
+    last_pps = pps;
+  }
+}
+
+} // namespace